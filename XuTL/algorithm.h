@@ -28,8 +28,8 @@ inline OutputIterator _copy(InputIterator first, InputIterator last,
 
 template <typename T, typename U>
 inline typename enable_if<
-    xutl::is_same<typename xutl::remove_const<T>, U>::value &&
-        xutl::is_trivially_copy_assignable<U>::value,
+    xutl::is_same<typename xutl::remove_const<T>::type, U>::value &&
+        xutl::is_trivially_copyable<U>::value,
     U*>::type
 _copy(T* first, T* last, U* result) {
     const size_t n = static_cast<size_t>(last - first);
@@ -90,7 +90,7 @@ inline OutputIterator _copy_backward(BidirectionalIterator first,
 template <typename T, typename U>
 inline typename enable_if<
     xutl::is_same<typename xutl::remove_const<T>::type, U>::value &&
-        xutl::is_trivially_copy_assignable<U>::value,
+        xutl::is_trivially_copyable<U>::value,
     U*>::type
 _copy_backward(T* first, T* last, U* result) {
     const size_t n = static_cast<size_t>(last - first);
@@ -123,13 +123,16 @@ OutputIterator _fill_n(OutputIterator first, Size n, const T& value) {
 
 template <typename T, typename Size, typename U>
 typename enable_if<xutl::is_integral<T>::value && sizeof(T) == 1 &&
-                   !xutl::is_same<T, bool>::value &&
-                   xutl::is_integral<U>::value && sizeof(U) == 1>::type
-_fill_n(T* first, Size n, U value) {
+                       !xutl::is_same<T, bool>::value &&
+                       xutl::is_integral<U>::value && sizeof(U) == 1,
+                   T*>::type
+_fill_n(T* first, Size n, const U& value) {
     if (n > 0) {
-        memset(first, value, n);
+        memset(first, static_cast<unsigned char>(value),
+               static_cast<size_t>(n));
+        return first + n;
     }
-    return first + n;
+    return first;
 }
 
 template <typename OutputIterator, typename Size, typename T>
@@ -167,8 +170,8 @@ void fill(ForwardIterator first, ForwardIterator last, const T& value) {
 // ************************************************************************************
 
 template <typename InputIterator, typename OutputIterator>
-InputIterator _move(InputIterator first, InputIterator last,
-                    OutputIterator result) {
+OutputIterator _move(InputIterator first, InputIterator last,
+                     OutputIterator result) {
     while (first != last) {
         *result = xutl::move(*first);
         ++result;
@@ -179,8 +182,8 @@ InputIterator _move(InputIterator first, InputIterator last,
 
 template <typename T, typename U>
 inline typename enable_if<
-    xutl::is_same<typename xutl::remove_const<T>, U>::value &&
-        xutl::is_trivially_move_assignable<U>::value,
+    xutl::is_same<typename xutl::remove_const<T>::type, U>::value &&
+        xutl::is_trivially_copyable<U>::value,
     U*>::type
 _move(T* first, T* last, U* result) {
     const size_t n = static_cast<size_t>(last - first);
@@ -214,7 +217,7 @@ inline OutputIterator _move_backward(InputIterator first, InputIterator last,
 template <typename T, typename U>
 inline typename enable_if<
     xutl::is_same<typename xutl::remove_const<T>::type, U>::value &&
-        xutl::is_trivially_copy_assignable<U>::value,
+        xutl::is_trivially_copyable<U>::value,
     U*>::type
 _move_backward(T* first, T* last, U* result) {
     const size_t n = static_cast<size_t>(last - first);
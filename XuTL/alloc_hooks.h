@@ -0,0 +1,22 @@
+#ifndef XUTL_ALLOC_HOOKS_H_
+#define XUTL_ALLOC_HOOKS_H_
+
+/**
+ * 该文件包含 allocator 中分配统计的钩子 XUTL_ALLOC_STATS_ALLOCATE/DEALLOCATE
+ * 定义宏 XUTL_ALLOC_STATS 时引入 alloc_stats.h 中的实现；未定义时钩子展开为空，
+ * 不引入任何标准库头文件，所有容器都可以放心地包含它。
+ * 查询和打印统计的接口在 alloc_stats.h 中
+ */
+
+#ifdef XUTL_ALLOC_STATS
+
+#include "alloc_stats.h"
+
+#else  // XUTL_ALLOC_STATS
+
+#define XUTL_ALLOC_STATS_ALLOCATE(T, bytes) ((void)0)
+#define XUTL_ALLOC_STATS_DEALLOCATE(T, bytes) ((void)0)
+
+#endif  // XUTL_ALLOC_STATS
+
+#endif  // XUTL_ALLOC_HOOKS_H_
@@ -0,0 +1,571 @@
+#ifndef XUTL_ALLOC_STATS_H_
+#define XUTL_ALLOC_STATS_H_
+
+/**
+ * 该文件包含 allocator 的分配统计
+ * 编译时定义宏 XUTL_ALLOC_STATS 才会开启，按类型和全局分别统计 allocate/deallocate
+ * 的次数、分配和释放的字节数、当前占用的字节数、峰值，以及分配大小的直方图。
+ * 未定义时 allocator 中的钩子展开为空，查询接口返回全零的结果，不产生任何开销。
+ *
+ * 计数器按线程、按类型各自独立，只有所属线程写入，查询时再把所有线程的计数合并，
+ * 因此分配路径上没有跨线程共享的写操作。占用字节数在每个线程上累积到
+ * XUTL_ALLOC_STATS_FLUSH_BYTES（默认 64KB）后才并入全局计数并更新峰值，
+ * 所以多线程下的峰值是近似值，每个线程的误差不超过这个值；定义为 0 则每次都更新，峰值精确。
+ *
+ * allocator 只通过 alloc_hooks.h 使用这里的钩子，未开启统计时不会包含本文件
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef XUTL_ALLOC_STATS
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#endif
+
+namespace xutl
+{
+
+// ************************************************************************************
+// 统计结果
+// ************************************************************************************
+
+// 直方图的桶数：第 i 个桶统计大小在 (2^(i+3), 2^(i+4)] 字节之间的分配，
+// 第 0 个桶包含所有不超过 16 字节的分配，最后一个桶包含所有超过 256KB 的分配
+constexpr size_t alloc_histogram_buckets = 16;
+
+// 一组分配统计
+struct alloc_stats
+{
+    std::string type_name;  // 类型名，全局统计时为空
+    size_t element_size = 0;
+    uint64_t allocations = 0;
+    uint64_t deallocations = 0;
+    uint64_t bytes_allocated = 0;
+    uint64_t bytes_deallocated = 0;
+    int64_t bytes_live = 0;
+    int64_t peak_bytes = 0;
+    uint64_t histogram[alloc_histogram_buckets] = {};
+};
+
+// 某一时刻所有统计的快照
+struct alloc_stats_snapshot
+{
+    alloc_stats total;
+    std::vector<alloc_stats> types;  // 只包含分配过内存的类型
+};
+
+// 分配 bytes 字节时落入的直方图桶
+inline size_t alloc_histogram_bucket(size_t bytes) noexcept
+{
+    if (bytes <= 16) return 0;
+    // ceil(log2(bytes)) - 4
+    const size_t bits = 64 - static_cast<size_t>(__builtin_clzll(bytes - 1));
+    return bits - 4 < alloc_histogram_buckets ? bits - 4
+                                              : alloc_histogram_buckets - 1;
+}
+
+// 第 bucket 个桶的上界（字节），最后一个桶没有上界，返回 0
+inline size_t alloc_histogram_upper_bound(size_t bucket) noexcept
+{
+    return bucket + 1 < alloc_histogram_buckets ? size_t(16) << bucket : 0;
+}
+
+#ifdef XUTL_ALLOC_STATS
+
+constexpr bool alloc_stats_enabled = true;
+
+#ifndef XUTL_ALLOC_STATS_FLUSH_BYTES
+#define XUTL_ALLOC_STATS_FLUSH_BYTES (64 * 1024)
+#endif
+
+// ************************************************************************************
+// 计数器
+// ************************************************************************************
+
+// 一个线程在一个类型上的计数器
+// 只有所属线程写入，用 load + store 代替原子的读改写；其它线程查询时只读取
+struct _alloc_counters
+{
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> deallocations;
+    std::atomic<uint64_t> bytes_allocated;
+    std::atomic<uint64_t> bytes_deallocated;
+    // 还没有并入 _alloc_record::live 的占用字节数
+    std::atomic<int64_t> pending_live;
+    std::atomic<uint64_t> histogram[alloc_histogram_buckets];
+
+    _alloc_counters() noexcept
+    {
+        allocations.store(0, std::memory_order_relaxed);
+        deallocations.store(0, std::memory_order_relaxed);
+        bytes_allocated.store(0, std::memory_order_relaxed);
+        bytes_deallocated.store(0, std::memory_order_relaxed);
+        pending_live.store(0, std::memory_order_relaxed);
+        for (auto& h : histogram)
+        {
+            h.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename U>
+    static void _bump(std::atomic<U>& counter, U delta) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + delta,
+                      std::memory_order_relaxed);
+    }
+
+    // 把计数累加到 s 上（不包括 pending_live）
+    void add_to(alloc_stats& s) const noexcept
+    {
+        s.allocations += allocations.load(std::memory_order_relaxed);
+        s.deallocations += deallocations.load(std::memory_order_relaxed);
+        s.bytes_allocated += bytes_allocated.load(std::memory_order_relaxed);
+        s.bytes_deallocated +=
+            bytes_deallocated.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < alloc_histogram_buckets; ++i)
+        {
+            s.histogram[i] += histogram[i].load(std::memory_order_relaxed);
+        }
+    }
+};
+
+// 一个类型（id 为 0 时为全局）的记录，创建后永不释放
+struct _alloc_record
+{
+    size_t id;
+    const char* signature;  // 带有类型名的 __PRETTY_FUNCTION__
+    size_t element_size;
+    std::atomic<int64_t> live;
+    std::atomic<int64_t> peak;
+    _alloc_counters retired;  // 已经退出的线程留下的计数，只在持有注册表的锁时访问
+
+    _alloc_record(size_t i, const char* sig, size_t size) noexcept
+        : id(i), signature(sig), element_size(size), live(0), peak(0)
+    {
+    }
+
+    // 占用字节数变化 delta，必要时更新峰值
+    void flush(int64_t delta) noexcept
+    {
+        const int64_t now =
+            live.fetch_add(delta, std::memory_order_relaxed) + delta;
+        int64_t old_peak = peak.load(std::memory_order_relaxed);
+        while (now > old_peak &&
+               !peak.compare_exchange_weak(old_peak, now,
+                                           std::memory_order_relaxed))
+        {
+        }
+    }
+};
+
+class _alloc_thread_block;
+
+// 所有类型记录和线程计数器的注册表，创建后永不释放，
+// 这样线程和静态对象在程序退出时以任意顺序析构都是安全的
+class _alloc_registry
+{
+public:
+    std::mutex lock;
+    std::vector<_alloc_record*> records;  // 下标即 id，0 为全局
+    std::vector<_alloc_thread_block*> threads;
+    alloc_stats_snapshot baseline;  // reset 时的快照，查询时减去
+
+    static _alloc_registry& instance()
+    {
+        static _alloc_registry* registry = new _alloc_registry();
+        return *registry;
+    }
+
+    _alloc_record* register_type(const char* signature, size_t element_size)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        _alloc_record* r =
+            new _alloc_record(records.size(), signature, element_size);
+        records.push_back(r);
+        return r;
+    }
+
+    _alloc_record* total() const noexcept
+    {
+        return records[0];
+    }
+
+private:
+    _alloc_registry()
+    {
+        records.push_back(new _alloc_record(0, "", 0));
+    }
+};
+
+// 一个线程的全部计数器，按类型 id 索引
+class _alloc_thread_block
+{
+public:
+    _alloc_thread_block()
+    {
+        _alloc_registry& registry = _alloc_registry::instance();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        registry.threads.push_back(this);
+    }
+
+    // 线程退出时把计数并入各个记录的 retired
+    ~_alloc_thread_block()
+    {
+        _destroyed() = true;
+        _alloc_registry& registry = _alloc_registry::instance();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        for (size_t id = 0; id < _counters.size(); ++id)
+        {
+            _alloc_counters* c = _counters[id];
+            if (c == nullptr) continue;
+            _alloc_record* r = registry.records[id];
+            alloc_stats sum;
+            c->add_to(sum);
+            _merge(r->retired, sum);
+            r->flush(c->pending_live.load(std::memory_order_relaxed));
+            delete c;
+        }
+        for (size_t i = 0; i < registry.threads.size(); ++i)
+        {
+            if (registry.threads[i] == this)
+            {
+                registry.threads[i] = registry.threads.back();
+                registry.threads.pop_back();
+                break;
+            }
+        }
+    }
+
+    // 当前线程的计数器；线程的 thread_local 对象已经析构时（例如程序退出时
+    // 静态对象的析构函数中仍在释放内存）返回 nullptr
+    static _alloc_thread_block* current()
+    {
+        if (_destroyed()) return nullptr;
+        static thread_local _alloc_thread_block block;
+        return &block;
+    }
+
+    // 类型 id 的计数器，第一次使用时创建
+    _alloc_counters& counters(size_t id)
+    {
+        if (id < _counters.size() && _counters[id] != nullptr)
+        {
+            return *_counters[id];
+        }
+        // 查询线程会遍历 _counters，因此修改它时要持有注册表的锁
+        _alloc_counters* c = new _alloc_counters();
+        std::lock_guard<std::mutex> guard(_alloc_registry::instance().lock);
+        if (id >= _counters.size()) _counters.resize(id + 1, nullptr);
+        _counters[id] = c;
+        return *c;
+    }
+
+    // 类型 id 的计数器，不存在时返回 nullptr，调用者须持有注册表的锁
+    const _alloc_counters* find(size_t id) const noexcept
+    {
+        return id < _counters.size() ? _counters[id] : nullptr;
+    }
+
+    // 把 from 累加到 to 上，调用者须持有注册表的锁
+    static void _merge(_alloc_counters& to, const alloc_stats& from) noexcept
+    {
+        _alloc_counters::_bump(to.allocations, from.allocations);
+        _alloc_counters::_bump(to.deallocations, from.deallocations);
+        _alloc_counters::_bump(to.bytes_allocated, from.bytes_allocated);
+        _alloc_counters::_bump(to.bytes_deallocated, from.bytes_deallocated);
+        for (size_t i = 0; i < alloc_histogram_buckets; ++i)
+        {
+            _alloc_counters::_bump(to.histogram[i], from.histogram[i]);
+        }
+    }
+
+private:
+    std::vector<_alloc_counters*> _counters;
+
+    static bool& _destroyed() noexcept
+    {
+        static thread_local bool destroyed = false;
+        return destroyed;
+    }
+};
+
+// ************************************************************************************
+// allocator 中的钩子
+// ************************************************************************************
+
+// 每个类型的记录在第一次分配时注册
+template <typename T>
+inline const char* _alloc_type_signature() noexcept
+{
+    return __PRETTY_FUNCTION__;
+}
+
+template <typename T>
+inline _alloc_record* _alloc_type_record()
+{
+    static _alloc_record* record = _alloc_registry::instance().register_type(
+        _alloc_type_signature<T>(), sizeof(T));
+    return record;
+}
+
+inline void _alloc_stats_update(_alloc_counters& c, _alloc_record* r,
+                                int64_t delta) noexcept
+{
+    const int64_t pending =
+        c.pending_live.load(std::memory_order_relaxed) + delta;
+    if (pending >= XUTL_ALLOC_STATS_FLUSH_BYTES ||
+        pending <= -XUTL_ALLOC_STATS_FLUSH_BYTES)
+    {
+        r->flush(pending);
+        c.pending_live.store(0, std::memory_order_relaxed);
+    }
+    else
+    {
+        c.pending_live.store(pending, std::memory_order_relaxed);
+    }
+}
+
+// 记录一次分配（allocate 为 true）或释放
+inline void _alloc_stats_on(_alloc_record* type, size_t bytes, bool allocate)
+{
+    _alloc_registry& registry = _alloc_registry::instance();
+    _alloc_record* records[2] = {type, registry.total()};
+    alloc_stats delta;
+    if (allocate)
+    {
+        delta.allocations = 1;
+        delta.bytes_allocated = bytes;
+        delta.histogram[alloc_histogram_bucket(bytes)] = 1;
+    }
+    else
+    {
+        delta.deallocations = 1;
+        delta.bytes_deallocated = bytes;
+    }
+    const int64_t live_delta =
+        allocate ? static_cast<int64_t>(bytes) : -static_cast<int64_t>(bytes);
+
+    _alloc_thread_block* block = _alloc_thread_block::current();
+    if (block == nullptr)
+    {
+        // 慢路径：直接记入 retired
+        std::lock_guard<std::mutex> guard(registry.lock);
+        for (_alloc_record* r : records)
+        {
+            _alloc_thread_block::_merge(r->retired, delta);
+            r->flush(live_delta);
+        }
+        return;
+    }
+    const size_t bucket = alloc_histogram_bucket(bytes);
+    for (_alloc_record* r : records)
+    {
+        _alloc_counters& c = block->counters(r->id);
+        if (allocate)
+        {
+            _alloc_counters::_bump(c.allocations, uint64_t(1));
+            _alloc_counters::_bump(c.bytes_allocated, uint64_t(bytes));
+            _alloc_counters::_bump(c.histogram[bucket], uint64_t(1));
+        }
+        else
+        {
+            _alloc_counters::_bump(c.deallocations, uint64_t(1));
+            _alloc_counters::_bump(c.bytes_deallocated, uint64_t(bytes));
+        }
+        _alloc_stats_update(c, r, live_delta);
+    }
+}
+
+#define XUTL_ALLOC_STATS_ALLOCATE(T, bytes) \
+    ::xutl::_alloc_stats_on(::xutl::_alloc_type_record<T>(), (bytes), true)
+#define XUTL_ALLOC_STATS_DEALLOCATE(T, bytes) \
+    ::xutl::_alloc_stats_on(::xutl::_alloc_type_record<T>(), (bytes), false)
+
+// ************************************************************************************
+// 查询
+// ************************************************************************************
+
+// 从 __PRETTY_FUNCTION__ 中取出类型名
+// GCC: "... _alloc_type_signature() [with T = int]"，Clang: "... [T = int]"
+inline std::string _alloc_type_name(const char* signature)
+{
+    const char* begin = strstr(signature, "T = ");
+    if (begin == nullptr) return signature;
+    begin += 4;
+    const char* end = strrchr(begin, ']');
+    return end ? std::string(begin, end) : std::string(begin);
+}
+
+// 合并 r 的所有计数，调用者须持有注册表的锁
+inline alloc_stats _alloc_collect(const _alloc_registry& registry,
+                                  const _alloc_record& r)
+{
+    alloc_stats s;
+    if (r.id != 0)
+    {
+        s.type_name = _alloc_type_name(r.signature);
+        s.element_size = r.element_size;
+    }
+    r.retired.add_to(s);
+    int64_t live = r.live.load(std::memory_order_relaxed);
+    for (const _alloc_thread_block* t : registry.threads)
+    {
+        const _alloc_counters* c = t->find(r.id);
+        if (c == nullptr) continue;
+        c->add_to(s);
+        live += c->pending_live.load(std::memory_order_relaxed);
+    }
+    s.bytes_live = live;
+    s.peak_bytes = std::max(r.peak.load(std::memory_order_relaxed), live);
+    return s;
+}
+
+// 减去 reset 时的基线，占用字节数和峰值不受影响
+inline void _alloc_subtract(alloc_stats& s, const alloc_stats& base)
+{
+    s.allocations -= base.allocations;
+    s.deallocations -= base.deallocations;
+    s.bytes_allocated -= base.bytes_allocated;
+    s.bytes_deallocated -= base.bytes_deallocated;
+    for (size_t i = 0; i < alloc_histogram_buckets; ++i)
+    {
+        s.histogram[i] -= base.histogram[i];
+    }
+}
+
+// 取得不减去基线的原始快照，types 按类型 id 排列（不省略任何类型），
+// 调用者须持有注册表的锁
+inline alloc_stats_snapshot _alloc_raw_snapshot(const _alloc_registry& registry)
+{
+    alloc_stats_snapshot snap;
+    snap.total = _alloc_collect(registry, *registry.records[0]);
+    for (size_t id = 1; id < registry.records.size(); ++id)
+    {
+        snap.types.push_back(_alloc_collect(registry, *registry.records[id]));
+    }
+    return snap;
+}
+
+// 取得当前所有统计的快照
+inline alloc_stats_snapshot snapshot_alloc_stats()
+{
+    _alloc_registry& registry = _alloc_registry::instance();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    alloc_stats_snapshot raw = _alloc_raw_snapshot(registry);
+    const alloc_stats_snapshot& base = registry.baseline;
+    alloc_stats_snapshot snap;
+    snap.total = raw.total;
+    _alloc_subtract(snap.total, base.total);
+    for (size_t i = 0; i < raw.types.size(); ++i)
+    {
+        alloc_stats& s = raw.types[i];
+        if (i < base.types.size()) _alloc_subtract(s, base.types[i]);
+        if (s.allocations != 0 || s.deallocations != 0 || s.bytes_live != 0)
+        {
+            snap.types.push_back(s);
+        }
+    }
+    return snap;
+}
+
+// 取得类型 T 的统计
+template <typename T>
+inline alloc_stats snapshot_alloc_stats()
+{
+    _alloc_record* r = _alloc_type_record<T>();
+    _alloc_registry& registry = _alloc_registry::instance();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    alloc_stats s = _alloc_collect(registry, *r);
+    if (r->id - 1 < registry.baseline.types.size())
+    {
+        _alloc_subtract(s, registry.baseline.types[r->id - 1]);
+    }
+    return s;
+}
+
+// 把次数、字节数和直方图清零，峰值重置为当前的占用字节数；
+// 并不真正修改各线程的计数器，而是记下当前值作为基线，之后查询时减去
+inline void reset_alloc_stats()
+{
+    _alloc_registry& registry = _alloc_registry::instance();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    registry.baseline = _alloc_raw_snapshot(registry);
+    registry.records[0]->peak.store(registry.baseline.total.bytes_live,
+                                    std::memory_order_relaxed);
+    for (size_t id = 1; id < registry.records.size(); ++id)
+    {
+        registry.records[id]->peak.store(
+            registry.baseline.types[id - 1].bytes_live,
+            std::memory_order_relaxed);
+    }
+}
+
+#else  // XUTL_ALLOC_STATS
+
+constexpr bool alloc_stats_enabled = false;
+
+inline alloc_stats_snapshot snapshot_alloc_stats()
+{
+    return alloc_stats_snapshot();
+}
+
+template <typename T>
+inline alloc_stats snapshot_alloc_stats()
+{
+    return alloc_stats();
+}
+
+inline void reset_alloc_stats()
+{
+}
+
+#endif  // XUTL_ALLOC_STATS
+
+// 以表格形式打印快照，按分配次数从多到少列出各类型
+inline void print_alloc_stats(const alloc_stats_snapshot& snap,
+                              FILE* out = stdout)
+{
+    if (!alloc_stats_enabled)
+    {
+        fprintf(out,
+                "allocation stats are disabled (define XUTL_ALLOC_STATS)\n");
+        return;
+    }
+    // 按下标排序：对 alloc_stats* 使用 std::sort 会通过 ADL 同时找到 xutl::swap
+    std::vector<size_t> order;
+    for (size_t i = 0; i < snap.types.size(); ++i)
+    {
+        order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&snap](size_t a, size_t b) {
+        return snap.types[a].allocations > snap.types[b].allocations;
+    });
+    std::vector<const alloc_stats*> rows;
+    for (size_t i : order)
+    {
+        rows.push_back(&snap.types[i]);
+    }
+    rows.push_back(&snap.total);
+    fprintf(out, "%12s %12s %14s %12s %12s  %s\n", "allocations",
+            "deallocs", "bytes alloc", "live", "peak", "type");
+    for (const alloc_stats* s : rows)
+    {
+        fprintf(out, "%12llu %12llu %14llu %12lld %12lld  %s\n",
+                static_cast<unsigned long long>(s->allocations),
+                static_cast<unsigned long long>(s->deallocations),
+                static_cast<unsigned long long>(s->bytes_allocated),
+                static_cast<long long>(s->bytes_live),
+                static_cast<long long>(s->peak_bytes),
+                s == &snap.total ? "(total)" : s->type_name.c_str());
+    }
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_ALLOC_STATS_H_
@@ -0,0 +1,652 @@
+#ifndef XUTL_BITSET_H_
+#define XUTL_BITSET_H_
+
+/**
+ * 该文件包含模板类 bitset 和类 dynamic_bitset
+ * 它们把位紧密地保存在 64 位的字中：bitset<N> 的位数在编译期确定，
+ * 字保存在对象内部；dynamic_bitset 的位数可变，字保存在 vector<uint64_t> 中
+ *
+ * 与、或、异或、与非都按字进行，字数较多且 CPU 支持 AVX2 时每次处理 4 个字；
+ * count() 使用硬件 popcnt，长的位集用 AVX2 的查表法统计；find_first()、
+ * find_next() 按字跳过全 0 的字，再用尾随零计数（tzcnt）定位。
+ * 最后一个字中超出 size() 的位始终为 0
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "exceptdef.h"
+#include "simd.h"
+#include "vector.h"
+
+namespace xutl
+{
+
+// ************************************************************************************
+// 按字的位运算
+// 参数都是字数组和字数，SIMD 路径在运行时按 CPU 特性选择
+// ************************************************************************************
+
+constexpr size_t _bits_per_word = 64;
+
+// 字数较少时不值得分派到 SIMD 路径
+constexpr size_t _bits_simd_min_words = 8;
+
+// 按位运算 dst = op(dst, src)
+struct _bits_and
+{
+    static uint64_t word(uint64_t a, uint64_t b) noexcept
+    {
+        return a & b;
+    }
+#if XUTL_SIMD_X86
+    XUTL_TARGET("avx2") static __m256i vec(__m256i a, __m256i b) noexcept
+    {
+        return _mm256_and_si256(a, b);
+    }
+#endif
+};
+
+struct _bits_or
+{
+    static uint64_t word(uint64_t a, uint64_t b) noexcept
+    {
+        return a | b;
+    }
+#if XUTL_SIMD_X86
+    XUTL_TARGET("avx2") static __m256i vec(__m256i a, __m256i b) noexcept
+    {
+        return _mm256_or_si256(a, b);
+    }
+#endif
+};
+
+struct _bits_xor
+{
+    static uint64_t word(uint64_t a, uint64_t b) noexcept
+    {
+        return a ^ b;
+    }
+#if XUTL_SIMD_X86
+    XUTL_TARGET("avx2") static __m256i vec(__m256i a, __m256i b) noexcept
+    {
+        return _mm256_xor_si256(a, b);
+    }
+#endif
+};
+
+// a & ~b
+struct _bits_and_not
+{
+    static uint64_t word(uint64_t a, uint64_t b) noexcept
+    {
+        return a & ~b;
+    }
+#if XUTL_SIMD_X86
+    XUTL_TARGET("avx2") static __m256i vec(__m256i a, __m256i b) noexcept
+    {
+        return _mm256_andnot_si256(b, a);
+    }
+#endif
+};
+
+#if XUTL_SIMD_X86
+template <typename Op>
+XUTL_TARGET("avx2")
+void _bits_apply_avx2(uint64_t* dst, const uint64_t* src, size_t n) noexcept
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<__m256i*>(dst + i));
+        __m256i b =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                            Op::vec(a, b));
+    }
+    for (; i < n; ++i)
+    {
+        dst[i] = Op::word(dst[i], src[i]);
+    }
+}
+#endif
+
+template <typename Op>
+void _bits_apply(uint64_t* dst, const uint64_t* src, size_t n) noexcept
+{
+#if XUTL_SIMD_X86
+    if (n >= _bits_simd_min_words && simd_has_avx2())
+    {
+        _bits_apply_avx2<Op>(dst, src, n);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; ++i)
+    {
+        dst[i] = Op::word(dst[i], src[i]);
+    }
+}
+
+// 1 的个数
+
+inline size_t _bits_count_generic(const uint64_t* p, size_t n) noexcept
+{
+    size_t result = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        result += static_cast<size_t>(__builtin_popcountll(p[i]));
+    }
+    return result;
+}
+
+#if XUTL_SIMD_X86
+// 开启 popcnt 后 __builtin_popcountll 编译为一条指令，否则是一次库函数调用
+XUTL_TARGET("popcnt")
+inline size_t _bits_count_popcnt(const uint64_t* p, size_t n) noexcept
+{
+    size_t result = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        result += static_cast<size_t>(__builtin_popcountll(p[i]));
+    }
+    return result;
+}
+
+// 查表法：每个字节拆成高低两个 4 位，用 pshufb 查出各自 1 的个数，
+// 再用 sad 把每 8 个字节的计数加到一个 64 位的累加器上
+XUTL_TARGET("avx2,popcnt")
+inline size_t _bits_count_avx2(const uint64_t* p, size_t n) noexcept
+{
+    const __m256i lookup =
+        _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1,
+                         1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i lo = _mm256_and_si256(v, low_mask);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+        __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                        _mm256_shuffle_epi8(lookup, hi));
+        acc = _mm256_add_epi64(acc,
+                               _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+    }
+    const size_t result = static_cast<size_t>(_mm256_extract_epi64(acc, 0)) +
+                          static_cast<size_t>(_mm256_extract_epi64(acc, 1)) +
+                          static_cast<size_t>(_mm256_extract_epi64(acc, 2)) +
+                          static_cast<size_t>(_mm256_extract_epi64(acc, 3));
+    // 不足 4 个字的尾部
+    return result + _bits_count_popcnt(p + i, n - i);
+}
+#endif
+
+inline size_t _bits_count(const uint64_t* p, size_t n) noexcept
+{
+#if XUTL_SIMD_X86
+    if (n >= _bits_simd_min_words && simd_has_avx2())
+    {
+        return _bits_count_avx2(p, n);
+    }
+    if (simd_has_popcnt()) return _bits_count_popcnt(p, n);
+#endif
+    return _bits_count_generic(p, n);
+}
+
+// 从第 w 个字开始第一个不为 0 的字的下标，没有时返回 n
+
+#if XUTL_SIMD_X86
+// 每次检查 4 个字是否全为 0
+XUTL_TARGET("avx2")
+inline size_t _bits_skip_zero_avx2(const uint64_t* p, size_t w,
+                                   size_t n) noexcept
+{
+    for (; w + 4 <= n; w += 4)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + w));
+        if (!_mm256_testz_si256(v, v)) break;
+    }
+    for (; w < n && p[w] == 0; ++w)
+    {
+    }
+    return w;
+}
+#endif
+
+inline size_t _bits_skip_zero(const uint64_t* p, size_t w, size_t n) noexcept
+{
+    // 1 通常不会太稀疏，先逐字检查几个字，省去分派的开销
+    for (const size_t stop = n - w < 4 ? n : w + 4; w < stop; ++w)
+    {
+        if (p[w] != 0) return w;
+    }
+#if XUTL_SIMD_X86
+    if (n - w >= _bits_simd_min_words && simd_has_avx2())
+    {
+        return _bits_skip_zero_avx2(p, w, n);
+    }
+#endif
+    for (; w < n && p[w] == 0; ++w)
+    {
+    }
+    return w;
+}
+
+// 下标不小于 pos 的第一个 1 的位置，没有时返回 npos
+// 编译器为 __builtin_ctzll 生成 rep bsf，在支持 BMI1 的 CPU 上即 tzcnt
+inline size_t _bits_find_from(const uint64_t* p, size_t n, size_t pos,
+                              size_t npos) noexcept
+{
+    size_t w = pos / _bits_per_word;
+    if (w >= n) return npos;
+    const uint64_t first = p[w] & (~uint64_t(0) << (pos % _bits_per_word));
+    if (first != 0)
+    {
+        return w * _bits_per_word +
+               static_cast<size_t>(__builtin_ctzll(first));
+    }
+    w = _bits_skip_zero(p, w + 1, n);
+    if (w == n) return npos;
+    return w * _bits_per_word + static_cast<size_t>(__builtin_ctzll(p[w]));
+}
+
+// 最后一个字中有效位的掩码，bits 为总位数
+inline uint64_t _bits_tail_mask(size_t bits) noexcept
+{
+    const size_t rest = bits % _bits_per_word;
+    return rest == 0 ? ~uint64_t(0) : (uint64_t(1) << rest) - 1;
+}
+
+// ************************************************************************************
+// bitset 和 dynamic_bitset 共用的操作
+// Derived 提供 _words()、_word_count() 和 size()
+// ************************************************************************************
+
+template <typename Derived>
+class _bitset_ops
+{
+public:
+    using size_type = size_t;
+
+    // find_first、find_next 找不到时的返回值
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    // ********************************************************************************
+    // 访问单个位
+    // ********************************************************************************
+
+    bool operator[](size_type pos) const noexcept
+    {
+        return (_cwords()[pos / _bits_per_word] >> (pos % _bits_per_word)) & 1;
+    }
+    bool test(size_type pos) const
+    {
+        if (pos >= _self().size())
+        {
+            THROW_OUT_OF_RANGE("bitset: position out of range");
+        }
+        return (*this)[pos];
+    }
+
+    Derived& set(size_type pos, bool value = true) noexcept
+    {
+        uint64_t& w = _mwords()[pos / _bits_per_word];
+        const uint64_t bit = uint64_t(1) << (pos % _bits_per_word);
+        w = value ? (w | bit) : (w & ~bit);
+        return _self();
+    }
+    Derived& reset(size_type pos) noexcept
+    {
+        return set(pos, false);
+    }
+    Derived& flip(size_type pos) noexcept
+    {
+        _mwords()[pos / _bits_per_word] ^= uint64_t(1)
+                                           << (pos % _bits_per_word);
+        return _self();
+    }
+
+    // ********************************************************************************
+    // 整体操作
+    // ********************************************************************************
+
+    Derived& set() noexcept
+    {
+        _fill(~uint64_t(0));
+        return _trim();
+    }
+    Derived& reset() noexcept
+    {
+        _fill(0);
+        return _self();
+    }
+    Derived& flip() noexcept
+    {
+        uint64_t* w = _mwords();
+        for (size_type i = 0; i < _count(); ++i)
+        {
+            w[i] = ~w[i];
+        }
+        return _trim();
+    }
+
+    // 1 的个数
+    size_type count() const noexcept
+    {
+        return _bits_count(_cwords(), _count());
+    }
+    bool any() const noexcept
+    {
+        return _bits_skip_zero(_cwords(), 0, _count()) != _count();
+    }
+    bool none() const noexcept
+    {
+        return !any();
+    }
+    bool all() const noexcept
+    {
+        return count() == _self().size();
+    }
+
+    // 第一个 1 的位置，没有时返回 npos
+    size_type find_first() const noexcept
+    {
+        return _bits_find_from(_cwords(), _count(), 0, npos);
+    }
+    // pos 之后（不含 pos）第一个 1 的位置，没有时返回 npos
+    size_type find_next(size_type pos) const noexcept
+    {
+        if (pos + 1 >= _self().size()) return npos;
+        return _bits_find_from(_cwords(), _count(), pos + 1, npos);
+    }
+
+    // ********************************************************************************
+    // 按字的位运算，两边的位数必须相同
+    // ********************************************************************************
+
+    Derived& operator&=(const Derived& rhs) noexcept
+    {
+        return _apply<_bits_and>(rhs);
+    }
+    Derived& operator|=(const Derived& rhs) noexcept
+    {
+        return _apply<_bits_or>(rhs);
+    }
+    Derived& operator^=(const Derived& rhs) noexcept
+    {
+        return _apply<_bits_xor>(rhs);
+    }
+    // *this &= ~rhs，即去掉 rhs 中为 1 的位
+    Derived& and_not(const Derived& rhs) noexcept
+    {
+        return _apply<_bits_and_not>(rhs);
+    }
+
+    Derived operator~() const
+    {
+        Derived result(_self());
+        result.flip();
+        return result;
+    }
+
+    friend Derived operator&(const Derived& lhs, const Derived& rhs)
+    {
+        Derived result(lhs);
+        result &= rhs;
+        return result;
+    }
+    friend Derived operator|(const Derived& lhs, const Derived& rhs)
+    {
+        Derived result(lhs);
+        result |= rhs;
+        return result;
+    }
+    friend Derived operator^(const Derived& lhs, const Derived& rhs)
+    {
+        Derived result(lhs);
+        result ^= rhs;
+        return result;
+    }
+
+    friend bool operator==(const Derived& lhs, const Derived& rhs) noexcept
+    {
+        if (lhs.size() != rhs.size()) return false;
+        const uint64_t* a = lhs._cwords();
+        const uint64_t* b = rhs._cwords();
+        for (size_type i = 0; i < lhs._count(); ++i)
+        {
+            if (a[i] != b[i]) return false;
+        }
+        return true;
+    }
+    friend bool operator!=(const Derived& lhs, const Derived& rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+protected:
+    // 清除最后一个字中超出 size() 的位
+    Derived& _trim() noexcept
+    {
+        if (_count() != 0)
+        {
+            _mwords()[_count() - 1] &= _bits_tail_mask(_self().size());
+        }
+        return _self();
+    }
+
+private:
+    Derived& _self() noexcept
+    {
+        return static_cast<Derived&>(*this);
+    }
+    const Derived& _self() const noexcept
+    {
+        return static_cast<const Derived&>(*this);
+    }
+    uint64_t* _mwords() noexcept
+    {
+        return _self()._words();
+    }
+    const uint64_t* _cwords() const noexcept
+    {
+        return _self()._words();
+    }
+    size_type _count() const noexcept
+    {
+        return _self()._word_count();
+    }
+
+    void _fill(uint64_t value) noexcept
+    {
+        uint64_t* w = _mwords();
+        for (size_type i = 0; i < _count(); ++i)
+        {
+            w[i] = value;
+        }
+    }
+
+    template <typename Op>
+    Derived& _apply(const Derived& rhs) noexcept
+    {
+        XUTL_ASSERT(_self().size() == rhs.size());
+        _bits_apply<Op>(_mwords(), rhs._cwords(), _count());
+        return _self();
+    }
+};
+
+template <typename Derived>
+constexpr typename _bitset_ops<Derived>::size_type _bitset_ops<Derived>::npos;
+
+// ************************************************************************************
+// bitset
+// ************************************************************************************
+
+template <size_t N>
+class bitset : public _bitset_ops<bitset<N>>
+{
+    friend class _bitset_ops<bitset<N>>;
+
+public:
+    using size_type = size_t;
+
+    static constexpr size_type word_count =
+        (N + _bits_per_word - 1) / _bits_per_word;
+
+private:
+    uint64_t _data[word_count == 0 ? 1 : word_count];
+
+public:
+    bitset() noexcept : _data()
+    {
+    }
+    // 低位在前，超出 N 的位被丢弃
+    explicit bitset(unsigned long long value) noexcept : _data()
+    {
+        _data[0] = value;
+        this->_trim();
+    }
+
+    constexpr size_type size() const noexcept
+    {
+        return N;
+    }
+
+    // 按字访问，低位在前
+    uint64_t* data() noexcept
+    {
+        return _data;
+    }
+    const uint64_t* data() const noexcept
+    {
+        return _data;
+    }
+
+private:
+    uint64_t* _words() noexcept
+    {
+        return _data;
+    }
+    const uint64_t* _words() const noexcept
+    {
+        return _data;
+    }
+    size_type _word_count() const noexcept
+    {
+        return word_count;
+    }
+};
+
+template <size_t N>
+constexpr typename bitset<N>::size_type bitset<N>::word_count;
+
+// ************************************************************************************
+// dynamic_bitset
+// ************************************************************************************
+
+class dynamic_bitset : public _bitset_ops<dynamic_bitset>
+{
+    friend class _bitset_ops<dynamic_bitset>;
+
+public:
+    using size_type = size_t;
+
+private:
+    vector<uint64_t> _data;
+    size_type _size = 0;
+
+public:
+    dynamic_bitset() = default;
+    explicit dynamic_bitset(size_type n, bool value = false)
+    {
+        resize(n, value);
+    }
+
+    size_type size() const noexcept
+    {
+        return _size;
+    }
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+    size_type word_count() const noexcept
+    {
+        return _data.size();
+    }
+
+    uint64_t* data() noexcept
+    {
+        return _data.data();
+    }
+    const uint64_t* data() const noexcept
+    {
+        return _data.data();
+    }
+
+    // 改变位数，新增的位为 value
+    void resize(size_type n, bool value = false)
+    {
+        const size_type old_size = _size;
+        const size_type old_words = _data.size();
+        const size_type words = (n + _bits_per_word - 1) / _bits_per_word;
+        const uint64_t fill = value ? ~uint64_t(0) : 0;
+        _data.resize_and_overwrite(words, [&](uint64_t* p, size_type count) {
+            for (size_type i = old_words; i < count; ++i)
+            {
+                p[i] = fill;
+            }
+            return count;
+        });
+        _size = n;
+        // 原来最后一个字中未使用的位也属于新增的位
+        if (value && n > old_size && old_size % _bits_per_word != 0)
+        {
+            _data[old_size / _bits_per_word] |= ~_bits_tail_mask(old_size);
+        }
+        _trim();
+    }
+
+    void push_back(bool value)
+    {
+        if (_size % _bits_per_word == 0) _data.push_back(0);
+        ++_size;
+        set(_size - 1, value);
+    }
+
+    void clear() noexcept
+    {
+        _data.clear();
+        _size = 0;
+    }
+
+    void swap(dynamic_bitset& x) noexcept
+    {
+        _data.swap(x._data);
+        xutl::swap(_size, x._size);
+    }
+
+private:
+    uint64_t* _words() noexcept
+    {
+        return _data.data();
+    }
+    const uint64_t* _words() const noexcept
+    {
+        return _data.data();
+    }
+    size_type _word_count() const noexcept
+    {
+        return _data.size();
+    }
+};
+
+inline void swap(dynamic_bitset& lhs, dynamic_bitset& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_BITSET_H_
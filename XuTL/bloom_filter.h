@@ -0,0 +1,307 @@
+#ifndef XUTL_BLOOM_FILTER_H_
+#define XUTL_BLOOM_FILTER_H_
+
+/**
+ * 该文件包含一个模板类 bloom_filter
+ * 它是按缓存行分块的布隆过滤器：每个键的 8 个位都落在同一个 64 字节的块中，
+ * 因此一次查询只访问一个缓存行。块由 8 个 64 位的字组成，
+ * 第 i 个位落在第 i 个字中，位置由键的哈希值乘以第 i 个常数得到，
+ * 于是 8 个字的掩码可以用 AVX2 一次算出、一次比较。
+ * 误判率在构造时给定，据此选择块数
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "exceptdef.h"
+#include "functional.h"
+#include "simd.h"
+#include "span.h"
+#include "vector.h"
+
+namespace xutl
+{
+
+// ************************************************************************************
+// 块和掩码
+// ************************************************************************************
+
+// 每个块的字数，也是每个键设置的位数
+// 每个字只放一个键的一个位，比把 k 个位散布在整个块中容易向量化；
+// 字取 64 位而不是 32 位，是因为同样的位数下 32 位的字更快被填满，误判率更高
+constexpr size_t _bloom_lanes = 8;
+
+struct alignas(64) _bloom_block
+{
+    uint64_t lanes[_bloom_lanes];
+};
+
+// 第 i 个字中的位置为 (h * _bloom_salt[i]) >> 26
+alignas(32) constexpr uint32_t _bloom_salt[_bloom_lanes] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+inline uint64_t _bloom_bit(uint32_t h, size_t i) noexcept
+{
+    return uint64_t(1) << ((h * _bloom_salt[i]) >> 26);
+}
+
+inline bool _bloom_test_scalar(const _bloom_block& b, uint32_t h) noexcept
+{
+    for (size_t i = 0; i < _bloom_lanes; ++i)
+    {
+        const uint64_t bit = _bloom_bit(h, i);
+        if ((b.lanes[i] & bit) == 0) return false;
+    }
+    return true;
+}
+
+inline void _bloom_set_scalar(_bloom_block& b, uint32_t h) noexcept
+{
+    for (size_t i = 0; i < _bloom_lanes; ++i)
+    {
+        b.lanes[i] |= _bloom_bit(h, i);
+    }
+}
+
+#if XUTL_SIMD_X86
+// 前 4 个字和后 4 个字的掩码：8 个位置用 32 位乘法一次算出，
+// 再扩展成 64 位的移位量
+XUTL_TARGET("avx2")
+inline void _bloom_masks(uint32_t h, __m256i& lo, __m256i& hi) noexcept
+{
+    const __m256i salt =
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(_bloom_salt));
+    const __m256i shift = _mm256_srli_epi32(
+        _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(h)), salt), 26);
+    const __m256i one = _mm256_set1_epi64x(1);
+    lo = _mm256_sllv_epi64(
+        one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(shift)));
+    hi = _mm256_sllv_epi64(
+        one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(shift, 1)));
+}
+
+XUTL_TARGET("avx2")
+inline bool _bloom_test_avx2(const _bloom_block& b, uint32_t h) noexcept
+{
+    __m256i lo, hi;
+    _bloom_masks(h, lo, hi);
+    const __m256i* p = reinterpret_cast<const __m256i*>(b.lanes);
+    // testc 在 mask 的每一位都在块中为 1 时返回 1
+    return _mm256_testc_si256(_mm256_load_si256(p), lo) &
+           _mm256_testc_si256(_mm256_load_si256(p + 1), hi);
+}
+
+XUTL_TARGET("avx2")
+inline void _bloom_set_avx2(_bloom_block& b, uint32_t h) noexcept
+{
+    __m256i lo, hi;
+    _bloom_masks(h, lo, hi);
+    __m256i* p = reinterpret_cast<__m256i*>(b.lanes);
+    _mm256_store_si256(p, _mm256_or_si256(_mm256_load_si256(p), lo));
+    _mm256_store_si256(p + 1, _mm256_or_si256(_mm256_load_si256(p + 1), hi));
+}
+#endif
+
+// 每块平均有 load 个键时的误判率
+// 块中的键数近似服从泊松分布，一个块中有 j 个键时，
+// 一个字中某一位仍为 0 的概率为 (63/64)^j
+inline double _bloom_false_positive_rate(double load) noexcept
+{
+    const size_t limit = static_cast<size_t>(load + 12 * std::sqrt(load)) + 16;
+    double poisson = std::exp(-load);
+    double result = 0;
+    for (size_t j = 0; j <= limit; ++j)
+    {
+        if (j > 0) poisson *= load / static_cast<double>(j);
+        const double fill = 1.0 - std::pow(63.0 / 64.0, static_cast<double>(j));
+        result += poisson * std::pow(fill, static_cast<double>(_bloom_lanes));
+    }
+    return result;
+}
+
+// ************************************************************************************
+// bloom_filter
+// ************************************************************************************
+
+template <typename Key, typename Hash = std::hash<Key>>
+class bloom_filter
+{
+public:
+    using key_type = Key;
+    using hasher = Hash;
+    using size_type = size_t;
+
+    // 批量查询时提前多少个键预取它们的块
+    static constexpr size_type prefetch_distance = 8;
+
+private:
+    vector<_bloom_block> _blocks;
+    double _fpr = 0;
+    Hash _hash;
+
+public:
+    // 预计插入 expected 个键，误判率不超过 fpr（0 < fpr < 1）
+    explicit bloom_filter(size_type expected, double fpr = 0.01,
+                          const Hash& hash = Hash()) :
+            _hash(hash)
+    {
+        if (!(fpr > 0 && fpr < 1))
+        {
+            THROW_OUT_OF_RANGE("bloom_filter: fpr must be in (0, 1)");
+        }
+        _choose_shape(expected == 0 ? 1 : expected, fpr);
+    }
+
+    // ********************************************************************************
+    // 插入和查询
+    // ********************************************************************************
+
+    void insert(const key_type& key) noexcept
+    {
+        const uint64_t h = _hash_of(key);
+        _bloom_block& b = _blocks[_block_of(h)];
+#if XUTL_SIMD_X86
+        if (simd_has_avx2())
+        {
+            _bloom_set_avx2(b, static_cast<uint32_t>(h));
+            return;
+        }
+#endif
+        _bloom_set_scalar(b, static_cast<uint32_t>(h));
+    }
+
+    // 返回 false 时 key 一定没有插入过；返回 true 时可能是误判
+    bool contains(const key_type& key) const noexcept
+    {
+        const uint64_t h = _hash_of(key);
+        return _test(_blocks[_block_of(h)], static_cast<uint32_t>(h));
+    }
+
+    // 批量查询，result[i] 为 contains(keys[i])，返回其中 true 的个数
+    // 先算出后面第 prefetch_distance 个键的块并预取，使多次访存重叠
+    size_type contains(span<const key_type> keys, bool* result) const noexcept
+    {
+        const size_type n = keys.size();
+        uint64_t hashes[prefetch_distance];
+        const size_type ahead = n < prefetch_distance ? n : prefetch_distance;
+        for (size_type i = 0; i < ahead; ++i)
+        {
+            hashes[i] = _prefetch(keys[i]);
+        }
+        size_type found = 0;
+        for (size_type i = 0; i < n; ++i)
+        {
+            const uint64_t h = hashes[i % prefetch_distance];
+            if (i + prefetch_distance < n)
+            {
+                hashes[i % prefetch_distance] =
+                    _prefetch(keys[i + prefetch_distance]);
+            }
+            result[i] =
+                _test(_blocks[_block_of(h)], static_cast<uint32_t>(h));
+            found += result[i];
+        }
+        return found;
+    }
+
+    // 清除所有键，不改变大小
+    void clear() noexcept
+    {
+        for (_bloom_block& b : _blocks)
+        {
+            for (uint64_t& w : b.lanes)
+            {
+                w = 0;
+            }
+        }
+    }
+
+    // ********************************************************************************
+    // 参数
+    // ********************************************************************************
+
+    size_type block_count() const noexcept
+    {
+        return _blocks.size();
+    }
+    size_type bit_count() const noexcept
+    {
+        return _blocks.size() * sizeof(_bloom_block) * 8;
+    }
+    // 每个键设置的位数
+    static constexpr size_type hash_count() noexcept
+    {
+        return _bloom_lanes;
+    }
+    // 插入预计个数的键后的理论误判率，不超过构造时给定的值
+    double expected_fpr() const noexcept
+    {
+        return _fpr;
+    }
+
+private:
+    // helper functions
+
+    // 打散后的用户哈希值：高 32 位选块，低 32 位选位
+    uint64_t _hash_of(const key_type& key) const
+    {
+        return _hash_mix(static_cast<uint64_t>(_hash(key)));
+    }
+
+    // 把高 32 位按比例映射到 [0, block_count())，不需要取模
+    size_type _block_of(uint64_t h) const noexcept
+    {
+        return static_cast<size_type>(((h >> 32) * _blocks.size()) >> 32);
+    }
+
+    uint64_t _prefetch(const key_type& key) const
+    {
+        const uint64_t h = _hash_of(key);
+        __builtin_prefetch(&_blocks[_block_of(h)]);
+        return h;
+    }
+
+    bool _test(const _bloom_block& b, uint32_t h) const noexcept
+    {
+#if XUTL_SIMD_X86
+        if (simd_has_avx2()) return _bloom_test_avx2(b, h);
+#endif
+        return _bloom_test_scalar(b, h);
+    }
+
+    // 先按理想布隆过滤器估计位数，再逐步增加块数，
+    // 直到分块后的误判率不超过 fpr
+    void _choose_shape(size_type expected, double fpr)
+    {
+        const double ln2 = std::log(2.0);
+        const double bits =
+            -static_cast<double>(expected) * std::log(fpr) / (ln2 * ln2);
+        const double block_bits = sizeof(_bloom_block) * 8;
+        double blocks = std::ceil(bits / block_bits);
+        if (blocks < 1) blocks = 1;
+        for (;;)
+        {
+            if (blocks > double(uint32_t(-1)))
+            {
+                THROW_LENGTH_ERROR("bloom_filter: too many keys");
+            }
+            _fpr = _bloom_false_positive_rate(
+                static_cast<double>(expected) / blocks);
+            if (_fpr <= fpr) break;
+            blocks = std::ceil(blocks * 1.05);
+        }
+        _blocks = vector<_bloom_block>(static_cast<size_type>(blocks),
+                                       _bloom_block());
+    }
+};
+
+template <typename Key, typename Hash>
+constexpr typename bloom_filter<Key, Hash>::size_type
+    bloom_filter<Key, Hash>::prefetch_distance;
+
+}  // namespace xutl
+
+#endif  // XUTL_BLOOM_FILTER_H_
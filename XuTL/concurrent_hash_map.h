@@ -0,0 +1,1037 @@
+#ifndef XUTL_CONCURRENT_HASH_MAP_H_
+#define XUTL_CONCURRENT_HASH_MAP_H_
+
+/**
+ * 该文件包含一个模板类 concurrent_hash_map
+ * 它是一个分片的开放寻址哈希表，写操作按分片加锁，读操作不加锁
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+
+#include "construct.h"
+#include "exceptdef.h"
+#include "functional.h"
+#include "memory.h"
+#include "trace.h"
+#include "type_traits.h"
+#include "utils.h"
+
+namespace xutl
+{
+
+// ************************************************************************************
+// _epoch_domain
+// 基于纪元的内存回收（epoch-based reclamation）
+// 无锁读者在访问共享数据前公布自己看到的全局纪元，写者把被替换下来的内存
+// 标记为「在纪元 e 退休」，只有当所有活跃读者公布的纪元都大于 e 时才真正释放
+// ************************************************************************************
+
+class _epoch_domain
+{
+public:
+    // 每个线程一条记录，独占一个缓存行；epoch 为 0 表示该线程不在读临界区内
+    struct alignas(cache_line_size) record
+    {
+        std::atomic<uint64_t> epoch;
+        std::atomic<bool> in_use;
+        record* next;
+    };
+
+    static _epoch_domain& instance()
+    {
+        static _epoch_domain domain;
+        return domain;
+    }
+
+    // 当前线程的记录，线程退出时归还以供复用
+    record* local_record()
+    {
+        thread_local _record_holder holder(*this);
+        return holder.rec;
+    }
+
+    // 进入读临界区，之后读到的共享指针在离开前都不会被释放
+    void enter(record* rec) noexcept
+    {
+        rec->epoch.store(_global.load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    void leave(record* rec) noexcept
+    {
+        rec->epoch.store(0, std::memory_order_release);
+    }
+
+    // 推进全局纪元，返回推进前的值，即刚被替换下来的内存的退休纪元
+    uint64_t advance() noexcept
+    {
+        uint64_t e = _global.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return e;
+    }
+
+    // 所有活跃读者中最小的纪元，没有活跃读者时返回 UINT64_MAX
+    uint64_t min_active() const noexcept
+    {
+        uint64_t result = UINT64_MAX;
+        for (record* r = _head.load(std::memory_order_acquire); r != nullptr;
+             r = r->next)
+        {
+            uint64_t e = r->epoch.load(std::memory_order_seq_cst);
+            if (e != 0 && e < result) result = e;
+        }
+        return result;
+    }
+
+private:
+    struct _record_holder
+    {
+        record* rec;
+
+        explicit _record_holder(_epoch_domain& domain) :
+                rec(domain._acquire_record())
+        {
+        }
+        ~_record_holder()
+        {
+            rec->epoch.store(0, std::memory_order_release);
+            rec->in_use.store(false, std::memory_order_release);
+        }
+    };
+
+    // 记录只增不减，数量不超过同时存在过的线程数，因此不回收
+    record* _acquire_record()
+    {
+        for (record* r = _head.load(std::memory_order_acquire); r != nullptr;
+             r = r->next)
+        {
+            bool expected = false;
+            if (!r->in_use.load(std::memory_order_relaxed) &&
+                r->in_use.compare_exchange_strong(expected, true))
+            {
+                return r;
+            }
+        }
+        record* r = allocator<record>::allocate();
+        xutl::construct(xutl::address_of(r->epoch), uint64_t(0));
+        xutl::construct(xutl::address_of(r->in_use), true);
+        r->next = _head.load(std::memory_order_relaxed);
+        while (!_head.compare_exchange_weak(r->next, r,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed))
+        {
+        }
+        return r;
+    }
+
+    _epoch_domain() : _global(1), _head(nullptr)
+    {
+    }
+
+    std::atomic<uint64_t> _global;
+    std::atomic<record*> _head;
+};
+
+// 读临界区的 RAII 守卫
+class _epoch_guard
+{
+public:
+    _epoch_guard() :
+            _domain(_epoch_domain::instance()), _rec(_domain.local_record())
+    {
+        _domain.enter(_rec);
+    }
+    ~_epoch_guard()
+    {
+        _domain.leave(_rec);
+    }
+
+    _epoch_guard(const _epoch_guard&) = delete;
+    _epoch_guard& operator=(const _epoch_guard&) = delete;
+
+private:
+    _epoch_domain& _domain;
+    _epoch_domain::record* _rec;
+};
+
+// ************************************************************************************
+// seqlock 保护的数据的读写
+// 读者校验失败时会丢弃读到的数据，但读写同时发生时数据本身仍然必须原子地访问，
+// 否则就是数据竞争。因此无锁读的键和值按不超过其对齐的单元，逐个单元地用
+// relaxed 原子操作读写
+// ************************************************************************************
+
+template <typename U>
+struct _seq_unit
+{
+    using type = typename conditional<
+        sizeof(U) % 8 == 0 && alignof(U) % 8 == 0, uint64_t,
+        typename conditional<
+            sizeof(U) % 4 == 0 && alignof(U) % 4 == 0, uint32_t,
+            typename conditional<sizeof(U) % 2 == 0 && alignof(U) % 2 == 0,
+                                 uint16_t, uint8_t>::type>::type>::type;
+};
+
+// 把 from 处的一个 U 读到 to，from 可能正被其它线程以 _seq_store 写入
+template <typename U>
+inline void _seq_load(void* to, const void* from) noexcept
+{
+    using unit = typename _seq_unit<U>::type;
+    unit* d = static_cast<unit*>(to);
+    const unit* s = static_cast<const unit*>(from);
+    for (size_t i = 0; i < sizeof(U) / sizeof(unit); ++i)
+    {
+        d[i] = __atomic_load_n(s + i, __ATOMIC_RELAXED);
+    }
+}
+
+// 把 from 处的一个 U 写到 to，to 可能正被其它线程以 _seq_load 读取
+template <typename U>
+inline void _seq_store(void* to, const void* from) noexcept
+{
+    using unit = typename _seq_unit<U>::type;
+    unit* d = static_cast<unit*>(to);
+    const unit* s = static_cast<const unit*>(from);
+    for (size_t i = 0; i < sizeof(U) / sizeof(unit); ++i)
+    {
+        __atomic_store_n(d + i, s[i], __ATOMIC_RELAXED);
+    }
+}
+
+// concurrent_hash_map 类
+// 键空间按哈希值的高位划分为若干分片，每个分片是一张线性探测的开放寻址表：
+//   写操作（insert_or_assign、erase 等）持有本分片的互斥锁，
+//   并在修改槽位前后把分片的序号 seq 变为奇数/偶数（seqlock）；
+//   读操作（find、contains）不加锁，读取前后比较 seq，不一致就重试。
+// 扩容只发生在单个分片内，并且是渐进的：先发布一张空的新表，旧表留作
+// 「正在迁出」的表，之后本分片的每次写操作顺带把旧表中的若干槽位迁到新表，
+// 读者和写者在迁完之前都会先查新表、再查旧表。旧表迁完后交给 _epoch_domain
+// 延迟释放，因此扩容既不阻塞读者，也不会让某一次写操作独自搬移整个分片。
+//
+// 无锁读要求 Key 和 T 都是 trivially copyable 的（读到的可能是正被改写的
+// 字节，校验失败后会丢弃）；否则 find 退化为持有分片锁读取。
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename KeyEqual = xutl::equal_to<Key>>
+class concurrent_hash_map
+{
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using size_type = size_t;
+
+    // 是否可以无锁读
+    using optimistic_read =
+        integral_constant<bool, xutl::is_trivially_copyable<Key>::value &&
+                                    xutl::is_trivially_copyable<T>::value>;
+
+private:
+    // 槽位：hash 为 0 表示空槽，为 _moved 表示元素已经迁到新表（只出现在
+    // 正在迁出的旧表中），否则为键的哈希值（最低位恒为 1）
+    // hash 可能被无锁读者同时读取，因此是原子的；键和值见 _seq_load/_seq_store
+    struct slot
+    {
+        std::atomic<size_type> hash;
+        typename aligned_storage<sizeof(Key), alignof(Key)>::type key;
+        typename aligned_storage<sizeof(T), alignof(T)>::type value;
+
+        Key* key_ptr() noexcept
+        {
+            return reinterpret_cast<Key*>(&key);
+        }
+        T* value_ptr() noexcept
+        {
+            return reinterpret_cast<T*>(&value);
+        }
+    };
+
+    // 表一旦发布就只有槽位内容会被修改，mask 和 slots 不变
+    struct table
+    {
+        size_type mask;
+        slot* slots;
+    };
+
+    struct alignas(cache_line_size) shard
+    {
+        std::mutex lock;              // 写者互斥
+        std::atomic<uint64_t> seq;    // 奇数表示正在修改槽位
+        std::atomic<table*> tab;      // 当前的表，新元素总是插入这里
+        std::atomic<table*> old;      // 正在迁出的旧表，没有在扩容时为 nullptr
+        size_type migrated;           // 旧表中下标小于它的槽位都已迁出，持锁访问
+        std::atomic<size_type> size;  // 元素个数，包括还在旧表中的元素
+    };
+
+    // 已经迁到新表的槽位，偶数，不会与键的哈希值相同
+    static constexpr size_type _moved = 2;
+    // 扩容期间每次写操作顺带迁移的旧表槽位数
+    static constexpr size_type _migrate_step = 16;
+
+    // 在纪元 epoch 退休、等待释放的旧表
+    struct retired
+    {
+        table* tab;
+        uint64_t epoch;
+        retired* next;
+    };
+
+    using slot_allocator = allocator<slot>;
+    using table_allocator = allocator<table>;
+    using shard_allocator = allocator<shard>;
+    using retired_allocator = allocator<retired>;
+
+    // 数据成员
+
+    shard* _shards;
+    size_type _shard_count;
+    unsigned _shard_shift;  // 分片下标 = 混合后的哈希值 >> _shard_shift
+    hasher _hash;
+    key_equal _equal;
+    std::mutex _retired_lock;
+    retired* _retired;
+
+public:
+    // ********************************************************************************
+    // 构造函数/析构函数
+    // ********************************************************************************
+
+    // expected 为预计的元素个数，shard_count 向上取整为 2 的幂
+    explicit concurrent_hash_map(size_type expected = 0,
+                                 size_type shard_count = 64,
+                                 const hasher& hash = hasher(),
+                                 const key_equal& equal = key_equal());
+
+    concurrent_hash_map(const concurrent_hash_map&) = delete;
+    concurrent_hash_map& operator=(const concurrent_hash_map&) = delete;
+
+    // 析构时不允许有其它线程仍在访问
+    ~concurrent_hash_map();
+
+    // ********************************************************************************
+    // 容量相关
+    // 并发修改时 size() 和 empty() 只是一个近似值
+    // ********************************************************************************
+
+    size_type size() const noexcept
+    {
+        size_type n = 0;
+        for (size_type i = 0; i < _shard_count; ++i)
+        {
+            n += _shards[i].size.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+    size_type shard_count() const noexcept
+    {
+        return _shard_count;
+    }
+
+    // 让每个分片都能不扩容地容纳 n / shard_count() 个元素
+    void reserve(size_type n);
+
+    // ********************************************************************************
+    // 查找
+    // ********************************************************************************
+
+    // 找到 key 时以 const T& 调用 visitor 并返回 true
+    // 无锁读时 visitor 拿到的是校验过的副本；否则 visitor 在持有分片锁时被调用，
+    // 不可以再访问本容器
+    template <typename Visitor>
+    bool find(const key_type& key, Visitor visitor) const;
+
+    // 找到 key 时把值拷贝到 value 并返回 true
+    bool find(const key_type& key, mapped_type& value) const
+    {
+        return find(key, [&value](const mapped_type& v) { value = v; });
+    }
+
+    bool contains(const key_type& key) const
+    {
+        return find(key, [](const mapped_type&) {});
+    }
+
+    // 依次持有每个分片的锁，对其中每个元素调用 visitor(key, value)
+    // 不是整个容器的快照：已经访问过的分片在之后仍可能被修改；
+    // visitor 不可以再访问本容器
+    template <typename Visitor>
+    void for_each(Visitor visitor) const;
+
+    // ********************************************************************************
+    // 修改
+    // ********************************************************************************
+
+    // 插入 key 或给已有的 key 赋新值，插入了新元素时返回 true
+    template <typename M>
+    bool insert_or_assign(const key_type& key, M&& obj)
+    {
+        return _insert_or_assign(key, xutl::forward<M>(obj));
+    }
+    template <typename M>
+    bool insert_or_assign(key_type&& key, M&& obj)
+    {
+        return _insert_or_assign(xutl::move(key), xutl::forward<M>(obj));
+    }
+
+    // 移除 key，移除了元素时返回 true
+    bool erase(const key_type& key);
+
+    // 析构所有元素，不释放表
+    void clear();
+
+private:
+    // helper functions
+
+    // 打散后的用户哈希值，并保证非 0
+    size_type _hash_of(const key_type& key) const
+    {
+        const uint64_t h = _hash_mix(static_cast<uint64_t>(_hash(key)));
+        return static_cast<size_type>(h | 1);
+    }
+
+    shard& _shard_of(size_type h) const noexcept
+    {
+        return _shards[_shard_shift >= 64 ? 0 : (h >> _shard_shift)];
+    }
+
+    // 分片内下标只用哈希值的低位，与选择分片的高位无关
+    static size_type _bucket_of(size_type h, size_type mask) noexcept
+    {
+        return (h >> 1) & mask;
+    }
+
+    // 槽位中是否有元素（既不是空槽，也没有迁走）
+    static bool _is_live(size_type h) noexcept
+    {
+        return (h & 1) != 0;
+    }
+
+    // 装载因子上限 3/4
+    static size_type _threshold(size_type capacity) noexcept
+    {
+        return capacity - capacity / 4;
+    }
+
+    static table* _create_table(size_type capacity);
+    static void _destroy_table(table* t) noexcept;
+
+    // 在 t 中线性探测查找 key 的哈希值为 h 的元素，把值读到 value_copy
+    // 不持有锁，读到的数据须由调用者用 seq 校验
+    bool _optimistic_probe(const table* t, size_type h, const key_type& key,
+                           void* value_copy) const;
+
+    // 以下函数都要求持有 s.lock
+
+    // 查找 key 所在的槽位，找不到时返回 nullptr
+    slot* _locked_find(table* t, size_type h, const key_type& key) const;
+    // 在当前的表和正在迁出的旧表中查找 key；key 还在旧表中时先把它迁到当前的表，
+    // 因此返回的槽位总在当前的表中
+    slot* _find_for_write(shard& s, size_type h, const key_type& key);
+    // 把 s 的表扩容到至少能容纳 n 个元素，新表先是空的，元素由 _migrate 迁入
+    void _grow(shard& s, size_type n);
+    // 把旧表中接下来的至多 steps 个槽位迁到当前的表，迁完后回收旧表
+    void _migrate(shard& s, size_type steps);
+    // 把旧表的槽位 from 中的元素搬到表 t，返回新的槽位，要求处于写区间内
+    slot& _migrate_slot(table* t, slot& from);
+
+    // seqlock 写端：修改槽位前后调用
+    static void _write_begin(shard& s) noexcept
+    {
+        s.seq.store(s.seq.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    static void _write_end(shard& s) noexcept
+    {
+        s.seq.store(s.seq.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+    }
+
+    // 写入槽位的键和值：可以无锁读时先在栈上构造好，再逐个单元原子地写入；
+    // 否则没有读者会同时访问槽位，直接在槽位中构造
+    template <typename K, typename M>
+    static void _construct_slot(slot& sl, K&& key, M&& obj, xutl::true_type);
+    template <typename K, typename M>
+    static void _construct_slot(slot& sl, K&& key, M&& obj, xutl::false_type);
+    static void _assign_value(slot& sl, T&& value, xutl::true_type) noexcept
+    {
+        _seq_store<T>(&sl.value, xutl::address_of(value));
+    }
+    static void _assign_value(slot& sl, T&& value, xutl::false_type)
+    {
+        *sl.value_ptr() = xutl::move(value);
+    }
+    // 把 from 的键和值搬到空槽 to，from 中的元素由调用者析构
+    static void _move_slot(slot& to, slot& from, xutl::true_type) noexcept
+    {
+        _seq_store<Key>(&to.key, &from.key);
+        _seq_store<T>(&to.value, &from.value);
+    }
+    static void _move_slot(slot& to, slot& from, xutl::false_type);
+
+    template <typename Visitor>
+    bool _find(shard& s, size_type h, const key_type& key, Visitor& visitor,
+               xutl::true_type) const;
+    template <typename Visitor>
+    bool _find(shard& s, size_type h, const key_type& key, Visitor& visitor,
+               xutl::false_type) const;
+
+    template <typename K, typename M>
+    bool _insert_or_assign(K&& key, M&& obj);
+
+    // 析构 t 中的所有元素并把槽位清空，要求处于写区间内
+    static void _destroy_elements(table* t) noexcept;
+
+    // 把旧表交给纪元回收，并顺带释放已经安全的旧表
+    void _retire(table* t);
+    void _reclaim(uint64_t min_active);
+};
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+constexpr typename concurrent_hash_map<Key, T, Hash, KeyEqual>::size_type
+    concurrent_hash_map<Key, T, Hash, KeyEqual>::_moved;
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+constexpr typename concurrent_hash_map<Key, T, Hash, KeyEqual>::size_type
+    concurrent_hash_map<Key, T, Hash, KeyEqual>::_migrate_step;
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+concurrent_hash_map<Key, T, Hash, KeyEqual>::concurrent_hash_map(
+    size_type expected, size_type shard_count, const hasher& hash,
+    const key_equal& equal) :
+        _shards(nullptr),
+        _shard_count(1),
+        _shard_shift(64),
+        _hash(hash),
+        _equal(equal),
+        _retired(nullptr)
+{
+    while (_shard_count < shard_count)
+    {
+        _shard_count <<= 1;
+        --_shard_shift;
+    }
+    size_type per_shard = expected / _shard_count + 1;
+    size_type capacity = 8;
+    while (_threshold(capacity) < per_shard)
+    {
+        capacity <<= 1;
+    }
+    _shards = shard_allocator::allocate(_shard_count);
+    size_type i = 0;
+    try
+    {
+        for (; i < _shard_count; ++i)
+        {
+            shard& s = _shards[i];
+            xutl::construct(xutl::address_of(s.lock));
+            xutl::construct(xutl::address_of(s.seq), uint64_t(0));
+            xutl::construct(xutl::address_of(s.tab), _create_table(capacity));
+            xutl::construct(xutl::address_of(s.old), nullptr);
+            s.migrated = 0;
+            xutl::construct(xutl::address_of(s.size), size_type(0));
+        }
+    }
+    catch (...)
+    {
+        while (i-- > 0)
+        {
+            _destroy_table(_shards[i].tab.load(std::memory_order_relaxed));
+        }
+        shard_allocator::deallocate(_shards, _shard_count);
+        throw;
+    }
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+concurrent_hash_map<Key, T, Hash, KeyEqual>::~concurrent_hash_map()
+{
+    // clear 同时回收了正在迁出的旧表
+    clear();
+    for (size_type i = 0; i < _shard_count; ++i)
+    {
+        _destroy_table(_shards[i].tab.load(std::memory_order_relaxed));
+        xutl::destroy(xutl::address_of(_shards[i].lock));
+    }
+    shard_allocator::deallocate(_shards, _shard_count);
+    _reclaim(UINT64_MAX);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+typename concurrent_hash_map<Key, T, Hash, KeyEqual>::table*
+concurrent_hash_map<Key, T, Hash, KeyEqual>::_create_table(size_type capacity)
+{
+    table* t = table_allocator::allocate();
+    try
+    {
+        t->slots = slot_allocator::allocate(capacity);
+    }
+    catch (...)
+    {
+        table_allocator::deallocate(t);
+        throw;
+    }
+    t->mask = capacity - 1;
+    for (size_type i = 0; i < capacity; ++i)
+    {
+        xutl::construct(xutl::address_of(t->slots[i].hash), size_type(0));
+    }
+    return t;
+}
+
+// 只释放内存，元素由调用方负责析构
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void concurrent_hash_map<Key, T, Hash, KeyEqual>::_destroy_table(
+    table* t) noexcept
+{
+    slot_allocator::deallocate(t->slots, t->mask + 1);
+    table_allocator::deallocate(t);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+typename concurrent_hash_map<Key, T, Hash, KeyEqual>::slot*
+concurrent_hash_map<Key, T, Hash, KeyEqual>::_locked_find(
+    table* t, size_type h, const key_type& key) const
+{
+    for (size_type i = _bucket_of(h, t->mask);; i = (i + 1) & t->mask)
+    {
+        slot& sl = t->slots[i];
+        const size_type sh = sl.hash.load(std::memory_order_relaxed);
+        if (sh == 0) return nullptr;
+        if (sh == h && _equal(*sl.key_ptr(), key)) return &sl;
+    }
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+typename concurrent_hash_map<Key, T, Hash, KeyEqual>::slot*
+concurrent_hash_map<Key, T, Hash, KeyEqual>::_find_for_write(
+    shard& s, size_type h, const key_type& key)
+{
+    table* t = s.tab.load(std::memory_order_relaxed);
+    slot* sl = _locked_find(t, h, key);
+    table* old = s.old.load(std::memory_order_relaxed);
+    if (sl != nullptr || old == nullptr) return sl;
+    slot* from = _locked_find(old, h, key);
+    if (from == nullptr) return nullptr;
+    _write_begin(s);
+    try
+    {
+        sl = &_migrate_slot(t, *from);
+    }
+    catch (...)
+    {
+        _write_end(s);
+        throw;
+    }
+    _write_end(s);
+    return sl;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+template <typename Visitor>
+bool concurrent_hash_map<Key, T, Hash, KeyEqual>::find(const key_type& key,
+                                                       Visitor visitor) const
+{
+    size_type h = _hash_of(key);
+    return _find(_shard_of(h), h, key, visitor, optimistic_read());
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+bool concurrent_hash_map<Key, T, Hash, KeyEqual>::_optimistic_probe(
+    const table* t, size_type h, const key_type& key, void* value_copy) const
+{
+    typename aligned_storage<sizeof(Key), alignof(Key)>::type key_copy;
+    // 读到的可能是不一致的数据，最多探测整张表，避免死循环
+    size_type i = _bucket_of(h, t->mask);
+    for (size_type n = 0; n <= t->mask; ++n, i = (i + 1) & t->mask)
+    {
+        const slot& sl = t->slots[i];
+        const size_type sh = sl.hash.load(std::memory_order_relaxed);
+        if (sh == 0) return false;
+        if (sh != h) continue;
+        _seq_load<Key>(&key_copy, &sl.key);
+        if (_equal(*reinterpret_cast<Key*>(&key_copy), key))
+        {
+            _seq_load<T>(value_copy, &sl.value);
+            return true;
+        }
+    }
+    return false;
+}
+
+// 无锁读：在 seq 的两次读取之间把键和值拷贝出来，seq 不变才算读到了一致的快照
+// 扩容期间元素可能在新表，也可能还在旧表；同一个元素的迁移处于写区间内，
+// 因此 seq 不变时它恰好在两张表之一中
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+template <typename Visitor>
+bool concurrent_hash_map<Key, T, Hash, KeyEqual>::_find(
+    shard& s, size_type h, const key_type& key, Visitor& visitor,
+    xutl::true_type) const
+{
+    typename aligned_storage<sizeof(T), alignof(T)>::type value_copy;
+    _epoch_guard guard;
+    for (;;)
+    {
+        uint64_t seq = s.seq.load(std::memory_order_acquire);
+        if (seq & 1) continue;
+        const table* t = s.tab.load(std::memory_order_acquire);
+        const table* old = s.old.load(std::memory_order_acquire);
+        bool found = _optimistic_probe(t, h, key, &value_copy) ||
+                     (old != nullptr &&
+                      _optimistic_probe(old, h, key, &value_copy));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) != seq) continue;
+        if (found)
+        {
+            visitor(*reinterpret_cast<const T*>(&value_copy));
+        }
+        return found;
+    }
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+template <typename Visitor>
+bool concurrent_hash_map<Key, T, Hash, KeyEqual>::_find(
+    shard& s, size_type h, const key_type& key, Visitor& visitor,
+    xutl::false_type) const
+{
+    std::lock_guard<std::mutex> lock(s.lock);
+    slot* sl = _locked_find(s.tab.load(std::memory_order_relaxed), h, key);
+    table* old = s.old.load(std::memory_order_relaxed);
+    if (sl == nullptr && old != nullptr) sl = _locked_find(old, h, key);
+    if (sl == nullptr) return false;
+    visitor(static_cast<const T&>(*sl->value_ptr()));
+    return true;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+template <typename K, typename M>
+void concurrent_hash_map<Key, T, Hash, KeyEqual>::_construct_slot(
+    slot& sl, K&& key, M&& obj, xutl::true_type)
+{
+    typename aligned_storage<sizeof(Key), alignof(Key)>::type k;
+    typename aligned_storage<sizeof(T), alignof(T)>::type v;
+    xutl::construct(reinterpret_cast<Key*>(&k), xutl::forward<K>(key));
+    xutl::construct(reinterpret_cast<T*>(&v), xutl::forward<M>(obj));
+    _seq_store<Key>(&sl.key, &k);
+    _seq_store<T>(&sl.value, &v);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+template <typename K, typename M>
+void concurrent_hash_map<Key, T, Hash, KeyEqual>::_construct_slot(
+    slot& sl, K&& key, M&& obj, xutl::false_type)
+{
+    xutl::construct(sl.key_ptr(), xutl::forward<K>(key));
+    try
+    {
+        xutl::construct(sl.value_ptr(), xutl::forward<M>(obj));
+    }
+    catch (...)
+    {
+        xutl::destroy(sl.key_ptr());
+        throw;
+    }
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void concurrent_hash_map<Key, T, Hash, KeyEqual>::_move_slot(
+    slot& to, slot& from, xutl::false_type)
+{
+    _construct_slot(to, xutl::move_if_noexcept(*from.key_ptr()),
+                    xutl::move_if_noexcept(*from.value_ptr()),
+                    xutl::false_type());
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+template <typename K, typename M>
+bool concurrent_hash_map<Key, T, Hash, KeyEqual>::_insert_or_assign(K&& key,
+                                                                    M&& obj)
+{
+    size_type h = _hash_of(key);
+    shard& s = _shard_of(h);
+    std::lock_guard<std::mutex> lock(s.lock);
+    _migrate(s, _migrate_step);
+    slot* sl = _find_for_write(s, h, key);
+    if (sl != nullptr)
+    {
+        // 先构造好新值，赋值期间读者会重试
+        T tmp(xutl::forward<M>(obj));
+        _write_begin(s);
+        _assign_value(*sl, xutl::move(tmp), optimistic_read());
+        _write_end(s);
+        return false;
+    }
+    size_type n = s.size.load(std::memory_order_relaxed);
+    table* t = s.tab.load(std::memory_order_relaxed);
+    if (n + 1 > _threshold(t->mask + 1))
+    {
+        _grow(s, n + 1);
+        t = s.tab.load(std::memory_order_relaxed);
+    }
+    size_type i = _bucket_of(h, t->mask);
+    while (t->slots[i].hash.load(std::memory_order_relaxed) != 0)
+    {
+        i = (i + 1) & t->mask;
+    }
+    slot& target = t->slots[i];
+    // 槽位在 hash 写入之前对读者不可见，因此构造不必处于写区间内
+    _construct_slot(target, xutl::forward<K>(key), xutl::forward<M>(obj),
+                    optimistic_read());
+    _write_begin(s);
+    target.hash.store(h, std::memory_order_relaxed);
+    _write_end(s);
+    s.size.store(n + 1, std::memory_order_relaxed);
+    return true;
+}
+
+// 线性探测的后移删除：把后续探测链上的元素前移填补空洞，不留墓碑
+// 要删除的元素总是先迁到当前的表，旧表中只会出现 _moved 标记
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+bool concurrent_hash_map<Key, T, Hash, KeyEqual>::erase(const key_type& key)
+{
+    size_type h = _hash_of(key);
+    shard& s = _shard_of(h);
+    std::lock_guard<std::mutex> lock(s.lock);
+    _migrate(s, _migrate_step);
+    slot* sl = _find_for_write(s, h, key);
+    if (sl == nullptr) return false;
+    table* t = s.tab.load(std::memory_order_relaxed);
+    size_type hole = static_cast<size_type>(sl - t->slots);
+    _write_begin(s);
+    xutl::destroy(sl->key_ptr());
+    xutl::destroy(sl->value_ptr());
+    for (size_type i = (hole + 1) & t->mask;; i = (i + 1) & t->mask)
+    {
+        slot& next = t->slots[i];
+        const size_type nh = next.hash.load(std::memory_order_relaxed);
+        if (nh == 0) break;
+        size_type home = _bucket_of(nh, t->mask);
+        // home 不在 (hole, i] 之间时，next 可以前移到 hole
+        if (((i - home) & t->mask) >= ((i - hole) & t->mask))
+        {
+            slot& dst = t->slots[hole];
+            _move_slot(dst, next, optimistic_read());
+            dst.hash.store(nh, std::memory_order_relaxed);
+            xutl::destroy(next.key_ptr());
+            xutl::destroy(next.value_ptr());
+            hole = i;
+        }
+    }
+    t->slots[hole].hash.store(0, std::memory_order_relaxed);
+    _write_end(s);
+    s.size.store(s.size.load(std::memory_order_relaxed) - 1,
+                 std::memory_order_relaxed);
+    return true;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+template <typename Visitor>
+void concurrent_hash_map<Key, T, Hash, KeyEqual>::for_each(
+    Visitor visitor) const
+{
+    for (size_type k = 0; k < _shard_count; ++k)
+    {
+        shard& s = _shards[k];
+        std::lock_guard<std::mutex> lock(s.lock);
+        table* tables[2] = {s.tab.load(std::memory_order_relaxed),
+                            s.old.load(std::memory_order_relaxed)};
+        for (table* t : tables)
+        {
+            if (t == nullptr) continue;
+            for (size_type i = 0; i <= t->mask; ++i)
+            {
+                slot& sl = t->slots[i];
+                if (_is_live(sl.hash.load(std::memory_order_relaxed)))
+                {
+                    const key_type& key = *sl.key_ptr();
+                    const mapped_type& value = *sl.value_ptr();
+                    visitor(key, value);
+                }
+            }
+        }
+    }
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void concurrent_hash_map<Key, T, Hash, KeyEqual>::_destroy_elements(
+    table* t) noexcept
+{
+    for (size_type i = 0; i <= t->mask; ++i)
+    {
+        slot& sl = t->slots[i];
+        if (_is_live(sl.hash.load(std::memory_order_relaxed)))
+        {
+            xutl::destroy(sl.key_ptr());
+            xutl::destroy(sl.value_ptr());
+        }
+        sl.hash.store(0, std::memory_order_relaxed);
+    }
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void concurrent_hash_map<Key, T, Hash, KeyEqual>::clear()
+{
+    for (size_type k = 0; k < _shard_count; ++k)
+    {
+        shard& s = _shards[k];
+        std::lock_guard<std::mutex> lock(s.lock);
+        table* old = s.old.load(std::memory_order_relaxed);
+        _write_begin(s);
+        _destroy_elements(s.tab.load(std::memory_order_relaxed));
+        if (old != nullptr)
+        {
+            _destroy_elements(old);
+            s.old.store(nullptr, std::memory_order_relaxed);
+        }
+        _write_end(s);
+        s.size.store(0, std::memory_order_relaxed);
+        if (old != nullptr) _retire(old);
+    }
+}
+
+// 预留的空间一次迁完，之后的写操作不再需要顺带迁移
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void concurrent_hash_map<Key, T, Hash, KeyEqual>::reserve(size_type n)
+{
+    size_type per_shard = n / _shard_count + 1;
+    for (size_type k = 0; k < _shard_count; ++k)
+    {
+        shard& s = _shards[k];
+        std::lock_guard<std::mutex> lock(s.lock);
+        _grow(s, per_shard);
+        _migrate(s, size_type(-1));
+    }
+}
+
+// 发布一张空的新表，当前的表成为正在迁出的旧表
+// 新表的容量按全部元素计算，迁移过程中不需要再扩容；
+// 上一次扩容还没有迁完时先把它迁完，任何时候每个分片最多只有一张旧表
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void concurrent_hash_map<Key, T, Hash, KeyEqual>::_grow(shard& s, size_type n)
+{
+    table* old_table = s.tab.load(std::memory_order_relaxed);
+    size_type capacity = old_table->mask + 1;
+    if (_threshold(capacity) >= n) return;
+    while (_threshold(capacity) < n)
+    {
+        if (capacity > slot_allocator::max_size() / 2)
+        {
+            THROW_LENGTH_ERROR("concurrent_hash_map<Key, T> is too large");
+        }
+        capacity <<= 1;
+    }
+    _migrate(s, size_type(-1));
+    XUTL_TRACE_SCOPE("concurrent_hash_map::rehash", this, old_table->mask + 1,
+                     capacity,
+                     s.size.load(std::memory_order_relaxed) *
+                         (sizeof(Key) + sizeof(T)));
+    table* new_table = _create_table(capacity);
+    _write_begin(s);
+    s.old.store(old_table, std::memory_order_release);
+    s.tab.store(new_table, std::memory_order_release);
+    s.migrated = 0;
+    _write_end(s);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void concurrent_hash_map<Key, T, Hash, KeyEqual>::_migrate(shard& s,
+                                                           size_type steps)
+{
+    table* old = s.old.load(std::memory_order_relaxed);
+    if (old == nullptr) return;
+    table* t = s.tab.load(std::memory_order_relaxed);
+    const size_type end =
+        steps > old->mask + 1 - s.migrated ? old->mask + 1
+                                           : s.migrated + steps;
+    _write_begin(s);
+    try
+    {
+        for (; s.migrated < end; ++s.migrated)
+        {
+            slot& from = old->slots[s.migrated];
+            if (_is_live(from.hash.load(std::memory_order_relaxed)))
+            {
+                _migrate_slot(t, from);
+            }
+        }
+    }
+    catch (...)
+    {
+        _write_end(s);
+        throw;
+    }
+    const bool done = s.migrated > old->mask;
+    if (done) s.old.store(nullptr, std::memory_order_relaxed);
+    _write_end(s);
+    if (done) _retire(old);
+}
+
+// 可以无锁读的类型是 trivially copyable 的，搬移后旧槽位仍然完整，
+// 读者在校验失败之前看到的始终是有效的字节
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+typename concurrent_hash_map<Key, T, Hash, KeyEqual>::slot&
+concurrent_hash_map<Key, T, Hash, KeyEqual>::_migrate_slot(table* t,
+                                                           slot& from)
+{
+    const size_type h = from.hash.load(std::memory_order_relaxed);
+    size_type j = _bucket_of(h, t->mask);
+    while (t->slots[j].hash.load(std::memory_order_relaxed) != 0)
+    {
+        j = (j + 1) & t->mask;
+    }
+    slot& to = t->slots[j];
+    _move_slot(to, from, optimistic_read());
+    to.hash.store(h, std::memory_order_relaxed);
+    from.hash.store(_moved, std::memory_order_relaxed);
+    xutl::destroy(from.key_ptr());
+    xutl::destroy(from.value_ptr());
+    return to;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void concurrent_hash_map<Key, T, Hash, KeyEqual>::_retire(table* t)
+{
+    _epoch_domain& domain = _epoch_domain::instance();
+    retired* r = retired_allocator::allocate();
+    r->tab = t;
+    r->epoch = domain.advance();
+    std::lock_guard<std::mutex> lock(_retired_lock);
+    r->next = _retired;
+    _retired = r;
+    _reclaim(domain.min_active());
+}
+
+// 释放所有退休纪元小于 min_active 的旧表，要求持有 _retired_lock 或已无并发访问
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void concurrent_hash_map<Key, T, Hash, KeyEqual>::_reclaim(uint64_t min_active)
+{
+    retired** link = &_retired;
+    while (*link != nullptr)
+    {
+        retired* r = *link;
+        if (r->epoch < min_active)
+        {
+            *link = r->next;
+            _destroy_table(r->tab);
+            retired_allocator::deallocate(r);
+        }
+        else
+        {
+            link = &r->next;
+        }
+    }
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_CONCURRENT_HASH_MAP_H_
@@ -66,9 +66,9 @@ void _destroy_iterator(ForwardIterator first, ForwardIterator last,
 template <typename ForwardIterator>
 void _destroy_iterator(ForwardIterator first, ForwardIterator last,
                        std::false_type) {
-    while (first++ != last) {
-        // auto current = &*first;
+    while (first != last) {
         destroy(&*first);
+        ++first;
     }
 }
 
@@ -6,7 +6,9 @@
  */
 
 #include <cassert>
+#include <cerrno>
 #include <stdexcept>
+#include <system_error>
 
 namespace xutl {
 
@@ -14,6 +16,10 @@ namespace xutl {
 
 #define THROW_LENGTH_ERROR(what) throw std::length_error(what)
 #define THROW_OUT_OF_RANGE(what) throw std::out_of_range(what)
+#define THROW_RUNTIME_ERROR(what) throw std::runtime_error(what)
+// 以当前的 errno 抛出 std::system_error，用于系统调用失败
+#define THROW_SYSTEM_ERROR(what) \
+    throw std::system_error(errno, std::generic_category(), what)
 
 }  // namespace xutl
 
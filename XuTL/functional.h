@@ -1,7 +1,18 @@
 #ifndef XUTL_FUNCTIONAL_H_
 #define XUTL_FUNCTIONAL_H_
 
-// 该文件包含必要的函数对象（仿函数）
+// 该文件包含必要的函数对象（仿函数），
+// 以及类型擦除的可调用对象包装 function、unique_function、function_ref
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <new>
+
+#include "exceptdef.h"
+#include "memory.h"
+#include "type_traits.h"
+#include "utils.h"
 
 namespace xutl {
 // 定义一元函数的参数类型和返回值类型
@@ -101,6 +112,463 @@ struct less_equal : public binary_function<T, T, bool> {
     }
 };
 
+// 把用户的哈希值打散（MurmurHash3 的 fmix64）。std::hash 对整数通常是恒等映射，
+// 哈希容器用它的结果选分片、块或格子之前先经过这一步
+inline uint64_t _hash_mix(uint64_t h) noexcept {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// ************************************************************************************
+// function / unique_function / function_ref 的公共部分
+// ************************************************************************************
+
+// 调用空的 function 时抛出
+class bad_function_call : public std::exception {
+public:
+    const char* what() const noexcept override {
+        return "bad_function_call";
+    }
+};
+
+// 调用 f 并把结果转换为 R，R 为 void 时丢弃结果
+template <typename R>
+struct _invoke_r {
+    template <typename F, typename... Args>
+    static R call(F& f, Args&&... args) {
+        return f(xutl::forward<Args>(args)...);
+    }
+};
+template <>
+struct _invoke_r<void> {
+    template <typename F, typename... Args>
+    static void call(F& f, Args&&... args) {
+        f(xutl::forward<Args>(args)...);
+    }
+};
+
+// F& 能以 Args... 调用，且结果可以转换为 R 时为 true
+template <typename F, typename R, typename... Args>
+struct _is_invocable_r {
+private:
+    template <typename G, typename Res = decltype(xutl::declval<G&>()(
+                              xutl::declval<Args>()...))>
+    static integral_constant<bool, is_void<R>::value ||
+                                       is_convertible<Res, R>::value>
+    _test(int);
+    template <typename G>
+    static false_type _test(...);
+
+public:
+    static constexpr bool value = decltype(_test<F>(0))::value;
+};
+
+// 空的函数指针包装后得到空的 function
+template <typename F>
+inline bool _is_null_callable(const F& f, true_type) noexcept {
+    return f == nullptr;
+}
+template <typename F>
+inline bool _is_null_callable(const F&, false_type) noexcept {
+    return false;
+}
+
+// function 和 unique_function 共用的实现，Copyable 为 false 时不要求可调用对象可拷贝
+template <typename Signature, bool Copyable>
+class _function_base;
+
+template <typename R, typename... Args, bool Copyable>
+class _function_base<R(Args...), Copyable> {
+protected:
+    // 内联存储的大小：3 个指针，足以放下捕获了 3 个指针/引用的 lambda
+    static constexpr size_t _inline_size = 3 * sizeof(void*);
+
+    union _storage_type {
+        void* _ptr;
+        typename aligned_storage<_inline_size, alignof(void*)>::type _buf;
+    };
+
+    enum class _op { move, copy, destroy };
+
+    using _invoker_type = R (*)(_storage_type&, Args&&...);
+    // move、copy 从 src 构造 dst，destroy 销毁 dst
+    using _manager_type = void (*)(_op, _storage_type& dst, _storage_type& src);
+
+    // 放得进内联存储，并且移动不会抛出异常时才内联存放，
+    // 这样移动 function 本身总是 noexcept
+    template <typename F>
+    struct _fits_inline
+        : public integral_constant<
+              bool, sizeof(F) <= _inline_size &&
+                        alignof(_storage_type) % alignof(F) == 0 &&
+                        is_nothrow_move_constructible<F>::value> {};
+
+    template <typename F, bool Inline = _fits_inline<F>::value>
+    struct _handler;
+
+    // 可调用对象就地存放在 _buf 中
+    template <typename F>
+    struct _handler<F, true> {
+        static F* get(_storage_type& s) noexcept {
+            return reinterpret_cast<F*>(&s._buf);
+        }
+        template <typename G>
+        static void create(_storage_type& s, G&& g) {
+            ::new (static_cast<void*>(&s._buf)) F(xutl::forward<G>(g));
+        }
+        static void manage(_op op, _storage_type& dst, _storage_type& src) {
+            switch (op) {
+                case _op::move:
+                    ::new (static_cast<void*>(&dst._buf))
+                        F(xutl::move(*get(src)));
+                    get(src)->~F();
+                    break;
+                case _op::copy:
+                    _copy(dst, src, integral_constant<bool, Copyable>());
+                    break;
+                case _op::destroy:
+                    get(dst)->~F();
+                    break;
+            }
+        }
+        static void _copy(_storage_type& dst, _storage_type& src, true_type) {
+            ::new (static_cast<void*>(&dst._buf)) F(*get(src));
+        }
+        static void _copy(_storage_type&, _storage_type&, false_type) {
+        }
+        static R invoke(_storage_type& s, Args&&... args) {
+            return _invoke_r<R>::call(*get(s), xutl::forward<Args>(args)...);
+        }
+    };
+
+    // 可调用对象用 allocator 分配在堆上，_ptr 指向它
+    template <typename F>
+    struct _handler<F, false> {
+        static F* get(_storage_type& s) noexcept {
+            return static_cast<F*>(s._ptr);
+        }
+        template <typename G>
+        static void create(_storage_type& s, G&& g) {
+            F* ptr = allocator<F>::allocate();
+            try {
+                allocator<F>::construct(ptr, xutl::forward<G>(g));
+            } catch (...) {
+                allocator<F>::deallocate(ptr);
+                throw;
+            }
+            s._ptr = ptr;
+        }
+        static void manage(_op op, _storage_type& dst, _storage_type& src) {
+            switch (op) {
+                case _op::move:
+                    dst._ptr = src._ptr;
+                    break;
+                case _op::copy:
+                    _copy(dst, src, integral_constant<bool, Copyable>());
+                    break;
+                case _op::destroy:
+                    allocator<F>::destroy(get(dst));
+                    allocator<F>::deallocate(get(dst));
+                    break;
+            }
+        }
+        static void _copy(_storage_type& dst, _storage_type& src, true_type) {
+            create(dst, *get(src));
+        }
+        static void _copy(_storage_type&, _storage_type&, false_type) {
+        }
+        static R invoke(_storage_type& s, Args&&... args) {
+            return _invoke_r<R>::call(*get(s), xutl::forward<Args>(args)...);
+        }
+    };
+
+    // 可以用来构造的可调用对象：不是 Self 本身，并且能以 Args... 调用
+    template <typename F, typename Self>
+    using _enable_if_callable = typename enable_if<
+        !is_same<typename decay<F>::type, Self>::value &&
+        _is_invocable_r<typename decay<F>::type, R, Args...>::value>::type;
+
+    // _invoker 为 nullptr 表示空
+    mutable _storage_type _storage;
+    _invoker_type _invoker;
+    _manager_type _manager;
+
+    _function_base() noexcept : _invoker(nullptr), _manager(nullptr) {
+    }
+
+    template <typename F>
+    explicit _function_base(F&& f) : _invoker(nullptr), _manager(nullptr) {
+        using functor = typename decay<F>::type;
+        using nullable =
+            integral_constant<bool, is_pointer<functor>::value ||
+                                        is_member_pointer<functor>::value>;
+        if (_is_null_callable(f, nullable())) return;
+        _handler<functor>::create(_storage, xutl::forward<F>(f));
+        _invoker = &_handler<functor>::invoke;
+        _manager = &_handler<functor>::manage;
+    }
+
+    _function_base(const _function_base& rhs)
+        : _invoker(nullptr), _manager(nullptr) {
+        if (rhs._invoker) {
+            rhs._manager(_op::copy, _storage, rhs._storage);
+            _invoker = rhs._invoker;
+            _manager = rhs._manager;
+        }
+    }
+
+    _function_base(_function_base&& rhs) noexcept
+        : _invoker(nullptr), _manager(nullptr) {
+        _take(rhs);
+    }
+
+    ~_function_base() {
+        _clear();
+    }
+
+    // 把 rhs 的可调用对象移动过来，*this 必须为空
+    void _take(_function_base& rhs) noexcept {
+        if (rhs._invoker) {
+            rhs._manager(_op::move, _storage, rhs._storage);
+            _invoker = rhs._invoker;
+            _manager = rhs._manager;
+            rhs._invoker = nullptr;
+            rhs._manager = nullptr;
+        }
+    }
+
+    void _clear() noexcept {
+        if (_invoker) {
+            _manager(_op::destroy, _storage, _storage);
+            _invoker = nullptr;
+            _manager = nullptr;
+        }
+    }
+
+    void _swap(_function_base& rhs) noexcept {
+        if (this == &rhs) return;
+        _function_base tmp(xutl::move(rhs));
+        rhs._take(*this);
+        _take(tmp);
+    }
+
+public:
+    R operator()(Args... args) const {
+        if (_invoker == nullptr) throw bad_function_call();
+        return _invoker(_storage, xutl::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept {
+        return _invoker != nullptr;
+    }
+};
+
+// ************************************************************************************
+// function
+// 可拷贝的类型擦除可调用对象包装。不超过 3 个指针大小、且移动不抛出异常的可调用对象
+// （如只捕获少量指针或引用的 lambda、函数指针）就地存放，不分配内存
+// ************************************************************************************
+
+template <typename Signature>
+class function;
+
+template <typename R, typename... Args>
+class function<R(Args...)> : public _function_base<R(Args...), true> {
+private:
+    using _base = _function_base<R(Args...), true>;
+
+    template <typename F>
+    using _enable_if_callable =
+        typename _base::template _enable_if_callable<F, function>;
+
+public:
+    using result_type = R;
+
+    function() noexcept {
+    }
+    function(std::nullptr_t) noexcept {
+    }
+    template <typename F, typename = _enable_if_callable<F>>
+    function(F f) : _base(xutl::move(f)) {
+    }
+    function(const function& rhs) = default;
+    function(function&& rhs) noexcept = default;
+
+    function& operator=(const function& rhs) {
+        function(rhs).swap(*this);
+        return *this;
+    }
+    function& operator=(function&& rhs) noexcept {
+        if (this != &rhs) {
+            this->_clear();
+            this->_take(rhs);
+        }
+        return *this;
+    }
+    function& operator=(std::nullptr_t) noexcept {
+        this->_clear();
+        return *this;
+    }
+    template <typename F, typename = _enable_if_callable<F>>
+    function& operator=(F&& f) {
+        function(xutl::forward<F>(f)).swap(*this);
+        return *this;
+    }
+
+    void swap(function& rhs) noexcept {
+        this->_swap(rhs);
+    }
+};
+
+// ************************************************************************************
+// unique_function
+// 只能移动的 function，可以保存只能移动的可调用对象（如捕获了 unique_ptr 的 lambda）
+// ************************************************************************************
+
+template <typename Signature>
+class unique_function;
+
+template <typename R, typename... Args>
+class unique_function<R(Args...)> : public _function_base<R(Args...), false> {
+private:
+    using _base = _function_base<R(Args...), false>;
+
+    template <typename F>
+    using _enable_if_callable =
+        typename _base::template _enable_if_callable<F, unique_function>;
+
+public:
+    using result_type = R;
+
+    unique_function() noexcept {
+    }
+    unique_function(std::nullptr_t) noexcept {
+    }
+    template <typename F, typename = _enable_if_callable<F>>
+    unique_function(F&& f) : _base(xutl::forward<F>(f)) {
+    }
+    unique_function(const unique_function&) = delete;
+    unique_function(unique_function&& rhs) noexcept = default;
+
+    unique_function& operator=(const unique_function&) = delete;
+    unique_function& operator=(unique_function&& rhs) noexcept {
+        if (this != &rhs) {
+            this->_clear();
+            this->_take(rhs);
+        }
+        return *this;
+    }
+    unique_function& operator=(std::nullptr_t) noexcept {
+        this->_clear();
+        return *this;
+    }
+    template <typename F, typename = _enable_if_callable<F>>
+    unique_function& operator=(F&& f) {
+        unique_function(xutl::forward<F>(f)).swap(*this);
+        return *this;
+    }
+
+    void swap(unique_function& rhs) noexcept {
+        this->_swap(rhs);
+    }
+};
+
+template <typename R, typename... Args>
+inline bool operator==(const function<R(Args...)>& f,
+                       std::nullptr_t) noexcept {
+    return !f;
+}
+template <typename R, typename... Args>
+inline bool operator!=(const function<R(Args...)>& f,
+                       std::nullptr_t) noexcept {
+    return static_cast<bool>(f);
+}
+template <typename R, typename... Args>
+inline bool operator==(const unique_function<R(Args...)>& f,
+                       std::nullptr_t) noexcept {
+    return !f;
+}
+template <typename R, typename... Args>
+inline bool operator!=(const unique_function<R(Args...)>& f,
+                       std::nullptr_t) noexcept {
+    return static_cast<bool>(f);
+}
+
+template <typename R, typename... Args>
+inline void swap(function<R(Args...)>& lhs,
+                 function<R(Args...)>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+template <typename R, typename... Args>
+inline void swap(unique_function<R(Args...)>& lhs,
+                 unique_function<R(Args...)>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+// ************************************************************************************
+// function_ref
+// 不拥有可调用对象的引用，只有两个指针大小，从不分配内存，适合作为回调参数。
+// 它只引用原对象，原对象必须比 function_ref 活得更久，
+// 不要用临时的 lambda 初始化一个之后还要使用的 function_ref 变量
+// ************************************************************************************
+
+template <typename Signature>
+class function_ref;
+
+template <typename R, typename... Args>
+class function_ref<R(Args...)> {
+private:
+    // 可调用对象的地址；函数指针不能转换为 void*，单独存放
+    union _target_type {
+        void* _obj;
+        void (*_fn)();
+    };
+
+    _target_type _target;
+    R (*_invoker)(_target_type, Args&&...);
+
+    template <typename F>
+    static R _invoke_object(_target_type t, Args&&... args) {
+        return _invoke_r<R>::call(*static_cast<F*>(t._obj),
+                                  xutl::forward<Args>(args)...);
+    }
+    template <typename F>
+    static R _invoke_function(_target_type t, Args&&... args) {
+        F* fn = reinterpret_cast<F*>(t._fn);
+        return _invoke_r<R>::call(*fn, xutl::forward<Args>(args)...);
+    }
+
+public:
+    template <typename F,
+              typename = typename enable_if<
+                  !is_same<typename decay<F>::type, function_ref>::value &&
+                  !is_function<typename remove_reference<F>::type>::value &&
+                  _is_invocable_r<typename remove_reference<F>::type, R,
+                                  Args...>::value>::type>
+    function_ref(F&& f) noexcept
+        : _invoker(&_invoke_object<typename remove_reference<F>::type>) {
+        _target._obj = const_cast<void*>(
+            static_cast<const volatile void*>(xutl::address_of(f)));
+    }
+    template <typename F, typename = typename enable_if<
+                              is_function<F>::value &&
+                              _is_invocable_r<F*, R, Args...>::value>::type>
+    function_ref(F* f) noexcept : _invoker(&_invoke_function<F>) {
+        XUTL_ASSERT(f != nullptr);
+        _target._fn = reinterpret_cast<void (*)()>(f);
+    }
+    function_ref(const function_ref&) noexcept = default;
+    function_ref& operator=(const function_ref&) noexcept = default;
+
+    R operator()(Args... args) const {
+        return _invoker(_target, xutl::forward<Args>(args)...);
+    }
+};
+
 }  // namespace xutl
 
-#endif  // XUTL_FUNCTIONAL_H_
\ No newline at end of file
+#endif  // XUTL_FUNCTIONAL_H_
@@ -0,0 +1,440 @@
+#ifndef XUTL_INTRUSIVE_LIST_H_
+#define XUTL_INTRUSIVE_LIST_H_
+
+/**
+ * 该文件包含一个模板类 intrusive_list
+ * 它是一个侵入式的双向链表：链表指针保存在元素内部的 list_hook 成员中，
+ * 链表只负责把已经存在的对象串起来，插入、删除和在链表之间移动都不分配内存，
+ * 也不构造或析构元素
+ *
+ * 一个对象可以有多个 list_hook，分别挂在不同的链表上；元素可以通过自己的 hook
+ * 在 O(1) 时间内从所在的链表中摘下，不需要知道是哪个链表。
+ * 接合操作与 list 共用 _link_transfer
+ */
+
+#include <cstddef>
+#include <cstring>
+
+#include "exceptdef.h"
+#include "iterator.h"
+#include "list.h"
+#include "type_traits.h"
+
+namespace xutl
+{
+
+// 嵌入到元素中的链表指针
+// 没有挂在链表上时两个指针都为空；拷贝对象时不拷贝链表关系
+// 对象析构时如果还挂在链表上，会自动摘下
+struct list_hook
+{
+    list_hook* prev = nullptr;
+    list_hook* next = nullptr;
+
+    list_hook() = default;
+    list_hook(const list_hook&) noexcept
+    {
+    }
+    list_hook& operator=(const list_hook&) noexcept
+    {
+        return *this;
+    }
+    ~list_hook()
+    {
+        unlink();
+    }
+
+    bool is_linked() const noexcept
+    {
+        return next != nullptr;
+    }
+
+    // 从所在的链表中摘下，没有挂在链表上时什么也不做
+    void unlink() noexcept
+    {
+        if (!is_linked()) return;
+        prev->next = next;
+        next->prev = prev;
+        prev = next = nullptr;
+    }
+};
+
+// 由 hook 的地址得到所在对象的地址
+template <typename T, list_hook T::*Hook>
+struct _hook_traits
+{
+    // 成员的偏移，不需要任何 T 对象
+    // Itanium C++ ABI（GCC、Clang）中数据成员指针的值就是成员相对于对象起始地址
+    // 的偏移，直接取出即可（Boost.Intrusive 也是这样做的）
+    static std::ptrdiff_t offset() noexcept
+    {
+        static_assert(sizeof(Hook) == sizeof(std::ptrdiff_t),
+                      "数据成员指针不是一个偏移量");
+        list_hook T::*member = Hook;
+        std::ptrdiff_t result;
+        std::memcpy(&result, &member, sizeof(result));
+        return result;
+    }
+    static T* to_value(list_hook* h) noexcept
+    {
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(h) - offset());
+    }
+    static const T* to_value(const list_hook* h) noexcept
+    {
+        return reinterpret_cast<const T*>(reinterpret_cast<const char*>(h) -
+                                          offset());
+    }
+};
+
+// intrusive_list 的迭代器
+template <typename T, list_hook T::*Hook, bool Const>
+class intrusive_list_iterator
+    : public xutl::iterator<bidirectional_iterator_tag, T, std::ptrdiff_t,
+                            typename conditional<Const, const T*, T*>::type,
+                            typename conditional<Const, const T&, T&>::type>
+{
+public:
+    using value_type = T;
+    using pointer = typename conditional<Const, const T*, T*>::type;
+    using reference = typename conditional<Const, const T&, T&>::type;
+    using self = intrusive_list_iterator<T, Hook, Const>;
+
+private:
+    using _traits = _hook_traits<T, Hook>;
+
+    list_hook* _node = nullptr;
+
+    template <typename U, list_hook U::*, bool>
+    friend class intrusive_list_iterator;
+    template <typename U, list_hook U::*>
+    friend class intrusive_list;
+
+public:
+    intrusive_list_iterator() = default;
+    explicit intrusive_list_iterator(list_hook* node) : _node(node)
+    {
+    }
+    // iterator 可以转换为 const_iterator
+    template <bool C, typename = typename enable_if<Const && !C>::type>
+    intrusive_list_iterator(const intrusive_list_iterator<T, Hook, C>& other) :
+            _node(other._node)
+    {
+    }
+
+    reference operator*() const
+    {
+        return *_traits::to_value(_node);
+    }
+    pointer operator->() const
+    {
+        return _traits::to_value(_node);
+    }
+
+    self& operator++()
+    {
+        _node = _node->next;
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        _node = _node->next;
+        return tmp;
+    }
+    self& operator--()
+    {
+        _node = _node->prev;
+        return *this;
+    }
+    self operator--(int)
+    {
+        self tmp = *this;
+        _node = _node->prev;
+        return tmp;
+    }
+
+    template <bool C>
+    bool operator==(const intrusive_list_iterator<T, Hook, C>& rhs) const
+    {
+        return _node == rhs._node;
+    }
+    template <bool C>
+    bool operator!=(const intrusive_list_iterator<T, Hook, C>& rhs) const
+    {
+        return _node != rhs._node;
+    }
+};
+
+// intrusive_list 类
+// Hook 为 T 中的 list_hook 成员，例如 intrusive_list<session, &session::hook>
+// 链表不拥有元素，元素的生命周期由调用者管理
+template <typename T, list_hook T::*Hook>
+class intrusive_list
+{
+public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = intrusive_list_iterator<T, Hook, false>;
+    using const_iterator = intrusive_list_iterator<T, Hook, true>;
+    using reverse_iterator = xutl::reverse_iterator<iterator>;
+    using const_reverse_iterator = xutl::reverse_iterator<const_iterator>;
+
+private:
+    using _traits = _hook_traits<T, Hook>;
+
+    // 尾端的空白节点，整个链表是一个环状双向链表
+    list_hook _root;
+
+public:
+    // ********************************************************************************
+    // 构造函数/析构函数
+    // ********************************************************************************
+
+    intrusive_list() noexcept
+    {
+        _root.prev = _root.next = &_root;
+    }
+    intrusive_list(const intrusive_list&) = delete;
+    intrusive_list(intrusive_list&& x) noexcept : intrusive_list()
+    {
+        splice(end(), x);
+    }
+
+    intrusive_list& operator=(const intrusive_list&) = delete;
+    intrusive_list& operator=(intrusive_list&& x) noexcept
+    {
+        if (this != &x)
+        {
+            clear();
+            splice(end(), x);
+        }
+        return *this;
+    }
+
+    // 摘下所有元素，元素本身不受影响
+    ~intrusive_list()
+    {
+        clear();
+        _root.prev = _root.next = nullptr;
+    }
+
+    // ********************************************************************************
+    // 迭代器相关
+    // ********************************************************************************
+
+    iterator begin() noexcept
+    {
+        return iterator(_root.next);
+    }
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(_root.next);
+    }
+    iterator end() noexcept
+    {
+        return iterator(&_root);
+    }
+    const_iterator end() const noexcept
+    {
+        return const_iterator(const_cast<list_hook*>(&_root));
+    }
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    // 指向 value 的迭代器，value 必须挂在本链表上
+    iterator iterator_to(reference value) noexcept
+    {
+        return iterator(&(value.*Hook));
+    }
+    const_iterator iterator_to(const_reference value) const noexcept
+    {
+        return const_iterator(const_cast<list_hook*>(&(value.*Hook)));
+    }
+
+    // ********************************************************************************
+    // 容量和元素访问
+    // ********************************************************************************
+
+    bool empty() const noexcept
+    {
+        return _root.next == &_root;
+    }
+    // 元素可以通过 hook 直接摘下，链表不知道元素个数，需要遍历整个链表
+    size_type size() const noexcept
+    {
+        return static_cast<size_type>(xutl::distance(begin(), end()));
+    }
+
+    reference front()
+    {
+        return *begin();
+    }
+    const_reference front() const
+    {
+        return *begin();
+    }
+    reference back()
+    {
+        return *(--end());
+    }
+    const_reference back() const
+    {
+        return *(--end());
+    }
+
+    // ********************************************************************************
+    // 修改容器相关
+    // ********************************************************************************
+
+    // 把 value 挂到 position 之前，value 不能已经挂在某个链表上
+    iterator insert(const_iterator position, reference value) noexcept
+    {
+        list_hook* h = &(value.*Hook);
+        XUTL_ASSERT(!h->is_linked());
+        list_hook* next = position._node;
+        h->next = next;
+        h->prev = next->prev;
+        next->prev->next = h;
+        next->prev = h;
+        return iterator(h);
+    }
+
+    void push_front(reference value) noexcept
+    {
+        insert(begin(), value);
+    }
+    void push_back(reference value) noexcept
+    {
+        insert(end(), value);
+    }
+
+    // 摘下 position 指向的元素，返回下一个元素的迭代器
+    iterator erase(const_iterator position) noexcept
+    {
+        list_hook* next = position._node->next;
+        position._node->unlink();
+        return iterator(next);
+    }
+    iterator erase(const_iterator first, const_iterator last) noexcept
+    {
+        while (first != last)
+        {
+            first = erase(first);
+        }
+        return iterator(last._node);
+    }
+    // 摘下 value，value 必须挂在本链表上
+    void remove(reference value) noexcept
+    {
+        (value.*Hook).unlink();
+    }
+
+    void pop_front() noexcept
+    {
+        erase(begin());
+    }
+    void pop_back() noexcept
+    {
+        erase(--end());
+    }
+
+    // 摘下所有元素
+    void clear() noexcept
+    {
+        list_hook* cur = _root.next;
+        while (cur != &_root)
+        {
+            list_hook* next = cur->next;
+            cur->prev = cur->next = nullptr;
+            cur = next;
+        }
+        _root.prev = _root.next = &_root;
+    }
+
+    // 与 list 一样，接合操作只改动 prev 和 next 指针，不分配内存
+
+    // 将链表 x 的所有元素接合到 position 之前
+    void splice(const_iterator position, intrusive_list& x) noexcept
+    {
+        if (!x.empty())
+        {
+            _link_transfer(position._node, x._root.next, &x._root);
+        }
+    }
+    // 将 it 所指元素接合到 position 之前，x 可以就是本链表
+    void splice(const_iterator position, intrusive_list&,
+                const_iterator it) noexcept
+    {
+        list_hook* next = it._node->next;
+        if (position._node == it._node || position._node == next) return;
+        _link_transfer(position._node, it._node, next);
+    }
+    // 将 [first, last) 接合到 position 之前，position 不能位于区间之内
+    void splice(const_iterator position, intrusive_list&,
+                const_iterator first, const_iterator last) noexcept
+    {
+        if (first != last)
+        {
+            _link_transfer(position._node, first._node, last._node);
+        }
+    }
+
+    void swap(intrusive_list& x) noexcept
+    {
+        intrusive_list tmp;
+        tmp.splice(tmp.end(), x);
+        x.splice(x.end(), *this);
+        splice(end(), tmp);
+    }
+
+    void reverse() noexcept
+    {
+        if (_root.next == &_root || _root.next->next == &_root) return;
+        // 从第二个元素开始，依次移到最前面
+        list_hook* cur = _root.next->next;
+        while (cur != &_root)
+        {
+            list_hook* next = cur->next;
+            _link_transfer(_root.next, cur, next);
+            cur = next;
+        }
+    }
+};
+
+template <typename T, list_hook T::*Hook>
+void swap(intrusive_list<T, Hook>& lhs, intrusive_list<T, Hook>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_INTRUSIVE_LIST_H_
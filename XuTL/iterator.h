@@ -205,7 +205,7 @@ void _advance(InputIterator& it, Distance n, input_iterator_tag) {
 }
 
 template <typename BidirectionalIterator, typename Distance>
-void _advance(BidirectionalIterator it, Distance n,
+void _advance(BidirectionalIterator& it, Distance n,
               bidirectional_iterator_tag) {
     if (n > 0) {
         while (n--) {
@@ -219,13 +219,15 @@ void _advance(BidirectionalIterator it, Distance n,
 }
 
 template <typename RandomAccessIterator, typename Distance>
-void _advance(RandomAccessIterator it, Distance n, random_access_iterator_tag) {
+void _advance(RandomAccessIterator& it, Distance n,
+              random_access_iterator_tag) {
     it += n;
 }
 
 template <typename InputIterator, typename Distance>
 void advance(InputIterator& it, Distance n) {
-    _advance(it, n, iterator_category(it));
+    _advance(it, n,
+             typename iterator_traits<InputIterator>::iterator_category());
 }
 
 // next：当前迭代器的后 n 位，n 默认为 1
@@ -0,0 +1,254 @@
+#ifndef XUTL_LARGE_ALLOC_H_
+#define XUTL_LARGE_ALLOC_H_
+
+/**
+ * 该文件包含 allocator 的大块分配模式
+ * 开启后，allocator 遇到不小于阈值的分配时不再调用 ::operator new，而是直接 mmap
+ * 一块按 2MB 对齐的匿名内存：可以用 MADV_HUGEPAGE 请求透明大页，减少大数组扫描时的
+ * TLB 缺失；还可以用 mbind 把内存绑定到调用线程所在的 NUMA 节点，或者在所有节点间交错
+ *
+ * 每块 mmap 的内存前面多映射一个普通页，存放块的长度并把所有块串成链表；
+ * 释放时只有不小于 huge_page_size 的块才需要查链表，且没有大块存活时不加锁。
+ * 默认关闭，调用 set_large_alloc_policy() 开启。只在 Linux 上有效，其它平台上
+ * 设置策略不起作用
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace xutl
+{
+
+// 透明大页的大小，也是大块分配的对齐粒度和阈值的下限
+constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+// NUMA 策略
+enum class numa_policy
+{
+    none,       // 不干预，由内核按首次访问的线程分配
+    local,      // 绑定到分配时调用线程所在的节点
+    interleave  // 在允许的所有节点之间按页交错
+};
+
+// 大块分配策略
+struct large_alloc_policy
+{
+    bool enabled = false;
+    size_t threshold = 64 * 1024 * 1024;  // 不小于该字节数的分配才使用 mmap
+    bool huge_pages = true;               // 是否 madvise(MADV_HUGEPAGE)
+    numa_policy numa = numa_policy::none;
+};
+
+// ************************************************************************************
+// 全局状态
+// ************************************************************************************
+
+// 每个 mmap 块前面的页中存放的块头
+struct _large_block
+{
+    _large_block* prev;
+    _large_block* next;
+    size_t length;  // 数据部分的长度，按 huge_page_size 取整
+};
+
+struct _large_alloc_state
+{
+    std::atomic<bool> enabled;
+    std::atomic<size_t> threshold;
+    std::atomic<bool> huge_pages;
+    std::atomic<int> numa;
+    std::atomic<size_t> live_blocks;
+    std::mutex lock;
+    _large_block head;  // 哨兵
+
+    static _large_alloc_state& instance()
+    {
+        static _large_alloc_state* state = new _large_alloc_state();
+        return *state;
+    }
+
+private:
+    _large_alloc_state() :
+            enabled(false),
+            threshold(large_alloc_policy().threshold),
+            huge_pages(true),
+            numa(static_cast<int>(numa_policy::none)),
+            live_blocks(0)
+    {
+        head.prev = head.next = &head;
+        head.length = 0;
+    }
+};
+
+// 设置策略，只影响之后的分配；已经分配的块仍然按原来的方式释放
+inline void set_large_alloc_policy(const large_alloc_policy& policy)
+{
+    _large_alloc_state& s = _large_alloc_state::instance();
+    const size_t threshold = policy.threshold < huge_page_size
+                                 ? huge_page_size
+                                 : policy.threshold;
+    s.threshold.store(threshold, std::memory_order_relaxed);
+    s.huge_pages.store(policy.huge_pages, std::memory_order_relaxed);
+    s.numa.store(static_cast<int>(policy.numa), std::memory_order_relaxed);
+    s.enabled.store(policy.enabled, std::memory_order_release);
+}
+
+inline large_alloc_policy get_large_alloc_policy()
+{
+    _large_alloc_state& s = _large_alloc_state::instance();
+    large_alloc_policy policy;
+    policy.enabled = s.enabled.load(std::memory_order_acquire);
+    policy.threshold = s.threshold.load(std::memory_order_relaxed);
+    policy.huge_pages = s.huge_pages.load(std::memory_order_relaxed);
+    policy.numa =
+        static_cast<numa_policy>(s.numa.load(std::memory_order_relaxed));
+    return policy;
+}
+
+// 当前存活的大块个数
+inline size_t large_alloc_live_blocks()
+{
+    return _large_alloc_state::instance().live_blocks.load(
+        std::memory_order_relaxed);
+}
+
+// ************************************************************************************
+// 分配和释放
+// ************************************************************************************
+
+#if defined(__linux__)
+
+// 对 [p, p + length) 应用 NUMA 策略，失败时（例如内核不支持 NUMA）忽略
+inline void _large_alloc_apply_numa(void* p, size_t length, numa_policy policy)
+{
+    if (policy == numa_policy::none) return;
+    const unsigned long max_node = 1024;
+    unsigned long mask[max_node / (8 * sizeof(unsigned long))] = {};
+    int mode = MPOL_BIND;
+    if (policy == numa_policy::local)
+    {
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return;
+        if (node >= max_node) return;
+        mask[node / (8 * sizeof(unsigned long))] |=
+            1ul << (node % (8 * sizeof(unsigned long)));
+    }
+    else
+    {
+        int ignored = 0;
+        if (syscall(SYS_get_mempolicy, &ignored, mask, max_node, nullptr,
+                    MPOL_F_MEMS_ALLOWED) != 0)
+        {
+            return;
+        }
+        mode = MPOL_INTERLEAVE;
+    }
+    syscall(SYS_mbind, p, length, mode, mask, max_node, 0);
+}
+
+// 不适用大块分配时返回 nullptr，由调用者改用 ::operator new
+inline void* _large_allocate(size_t bytes)
+{
+    _large_alloc_state& s = _large_alloc_state::instance();
+    if (!s.enabled.load(std::memory_order_acquire) ||
+        bytes < s.threshold.load(std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t length =
+        (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+    // 多映射 huge_page_size 用于对齐，再把两端多余的部分还回去
+    const size_t mapped = page + length + huge_page_size;
+    void* p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) throw std::bad_alloc();
+    const uintptr_t base = reinterpret_cast<uintptr_t>(p);
+    const uintptr_t data = (base + page + huge_page_size - 1) /
+                           huge_page_size * huge_page_size;
+    const uintptr_t start = data - page;
+    if (start > base) munmap(p, start - base);
+    const uintptr_t end = data + length;
+    if (base + mapped > end)
+    {
+        munmap(reinterpret_cast<void*>(end), base + mapped - end);
+    }
+
+    void* d = reinterpret_cast<void*>(data);
+    if (s.huge_pages.load(std::memory_order_relaxed))
+    {
+        madvise(d, length, MADV_HUGEPAGE);
+    }
+    _large_alloc_apply_numa(
+        d, length,
+        static_cast<numa_policy>(s.numa.load(std::memory_order_relaxed)));
+
+    _large_block* block = reinterpret_cast<_large_block*>(start);
+    block->length = length;
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        block->prev = &s.head;
+        block->next = s.head.next;
+        s.head.next->prev = block;
+        s.head.next = block;
+        s.live_blocks.fetch_add(1, std::memory_order_relaxed);
+    }
+    return d;
+}
+
+// ptr 是大块时释放它并返回 true，否则返回 false
+inline bool _large_deallocate(void* ptr, size_t bytes) noexcept
+{
+    if (bytes < huge_page_size) return false;
+    _large_alloc_state& s = _large_alloc_state::instance();
+    if (s.live_blocks.load(std::memory_order_relaxed) == 0) return false;
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    _large_block* found = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        for (_large_block* b = s.head.next; b != &s.head; b = b->next)
+        {
+            if (reinterpret_cast<char*>(b) + page == ptr)
+            {
+                b->prev->next = b->next;
+                b->next->prev = b->prev;
+                s.live_blocks.fetch_sub(1, std::memory_order_relaxed);
+                found = b;
+                break;
+            }
+        }
+    }
+    if (found == nullptr) return false;
+    munmap(found, page + found->length);
+    return true;
+}
+
+#else  // __linux__
+
+inline void* _large_allocate(size_t)
+{
+    return nullptr;
+}
+
+inline bool _large_deallocate(void*, size_t) noexcept
+{
+    return false;
+}
+
+#endif  // __linux__
+
+}  // namespace xutl
+
+#endif  // XUTL_LARGE_ALLOC_H_
@@ -34,6 +34,23 @@ struct list_node {
     T data;         // 数据域
 };
 
+// 将 [first, last) 区间的节点移动到 position 之前
+// 只改动 prev 和 next 指针，list 与 intrusive_list 共用
+// [first, last) 和 position 可以属于同一个链表，但 position 不能位于区间之内
+template <class NodePtr>
+void _link_transfer(NodePtr position, NodePtr first, NodePtr last) noexcept {
+    if (position == last) return;  // 如果 last 就是 position，什么都不用做
+    // 先把 [first, last) 所属链表的区间前后连接起来
+    first->prev->next = last;
+    NodePtr end_node = last->prev;
+    last->prev = first->prev;
+    // 再断开 [first, last)，连接到 position 之前
+    first->prev = position->prev;
+    end_node->next = position;
+    position->prev->next = first;
+    position->prev = end_node;
+}
+
 // list 的迭代器
 template <class T>
 struct list_iterator
@@ -51,8 +68,7 @@ struct list_iterator
     list_iterator() = default;
     list_iterator(node_ptr x) : node(x) {
     }
-    list_iterator(const list_iterator& rhs) : node(rhs.node) {
-    }
+    list_iterator(const list_iterator&) = default;
 
     bool operator==(const self& rhs) const {
         return node == rhs.node;
@@ -116,11 +132,13 @@ public:
 private:
     // node 是尾端的一个空白节点，整个 list 是一个环状双向链表
     node_ptr _node;
+    // 元素个数，size() 不需要遍历链表
+    size_type _size;
 
 public:
     // 构造函数
     list() {
-        _fill_init(0, value_type());
+        _empty_init();
     }
 
     explicit list(size_type n) {
@@ -132,8 +150,8 @@ public:
     }
 
     template <class Iterator,
-              typename xutl::enable_if<xutl::is_input_iterator<iterator>::value,
-                                       int>::type* = 0>
+              typename xutl::enable_if<xutl::is_input_iterator<Iterator>::value,
+                                       int>::type* = nullptr>
     list(Iterator first, Iterator last) {
         _copy_init(first, last);
     }
@@ -142,8 +160,33 @@ public:
         _copy_init(rhs.cbegin(), rhs.cend());
     }
 
-    list(list&& rhs) noexcept : _node(rhs._node) {
+    list(list&& rhs) noexcept : _node(rhs._node), _size(rhs._size) {
         rhs._node = nullptr;
+        rhs._size = 0;
+    }
+
+    ~list() {
+        if (_node != nullptr) {
+            clear();
+            node_allocator::deallocate(_node);
+        }
+    }
+
+    list& operator=(const list& rhs) {
+        if (this != &rhs) {
+            list(rhs).swap(*this);
+        }
+        return *this;
+    }
+
+    list& operator=(list&& rhs) noexcept {
+        list(xutl::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    void swap(list& rhs) noexcept {
+        xutl::swap(_node, rhs._node);
+        xutl::swap(_size, rhs._size);
     }
 
 public:
@@ -166,7 +209,7 @@ public:
         return _node->next == _node;
     }
     size_type size() const {
-        return xutl::distance(cbegin(), cend());
+        return _size;
     }
 
     reference front() {
@@ -190,9 +233,32 @@ public:
         tmp_node->prev = position.node->prev;
         position.node->prev->next = tmp_node;
         position.node->prev = tmp_node;
+        ++_size;
         return tmp_node;
     }
 
+    // 在 position 位置插入 n 个值为 value 的节点
+    // 返回指向第一个新节点的迭代器，n 为 0 时返回 position
+    iterator insert(iterator position, size_type n, const_reference value) {
+        node_ptr head = nullptr;
+        node_ptr tail = nullptr;
+        _size += _create_chain(head, tail, _fill_source{n, value});
+        return _link_chain(position.node, head, tail);
+    }
+
+    // 在 position 位置插入 [first, last) 区间的元素
+    // 返回指向第一个新节点的迭代器，区间为空时返回 position
+    template <class Iterator,
+              typename xutl::enable_if<xutl::is_input_iterator<Iterator>::value,
+                                       int>::type* = nullptr>
+    iterator insert(iterator position, Iterator first, Iterator last) {
+        node_ptr head = nullptr;
+        node_ptr tail = nullptr;
+        _size +=
+            _create_chain(head, tail, _range_source<Iterator>{first, last});
+        return _link_chain(position.node, head, tail);
+    }
+
     void push_front(const_reference value) {
         insert(begin(), value);
     }
@@ -207,6 +273,7 @@ public:
         prev_node->next = next_node;
         next_node->prev = prev_node;
         _destroy_node(position.node);
+        --_size;
         return next_node;
     }
 
@@ -215,48 +282,81 @@ public:
     }
 
     void pop_back() {
-        erase(end());
+        erase(--end());
     }
 
     void clear() {
-        node_ptr cur_node = begin();
+        node_ptr cur_node = _node->next;
         while (cur_node != _node) {
             node_ptr tmp_node = cur_node;
-            _destroy_node(tmp_node);
             cur_node = cur_node->next;
+            _destroy_node(tmp_node);
         }
         // 还原 node 空链表状态
         _node->prev = _node->next = _node;
-    }
-
-    void remove(const_reference value) {
-        iterator first = begin();
-        iterator last = end();
-        // 遍历所有节点，找到值为 value 的就移除
-        while (first != last) {
-            iterator next = first;
-            ++next;
-            if (*first == value) {
-                erase(first);
+        _size = 0;
+    }
+
+    // 移除所有值为 value 的元素，返回移除的个数
+    // value 可以是链表中某个元素的引用
+    size_type remove(const_reference value) {
+        return remove_if([&value](const_reference x) { return x == value; });
+    }
+
+    // 移除所有使 pred 为真的元素，返回移除的个数
+    // 连续的一段匹配元素一起摘下，串到一条临时链上，遍历结束后再统一销毁，
+    // 因此 pred 在整个过程中都可以安全地引用被移除的元素
+    template <class Predicate>
+    size_type remove_if(Predicate pred) {
+        _removed_chain removed(*this);
+        node_ptr cur = _node->next;
+        while (cur != _node) {
+            if (!pred(cur->data)) {
+                cur = cur->next;
+                continue;
+            }
+            // [cur, last) 是一段连续的匹配元素，last 不匹配或是尾节点
+            node_ptr last = cur->next;
+            size_type n = 1;
+            while (last != _node && pred(last->data)) {
+                last = last->next;
+                ++n;
             }
-            first = next;
+            removed.take(cur, last, n);
+            cur = last == _node ? _node : last->next;
         }
-    }
-
-    // 移除连续的相同元素，使得它们只保留一个
-    void unique() {
-        iterator first = begin();
-        iterator last = end();
-        if (first == last) return;  // 空链表，什么都不做
-        iterator next = first;
-        while (++next != last) {
-            if (*first == *next) {
-                erase(next);
-            } else {
+        return removed.count;
+    }
+
+    // 移除连续的相同元素，使得它们只保留一个，返回移除的个数
+    size_type unique() {
+        return unique(xutl::equal_to<T>());
+    }
+    // 移除与前面保留的元素使 pred 为真的连续元素，返回移除的个数
+    // 与 remove_if 一样，被移除的元素在遍历结束后才销毁
+    template <class BinaryPredicate>
+    size_type unique(BinaryPredicate pred) {
+        _removed_chain removed(*this);
+        node_ptr first = _node->next;
+        if (first == _node) return 0;  // 空链表，什么都不做
+        node_ptr next = first->next;
+        while (next != _node) {
+            if (!pred(first->data, next->data)) {
                 first = next;
+                next = next->next;
+                continue;
+            }
+            node_ptr last = next->next;
+            size_type n = 1;
+            while (last != _node && pred(first->data, last->data)) {
+                last = last->next;
+                ++n;
             }
-            next = first;
+            removed.take(next, last, n);
+            first = last;
+            next = last == _node ? _node : last->next;
         }
+        return removed.count;
     }
 
     // 将链表 another 接合到 postion 之前
@@ -264,6 +364,8 @@ public:
     void splice(iterator position, list& x) {
         if (!x.empty()) {
             _transfer(position, x.begin(), x.end());
+            _size += x._size;
+            x._size = 0;
         }
     }
     // 将 iter 所指元素接合到 position 之前
@@ -273,14 +375,21 @@ public:
         ++next_iter;
         if (position == iter || position == next_iter) return;
         _transfer(position, iter, next_iter);
+        ++_size;
+        --x._size;
     }
     // 将 [first, last) 区间内的元素接合到 position 之前
     // position 和 [first, last) 可以指向同一个链表，
     // 但 position 不能位于 [first, last) 之内
+    // x 不是本链表时需要遍历区间来更新元素个数
     void splice(iterator position, list& x, iterator first, iterator last) {
-        if (first != last) {
-            _transfer(position, first, last);
+        if (first == last) return;
+        if (&x != this) {
+            const size_type n = xutl::distance(first, last);
+            _size += n;
+            x._size -= n;
         }
+        _transfer(position, first, last);
     }
 
     // 与另一个链表 x 合并
@@ -293,6 +402,8 @@ public:
     // 按照 comp 为真的顺序
     template <class Compare>
     void merge(list& x, Compare comp) {
+        // 与自身合并什么也不做
+        if (&x == this) return;
         iterator first1 = begin();
         iterator last1 = end();
         iterator first2 = x.begin();
@@ -311,13 +422,16 @@ public:
         if (first2 != last2) {
             _transfer(last1, first2, last2);
         }
+        _size += x._size;
+        x._size = 0;
     }
 
     void reverse() {
         // 如果链表为空或只有一个元素，不需要任何操作
         if (_node->next == _node || _node->next->next == _node) return;
 
-        iterator next_node = begin();
+        // 从第二个元素开始，依次移到最前面
+        iterator next_node = ++begin();
         while (next_node != end()) {
             iterator cur_node = next_node;
             _transfer(begin(), cur_node, ++next_node);
@@ -345,42 +459,154 @@ private:
         node_allocator::deallocate(np);
     }
 
-    // 用 n 个值为 value 的元素初始化
-    void _fill_init(size_type n, const_reference value) {
+    // 先把所有新节点串成一条独立的链，再一次接到 position 之前
+    // 每个节点的分配、构造和链接都只依赖链尾，不触碰原链表；
+    // 构造过程中抛出异常时销毁已经创建的节点，原链表保持不变
+
+    // 新元素的来源：empty() 表示没有更多元素，construct(p) 在 p 上构造下一个
+    struct _fill_source {
+        size_type n;
+        const_reference value;
+
+        bool empty() const {
+            return n == 0;
+        }
+        void construct(pointer p) {
+            data_allocator::construct(p, value);
+            --n;
+        }
+    };
+    template <class Iterator>
+    struct _range_source {
+        Iterator first;
+        Iterator last;
+
+        bool empty() const {
+            return first == last;
+        }
+        void construct(pointer p) {
+            data_allocator::construct(p, *first);
+            ++first;
+        }
+    };
+
+    // 用 source 中的所有元素创建一条链，head 和 tail 为链的首尾，
+    // 没有元素时都为空；返回创建的节点数
+    template <class Source>
+    size_type _create_chain(node_ptr& head, node_ptr& tail, Source source) {
+        size_type n = 0;
+        try {
+            while (!source.empty()) {
+                node_ptr np = node_allocator::allocate();
+                try {
+                    source.construct(xutl::address_of(np->data));
+                } catch (...) {
+                    node_allocator::deallocate(np);
+                    throw;
+                }
+                if (tail == nullptr) {
+                    head = np;
+                } else {
+                    tail->next = np;
+                    np->prev = tail;
+                }
+                tail = np;
+                ++n;
+            }
+        } catch (...) {
+            _destroy_chain(head, tail);
+            throw;
+        }
+        return n;
+    }
+
+    // 销毁 [head, tail] 上的所有节点
+    void _destroy_chain(node_ptr head, node_ptr tail) {
+        if (head == nullptr) return;
+        while (head != tail) {
+            node_ptr next = head->next;
+            _destroy_node(head);
+            head = next;
+        }
+        _destroy_node(tail);
+    }
+
+    // remove_if 和 unique 摘下的节点
+    // 各段首尾相接成一条链，析构时（包括谓词抛出异常时）一次更新元素个数并销毁
+    struct _removed_chain {
+        list& owner;
+        node_ptr head = nullptr;
+        node_ptr tail = nullptr;
+        size_type count = 0;
+
+        explicit _removed_chain(list& li) : owner(li) {
+        }
+        _removed_chain(const _removed_chain&) = delete;
+        _removed_chain& operator=(const _removed_chain&) = delete;
+        ~_removed_chain() {
+            owner._size -= count;
+            owner._destroy_chain(head, tail);
+        }
+
+        // 从链表中摘下 n 个节点 [first, last)，接到链尾
+        void take(node_ptr first, node_ptr last, size_type n) {
+            node_ptr end_node = last->prev;
+            first->prev->next = last;
+            last->prev = first->prev;
+            if (tail == nullptr) {
+                head = first;
+            } else {
+                tail->next = first;
+            }
+            tail = end_node;
+            count += n;
+        }
+    };
+
+    // 把链 [head, tail] 接到 position 之前，返回第一个节点
+    node_ptr _link_chain(node_ptr position, node_ptr head, node_ptr tail) {
+        if (head == nullptr) return position;
+        head->prev = position->prev;
+        tail->next = position;
+        position->prev->next = head;
+        position->prev = tail;
+        return head;
+    }
+
+    // 只创建尾端的空白节点
+    void _empty_init() {
         _node = node_allocator::allocate();
+        _size = 0;
         // 初始化：令 _node 前后都指向自己，并且不设元素值
         _node->prev = _node->next = _node;
-        // 一个一个插入
-        while (n--) {
-            // node_ptr tmp_node = _create_node(value);
-            insert(end(), value);
+    }
+
+    // 用 n 个值为 value 的元素初始化
+    void _fill_init(size_type n, const_reference value) {
+        _empty_init();
+        try {
+            insert(end(), n, value);
+        } catch (...) {
+            node_allocator::deallocate(_node);
+            throw;
         }
     }
 
     // 用 [first, last) 区间的元素初始化
     template <class Iterator>
     void _copy_init(Iterator first, Iterator last) {
-        _node = node_allocator::allocate();
-        _node->prev = _node->next = _node;
-        while (first != last) {
-            // node_ptr node = _create_node(*first);
-            insert(end(), *first);
-            ++first;
+        _empty_init();
+        try {
+            insert(end(), first, last);
+        } catch (...) {
+            node_allocator::deallocate(_node);
+            throw;
         }
     }
 
     // 将 [first, last) 区间的元素移动到 position 之前
     void _transfer(iterator position, iterator first, iterator last) {
-        if (position == last) return;  // 如果 last 就是 position，什么都不用做
-        // 先把 [first, last) 所属链表的区间前后连接起来
-        first.node->prev->next = last.node;
-        node_ptr end_node = last.node->prev;
-        last.node->prev = first.node->prev;
-        // 再断开 [first, last)，连接到 position 之前
-        first.node->prev = position.node->prev;
-        end_node->next = position.node;
-        position.node->prev->next = first.node;
-        position.node->prev = end_node;
+        _link_transfer(position.node, first.node, last.node);
     }
 };
 }  // namespace xutl
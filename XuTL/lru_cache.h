@@ -0,0 +1,447 @@
+#ifndef XUTL_LRU_CACHE_H_
+#define XUTL_LRU_CACHE_H_
+
+/**
+ * 该文件包含一个模板类 lru_cache
+ * 它是容量有限的键值缓存，满了以后按 LRU 或 CLOCK（second-chance）策略淘汰
+ *
+ * 条目紧密地保存在一个 vector 中，删除时把最后一个条目移到空位上；
+ * 索引是一个只保存条目下标和哈希值的开放寻址表，LRU 链表也用下标链接。
+ * 因此查找、插入、淘汰都是 O(1)，条目和索引的空间只在容量增长时分配，
+ * 缓存装满之后插入和淘汰不再分配内存（键和值本身的分配除外）
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "exceptdef.h"
+#include "functional.h"
+#include "utils.h"
+#include "vector.h"
+
+namespace xutl
+{
+
+// 淘汰策略
+enum class cache_policy
+{
+    lru,   // 淘汰最久未访问的条目，每次命中都把条目移到链表头部
+    clock  // 命中只设置访问位，淘汰时指针扫过条目，跳过并清除访问位为 1 的
+};
+
+// 默认的代价：每个条目为 1，此时容量就是条目个数
+struct cache_unit_cost
+{
+    template <typename Key, typename T>
+    size_t operator()(const Key&, const T&) const noexcept
+    {
+        return 1;
+    }
+};
+
+// ************************************************************************************
+// _cache_entry
+// ************************************************************************************
+
+template <typename Key, typename T>
+struct _cache_entry
+{
+    Key key;
+    T value;
+    size_t cost;
+    uint32_t hash;
+    // LRU 链表，靠近头部的是最近访问的
+    uint32_t prev;
+    uint32_t next;
+    // CLOCK 的访问位；命中时只写这一位，因此用原子变量
+    std::atomic<bool> referenced;
+
+    template <typename K, typename V>
+    _cache_entry(K&& k, V&& v, size_t c, uint32_t h) :
+            key(xutl::forward<K>(k)),
+            value(xutl::forward<V>(v)),
+            cost(c),
+            hash(h),
+            prev(0),
+            next(0),
+            referenced(false)
+    {
+    }
+    _cache_entry(_cache_entry&& x) :
+            key(xutl::move(x.key)),
+            value(xutl::move(x.value)),
+            cost(x.cost),
+            hash(x.hash),
+            prev(x.prev),
+            next(x.next),
+            referenced(x.referenced.load(std::memory_order_relaxed))
+    {
+    }
+    _cache_entry& operator=(_cache_entry&& x)
+    {
+        key = xutl::move(x.key);
+        value = xutl::move(x.value);
+        cost = x.cost;
+        hash = x.hash;
+        prev = x.prev;
+        next = x.next;
+        referenced.store(x.referenced.load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+        return *this;
+    }
+};
+
+// 索引表的一格，index 为 0 表示空，否则为条目下标加 1
+struct _cache_slot
+{
+    uint32_t index;
+    uint32_t hash;
+};
+
+// ************************************************************************************
+// lru_cache
+// ************************************************************************************
+
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename KeyEqual = xutl::equal_to<Key>,
+          typename Cost = cache_unit_cost>
+class lru_cache
+{
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using cost_type = Cost;
+    using size_type = size_t;
+
+private:
+    using entry = _cache_entry<Key, T>;
+
+    static constexpr uint32_t _none = static_cast<uint32_t>(-1);
+
+    vector<entry> _entries;
+    vector<_cache_slot> _slots;  // 大小为 0 或 2 的幂
+    size_type _capacity;
+    size_type _total_cost = 0;
+    cache_policy _policy;
+    uint32_t _head = _none;  // LRU 链表头，最近访问的条目
+    uint32_t _tail = _none;  // LRU 链表尾，下一个被淘汰的条目
+    size_type _hand = 0;     // CLOCK 指针
+    Hash _hash;
+    KeyEqual _equal;
+    Cost _cost;
+
+public:
+    // 所有条目的代价之和不超过 capacity；默认代价下即最多 capacity 个条目
+    explicit lru_cache(size_type capacity,
+                       cache_policy policy = cache_policy::lru,
+                       const Cost& cost = Cost(), const Hash& hash = Hash(),
+                       const KeyEqual& equal = KeyEqual()) :
+            _capacity(capacity),
+            _policy(policy),
+            _hash(hash),
+            _equal(equal),
+            _cost(cost)
+    {
+    }
+
+    lru_cache(const lru_cache&) = delete;
+    lru_cache& operator=(const lru_cache&) = delete;
+
+    // ********************************************************************************
+    // 容量
+    // ********************************************************************************
+
+    size_type size() const noexcept
+    {
+        return _entries.size();
+    }
+    bool empty() const noexcept
+    {
+        return _entries.empty();
+    }
+    size_type capacity() const noexcept
+    {
+        return _capacity;
+    }
+    size_type total_cost() const noexcept
+    {
+        return _total_cost;
+    }
+    cache_policy policy() const noexcept
+    {
+        return _policy;
+    }
+
+    // 预先为 n 个条目分配空间，之后插入 n 个条目以内不再分配
+    void reserve(size_type n)
+    {
+        _entries.reserve(n);
+        if (_slots_needed(n) > _slots.size()) _rehash(_slots_needed(n));
+    }
+
+    // ********************************************************************************
+    // 查找
+    // ********************************************************************************
+
+    // 返回值的地址并记录一次访问，不存在时返回 nullptr
+    // 地址在下一次 put、erase、clear 之前有效
+    // LRU 策略下条目被移到链表头部；CLOCK 策略下只设置访问位，
+    // 因此多个线程在读锁保护下同时调用 get() 是安全的
+    T* get(const key_type& key)
+    {
+        const uint32_t i = _find(key, _hash_of(key));
+        if (i == _none) return nullptr;
+        _touch(i);
+        return &_entries[i].value;
+    }
+
+    // 只查找，不记录访问
+    const T* peek(const key_type& key) const
+    {
+        const uint32_t i = _find(key, _hash_of(key));
+        return i == _none ? nullptr : &_entries[i].value;
+    }
+
+    bool contains(const key_type& key) const
+    {
+        return _find(key, _hash_of(key)) != _none;
+    }
+
+    // ********************************************************************************
+    // 修改
+    // ********************************************************************************
+
+    // 插入或替换 key 对应的值，必要时淘汰其它条目
+    // 单个条目的代价超过容量时不保存它（原有的同键条目也被删除），返回 false
+    template <typename K, typename V>
+    bool put(K&& key, V&& value)
+    {
+        const uint32_t h = _hash_of(key);
+        const size_type c = _cost(key, value);
+        uint32_t i = _find(key, h);
+        if (i != _none)
+        {
+            if (c > _capacity)
+            {
+                // 必须先删除它：刚访问过的条目最后才会被淘汰，
+                // 否则会先淘汰掉其它所有条目
+                _remove(i);
+                return false;
+            }
+            entry& e = _entries[i];
+            _total_cost = _total_cost - e.cost + c;
+            e.value = xutl::forward<V>(value);
+            e.cost = c;
+            _touch(i);
+            while (_total_cost > _capacity) _evict();
+            return _find(key, h) != _none;
+        }
+        if (c > _capacity) return false;
+        while (!_entries.empty() && _total_cost + c > _capacity) _evict();
+
+        if (_slots_needed(_entries.size() + 1) > _slots.size())
+        {
+            _rehash(_slots_needed(_entries.size() + 1));
+        }
+        i = static_cast<uint32_t>(_entries.size());
+        _entries.emplace_back(xutl::forward<K>(key), xutl::forward<V>(value),
+                              c, h);
+        _total_cost += c;
+        _slot_insert(i, h);
+        _link_front(i);
+        return true;
+    }
+
+    // 删除 key 对应的条目，删除了条目时返回 true
+    bool erase(const key_type& key)
+    {
+        const uint32_t i = _find(key, _hash_of(key));
+        if (i == _none) return false;
+        _remove(i);
+        return true;
+    }
+
+    // 删除所有条目，保留已分配的空间
+    void clear() noexcept
+    {
+        _entries.clear();
+        for (_cache_slot& s : _slots)
+        {
+            s.index = 0;
+        }
+        _total_cost = 0;
+        _head = _tail = _none;
+        _hand = 0;
+    }
+
+private:
+    // helper functions
+
+    // 打散后的用户哈希值的低 32 位，保存在格子中
+    uint32_t _hash_of(const key_type& key) const
+    {
+        return static_cast<uint32_t>(
+            _hash_mix(static_cast<uint64_t>(_hash(key))));
+    }
+
+    // 负载因子不超过 1/2，保证线性探测的序列很短
+    static size_type _slots_needed(size_type n) noexcept
+    {
+        size_type s = 16;
+        while (s < 2 * n) s *= 2;
+        return s;
+    }
+
+    size_type _mask() const noexcept
+    {
+        return _slots.size() - 1;
+    }
+
+    uint32_t _find(const key_type& key, uint32_t h) const
+    {
+        if (_slots.empty()) return _none;
+        for (size_type s = h & _mask();; s = (s + 1) & _mask())
+        {
+            const _cache_slot& slot = _slots[s];
+            if (slot.index == 0) return _none;
+            if (slot.hash == h && _equal(_entries[slot.index - 1].key, key))
+            {
+                return slot.index - 1;
+            }
+        }
+    }
+
+    // 条目 i 所在的格子
+    size_type _slot_of(uint32_t i) const noexcept
+    {
+        for (size_type s = _entries[i].hash & _mask();; s = (s + 1) & _mask())
+        {
+            if (_slots[s].index == i + 1) return s;
+        }
+    }
+
+    void _slot_insert(uint32_t i, uint32_t h) noexcept
+    {
+        size_type s = h & _mask();
+        while (_slots[s].index != 0) s = (s + 1) & _mask();
+        _slots[s].index = i + 1;
+        _slots[s].hash = h;
+    }
+
+    // 删除格子 s，把后面探测序列中的格子前移，不留墓碑
+    void _slot_erase(size_type s) noexcept
+    {
+        for (size_type next = (s + 1) & _mask();; next = (next + 1) & _mask())
+        {
+            const _cache_slot& slot = _slots[next];
+            if (slot.index == 0) break;
+            const size_type home = slot.hash & _mask();
+            // home 不在 (s, next] 中时，slot 可以移到 s
+            const bool stays = s <= next ? (s < home && home <= next)
+                                         : (s < home || home <= next);
+            if (!stays)
+            {
+                _slots[s] = slot;
+                s = next;
+            }
+        }
+        _slots[s].index = 0;
+    }
+
+    void _rehash(size_type n)
+    {
+        _slots = vector<_cache_slot>(n, _cache_slot{0, 0});
+        for (uint32_t i = 0; i < _entries.size(); ++i)
+        {
+            _slot_insert(i, _entries[i].hash);
+        }
+    }
+
+    // LRU 链表
+
+    void _link_front(uint32_t i) noexcept
+    {
+        entry& e = _entries[i];
+        e.prev = _none;
+        e.next = _head;
+        if (_head != _none) _entries[_head].prev = i;
+        _head = i;
+        if (_tail == _none) _tail = i;
+    }
+
+    void _unlink(uint32_t i) noexcept
+    {
+        entry& e = _entries[i];
+        (e.prev == _none ? _head : _entries[e.prev].next) = e.next;
+        (e.next == _none ? _tail : _entries[e.next].prev) = e.prev;
+    }
+
+    // 记录一次访问
+    void _touch(uint32_t i) noexcept
+    {
+        if (_policy == cache_policy::clock)
+        {
+            entry& e = _entries[i];
+            // 已经为 1 时不写，避免多个线程反复写同一缓存行
+            if (!e.referenced.load(std::memory_order_relaxed))
+            {
+                e.referenced.store(true, std::memory_order_relaxed);
+            }
+            return;
+        }
+        if (_head == i) return;
+        _unlink(i);
+        _link_front(i);
+    }
+
+    // 按策略淘汰一个条目
+    void _evict()
+    {
+        XUTL_ASSERT(!_entries.empty());
+        if (_policy == cache_policy::lru)
+        {
+            _remove(_tail);
+            return;
+        }
+        for (;;)
+        {
+            if (_hand >= _entries.size()) _hand = 0;
+            entry& e = _entries[_hand];
+            if (!e.referenced.load(std::memory_order_relaxed)) break;
+            e.referenced.store(false, std::memory_order_relaxed);
+            ++_hand;
+        }
+        // 最后一个条目移到 _hand，下一次从它开始检查
+        _remove(static_cast<uint32_t>(_hand));
+    }
+
+    // 删除条目 i，把最后一个条目移到 i 上，并修正它的格子和链表邻居
+    void _remove(uint32_t i)
+    {
+        _slot_erase(_slot_of(i));
+        _unlink(i);
+        _total_cost -= _entries[i].cost;
+        const uint32_t last = static_cast<uint32_t>(_entries.size() - 1);
+        if (i != last)
+        {
+            _slots[_slot_of(last)].index = i + 1;
+            entry& e = _entries[i];
+            e = xutl::move(_entries[last]);
+            (e.prev == _none ? _head : _entries[e.prev].next) = i;
+            (e.next == _none ? _tail : _entries[e.next].prev) = i;
+        }
+        _entries.pop_back();
+    }
+};
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Cost>
+constexpr uint32_t lru_cache<Key, T, Hash, KeyEqual, Cost>::_none;
+
+}  // namespace xutl
+
+#endif  // XUTL_LRU_CACHE_H_
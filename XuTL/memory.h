@@ -3,17 +3,28 @@
 
 /**
  * 该文件包含内存管理相关的一切
- * 包括模板类 allocator 作为默认分配器
+ * 包括模板类 allocator 作为默认分配器，
+ * 以及智能指针 unique_ptr、shared_ptr、weak_ptr、local_shared_ptr、intrusive_ptr
  */
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <exception>
+#include <new>
 
+#include "alloc_hooks.h"
 #include "construct.h"
+#include "large_alloc.h"
 #include "type_traits.h"
 #include "utils.h"
 
 namespace xutl {
 
+// 缓存行大小，并发容器用它来填充数据成员，避免伪共享
+constexpr size_t cache_line_size = 64;
+
 // ************************************************************************************
 // allocator_traits / helper classes
 // ************************************************************************************
@@ -40,6 +51,45 @@ struct allocator_has_construct
                                           declval<Args>()...)),
                                       true_type>::value> {};
 
+// ************************************************************************************
+// 按对齐要求分配原始内存
+// ************************************************************************************
+
+// ::operator new 保证的对齐
+#ifdef __STDCPP_DEFAULT_NEW_ALIGNMENT__
+constexpr size_t default_new_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+#else
+constexpr size_t default_new_alignment = alignof(std::max_align_t);
+#endif
+
+// 分配 bytes 字节，起始地址按 align（2 的幂）对齐
+// 有 C++17 的对齐 operator new 时直接使用它；否则多分配 align 字节，
+// 把 ::operator new 返回的原始指针存放在对齐后地址的前面
+inline void* _aligned_operator_new(size_t bytes, size_t align) {
+    if (align <= default_new_alignment) return ::operator new(bytes);
+#ifdef __cpp_aligned_new
+    return ::operator new(bytes, std::align_val_t(align));
+#else
+    void* raw = ::operator new(bytes + align);
+    uintptr_t p = (reinterpret_cast<uintptr_t>(raw) + align) & ~(align - 1);
+    reinterpret_cast<void**>(p)[-1] = raw;
+    return reinterpret_cast<void*>(p);
+#endif
+}
+
+// 释放 _aligned_operator_new 分配的内存，align 必须与分配时相同
+inline void _aligned_operator_delete(void* ptr, size_t align) noexcept {
+    if (align <= default_new_alignment) {
+        ::operator delete(ptr);
+        return;
+    }
+#ifdef __cpp_aligned_new
+    ::operator delete(ptr, std::align_val_t(align));
+#else
+    ::operator delete(static_cast<void**>(ptr)[-1]);
+#endif
+}
+
 // ************************************************************************************
 // allocator 类
 // ************************************************************************************
@@ -84,28 +134,66 @@ public:
         return &x;
     }
 
+    // 最多可以分配的元素个数
+    static size_type max_size() noexcept {
+        return static_cast<size_type>(-1) / sizeof(value_type);
+    }
+
     // 分配空间
     // ::operator new 返回一个 void*, 利用 static_cast 将 void* 转换成 T*
+    // 起始地址至少按 alignof(T) 对齐，alignas(64) 之类超过 ::operator new
+    // 默认对齐的类型也是如此
+
+    // 定义 XUTL_ALLOC_STATS 时，分配和释放都会记入 alloc_stats.h 中的统计，
+    // 钩子来自 alloc_hooks.h
+    // 开启 large_alloc.h 中的大块分配模式后，超过阈值的分配改用 mmap
 
     // 分配一个大小为 sizeof(T) 的空间
     static pointer allocate() {
-        return static_cast<pointer>(::operator new(sizeof(value_type)));
+        pointer ptr = static_cast<pointer>(
+            _aligned_operator_new(sizeof(value_type), alignof(T)));
+        XUTL_ALLOC_STATS_ALLOCATE(T, sizeof(value_type));
+        return ptr;
     }
     // 分配 n 个大小为 sizeof(T) 的空间
     static pointer allocate(size_type n) {
+        return allocate_aligned(n, alignof(T));
+    }
+    // 分配 n 个大小为 sizeof(T) 的空间，起始地址按 align 对齐
+    // align 必须是 2 的幂，小于 alignof(T) 时按 alignof(T) 对齐
+    static pointer allocate_aligned(size_type n, size_type align) {
         if (n == 0) return nullptr;
-        return static_cast<pointer>(::operator new(n * sizeof(value_type)));
+        if (align < alignof(T)) align = alignof(T);
+        const size_type bytes = n * sizeof(value_type);
+        // 大块按 huge_page_size 对齐，满足任何不超过它的对齐要求
+        void* p = bytes >= huge_page_size && align <= huge_page_size
+                      ? _large_allocate(bytes)
+                      : nullptr;
+        if (p == nullptr) p = _aligned_operator_new(bytes, align);
+        XUTL_ALLOC_STATS_ALLOCATE(T, bytes);
+        return static_cast<pointer>(p);
     }
 
     // 释放空间
+    // n 必须与分配时相同，统计依靠它计算释放的字节数
 
     static void deallocate(T* ptr) {
         if (ptr == nullptr) return;
-        ::operator delete(ptr);
+        _aligned_operator_delete(ptr, alignof(T));
+        XUTL_ALLOC_STATS_DEALLOCATE(T, sizeof(value_type));
     }
     static void deallocate(T* ptr, size_type n) {
+        deallocate_aligned(ptr, n, alignof(T));
+    }
+    // 释放 allocate_aligned 分配的空间，n 和 align 必须与分配时相同
+    static void deallocate_aligned(T* ptr, size_type n, size_type align) {
         if (ptr == nullptr) return;
-        ::operator delete(ptr);
+        if (align < alignof(T)) align = alignof(T);
+        const size_type bytes = n * sizeof(value_type);
+        if (!_large_deallocate(ptr, bytes)) {
+            _aligned_operator_delete(ptr, align);
+        }
+        XUTL_ALLOC_STATS_DEALLOCATE(T, bytes);
     }
 
     // 构造对象
@@ -164,6 +252,1354 @@ inline bool operator!=(const allocator<T1>&, const allocator<T2>&) {
     return false;
 }
 
+// ************************************************************************************
+// _compressed_pair
+// 第二个成员为空类时，利用空基类优化使其不占用存储空间
+// ************************************************************************************
+
+template <typename T1, typename T2,
+          bool = xutl::is_empty<T2>::value && !__is_final(T2)>
+class _compressed_pair : private T2 {
+public:
+    _compressed_pair() : T2(), _first() {
+    }
+    template <typename U1, typename U2>
+    _compressed_pair(U1&& first, U2&& second)
+        : T2(xutl::forward<U2>(second)), _first(xutl::forward<U1>(first)) {
+    }
+
+    T1& first() noexcept {
+        return _first;
+    }
+    const T1& first() const noexcept {
+        return _first;
+    }
+    T2& second() noexcept {
+        return *this;
+    }
+    const T2& second() const noexcept {
+        return *this;
+    }
+
+private:
+    T1 _first;
+};
+
+template <typename T1, typename T2>
+class _compressed_pair<T1, T2, false> {
+public:
+    _compressed_pair() : _first(), _second() {
+    }
+    template <typename U1, typename U2>
+    _compressed_pair(U1&& first, U2&& second)
+        : _first(xutl::forward<U1>(first)), _second(xutl::forward<U2>(second)) {
+    }
+
+    T1& first() noexcept {
+        return _first;
+    }
+    const T1& first() const noexcept {
+        return _first;
+    }
+    T2& second() noexcept {
+        return _second;
+    }
+    const T2& second() const noexcept {
+        return _second;
+    }
+
+private:
+    T1 _first;
+    T2 _second;
+};
+
+// ************************************************************************************
+// default_delete
+// unique_ptr 的默认删除器，是一个空类
+// ************************************************************************************
+
+template <typename T>
+struct default_delete {
+    constexpr default_delete() noexcept = default;
+    template <typename U, typename = typename enable_if<
+                              xutl::is_convertible<U*, T*>::value>::type>
+    default_delete(const default_delete<U>&) noexcept {
+    }
+
+    void operator()(T* ptr) const {
+        static_assert(sizeof(T) > 0, "不能删除不完整类型");
+        delete ptr;
+    }
+};
+
+template <typename T>
+struct default_delete<T[]> {
+    constexpr default_delete() noexcept = default;
+
+    void operator()(T* ptr) const {
+        static_assert(sizeof(T) > 0, "不能删除不完整类型");
+        delete[] ptr;
+    }
+};
+
+// ************************************************************************************
+// unique_ptr
+// 独占所有权的智能指针，删除器为空类时与普通指针一样大
+// ************************************************************************************
+
+// 删除器定义了 pointer 类型时使用它，否则使用 T*
+template <typename T, typename D>
+class _unique_ptr_pointer {
+private:
+    template <typename U>
+    static typename U::pointer test(typename U::pointer*);
+    template <typename U>
+    static T* test(...);
+
+public:
+    using type = decltype(test<typename xutl::remove_reference<D>::type>(0));
+};
+
+template <typename T, typename D = default_delete<T>>
+class unique_ptr {
+public:
+    using pointer = typename _unique_ptr_pointer<T, D>::type;
+    using element_type = T;
+    using deleter_type = D;
+
+private:
+    _compressed_pair<pointer, deleter_type> _pair;
+
+    template <typename U, typename E>
+    friend class unique_ptr;
+
+public:
+    // 构造函数
+
+    constexpr unique_ptr() noexcept : _pair() {
+    }
+    constexpr unique_ptr(std::nullptr_t) noexcept : _pair() {
+    }
+    explicit unique_ptr(pointer ptr) noexcept : _pair(ptr, deleter_type()) {
+    }
+    unique_ptr(pointer ptr, const deleter_type& d) noexcept : _pair(ptr, d) {
+    }
+    unique_ptr(pointer ptr,
+               typename xutl::remove_reference<deleter_type>::type&& d) noexcept
+        : _pair(ptr, xutl::move(d)) {
+    }
+    unique_ptr(unique_ptr&& rhs) noexcept
+        : _pair(rhs.release(), xutl::forward<deleter_type>(rhs.get_deleter())) {
+    }
+    // 从可以转换的 unique_ptr<U, E> 移动构造
+    template <typename U, typename E,
+              typename = typename enable_if<
+                  !xutl::is_array<U>::value &&
+                  xutl::is_convertible<typename unique_ptr<U, E>::pointer,
+                                       pointer>::value &&
+                  xutl::is_convertible<E, deleter_type>::value>::type>
+    unique_ptr(unique_ptr<U, E>&& rhs) noexcept
+        : _pair(rhs.release(), xutl::forward<E>(rhs.get_deleter())) {
+    }
+
+    unique_ptr(const unique_ptr&) = delete;
+    unique_ptr& operator=(const unique_ptr&) = delete;
+
+    ~unique_ptr() {
+        reset();
+    }
+
+    // operator=
+
+    unique_ptr& operator=(unique_ptr&& rhs) noexcept {
+        reset(rhs.release());
+        get_deleter() = xutl::forward<deleter_type>(rhs.get_deleter());
+        return *this;
+    }
+    template <typename U, typename E>
+    typename enable_if<
+        !xutl::is_array<U>::value &&
+            xutl::is_convertible<typename unique_ptr<U, E>::pointer,
+                                 pointer>::value,
+        unique_ptr&>::type
+    operator=(unique_ptr<U, E>&& rhs) noexcept {
+        reset(rhs.release());
+        get_deleter() = xutl::forward<E>(rhs.get_deleter());
+        return *this;
+    }
+    unique_ptr& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    // 观察
+
+    typename xutl::add_lvalue_reference<T>::type operator*() const {
+        return *_pair.first();
+    }
+    pointer operator->() const noexcept {
+        return _pair.first();
+    }
+    pointer get() const noexcept {
+        return _pair.first();
+    }
+    deleter_type& get_deleter() noexcept {
+        return _pair.second();
+    }
+    const deleter_type& get_deleter() const noexcept {
+        return _pair.second();
+    }
+    explicit operator bool() const noexcept {
+        return _pair.first() != nullptr;
+    }
+
+    // 修改
+
+    // 放弃所有权并返回指针，不会删除对象
+    pointer release() noexcept {
+        pointer ptr = _pair.first();
+        _pair.first() = pointer();
+        return ptr;
+    }
+    void reset(pointer ptr = pointer()) noexcept {
+        pointer old = _pair.first();
+        _pair.first() = ptr;
+        if (old) get_deleter()(old);
+    }
+    void swap(unique_ptr& rhs) noexcept {
+        xutl::swap(_pair.first(), rhs._pair.first());
+        xutl::swap(_pair.second(), rhs._pair.second());
+    }
+};
+
+// 管理数组的 unique_ptr
+template <typename T, typename D>
+class unique_ptr<T[], D> {
+public:
+    using pointer = typename _unique_ptr_pointer<T, D>::type;
+    using element_type = T;
+    using deleter_type = D;
+
+private:
+    _compressed_pair<pointer, deleter_type> _pair;
+
+public:
+    constexpr unique_ptr() noexcept : _pair() {
+    }
+    constexpr unique_ptr(std::nullptr_t) noexcept : _pair() {
+    }
+    explicit unique_ptr(pointer ptr) noexcept : _pair(ptr, deleter_type()) {
+    }
+    unique_ptr(pointer ptr, const deleter_type& d) noexcept : _pair(ptr, d) {
+    }
+    unique_ptr(pointer ptr,
+               typename xutl::remove_reference<deleter_type>::type&& d) noexcept
+        : _pair(ptr, xutl::move(d)) {
+    }
+    unique_ptr(unique_ptr&& rhs) noexcept
+        : _pair(rhs.release(), xutl::forward<deleter_type>(rhs.get_deleter())) {
+    }
+
+    unique_ptr(const unique_ptr&) = delete;
+    unique_ptr& operator=(const unique_ptr&) = delete;
+
+    ~unique_ptr() {
+        reset();
+    }
+
+    unique_ptr& operator=(unique_ptr&& rhs) noexcept {
+        reset(rhs.release());
+        get_deleter() = xutl::forward<deleter_type>(rhs.get_deleter());
+        return *this;
+    }
+    unique_ptr& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    T& operator[](size_t i) const {
+        return _pair.first()[i];
+    }
+    pointer get() const noexcept {
+        return _pair.first();
+    }
+    deleter_type& get_deleter() noexcept {
+        return _pair.second();
+    }
+    const deleter_type& get_deleter() const noexcept {
+        return _pair.second();
+    }
+    explicit operator bool() const noexcept {
+        return _pair.first() != nullptr;
+    }
+
+    pointer release() noexcept {
+        pointer ptr = _pair.first();
+        _pair.first() = pointer();
+        return ptr;
+    }
+    void reset(pointer ptr = pointer()) noexcept {
+        pointer old = _pair.first();
+        _pair.first() = ptr;
+        if (old) get_deleter()(old);
+    }
+    void swap(unique_ptr& rhs) noexcept {
+        xutl::swap(_pair.first(), rhs._pair.first());
+        xutl::swap(_pair.second(), rhs._pair.second());
+    }
+};
+
+// unique_ptr 只有一个指针和一个删除器，按字节搬移后不再析构原对象是安全的
+template <typename T, typename D>
+struct is_trivially_relocatable<unique_ptr<T, D>>
+    : public is_trivially_relocatable<D> {};
+
+// make_unique
+
+template <typename T, typename... Args>
+inline typename enable_if<!xutl::is_array<T>::value, unique_ptr<T>>::type
+make_unique(Args&&... args) {
+    return unique_ptr<T>(new T(xutl::forward<Args>(args)...));
+}
+template <typename T>
+inline typename enable_if<xutl::is_array<T>::value, unique_ptr<T>>::type
+make_unique(size_t n) {
+    using U = typename xutl::remove_extent<T>::type;
+    return unique_ptr<T>(new U[n]());
+}
+
+// 比较操作
+
+template <typename T1, typename D1, typename T2, typename D2>
+inline bool operator==(const unique_ptr<T1, D1>& lhs,
+                       const unique_ptr<T2, D2>& rhs) {
+    return lhs.get() == rhs.get();
+}
+template <typename T1, typename D1, typename T2, typename D2>
+inline bool operator!=(const unique_ptr<T1, D1>& lhs,
+                       const unique_ptr<T2, D2>& rhs) {
+    return lhs.get() != rhs.get();
+}
+template <typename T1, typename D1, typename T2, typename D2>
+inline bool operator<(const unique_ptr<T1, D1>& lhs,
+                      const unique_ptr<T2, D2>& rhs) {
+    return lhs.get() < rhs.get();
+}
+template <typename T, typename D>
+inline bool operator==(const unique_ptr<T, D>& lhs, std::nullptr_t) noexcept {
+    return !lhs;
+}
+template <typename T, typename D>
+inline bool operator==(std::nullptr_t, const unique_ptr<T, D>& rhs) noexcept {
+    return !rhs;
+}
+template <typename T, typename D>
+inline bool operator!=(const unique_ptr<T, D>& lhs, std::nullptr_t) noexcept {
+    return static_cast<bool>(lhs);
+}
+template <typename T, typename D>
+inline bool operator!=(std::nullptr_t, const unique_ptr<T, D>& rhs) noexcept {
+    return static_cast<bool>(rhs);
+}
+
+template <typename T, typename D>
+inline void swap(unique_ptr<T, D>& lhs, unique_ptr<T, D>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+// ************************************************************************************
+// 控制块
+// shared_ptr 和 weak_ptr 共享一个控制块，其中保存强引用计数和弱引用计数，
+// 所有 shared_ptr 合起来持有一个弱引用，因此弱引用计数归零时才释放控制块
+// ************************************************************************************
+
+// weak_ptr 已经失效时，用它构造 shared_ptr 会抛出该异常
+class bad_weak_ptr : public std::exception {
+public:
+    const char* what() const noexcept override {
+        return "bad_weak_ptr";
+    }
+};
+
+class _shared_count {
+public:
+    _shared_count() noexcept : _use_count(1), _weak_count(1) {
+    }
+    virtual ~_shared_count() = default;
+
+    _shared_count(const _shared_count&) = delete;
+    _shared_count& operator=(const _shared_count&) = delete;
+
+    void add_shared() noexcept {
+        _use_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    void release_shared() noexcept {
+        if (_use_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            _on_zero_shared();
+            release_weak();
+        }
+    }
+    void add_weak() noexcept {
+        _weak_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    void release_weak() noexcept {
+        // 没有 weak_ptr 时（最常见的情况）不必再做一次原子减法
+        if (_weak_count.load(std::memory_order_acquire) == 1 ||
+            _weak_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            _on_zero_weak();
+        }
+    }
+    // 强引用计数不为 0 时加一并返回 true，供 weak_ptr::lock 使用
+    bool lock() noexcept {
+        long count = _use_count.load(std::memory_order_relaxed);
+        while (count != 0) {
+            if (_use_count.compare_exchange_weak(count, count + 1,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    long use_count() const noexcept {
+        return _use_count.load(std::memory_order_relaxed);
+    }
+
+private:
+    // 强引用计数归零时析构被管理的对象
+    virtual void _on_zero_shared() noexcept = 0;
+    // 弱引用计数归零时释放控制块自身
+    virtual void _on_zero_weak() noexcept = 0;
+
+    std::atomic<long> _use_count;
+    std::atomic<long> _weak_count;
+};
+
+// local_shared_ptr 的控制块：引用计数不是原子的，只能在单个线程内使用，
+// 没有 weak_ptr，强引用计数归零时同时析构对象和释放控制块
+class _local_shared_count {
+public:
+    _local_shared_count() noexcept : _use_count(1) {
+    }
+    virtual ~_local_shared_count() = default;
+
+    _local_shared_count(const _local_shared_count&) = delete;
+    _local_shared_count& operator=(const _local_shared_count&) = delete;
+
+    void add_shared() noexcept {
+        ++_use_count;
+    }
+    void release_shared() noexcept {
+        if (--_use_count == 0) {
+            _on_zero_shared();
+            _on_zero_weak();
+        }
+    }
+    long use_count() const noexcept {
+        return _use_count;
+    }
+
+private:
+    virtual void _on_zero_shared() noexcept = 0;
+    virtual void _on_zero_weak() noexcept = 0;
+
+    long _use_count;
+};
+
+// 以下两种控制块的 Count 为 _shared_count 或 _local_shared_count
+
+// 由指针构造 shared_ptr 时使用的控制块，对象和控制块分别分配
+template <typename P, typename D, typename Count = _shared_count>
+class _shared_ptr_pointer : public Count {
+public:
+    _shared_ptr_pointer(P ptr, D d) : _pair(ptr, xutl::move(d)) {
+    }
+
+private:
+    using _self_allocator = allocator<_shared_ptr_pointer>;
+
+    void _on_zero_shared() noexcept override {
+        _pair.second()(_pair.first());
+    }
+    void _on_zero_weak() noexcept override {
+        this->~_shared_ptr_pointer();
+        _self_allocator::deallocate(this);
+    }
+
+    _compressed_pair<P, D> _pair;
+};
+
+// make_shared 使用的控制块，对象就地存放在控制块之后，只需一次分配
+template <typename T, typename Count = _shared_count>
+class _shared_ptr_emplace : public Count {
+public:
+    template <typename... Args>
+    explicit _shared_ptr_emplace(Args&&... args) {
+        xutl::construct(get(), xutl::forward<Args>(args)...);
+    }
+
+    T* get() noexcept {
+        return reinterpret_cast<T*>(&_storage);
+    }
+
+private:
+    using _self_allocator = allocator<_shared_ptr_emplace>;
+
+    void _on_zero_shared() noexcept override {
+        xutl::destroy(get());
+    }
+    void _on_zero_weak() noexcept override {
+        this->~_shared_ptr_emplace();
+        _self_allocator::deallocate(this);
+    }
+
+    typename aligned_storage<sizeof(T), alignof(T)>::type _storage;
+};
+
+// 为 ptr 分配并构造一个 _shared_ptr_pointer 控制块，删除器复制自 d
+// 失败时只释放控制块本身，ptr 仍归调用者所有，供由 unique_ptr 构造时使用
+template <typename Count, typename P, typename D>
+Count* _new_pointer_block(P ptr, const D& d) {
+    using block = _shared_ptr_pointer<P, D, Count>;
+    block* cntrl = allocator<block>::allocate();
+    try {
+        ::new (cntrl) block(ptr, d);
+    } catch (...) {
+        allocator<block>::deallocate(cntrl);
+        throw;
+    }
+    return cntrl;
+}
+
+template <typename T>
+class weak_ptr;
+
+// ************************************************************************************
+// shared_ptr
+// 共享所有权的智能指针，引用计数的增减是原子操作
+// ************************************************************************************
+
+template <typename T>
+class shared_ptr {
+public:
+    using element_type = T;
+    using weak_type = weak_ptr<T>;
+
+private:
+    element_type* _ptr;
+    _shared_count* _cntrl;
+
+    template <typename U>
+    friend class shared_ptr;
+    template <typename U>
+    friend class weak_ptr;
+    template <typename U, typename... Args>
+    friend shared_ptr<U> allocate_shared(const allocator<U>&, Args&&...);
+
+    // 从 U* 转换到 T* 可行时才参与重载
+    template <typename U>
+    using _enable_if_convertible =
+        typename enable_if<xutl::is_convertible<U*, T*>::value>::type;
+
+public:
+    // 构造函数
+
+    constexpr shared_ptr() noexcept : _ptr(nullptr), _cntrl(nullptr) {
+    }
+    constexpr shared_ptr(std::nullptr_t) noexcept
+        : _ptr(nullptr), _cntrl(nullptr) {
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    explicit shared_ptr(U* ptr) : shared_ptr(ptr, default_delete<U>()) {
+    }
+    // 分配控制块失败时，用 d 删除 ptr 后抛出异常
+    template <typename U, typename D, typename = _enable_if_convertible<U>>
+    shared_ptr(U* ptr, D d) : _ptr(ptr), _cntrl(nullptr) {
+        using block = _shared_ptr_pointer<U*, D>;
+        block* cntrl = nullptr;
+        try {
+            cntrl = allocator<block>::allocate();
+            ::new (cntrl) block(ptr, d);
+        } catch (...) {
+            allocator<block>::deallocate(cntrl);
+            d(ptr);
+            throw;
+        }
+        _cntrl = cntrl;
+    }
+    template <typename D>
+    shared_ptr(std::nullptr_t, D d) : _ptr(nullptr), _cntrl(nullptr) {
+        using block = _shared_ptr_pointer<std::nullptr_t, D>;
+        block* cntrl = nullptr;
+        try {
+            cntrl = allocator<block>::allocate();
+            ::new (cntrl) block(nullptr, d);
+        } catch (...) {
+            allocator<block>::deallocate(cntrl);
+            d(nullptr);
+            throw;
+        }
+        _cntrl = cntrl;
+    }
+    // 别名构造：与 rhs 共享所有权，但指向 ptr
+    template <typename U>
+    shared_ptr(const shared_ptr<U>& rhs, element_type* ptr) noexcept
+        : _ptr(ptr), _cntrl(rhs._cntrl) {
+        if (_cntrl) _cntrl->add_shared();
+    }
+    shared_ptr(const shared_ptr& rhs) noexcept
+        : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        if (_cntrl) _cntrl->add_shared();
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    shared_ptr(const shared_ptr<U>& rhs) noexcept
+        : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        if (_cntrl) _cntrl->add_shared();
+    }
+    shared_ptr(shared_ptr&& rhs) noexcept : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        rhs._ptr = nullptr;
+        rhs._cntrl = nullptr;
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    shared_ptr(shared_ptr<U>&& rhs) noexcept
+        : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        rhs._ptr = nullptr;
+        rhs._cntrl = nullptr;
+    }
+    // weak_ptr 已经失效时抛出 bad_weak_ptr
+    template <typename U, typename = _enable_if_convertible<U>>
+    explicit shared_ptr(const weak_ptr<U>& rhs)
+        : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        if (_cntrl == nullptr || !_cntrl->lock()) {
+            throw bad_weak_ptr();
+        }
+    }
+    template <typename U, typename D,
+              typename = typename enable_if<xutl::is_convertible<
+                  typename unique_ptr<U, D>::pointer, element_type*>::value>::type>
+    shared_ptr(unique_ptr<U, D>&& rhs) : _ptr(nullptr), _cntrl(nullptr) {
+        // 控制块分配成功后才让 rhs 放弃所有权，失败时 rhs 保持不变
+        if (rhs) {
+            _cntrl = _new_pointer_block<_shared_count>(rhs.get(),
+                                                       rhs.get_deleter());
+            _ptr = rhs.release();
+        }
+    }
+
+    ~shared_ptr() {
+        if (_cntrl) _cntrl->release_shared();
+    }
+
+    // operator=
+
+    shared_ptr& operator=(const shared_ptr& rhs) noexcept {
+        shared_ptr(rhs).swap(*this);
+        return *this;
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    shared_ptr& operator=(const shared_ptr<U>& rhs) noexcept {
+        shared_ptr(rhs).swap(*this);
+        return *this;
+    }
+    shared_ptr& operator=(shared_ptr&& rhs) noexcept {
+        shared_ptr(xutl::move(rhs)).swap(*this);
+        return *this;
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    shared_ptr& operator=(shared_ptr<U>&& rhs) noexcept {
+        shared_ptr(xutl::move(rhs)).swap(*this);
+        return *this;
+    }
+    template <typename U, typename D>
+    shared_ptr& operator=(unique_ptr<U, D>&& rhs) {
+        shared_ptr(xutl::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    // 修改
+
+    void reset() noexcept {
+        shared_ptr().swap(*this);
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    void reset(U* ptr) {
+        shared_ptr(ptr).swap(*this);
+    }
+    template <typename U, typename D, typename = _enable_if_convertible<U>>
+    void reset(U* ptr, D d) {
+        shared_ptr(ptr, d).swap(*this);
+    }
+    void swap(shared_ptr& rhs) noexcept {
+        xutl::swap(_ptr, rhs._ptr);
+        xutl::swap(_cntrl, rhs._cntrl);
+    }
+
+    // 观察
+
+    element_type* get() const noexcept {
+        return _ptr;
+    }
+    typename xutl::add_lvalue_reference<element_type>::type operator*()
+        const noexcept {
+        return *_ptr;
+    }
+    element_type* operator->() const noexcept {
+        return _ptr;
+    }
+    long use_count() const noexcept {
+        return _cntrl ? _cntrl->use_count() : 0;
+    }
+    bool unique() const noexcept {
+        return use_count() == 1;
+    }
+    explicit operator bool() const noexcept {
+        return _ptr != nullptr;
+    }
+    // 按控制块而不是指向的对象排序
+    template <typename U>
+    bool owner_before(const shared_ptr<U>& rhs) const noexcept {
+        return _cntrl < rhs._cntrl;
+    }
+    template <typename U>
+    bool owner_before(const weak_ptr<U>& rhs) const noexcept {
+        return _cntrl < rhs._cntrl;
+    }
+
+private:
+    // 接管一个已经计入了本次引用的控制块
+    struct _adopt_tag {};
+    shared_ptr(_adopt_tag, element_type* ptr, _shared_count* cntrl) noexcept
+        : _ptr(ptr), _cntrl(cntrl) {
+    }
+};
+
+template <typename T>
+struct is_trivially_relocatable<shared_ptr<T>> : public true_type {};
+
+// allocate_shared / make_shared
+// 控制块和对象放在同一块 allocator 分配的内存中
+
+template <typename T, typename... Args>
+inline shared_ptr<T> allocate_shared(const allocator<T>&, Args&&... args) {
+    using block = _shared_ptr_emplace<T>;
+    using block_allocator = typename allocator<T>::template rebind<block>::other;
+    block* cntrl = block_allocator::allocate();
+    try {
+        ::new (cntrl) block(xutl::forward<Args>(args)...);
+    } catch (...) {
+        block_allocator::deallocate(cntrl);
+        throw;
+    }
+    return shared_ptr<T>(typename shared_ptr<T>::_adopt_tag(), cntrl->get(),
+                         cntrl);
+}
+
+template <typename T, typename... Args>
+inline shared_ptr<T> make_shared(Args&&... args) {
+    return xutl::allocate_shared<T>(allocator<T>(),
+                                    xutl::forward<Args>(args)...);
+}
+
+// 类型转换
+
+template <typename T, typename U>
+inline shared_ptr<T> static_pointer_cast(const shared_ptr<U>& rhs) noexcept {
+    return shared_ptr<T>(rhs, static_cast<T*>(rhs.get()));
+}
+template <typename T, typename U>
+inline shared_ptr<T> dynamic_pointer_cast(const shared_ptr<U>& rhs) noexcept {
+    T* ptr = dynamic_cast<T*>(rhs.get());
+    return ptr ? shared_ptr<T>(rhs, ptr) : shared_ptr<T>();
+}
+template <typename T, typename U>
+inline shared_ptr<T> const_pointer_cast(const shared_ptr<U>& rhs) noexcept {
+    return shared_ptr<T>(rhs, const_cast<T*>(rhs.get()));
+}
+
+// 比较操作
+
+template <typename T, typename U>
+inline bool operator==(const shared_ptr<T>& lhs,
+                       const shared_ptr<U>& rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+template <typename T, typename U>
+inline bool operator!=(const shared_ptr<T>& lhs,
+                       const shared_ptr<U>& rhs) noexcept {
+    return lhs.get() != rhs.get();
+}
+template <typename T, typename U>
+inline bool operator<(const shared_ptr<T>& lhs,
+                      const shared_ptr<U>& rhs) noexcept {
+    return lhs.get() < rhs.get();
+}
+template <typename T>
+inline bool operator==(const shared_ptr<T>& lhs, std::nullptr_t) noexcept {
+    return !lhs;
+}
+template <typename T>
+inline bool operator==(std::nullptr_t, const shared_ptr<T>& rhs) noexcept {
+    return !rhs;
+}
+template <typename T>
+inline bool operator!=(const shared_ptr<T>& lhs, std::nullptr_t) noexcept {
+    return static_cast<bool>(lhs);
+}
+template <typename T>
+inline bool operator!=(std::nullptr_t, const shared_ptr<T>& rhs) noexcept {
+    return static_cast<bool>(rhs);
+}
+
+template <typename T>
+inline void swap(shared_ptr<T>& lhs, shared_ptr<T>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+// ************************************************************************************
+// weak_ptr
+// 不拥有对象，只观察 shared_ptr 管理的对象是否还存在
+// ************************************************************************************
+
+template <typename T>
+class weak_ptr {
+public:
+    using element_type = T;
+
+private:
+    element_type* _ptr;
+    _shared_count* _cntrl;
+
+    template <typename U>
+    friend class shared_ptr;
+    template <typename U>
+    friend class weak_ptr;
+
+    template <typename U>
+    using _enable_if_convertible =
+        typename enable_if<xutl::is_convertible<U*, T*>::value>::type;
+
+public:
+    constexpr weak_ptr() noexcept : _ptr(nullptr), _cntrl(nullptr) {
+    }
+    weak_ptr(const weak_ptr& rhs) noexcept : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        if (_cntrl) _cntrl->add_weak();
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    weak_ptr(const weak_ptr<U>& rhs) noexcept
+        : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        if (_cntrl) _cntrl->add_weak();
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    weak_ptr(const shared_ptr<U>& rhs) noexcept
+        : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        if (_cntrl) _cntrl->add_weak();
+    }
+    weak_ptr(weak_ptr&& rhs) noexcept : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        rhs._ptr = nullptr;
+        rhs._cntrl = nullptr;
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    weak_ptr(weak_ptr<U>&& rhs) noexcept : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        rhs._ptr = nullptr;
+        rhs._cntrl = nullptr;
+    }
+
+    ~weak_ptr() {
+        if (_cntrl) _cntrl->release_weak();
+    }
+
+    weak_ptr& operator=(const weak_ptr& rhs) noexcept {
+        weak_ptr(rhs).swap(*this);
+        return *this;
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    weak_ptr& operator=(const weak_ptr<U>& rhs) noexcept {
+        weak_ptr(rhs).swap(*this);
+        return *this;
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    weak_ptr& operator=(const shared_ptr<U>& rhs) noexcept {
+        weak_ptr(rhs).swap(*this);
+        return *this;
+    }
+    weak_ptr& operator=(weak_ptr&& rhs) noexcept {
+        weak_ptr(xutl::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    void reset() noexcept {
+        weak_ptr().swap(*this);
+    }
+    void swap(weak_ptr& rhs) noexcept {
+        xutl::swap(_ptr, rhs._ptr);
+        xutl::swap(_cntrl, rhs._cntrl);
+    }
+
+    long use_count() const noexcept {
+        return _cntrl ? _cntrl->use_count() : 0;
+    }
+    bool expired() const noexcept {
+        return use_count() == 0;
+    }
+    // 对象仍然存在时返回共享它的 shared_ptr，否则返回空的 shared_ptr
+    shared_ptr<T> lock() const noexcept {
+        if (_cntrl && _cntrl->lock()) {
+            return shared_ptr<T>(typename shared_ptr<T>::_adopt_tag(), _ptr,
+                                 _cntrl);
+        }
+        return shared_ptr<T>();
+    }
+    template <typename U>
+    bool owner_before(const shared_ptr<U>& rhs) const noexcept {
+        return _cntrl < rhs._cntrl;
+    }
+    template <typename U>
+    bool owner_before(const weak_ptr<U>& rhs) const noexcept {
+        return _cntrl < rhs._cntrl;
+    }
+};
+
+template <typename T>
+struct is_trivially_relocatable<weak_ptr<T>> : public true_type {};
+
+template <typename T>
+inline void swap(weak_ptr<T>& lhs, weak_ptr<T>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+// ************************************************************************************
+// local_shared_ptr
+// 引用计数不是原子操作的 shared_ptr，用于不会跨线程共享的对象，
+// 拷贝和析构只是普通的加减法；不支持 weak_ptr
+// ************************************************************************************
+
+template <typename T>
+class local_shared_ptr {
+public:
+    using element_type = T;
+
+private:
+    element_type* _ptr;
+    _local_shared_count* _cntrl;
+
+    template <typename U>
+    friend class local_shared_ptr;
+    template <typename U, typename... Args>
+    friend local_shared_ptr<U> allocate_local_shared(const allocator<U>&,
+                                                     Args&&...);
+
+    template <typename U>
+    using _enable_if_convertible =
+        typename enable_if<xutl::is_convertible<U*, T*>::value>::type;
+
+    // 接管一个已经计入了本次引用的控制块，供 allocate_local_shared 使用
+    struct _adopt_tag {};
+    local_shared_ptr(_adopt_tag, element_type* ptr,
+                     _local_shared_count* cntrl) noexcept
+        : _ptr(ptr), _cntrl(cntrl) {
+    }
+
+public:
+    // 构造函数
+
+    constexpr local_shared_ptr() noexcept : _ptr(nullptr), _cntrl(nullptr) {
+    }
+    constexpr local_shared_ptr(std::nullptr_t) noexcept
+        : _ptr(nullptr), _cntrl(nullptr) {
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    explicit local_shared_ptr(U* ptr)
+        : local_shared_ptr(ptr, default_delete<U>()) {
+    }
+    template <typename U, typename D, typename = _enable_if_convertible<U>>
+    local_shared_ptr(U* ptr, D d) : _ptr(ptr), _cntrl(nullptr) {
+        using block = _shared_ptr_pointer<U*, D, _local_shared_count>;
+        block* cntrl = nullptr;
+        try {
+            cntrl = allocator<block>::allocate();
+            ::new (cntrl) block(ptr, d);
+        } catch (...) {
+            allocator<block>::deallocate(cntrl);
+            d(ptr);
+            throw;
+        }
+        _cntrl = cntrl;
+    }
+    template <typename U>
+    local_shared_ptr(const local_shared_ptr<U>& rhs,
+                     element_type* ptr) noexcept
+        : _ptr(ptr), _cntrl(rhs._cntrl) {
+        if (_cntrl) _cntrl->add_shared();
+    }
+    local_shared_ptr(const local_shared_ptr& rhs) noexcept
+        : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        if (_cntrl) _cntrl->add_shared();
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    local_shared_ptr(const local_shared_ptr<U>& rhs) noexcept
+        : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        if (_cntrl) _cntrl->add_shared();
+    }
+    local_shared_ptr(local_shared_ptr&& rhs) noexcept
+        : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        rhs._ptr = nullptr;
+        rhs._cntrl = nullptr;
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    local_shared_ptr(local_shared_ptr<U>&& rhs) noexcept
+        : _ptr(rhs._ptr), _cntrl(rhs._cntrl) {
+        rhs._ptr = nullptr;
+        rhs._cntrl = nullptr;
+    }
+    template <typename U, typename D,
+              typename = typename enable_if<xutl::is_convertible<
+                  typename unique_ptr<U, D>::pointer, element_type*>::value>::type>
+    local_shared_ptr(unique_ptr<U, D>&& rhs) : _ptr(nullptr), _cntrl(nullptr) {
+        if (rhs) {
+            _cntrl = _new_pointer_block<_local_shared_count>(
+                rhs.get(), rhs.get_deleter());
+            _ptr = rhs.release();
+        }
+    }
+
+    ~local_shared_ptr() {
+        if (_cntrl) _cntrl->release_shared();
+    }
+
+    // operator=
+
+    local_shared_ptr& operator=(const local_shared_ptr& rhs) noexcept {
+        local_shared_ptr(rhs).swap(*this);
+        return *this;
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    local_shared_ptr& operator=(const local_shared_ptr<U>& rhs) noexcept {
+        local_shared_ptr(rhs).swap(*this);
+        return *this;
+    }
+    local_shared_ptr& operator=(local_shared_ptr&& rhs) noexcept {
+        local_shared_ptr(xutl::move(rhs)).swap(*this);
+        return *this;
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    local_shared_ptr& operator=(local_shared_ptr<U>&& rhs) noexcept {
+        local_shared_ptr(xutl::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    // 修改
+
+    void reset() noexcept {
+        local_shared_ptr().swap(*this);
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    void reset(U* ptr) {
+        local_shared_ptr(ptr).swap(*this);
+    }
+    template <typename U, typename D, typename = _enable_if_convertible<U>>
+    void reset(U* ptr, D d) {
+        local_shared_ptr(ptr, d).swap(*this);
+    }
+    void swap(local_shared_ptr& rhs) noexcept {
+        xutl::swap(_ptr, rhs._ptr);
+        xutl::swap(_cntrl, rhs._cntrl);
+    }
+
+    // 观察
+
+    element_type* get() const noexcept {
+        return _ptr;
+    }
+    typename xutl::add_lvalue_reference<element_type>::type operator*()
+        const noexcept {
+        return *_ptr;
+    }
+    element_type* operator->() const noexcept {
+        return _ptr;
+    }
+    long use_count() const noexcept {
+        return _cntrl ? _cntrl->use_count() : 0;
+    }
+    explicit operator bool() const noexcept {
+        return _ptr != nullptr;
+    }
+};
+
+template <typename T>
+struct is_trivially_relocatable<local_shared_ptr<T>> : public true_type {};
+
+// allocate_local_shared / make_local_shared
+// 与 make_shared 相同，控制块和对象只需一次 allocator 分配
+
+template <typename T, typename... Args>
+inline local_shared_ptr<T> allocate_local_shared(const allocator<T>&,
+                                                 Args&&... args) {
+    using block = _shared_ptr_emplace<T, _local_shared_count>;
+    using block_allocator = typename allocator<T>::template rebind<block>::other;
+    block* cntrl = block_allocator::allocate();
+    try {
+        ::new (cntrl) block(xutl::forward<Args>(args)...);
+    } catch (...) {
+        block_allocator::deallocate(cntrl);
+        throw;
+    }
+    return local_shared_ptr<T>(typename local_shared_ptr<T>::_adopt_tag(),
+                               cntrl->get(), cntrl);
+}
+
+template <typename T, typename... Args>
+inline local_shared_ptr<T> make_local_shared(Args&&... args) {
+    return xutl::allocate_local_shared<T>(allocator<T>(),
+                                          xutl::forward<Args>(args)...);
+}
+
+template <typename T, typename U>
+inline bool operator==(const local_shared_ptr<T>& lhs,
+                       const local_shared_ptr<U>& rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+template <typename T, typename U>
+inline bool operator!=(const local_shared_ptr<T>& lhs,
+                       const local_shared_ptr<U>& rhs) noexcept {
+    return lhs.get() != rhs.get();
+}
+template <typename T>
+inline bool operator==(const local_shared_ptr<T>& lhs,
+                       std::nullptr_t) noexcept {
+    return !lhs;
+}
+template <typename T>
+inline bool operator!=(const local_shared_ptr<T>& lhs,
+                       std::nullptr_t) noexcept {
+    return static_cast<bool>(lhs);
+}
+
+template <typename T>
+inline void swap(local_shared_ptr<T>& lhs, local_shared_ptr<T>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+// ************************************************************************************
+// intrusive_ptr
+// 引用计数存放在对象内部，由用户提供两个可以通过 ADL 找到的函数：
+//   void intrusive_ptr_add_ref(T*);
+//   void intrusive_ptr_release(T*);  // 计数归零时负责销毁对象
+// intrusive_ptr 本身只有一个指针，也不需要额外分配控制块
+// ************************************************************************************
+
+template <typename T>
+class intrusive_ptr {
+public:
+    using element_type = T;
+
+private:
+    T* _ptr;
+
+    template <typename U>
+    friend class intrusive_ptr;
+
+    template <typename U>
+    using _enable_if_convertible =
+        typename enable_if<xutl::is_convertible<U*, T*>::value>::type;
+
+public:
+    constexpr intrusive_ptr() noexcept : _ptr(nullptr) {
+    }
+    // add_ref 为 false 时接管一个已经计入了本次引用的对象
+    intrusive_ptr(T* ptr, bool add_ref = true) : _ptr(ptr) {
+        if (_ptr && add_ref) intrusive_ptr_add_ref(_ptr);
+    }
+    intrusive_ptr(const intrusive_ptr& rhs) : _ptr(rhs._ptr) {
+        if (_ptr) intrusive_ptr_add_ref(_ptr);
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    intrusive_ptr(const intrusive_ptr<U>& rhs) : _ptr(rhs._ptr) {
+        if (_ptr) intrusive_ptr_add_ref(_ptr);
+    }
+    intrusive_ptr(intrusive_ptr&& rhs) noexcept : _ptr(rhs._ptr) {
+        rhs._ptr = nullptr;
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    intrusive_ptr(intrusive_ptr<U>&& rhs) noexcept : _ptr(rhs._ptr) {
+        rhs._ptr = nullptr;
+    }
+
+    ~intrusive_ptr() {
+        if (_ptr) intrusive_ptr_release(_ptr);
+    }
+
+    intrusive_ptr& operator=(const intrusive_ptr& rhs) {
+        intrusive_ptr(rhs).swap(*this);
+        return *this;
+    }
+    template <typename U, typename = _enable_if_convertible<U>>
+    intrusive_ptr& operator=(const intrusive_ptr<U>& rhs) {
+        intrusive_ptr(rhs).swap(*this);
+        return *this;
+    }
+    intrusive_ptr& operator=(intrusive_ptr&& rhs) noexcept {
+        intrusive_ptr(xutl::move(rhs)).swap(*this);
+        return *this;
+    }
+    intrusive_ptr& operator=(T* ptr) {
+        intrusive_ptr(ptr).swap(*this);
+        return *this;
+    }
+
+    void reset() {
+        intrusive_ptr().swap(*this);
+    }
+    void reset(T* ptr, bool add_ref = true) {
+        intrusive_ptr(ptr, add_ref).swap(*this);
+    }
+    // 放弃所有权但不减少引用计数，返回指针
+    T* detach() noexcept {
+        T* ptr = _ptr;
+        _ptr = nullptr;
+        return ptr;
+    }
+    void swap(intrusive_ptr& rhs) noexcept {
+        xutl::swap(_ptr, rhs._ptr);
+    }
+
+    T* get() const noexcept {
+        return _ptr;
+    }
+    T& operator*() const noexcept {
+        return *_ptr;
+    }
+    T* operator->() const noexcept {
+        return _ptr;
+    }
+    explicit operator bool() const noexcept {
+        return _ptr != nullptr;
+    }
+};
+
+template <typename T>
+struct is_trivially_relocatable<intrusive_ptr<T>> : public true_type {};
+
+template <typename T, typename U>
+inline bool operator==(const intrusive_ptr<T>& lhs,
+                       const intrusive_ptr<U>& rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+template <typename T, typename U>
+inline bool operator!=(const intrusive_ptr<T>& lhs,
+                       const intrusive_ptr<U>& rhs) noexcept {
+    return lhs.get() != rhs.get();
+}
+template <typename T>
+inline bool operator==(const intrusive_ptr<T>& lhs, std::nullptr_t) noexcept {
+    return !lhs;
+}
+template <typename T>
+inline bool operator!=(const intrusive_ptr<T>& lhs, std::nullptr_t) noexcept {
+    return static_cast<bool>(lhs);
+}
+
+template <typename T>
+inline void swap(intrusive_ptr<T>& lhs, intrusive_ptr<T>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+template <typename T, typename U>
+inline intrusive_ptr<T> static_pointer_cast(const intrusive_ptr<U>& rhs) {
+    return intrusive_ptr<T>(static_cast<T*>(rhs.get()));
+}
+template <typename T, typename U>
+inline intrusive_ptr<T> dynamic_pointer_cast(const intrusive_ptr<U>& rhs) {
+    return intrusive_ptr<T>(dynamic_cast<T*>(rhs.get()));
+}
+
+// ************************************************************************************
+// intrusive_ref_counter
+// 为 intrusive_ptr 提供引用计数的基类，Derived 继承它即可直接放进 intrusive_ptr。
+// 计数归零时用 allocator<Derived> 析构并释放对象，因此对象应当由 make_intrusive
+// 创建（allocator 使用全局 operator new，用 new 创建的对象也可以）
+// ************************************************************************************
+
+// 计数策略：非原子计数，只能在单个线程内使用
+struct thread_unsafe_counter {
+    using type = long;
+
+    static long increment(long& count) noexcept {
+        return ++count;
+    }
+    static long decrement(long& count) noexcept {
+        return --count;
+    }
+    static long load(const long& count) noexcept {
+        return count;
+    }
+};
+
+// 计数策略：原子计数
+struct thread_safe_counter {
+    using type = std::atomic<long>;
+
+    static long increment(std::atomic<long>& count) noexcept {
+        return count.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    static long decrement(std::atomic<long>& count) noexcept {
+        return count.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    }
+    static long load(const std::atomic<long>& count) noexcept {
+        return count.load(std::memory_order_relaxed);
+    }
+};
+
+template <typename Derived, typename CounterPolicy = thread_unsafe_counter>
+class intrusive_ref_counter {
+public:
+    intrusive_ref_counter() noexcept : _ref_count(0) {
+    }
+    // 拷贝出来的对象是新的对象，引用计数从 0 开始
+    intrusive_ref_counter(const intrusive_ref_counter&) noexcept
+        : _ref_count(0) {
+    }
+    intrusive_ref_counter& operator=(const intrusive_ref_counter&) noexcept {
+        return *this;
+    }
+
+    long use_count() const noexcept {
+        return CounterPolicy::load(_ref_count);
+    }
+
+    friend void intrusive_ptr_add_ref(
+        const intrusive_ref_counter* counter) noexcept {
+        CounterPolicy::increment(counter->_ref_count);
+    }
+    friend void intrusive_ptr_release(
+        const intrusive_ref_counter* counter) noexcept {
+        if (CounterPolicy::decrement(counter->_ref_count) == 0) {
+            Derived* ptr =
+                static_cast<Derived*>(const_cast<intrusive_ref_counter*>(counter));
+            allocator<Derived>::destroy(ptr);
+            allocator<Derived>::deallocate(ptr);
+        }
+    }
+
+protected:
+    ~intrusive_ref_counter() = default;
+
+private:
+    mutable typename CounterPolicy::type _ref_count;
+};
+
+// 用 allocator<T> 创建对象并放进 intrusive_ptr
+template <typename T, typename... Args>
+inline intrusive_ptr<T> make_intrusive(Args&&... args) {
+    T* ptr = allocator<T>::allocate();
+    try {
+        allocator<T>::construct(ptr, xutl::forward<Args>(args)...);
+    } catch (...) {
+        allocator<T>::deallocate(ptr);
+        throw;
+    }
+    return intrusive_ptr<T>(ptr);
+}
+
 }  // namespace xutl
 
 #endif  // XUTL_MEMORY_H_
\ No newline at end of file
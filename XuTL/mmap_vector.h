@@ -0,0 +1,719 @@
+#ifndef XUTL_MMAP_VECTOR_H_
+#define XUTL_MMAP_VECTOR_H_
+
+/**
+ * 该文件包含一个模板类 mmap_vector
+ * 它的元素保存在一个映射到内存的文件中，接口与 vector 相同，进程重启后重新打开文件
+ * 只需要一次 mmap，不必重建整个表
+ *
+ * 文件布局：开头是 64 字节的文件头（魔数、版本、元素大小、类型标签、元素个数、容量），
+ * 随后是 capacity 个元素。扩容时用 ftruncate 加长文件，再用 mremap 扩大映射；
+ * 元素个数直接写在映射的文件头里，因此对元素的修改和 sync() 之后的状态会一起落盘
+ *
+ * 只支持 trivially copyable 的 T，元素按字节读写，不调用构造函数和析构函数
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "algorithm.h"
+#include "exceptdef.h"
+#include "iterator.h"
+#include "type_traits.h"
+#include "uninitialized.h"
+#include "utils.h"
+
+namespace xutl
+{
+
+// 文件头，固定 64 字节，元素从第 64 字节开始
+struct mmap_vector_header
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t element_size;
+    uint64_t type_tag;
+    uint64_t size;
+    uint64_t capacity;
+    uint64_t reserved[3];
+};
+
+static_assert(sizeof(mmap_vector_header) == 64, "文件头必须是 64 字节");
+
+// 打开方式
+enum class mmap_mode
+{
+    read_write,  // 读写，文件不存在时创建
+    read_only,   // 只读，打开时用 MAP_POPULATE 预先读入所有页
+    truncate     // 读写，丢弃文件原有的内容
+};
+
+// 访问模式提示，对应 madvise 的参数
+enum class mmap_advice
+{
+    normal,
+    sequential,
+    random,
+    willneed,
+    dontneed
+};
+
+// 类型 T 的默认标签：对编译器给出的类型名做 FNV-1a 哈希
+// 类型名的写法取决于编译器，需要在不同编译器之间共享文件时应显式指定标签
+template <typename T>
+uint64_t mmap_type_tag() noexcept
+{
+    static const uint64_t tag = []() {
+        uint64_t h = 14695981039346656037ull;
+        for (const char* p = __PRETTY_FUNCTION__; *p != '\0'; ++p)
+        {
+            h = (h ^ static_cast<unsigned char>(*p)) * 1099511628211ull;
+        }
+        return h;
+    }();
+    return tag;
+}
+
+// mmap_vector 类
+template <typename T>
+class mmap_vector
+{
+public:
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "xutl::mmap_vector 只支持 trivially copyable 的 value_type");
+    static_assert(alignof(T) <= sizeof(mmap_vector_header),
+                  "xutl::mmap_vector 的 value_type 对齐要求过大");
+
+    using value_type = T;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = value_type*;
+    using const_iterator = const value_type*;
+    using reverse_iterator = xutl::reverse_iterator<iterator>;
+    using const_reverse_iterator = xutl::reverse_iterator<const_iterator>;
+
+    static constexpr uint64_t magic = 0x4345564d4c545558ull;  // "XUTLMVEC"
+    static constexpr uint32_t version = 1;
+
+private:  // 数据成员
+    int _fd = -1;
+    char* _map = nullptr;  // 映射的起始地址，即文件头
+    size_type _map_bytes = 0;
+    bool _writable = false;
+
+public:
+    // ********************************************************************************
+    // 构造函数/析构函数
+    // ********************************************************************************
+
+    // 构造一个没有打开文件的 mmap_vector
+    mmap_vector() noexcept = default;
+
+    // 打开 path 对应的文件，tag 必须与创建文件时的标签一致
+    explicit mmap_vector(const char* path,
+                         mmap_mode mode = mmap_mode::read_write,
+                         uint64_t tag = mmap_type_tag<T>())
+    {
+        open(path, mode, tag);
+    }
+
+    mmap_vector(const mmap_vector&) = delete;
+    mmap_vector& operator=(const mmap_vector&) = delete;
+
+    mmap_vector(mmap_vector&& x) noexcept
+    {
+        swap(x);
+    }
+    mmap_vector& operator=(mmap_vector&& x) noexcept
+    {
+        mmap_vector tmp(xutl::move(x));
+        swap(tmp);
+        return *this;
+    }
+
+    ~mmap_vector()
+    {
+        close();
+    }
+
+    // ********************************************************************************
+    // 文件相关
+    // ********************************************************************************
+
+    void open(const char* path, mmap_mode mode = mmap_mode::read_write,
+              uint64_t tag = mmap_type_tag<T>());
+
+    // 解除映射并关闭文件，不会主动刷盘
+    void close() noexcept
+    {
+        if (_map != nullptr)
+        {
+            ::munmap(_map, _map_bytes);
+            _map = nullptr;
+            _map_bytes = 0;
+        }
+        if (_fd >= 0)
+        {
+            ::close(_fd);
+            _fd = -1;
+        }
+        _writable = false;
+    }
+
+    bool is_open() const noexcept
+    {
+        return _map != nullptr;
+    }
+    bool is_read_only() const noexcept
+    {
+        return is_open() && !_writable;
+    }
+
+    // 把修改写回文件；async 为 true 时只发起写回，不等待完成
+    void sync(bool async = false)
+    {
+        if (_map == nullptr || !_writable) return;
+        if (::msync(_map, _map_bytes, async ? MS_ASYNC : MS_SYNC) != 0)
+        {
+            THROW_SYSTEM_ERROR("mmap_vector<T>: msync");
+        }
+    }
+
+    // 提示接下来的访问模式，失败时忽略
+    void advise(mmap_advice advice) const noexcept
+    {
+        if (_map == nullptr) return;
+        int a = MADV_NORMAL;
+        switch (advice)
+        {
+        case mmap_advice::normal: a = MADV_NORMAL; break;
+        case mmap_advice::sequential: a = MADV_SEQUENTIAL; break;
+        case mmap_advice::random: a = MADV_RANDOM; break;
+        case mmap_advice::willneed: a = MADV_WILLNEED; break;
+        case mmap_advice::dontneed: a = MADV_DONTNEED; break;
+        }
+        ::madvise(_map, _map_bytes, a);
+    }
+
+    // 没有打开文件时返回 0
+    uint64_t type_tag() const noexcept
+    {
+        return _map == nullptr ? 0 : _header()->type_tag;
+    }
+
+    // ********************************************************************************
+    // 迭代器相关
+    // ********************************************************************************
+
+    iterator begin() noexcept
+    {
+        return _data();
+    }
+    const_iterator begin() const noexcept
+    {
+        return _data();
+    }
+    iterator end() noexcept
+    {
+        return _data() + size();
+    }
+    const_iterator end() const noexcept
+    {
+        return _data() + size();
+    }
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+    const_reverse_iterator crbegin() const noexcept
+    {
+        return rbegin();
+    }
+    const_reverse_iterator crend() const noexcept
+    {
+        return rend();
+    }
+
+    // ********************************************************************************
+    // 容量相关
+    // ********************************************************************************
+
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+    size_type size() const noexcept
+    {
+        return _map == nullptr ? 0 : static_cast<size_type>(_header()->size);
+    }
+    size_type capacity() const noexcept
+    {
+        return _map == nullptr ? 0
+                               : static_cast<size_type>(_header()->capacity);
+    }
+    size_type max_size() const noexcept
+    {
+        return (static_cast<size_type>(-1) - sizeof(mmap_vector_header)) /
+               sizeof(T);
+    }
+
+    void reserve(size_type n)
+    {
+        if (n > capacity())
+        {
+            _remap(n);
+        }
+    }
+
+    // 缩短文件，丢弃多余的容量
+    void shrink_to_fit()
+    {
+        if (size() < capacity())
+        {
+            _remap(size());
+        }
+    }
+
+    // ********************************************************************************
+    // 元素访问
+    // ********************************************************************************
+
+    reference operator[](size_type n)
+    {
+        return *(begin() + n);
+    }
+    const_reference operator[](size_type n) const
+    {
+        return *(begin() + n);
+    }
+
+    reference at(size_type n)
+    {
+        if (n >= size())
+        {
+            THROW_OUT_OF_RANGE("mmap_vector");
+        }
+        return *(begin() + n);
+    }
+    const_reference at(size_type n) const
+    {
+        if (n >= size())
+        {
+            THROW_OUT_OF_RANGE("mmap_vector");
+        }
+        return *(begin() + n);
+    }
+
+    reference front()
+    {
+        return *begin();
+    }
+    const_reference front() const
+    {
+        return *begin();
+    }
+    reference back()
+    {
+        return *(end() - 1);
+    }
+    const_reference back() const
+    {
+        return *(end() - 1);
+    }
+
+    pointer data() noexcept
+    {
+        return _data();
+    }
+    const_pointer data() const noexcept
+    {
+        return _data();
+    }
+
+    // ********************************************************************************
+    // 修改容器相关
+    // ********************************************************************************
+
+    void assign(size_type n, const_reference value)
+    {
+        const value_type tmp = value;
+        clear();
+        reserve(n);
+        xutl::uninitialized_fill_n(_data(), n, tmp);
+        _set_size(n);
+    }
+    template <typename InputIterator>
+    void assign(InputIterator first, InputIterator last,
+                typename enable_if<
+                    xutl::is_input_iterator<InputIterator>::value>::type* =
+                    nullptr)
+    {
+        clear();
+        insert(end(), first, last);
+    }
+    void assign(std::initializer_list<value_type> list)
+    {
+        assign(list.begin(), list.end());
+    }
+
+    void push_back(const_reference value)
+    {
+        const value_type tmp = value;  // value 可能是本容器的元素，扩容后失效
+        _check_writable();
+        if (size() == capacity())
+        {
+            _remap(_recommend_capacity(size() + 1));
+        }
+        _data()[size()] = tmp;
+        _set_size(size() + 1);
+    }
+    template <typename... Args>
+    void emplace_back(Args&&... args)
+    {
+        push_back(value_type(xutl::forward<Args>(args)...));
+    }
+
+    void pop_back()
+    {
+        _check_writable();
+        XUTL_ASSERT(!empty());
+        _set_size(size() - 1);
+    }
+
+    iterator insert(const_iterator pos, const_reference value)
+    {
+        return insert(pos, static_cast<size_type>(1), value);
+    }
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        return insert(pos, value_type(xutl::forward<Args>(args)...));
+    }
+    iterator insert(const_iterator pos, size_type n, const_reference value)
+    {
+        const value_type tmp = value;
+        pointer p = _make_gap(pos, n);
+        xutl::uninitialized_fill_n(p, n, tmp);
+        return p;
+    }
+    // [first, last) 不能是本容器中的元素
+    template <typename InputIterator>
+    iterator insert(const_iterator pos, InputIterator first,
+                    InputIterator last,
+                    typename enable_if<xutl::is_input_iterator<
+                        InputIterator>::value>::type* = nullptr)
+    {
+        const size_type offset = static_cast<size_type>(pos - begin());
+        const size_type n = static_cast<size_type>(xutl::distance(first, last));
+        pointer p = _make_gap(pos, n);
+        for (; first != last; ++first, ++p)
+        {
+            *p = *first;
+        }
+        return _data() + offset;
+    }
+    iterator insert(const_iterator pos, std::initializer_list<value_type> list)
+    {
+        return insert(pos, list.begin(), list.end());
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        _check_writable();
+        pointer p = const_cast<pointer>(first);
+        const size_type n = static_cast<size_type>(last - first);
+        if (n > 0)
+        {
+            std::memmove(p, last, (cend() - last) * sizeof(T));
+            _set_size(size() - n);
+        }
+        return p;
+    }
+
+    void clear()
+    {
+        if (_map != nullptr && size() > 0)
+        {
+            _check_writable();
+            _set_size(0);
+        }
+    }
+
+    void resize(size_type new_size)
+    {
+        resize(new_size, value_type());
+    }
+    void resize(size_type new_size, const_reference value)
+    {
+        if (new_size < size())
+        {
+            erase(begin() + new_size, end());
+        }
+        else
+        {
+            insert(end(), new_size - size(), value);
+        }
+    }
+
+    // 把容量扩大到至少 n，调用 op(data(), n) 直接写入，op 返回保留的元素个数
+    template <typename Operation>
+    void resize_and_overwrite(size_type n, Operation op)
+    {
+        _check_writable();
+        reserve(n);
+        const size_type m = static_cast<size_type>(op(_data(), n));
+        XUTL_ASSERT(m <= n);
+        _set_size(m);
+    }
+
+    void swap(mmap_vector& x) noexcept
+    {
+        xutl::swap(_fd, x._fd);
+        xutl::swap(_map, x._map);
+        xutl::swap(_map_bytes, x._map_bytes);
+        xutl::swap(_writable, x._writable);
+    }
+
+private:
+    // ********************************************************************************
+    // 辅助函数
+    // ********************************************************************************
+
+    mmap_vector_header* _header() const noexcept
+    {
+        return reinterpret_cast<mmap_vector_header*>(_map);
+    }
+
+    pointer _data() const noexcept
+    {
+        return _map == nullptr
+                   ? nullptr
+                   : reinterpret_cast<pointer>(_map +
+                                               sizeof(mmap_vector_header));
+    }
+
+    void _set_size(size_type n) noexcept
+    {
+        _header()->size = n;
+    }
+
+    void _check_writable() const
+    {
+        if (!_writable)
+        {
+            THROW_RUNTIME_ERROR("mmap_vector<T> is not open for writing");
+        }
+    }
+
+    size_type _recommend_capacity(size_type new_capacity) const
+    {
+        const size_type ms = max_size();
+        if (new_capacity > ms)
+        {
+            THROW_LENGTH_ERROR("mmap_vector<T> is too large");
+        }
+        const size_type cap = capacity();
+        if (cap >= ms / 2) return ms;
+        return xutl::max<size_type>(2 * cap, new_capacity);
+    }
+
+    // 容纳 n 个元素所需的文件大小，按页对齐
+    static size_type _file_bytes(size_type n)
+    {
+        const size_type page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+        const size_type bytes = sizeof(mmap_vector_header) + n * sizeof(T);
+        return (bytes + page - 1) / page * page;
+    }
+
+    // 把文件和映射调整为至少容纳 n 个元素，多出的页也计入容量
+    void _remap(size_type n)
+    {
+        _check_writable();
+        const size_type bytes = _file_bytes(n);
+        if (bytes == _map_bytes) return;
+        if (::ftruncate(_fd, static_cast<off_t>(bytes)) != 0)
+        {
+            THROW_SYSTEM_ERROR("mmap_vector<T>: ftruncate");
+        }
+#if defined(__linux__)
+        void* p = ::mremap(_map, _map_bytes, bytes, MREMAP_MAYMOVE);
+#else
+        ::munmap(_map, _map_bytes);
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         _fd, 0);
+#endif
+        if (p == MAP_FAILED)
+        {
+            // 映射保持原样；文件可能已经改变大小，恢复为原来的大小
+            const int saved = errno;
+            (void)::ftruncate(_fd, static_cast<off_t>(_map_bytes));
+            errno = saved;
+            THROW_SYSTEM_ERROR("mmap_vector<T>: mremap");
+        }
+        _map = static_cast<char*>(p);
+        _map_bytes = bytes;
+        _header()->capacity =
+            (bytes - sizeof(mmap_vector_header)) / sizeof(T);
+    }
+
+    // 在 pos 处空出 n 个元素的位置，返回空位的起点
+    pointer _make_gap(const_iterator pos, size_type n)
+    {
+        _check_writable();
+        const size_type offset = static_cast<size_type>(pos - cbegin());
+        const size_type old_size = size();
+        if (n == 0) return _data() + offset;
+        if (old_size + n > capacity())
+        {
+            _remap(_recommend_capacity(old_size + n));
+        }
+        pointer p = _data() + offset;
+        std::memmove(p + n, p, (old_size - offset) * sizeof(T));
+        _set_size(old_size + n);
+        return p;
+    }
+};
+
+template <typename T>
+constexpr uint64_t mmap_vector<T>::magic;
+template <typename T>
+constexpr uint32_t mmap_vector<T>::version;
+
+template <typename T>
+void mmap_vector<T>::open(const char* path, mmap_mode mode, uint64_t tag)
+{
+    close();
+    const bool writable = mode != mmap_mode::read_only;
+    int flags = writable ? O_RDWR | O_CREAT : O_RDONLY;
+    if (mode == mmap_mode::truncate) flags |= O_TRUNC;
+    _fd = ::open(path, flags | O_CLOEXEC, 0644);
+    if (_fd < 0)
+    {
+        THROW_SYSTEM_ERROR("mmap_vector<T>: open");
+    }
+    _writable = writable;
+    try
+    {
+        struct stat st;
+        if (::fstat(_fd, &st) != 0)
+        {
+            THROW_SYSTEM_ERROR("mmap_vector<T>: fstat");
+        }
+        const size_type file_bytes = static_cast<size_type>(st.st_size);
+        const bool fresh = file_bytes == 0 && writable;
+        if (fresh)
+        {
+            // 新文件：写入文件头，容量为第一页剩余的空间
+            _map_bytes = _file_bytes(0);
+            if (::ftruncate(_fd, static_cast<off_t>(_map_bytes)) != 0)
+            {
+                THROW_SYSTEM_ERROR("mmap_vector<T>: ftruncate");
+            }
+        }
+        else if (file_bytes < sizeof(mmap_vector_header))
+        {
+            THROW_RUNTIME_ERROR("mmap_vector<T>: file is too small");
+        }
+        else
+        {
+            _map_bytes = file_bytes;
+        }
+
+        int prot = PROT_READ;
+        int map_flags = MAP_SHARED;
+        if (writable)
+        {
+            prot |= PROT_WRITE;
+        }
+#if defined(MAP_POPULATE)
+        else
+        {
+            map_flags |= MAP_POPULATE;
+        }
+#endif
+        void* p = ::mmap(nullptr, _map_bytes, prot, map_flags, _fd, 0);
+        if (p == MAP_FAILED)
+        {
+            _map_bytes = 0;
+            THROW_SYSTEM_ERROR("mmap_vector<T>: mmap");
+        }
+        _map = static_cast<char*>(p);
+
+        mmap_vector_header* h = _header();
+        if (fresh)
+        {
+            h->magic = magic;
+            h->version = version;
+            h->element_size = static_cast<uint32_t>(sizeof(T));
+            h->type_tag = tag;
+            h->size = 0;
+            h->capacity =
+                (_map_bytes - sizeof(mmap_vector_header)) / sizeof(T);
+            return;
+        }
+        if (h->magic != magic || h->version != version)
+        {
+            THROW_RUNTIME_ERROR("mmap_vector<T>: not an mmap_vector file");
+        }
+        if (h->element_size != sizeof(T) || h->type_tag != tag)
+        {
+            THROW_RUNTIME_ERROR("mmap_vector<T>: element type mismatch");
+        }
+        if (h->size > h->capacity ||
+            h->capacity > (_map_bytes - sizeof(mmap_vector_header)) / sizeof(T))
+        {
+            THROW_RUNTIME_ERROR("mmap_vector<T>: corrupted header");
+        }
+    }
+    catch (...)
+    {
+        close();
+        throw;
+    }
+}
+
+template <typename T>
+void swap(mmap_vector<T>& x, mmap_vector<T>& y) noexcept
+{
+    x.swap(y);
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_MMAP_VECTOR_H_
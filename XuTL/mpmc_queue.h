@@ -0,0 +1,405 @@
+#ifndef XUTL_MPMC_QUEUE_H_
+#define XUTL_MPMC_QUEUE_H_
+
+/**
+ * 该文件包含一个模板类 mpmc_queue
+ * 它是一个有界的多生产者多消费者无锁队列（Dmitry Vyukov 的算法）
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <thread>
+#endif
+
+#include "construct.h"
+#include "exceptdef.h"
+#include "memory.h"
+#include "type_traits.h"
+#include "utils.h"
+
+namespace xutl
+{
+
+// ************************************************************************************
+// futex 辅助函数
+// 阻塞版本的 push/pop 在队列满/空时睡眠在一个 32 位的「纪元」计数器上，
+// 对端每次成功操作后，仅在有等待者时才递增纪元并唤醒，因此无竞争时不会陷入内核
+// ************************************************************************************
+
+// 若 *word 仍等于 expected，则睡眠直到被唤醒（允许虚假唤醒）
+inline void _futex_wait(std::atomic<uint32_t>* word, uint32_t expected)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE,
+            expected, nullptr, nullptr, 0);
+#else
+    if (word->load(std::memory_order_acquire) == expected)
+    {
+        std::this_thread::yield();
+    }
+#endif
+}
+
+// 唤醒至多 n 个睡眠在 word 上的线程
+inline void _futex_wake(std::atomic<uint32_t>* word, int n)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, n,
+            nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)n;
+#endif
+}
+
+// mpmc_queue 类
+// 每个槽位带有一个序号 sequence：
+//   sequence == pos      槽位空闲，可由第 pos 次 push 写入
+//   sequence == pos + 1  槽位已写入，可由第 pos 次 pop 读出
+// 生产者与消费者只在 _tail/_head 上做一次 CAS，此后各自独占槽位
+template <typename T>
+class mpmc_queue
+{
+public:
+    using value_type = T;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+
+private:
+    // 每个槽位独占一个缓存行，相邻槽位的生产者和消费者互不干扰
+    struct alignas(cache_line_size) slot
+    {
+        std::atomic<size_type> sequence;
+        // 构造元素时抛出了异常的槽位仍要发布，此时为 false，消费者跳过它
+        bool filled;
+        typename aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* data() noexcept
+        {
+            return reinterpret_cast<T*>(&storage);
+        }
+    };
+
+    using slot_allocator = allocator<slot>;
+
+    // 数据成员
+    // 生产者和消费者的计数器分别放在不同的缓存行上
+
+    slot* _slots;
+    size_type _mask;
+    alignas(cache_line_size) std::atomic<size_type> _tail;  // 下一次 push 的位置
+    alignas(cache_line_size) std::atomic<size_type> _head;  // 下一次 pop 的位置
+
+    // 阻塞等待用的纪元计数器和等待者数量
+    alignas(cache_line_size) std::atomic<uint32_t> _not_empty_epoch;
+    std::atomic<uint32_t> _not_empty_waiters;
+    alignas(cache_line_size) std::atomic<uint32_t> _not_full_epoch;
+    std::atomic<uint32_t> _not_full_waiters;
+
+public:
+    // ********************************************************************************
+    // 构造函数/析构函数
+    // ********************************************************************************
+
+    // 构造一个至少能容纳 capacity 个元素的队列，实际容量向上取整为 2 的幂
+    explicit mpmc_queue(size_type capacity) :
+            _slots(nullptr),
+            _mask(0),
+            _tail(0),
+            _head(0),
+            _not_empty_epoch(0),
+            _not_empty_waiters(0),
+            _not_full_epoch(0),
+            _not_full_waiters(0)
+    {
+        if (capacity > max_size())
+        {
+            THROW_LENGTH_ERROR("mpmc_queue<T> is too large");
+        }
+        size_type n = 2;
+        while (n < capacity)
+        {
+            n <<= 1;
+        }
+        _slots = slot_allocator::allocate(n);
+        _mask = n - 1;
+        for (size_type i = 0; i < n; ++i)
+        {
+            xutl::construct(xutl::address_of(_slots[i].sequence), i);
+        }
+    }
+
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    // 析构时不允许有其它线程仍在访问队列
+    ~mpmc_queue()
+    {
+        size_type head = _head.load(std::memory_order_relaxed);
+        size_type tail = _tail.load(std::memory_order_relaxed);
+        for (; head != tail; ++head)
+        {
+            slot& s = _slots[head & _mask];
+            if (s.filled) xutl::destroy(s.data());
+        }
+        for (size_type i = 0; i <= _mask; ++i)
+        {
+            xutl::destroy(xutl::address_of(_slots[i].sequence));
+        }
+        slot_allocator::deallocate(_slots, _mask + 1);
+    }
+
+    // ********************************************************************************
+    // 容量相关
+    // 并发修改时 size() 和 empty() 只是一个近似值
+    // ********************************************************************************
+
+    size_type capacity() const noexcept
+    {
+        return _mask + 1;
+    }
+    size_type size() const noexcept
+    {
+        size_type head = _head.load(std::memory_order_acquire);
+        size_type tail = _tail.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+    static constexpr size_type max_size() noexcept
+    {
+        return (static_cast<size_type>(-1) >> 1) / sizeof(slot);
+    }
+
+    // ********************************************************************************
+    // 非阻塞操作，失败时立即返回 false
+    // ********************************************************************************
+
+    bool try_push(const_reference value)
+    {
+        return try_emplace(value);
+    }
+    bool try_push(value_type&& value)
+    {
+        return try_emplace(xutl::move(value));
+    }
+
+    // 队列已满时返回 false，此时不会动用 args，右值参数仍然完好
+    template <typename... Args>
+    bool try_emplace(Args&&... args);
+
+    // 队列为空时返回 false，否则把队首元素移动到 value
+    bool try_pop(reference value);
+
+    // ********************************************************************************
+    // 阻塞操作，队列满/空时在 futex 上睡眠
+    // ********************************************************************************
+
+    void push(const_reference value)
+    {
+        emplace(value);
+    }
+    void push(value_type&& value)
+    {
+        emplace(xutl::move(value));
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args);
+
+    void pop(reference value);
+
+private:
+    // helper functions
+
+    // 占据一个可写的槽位，队列已满时返回 nullptr
+    slot* _claim_push_slot(size_type& pos) noexcept;
+    // 占据一个可读的槽位，队列为空时返回 nullptr
+    slot* _claim_pop_slot(size_type& pos) noexcept;
+
+    // 通知睡眠在 epoch 上的线程
+    static void _notify(std::atomic<uint32_t>& epoch,
+                        std::atomic<uint32_t>& waiters) noexcept
+    {
+        // 与等待方的 fence 配对：要么等待方看到刚发布的槽位，要么这里看到等待者
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) != 0)
+        {
+            epoch.fetch_add(1, std::memory_order_release);
+            _futex_wake(&epoch, 1);
+        }
+    }
+};
+
+template <typename T>
+typename mpmc_queue<T>::slot* mpmc_queue<T>::_claim_push_slot(
+    size_type& pos) noexcept
+{
+    pos = _tail.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        slot* s = _slots + (pos & _mask);
+        size_type seq = s->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff =
+            static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0)
+        {
+            if (_tail.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed))
+            {
+                return s;
+            }
+        }
+        else if (diff < 0)
+        {
+            return nullptr;  // 槽位还未被上一轮的消费者读走，队列已满
+        }
+        else
+        {
+            pos = _tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+typename mpmc_queue<T>::slot* mpmc_queue<T>::_claim_pop_slot(
+    size_type& pos) noexcept
+{
+    pos = _head.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        slot* s = _slots + (pos & _mask);
+        size_type seq = s->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) -
+                              static_cast<std::ptrdiff_t>(pos + 1);
+        if (diff == 0)
+        {
+            if (_head.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed))
+            {
+                return s;
+            }
+        }
+        else if (diff < 0)
+        {
+            return nullptr;  // 槽位还未被生产者写入，队列为空
+        }
+        else
+        {
+            pos = _head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// 先占据槽位再在其中构造元素，队列已满时参数不会被移动
+template <typename T>
+template <typename... Args>
+bool mpmc_queue<T>::try_emplace(Args&&... args)
+{
+    size_type pos;
+    slot* s = _claim_push_slot(pos);
+    if (s == nullptr) return false;
+    try
+    {
+        xutl::construct(s->data(), xutl::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        // 已占据的槽位必须发布，否则第 pos 次 pop 会永远等待；发布为空洞
+        s->filled = false;
+        s->sequence.store(pos + 1, std::memory_order_release);
+        _notify(_not_empty_epoch, _not_empty_waiters);
+        throw;
+    }
+    s->filled = true;
+    s->sequence.store(pos + 1, std::memory_order_release);
+    _notify(_not_empty_epoch, _not_empty_waiters);
+    return true;
+}
+
+template <typename T>
+bool mpmc_queue<T>::try_pop(reference value)
+{
+    size_type pos;
+    slot* s;
+    for (;;)
+    {
+        s = _claim_pop_slot(pos);
+        if (s == nullptr) return false;
+        if (s->filled) break;
+        // 跳过构造失败的空洞，归还槽位后继续取下一个
+        s->sequence.store(pos + _mask + 1, std::memory_order_release);
+        _notify(_not_full_epoch, _not_full_waiters);
+    }
+    T* ptr = s->data();
+    try
+    {
+        value = xutl::move(*ptr);
+    }
+    catch (...)
+    {
+        // 即使移动赋值失败，也必须归还槽位，否则后续生产者会永远看到队列已满
+        xutl::destroy(ptr);
+        s->sequence.store(pos + _mask + 1, std::memory_order_release);
+        _notify(_not_full_epoch, _not_full_waiters);
+        throw;
+    }
+    xutl::destroy(ptr);
+    s->sequence.store(pos + _mask + 1, std::memory_order_release);
+    _notify(_not_full_epoch, _not_full_waiters);
+    return true;
+}
+
+// 失败的 try_emplace 不会动用参数，因此可以把同一组参数反复转发给它
+template <typename T>
+template <typename... Args>
+void mpmc_queue<T>::emplace(Args&&... args)
+{
+    for (;;)
+    {
+        if (try_emplace(xutl::forward<Args>(args)...)) return;
+        _not_full_waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t epoch = _not_full_epoch.load(std::memory_order_acquire);
+        if (try_emplace(xutl::forward<Args>(args)...))
+        {
+            _not_full_waiters.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+        _futex_wait(&_not_full_epoch, epoch);
+        _not_full_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+void mpmc_queue<T>::pop(reference value)
+{
+    for (;;)
+    {
+        if (try_pop(value)) return;
+        _not_empty_waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t epoch = _not_empty_epoch.load(std::memory_order_acquire);
+        if (try_pop(value))
+        {
+            _not_empty_waiters.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+        _futex_wait(&_not_empty_epoch, epoch);
+        _not_empty_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_MPMC_QUEUE_H_
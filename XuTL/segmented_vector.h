@@ -0,0 +1,753 @@
+#ifndef XUTL_SEGMENTED_VECTOR_H_
+#define XUTL_SEGMENTED_VECTOR_H_
+
+/**
+ * 该文件包含一个模板类 segmented_vector
+ * 它由一组按几何级数增长的块组成：第 k 块可以放 base_chunk_size << k 个元素，
+ * 扩容时只分配新的块，已有的元素从不移动，因此元素的地址在它被删除之前一直有效
+ *
+ * 把下标 i 加上 base_chunk_size 后，最高位的位置决定它在哪一块，余下的低位就是块内
+ * 偏移，因此随机访问只需要一次前导零计数。块指针保存在一张定长的表中，
+ * 表在分配第一块时分配在堆上，之后不再移动：交换和移动容器时只交换表指针，
+ * 迭代器与元素一起归属另一个容器，仍然有效
+ */
+
+#include <climits>
+#include <cstddef>
+#include <initializer_list>
+
+#include "algorithm.h"
+#include "exceptdef.h"
+#include "iterator.h"
+#include "memory.h"
+#include "type_traits.h"
+#include "utils.h"
+
+namespace xutl
+{
+
+// 不超过 n 的最大的 2 的幂的指数，n 必须大于 0
+inline size_t _floor_log2(size_t n) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return sizeof(unsigned long long) * CHAR_BIT - 1 -
+           static_cast<size_t>(
+               __builtin_clzll(static_cast<unsigned long long>(n)));
+#else
+    size_t r = 0;
+    while (n >>= 1)
+    {
+        ++r;
+    }
+    return r;
+#endif
+}
+
+// 不小于 n 的最小的 2 的幂
+constexpr size_t _ceil_pow2(size_t n, size_t p = 1)
+{
+    return p >= n ? p : _ceil_pow2(n, p * 2);
+}
+
+constexpr size_t _constexpr_log2(size_t n)
+{
+    return n <= 1 ? 0 : 1 + _constexpr_log2(n / 2);
+}
+
+// ************************************************************************************
+// segmented_vector_iterator
+// 保存块指针表和下标，另外缓存当前元素的地址和所在块的边界，
+// 顺序遍历时只有跨块才需要重新定位
+// ************************************************************************************
+
+template <typename T, typename Ref, typename Ptr, size_t Base>
+class segmented_vector_iterator
+    : public xutl::iterator<random_access_iterator_tag, T, std::ptrdiff_t, Ptr,
+                            Ref>
+{
+public:
+    using value_type = T;
+    using pointer = Ptr;
+    using reference = Ref;
+    using difference_type = std::ptrdiff_t;
+    using size_type = size_t;
+
+    using self = segmented_vector_iterator<T, Ref, Ptr, Base>;
+    using iterator = segmented_vector_iterator<T, T&, T*, Base>;
+
+private:
+    T* const* _chunks = nullptr;
+    size_type _index = 0;
+    pointer _cur = nullptr;
+    pointer _chunk_begin = nullptr;
+    pointer _chunk_end = nullptr;
+
+    template <typename, typename, typename, size_t>
+    friend class segmented_vector_iterator;
+
+public:
+    segmented_vector_iterator() = default;
+    segmented_vector_iterator(T* const* chunks, size_type index) :
+            _chunks(chunks),
+            _index(index)
+    {
+        _seek();
+    }
+    // iterator 可以转换为 const_iterator
+    segmented_vector_iterator(const iterator& other) :
+            _chunks(other._chunks),
+            _index(other._index),
+            _cur(other._cur),
+            _chunk_begin(other._chunk_begin),
+            _chunk_end(other._chunk_end)
+    {
+    }
+
+    size_type index() const noexcept
+    {
+        return _index;
+    }
+
+    reference operator*() const
+    {
+        return *_cur;
+    }
+    pointer operator->() const
+    {
+        return _cur;
+    }
+    reference operator[](difference_type n) const
+    {
+        return *(*this + n);
+    }
+
+    self& operator++()
+    {
+        ++_index;
+        if (++_cur == _chunk_end) _seek();
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+    self& operator--()
+    {
+        --_index;
+        if (_cur == _chunk_begin)
+        {
+            _seek();
+        }
+        else
+        {
+            --_cur;
+        }
+        return *this;
+    }
+    self operator--(int)
+    {
+        self tmp = *this;
+        --*this;
+        return tmp;
+    }
+    self& operator+=(difference_type n)
+    {
+        _index += n;
+        if (n >= _chunk_begin - _cur && n < _chunk_end - _cur)
+        {
+            _cur += n;
+        }
+        else
+        {
+            _seek();
+        }
+        return *this;
+    }
+    self& operator-=(difference_type n)
+    {
+        return *this += -n;
+    }
+    self operator+(difference_type n) const
+    {
+        self tmp = *this;
+        return tmp += n;
+    }
+    friend self operator+(difference_type n, const self& it)
+    {
+        return it + n;
+    }
+    self operator-(difference_type n) const
+    {
+        self tmp = *this;
+        return tmp -= n;
+    }
+    template <typename R, typename P>
+    difference_type operator-(
+        const segmented_vector_iterator<T, R, P, Base>& rhs) const
+    {
+        return static_cast<difference_type>(_index) -
+               static_cast<difference_type>(rhs._index);
+    }
+
+    template <typename R, typename P>
+    bool operator==(const segmented_vector_iterator<T, R, P, Base>& rhs) const
+    {
+        return _index == rhs._index;
+    }
+    template <typename R, typename P>
+    bool operator!=(const segmented_vector_iterator<T, R, P, Base>& rhs) const
+    {
+        return _index != rhs._index;
+    }
+    template <typename R, typename P>
+    bool operator<(const segmented_vector_iterator<T, R, P, Base>& rhs) const
+    {
+        return _index < rhs._index;
+    }
+    template <typename R, typename P>
+    bool operator>(const segmented_vector_iterator<T, R, P, Base>& rhs) const
+    {
+        return _index > rhs._index;
+    }
+    template <typename R, typename P>
+    bool operator<=(const segmented_vector_iterator<T, R, P, Base>& rhs) const
+    {
+        return _index <= rhs._index;
+    }
+    template <typename R, typename P>
+    bool operator>=(const segmented_vector_iterator<T, R, P, Base>& rhs) const
+    {
+        return _index >= rhs._index;
+    }
+
+private:
+    // 根据 _index 重新定位；所在的块还没有分配时（例如容量已满时的 end()），
+    // 三个指针都为空
+    void _seek()
+    {
+        const size_type j = _index + Base;
+        const size_type msb = _floor_log2(j);
+        T* chunk = _chunks[msb - _constexpr_log2(Base)];
+        if (chunk == nullptr)
+        {
+            _cur = _chunk_begin = _chunk_end = nullptr;
+            return;
+        }
+        _chunk_begin = chunk;
+        _chunk_end = chunk + (size_type(1) << msb);
+        _cur = chunk + (j - (size_type(1) << msb));
+    }
+};
+
+// ************************************************************************************
+// segmented_vector
+// ************************************************************************************
+
+template <typename T>
+class segmented_vector
+{
+public:
+    // 第 0 块的元素个数：至少 8 个，且至少占 512 字节，取 2 的幂
+    static constexpr size_t base_chunk_size =
+        _ceil_pow2(512 / sizeof(T) > 8 ? 512 / sizeof(T) : 8);
+
+    using allocator_type = allocator<T>;
+
+    using value_type = T;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator =
+        segmented_vector_iterator<T, T&, T*, base_chunk_size>;
+    using const_iterator =
+        segmented_vector_iterator<T, const T&, const T*, base_chunk_size>;
+    using reverse_iterator = xutl::reverse_iterator<iterator>;
+    using const_reverse_iterator = xutl::reverse_iterator<const_iterator>;
+
+private:
+    static constexpr size_type _base_shift = _constexpr_log2(base_chunk_size);
+    // 块的最大个数，再多一个空指针作为哨兵，供容量已满时的 end() 定位
+    static constexpr size_type _max_chunks =
+        sizeof(size_type) * CHAR_BIT - _base_shift;
+
+    using _data_allocator = allocator_type;
+
+    using _table_allocator = allocator<pointer>;
+
+    // 数据成员
+
+    // 块指针表，有 _max_chunks + 1 项；还没有分配任何块时指向共享的全空表
+    pointer* _chunks;
+    size_type _chunk_count = 0;  // 已分配的块数
+    size_type _size = 0;
+    // 下一个元素的地址和它所在块的尾，push_back 只在跨块时才需要重新定位；
+    // 容量已满时两者都为空
+    pointer _finish = nullptr;
+    pointer _chunk_limit = nullptr;
+
+public:
+    // ********************************************************************************
+    // 构造函数/析构函数
+    // ********************************************************************************
+
+    segmented_vector() noexcept : _chunks(_no_chunks())
+    {
+    }
+    // 以下构造函数都委托给默认构造函数，构造元素时抛出异常会执行析构函数，
+    // 释放已经构造的元素和分配的块
+    explicit segmented_vector(size_type n) : segmented_vector()
+    {
+        resize(n);
+    }
+    segmented_vector(size_type n, const value_type& value) : segmented_vector()
+    {
+        resize(n, value);
+    }
+    template <typename InputIterator,
+              typename = typename enable_if<
+                  !is_integral<InputIterator>::value>::type>
+    segmented_vector(InputIterator first, InputIterator last) :
+            segmented_vector()
+    {
+        _append(first, last);
+    }
+    segmented_vector(std::initializer_list<value_type> list) :
+            segmented_vector()
+    {
+        _append(list.begin(), list.end());
+    }
+    segmented_vector(const segmented_vector& x) : segmented_vector()
+    {
+        reserve(x.size());
+        _append(x.begin(), x.end());
+    }
+    // 只交换块指针表，元素的地址和指向它们的迭代器都保持有效
+    segmented_vector(segmented_vector&& x) noexcept : segmented_vector()
+    {
+        swap(x);
+    }
+
+    segmented_vector& operator=(const segmented_vector& x)
+    {
+        if (this != &x)
+        {
+            segmented_vector tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+    segmented_vector& operator=(segmented_vector&& x) noexcept
+    {
+        segmented_vector tmp(xutl::move(x));
+        swap(tmp);
+        return *this;
+    }
+    segmented_vector& operator=(std::initializer_list<value_type> list)
+    {
+        segmented_vector tmp(list);
+        swap(tmp);
+        return *this;
+    }
+
+    ~segmented_vector()
+    {
+        clear();
+        _deallocate_chunks(0);
+        if (_chunks != _no_chunks())
+        {
+            _table_allocator::deallocate(_chunks, _max_chunks + 1);
+        }
+    }
+
+    // ********************************************************************************
+    // 迭代器相关
+    // ********************************************************************************
+
+    iterator begin() noexcept
+    {
+        return iterator(_chunks, 0);
+    }
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(_chunks, 0);
+    }
+    iterator end() noexcept
+    {
+        return iterator(_chunks, _size);
+    }
+    const_iterator end() const noexcept
+    {
+        return const_iterator(_chunks, _size);
+    }
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    // ********************************************************************************
+    // 容量相关
+    // ********************************************************************************
+
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+    size_type size() const noexcept
+    {
+        return _size;
+    }
+    size_type capacity() const noexcept
+    {
+        return _capacity_of(_chunk_count);
+    }
+    size_type max_size() const noexcept
+    {
+        return static_cast<size_type>(-1) / sizeof(T);
+    }
+    // 已分配的块数
+    size_type chunk_count() const noexcept
+    {
+        return _chunk_count;
+    }
+
+    // 分配足够的块，使容量不小于 n
+    void reserve(size_type n)
+    {
+        if (n > max_size())
+        {
+            THROW_LENGTH_ERROR("segmented_vector<T>'s size too big");
+        }
+        while (capacity() < n)
+        {
+            _add_chunk();
+        }
+        _sync_tail();
+    }
+
+    // 释放末尾完全空闲的块
+    void shrink_to_fit() noexcept
+    {
+        size_type keep = 0;
+        while (_capacity_of(keep) < _size)
+        {
+            ++keep;
+        }
+        _deallocate_chunks(keep);
+    }
+
+    // ********************************************************************************
+    // 元素访问
+    // ********************************************************************************
+
+    reference operator[](size_type n)
+    {
+        return *_address(n);
+    }
+    const_reference operator[](size_type n) const
+    {
+        return *_address(n);
+    }
+
+    reference at(size_type n)
+    {
+        if (n >= _size)
+        {
+            THROW_OUT_OF_RANGE("segmented_vector");
+        }
+        return (*this)[n];
+    }
+    const_reference at(size_type n) const
+    {
+        if (n >= _size)
+        {
+            THROW_OUT_OF_RANGE("segmented_vector");
+        }
+        return (*this)[n];
+    }
+
+    reference front()
+    {
+        return *_chunks[0];
+    }
+    const_reference front() const
+    {
+        return *_chunks[0];
+    }
+    reference back()
+    {
+        return (*this)[_size - 1];
+    }
+    const_reference back() const
+    {
+        return (*this)[_size - 1];
+    }
+
+    // 第 k 块的起始地址和元素个数，可以按块遍历
+    pointer chunk_data(size_type k) noexcept
+    {
+        return _chunks[k];
+    }
+    const_pointer chunk_data(size_type k) const noexcept
+    {
+        return _chunks[k];
+    }
+    static constexpr size_type chunk_capacity(size_type k) noexcept
+    {
+        return base_chunk_size << k;
+    }
+
+    // ********************************************************************************
+    // 修改容器相关
+    // ********************************************************************************
+
+    template <typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if (_finish == _chunk_limit)
+        {
+            _next_tail();
+        }
+        pointer p = _finish;
+        _data_allocator::construct(p, xutl::forward<Args>(args)...);
+        ++_finish;
+        ++_size;
+        return *p;
+    }
+
+    void push_back(const value_type& value)
+    {
+        emplace_back(value);
+    }
+    void push_back(value_type&& value)
+    {
+        emplace_back(xutl::move(value));
+    }
+
+    void pop_back()
+    {
+        --_size;
+        _data_allocator::destroy(_address(_size));
+        _sync_tail();
+    }
+
+    // 只析构元素，保留已分配的块
+    void clear() noexcept
+    {
+        _destroy_from(0);
+    }
+
+    void resize(size_type n)
+    {
+        if (n < _size)
+        {
+            _destroy_from(n);
+            return;
+        }
+        reserve(n);
+        while (_size < n)
+        {
+            emplace_back();
+        }
+    }
+    void resize(size_type n, const value_type& value)
+    {
+        if (n < _size)
+        {
+            _destroy_from(n);
+            return;
+        }
+        reserve(n);
+        while (_size < n)
+        {
+            emplace_back(value);
+        }
+    }
+
+    // 迭代器引用的是块指针表，交换后随元素一起归属另一个容器
+    void swap(segmented_vector& x) noexcept
+    {
+        xutl::swap(_chunks, x._chunks);
+        xutl::swap(_chunk_count, x._chunk_count);
+        xutl::swap(_size, x._size);
+        xutl::swap(_finish, x._finish);
+        xutl::swap(_chunk_limit, x._chunk_limit);
+    }
+
+private:
+    // ********************************************************************************
+    // 辅助函数
+    // ********************************************************************************
+
+    // 前 k 块的总容量
+    static size_type _capacity_of(size_type k) noexcept
+    {
+        return k == 0 ? 0 : (((size_type(1) << k) - 1) << _base_shift);
+    }
+
+    // 下标 n 的元素的地址，所在的块必须已经分配
+    pointer _address(size_type n) const noexcept
+    {
+        const size_type j = n + base_chunk_size;
+        const size_type msb = _floor_log2(j);
+        return _chunks[msb - _base_shift] + (j - (size_type(1) << msb));
+    }
+
+    // 没有分配任何块的容器共用的块指针表，所有项都为空，从不写入
+    static pointer* _no_chunks() noexcept
+    {
+        static pointer none[_max_chunks + 1] = {};
+        return none;
+    }
+
+    void _add_chunk()
+    {
+        if (_chunks == _no_chunks())
+        {
+            pointer* table = _table_allocator::allocate(_max_chunks + 1);
+            for (size_type k = 0; k <= _max_chunks; ++k)
+            {
+                table[k] = nullptr;
+            }
+            _chunks = table;
+        }
+        _chunks[_chunk_count] =
+            _data_allocator::allocate(chunk_capacity(_chunk_count));
+        ++_chunk_count;
+    }
+
+    // 释放第 keep 块及之后的块，这些块中不能有元素
+    void _deallocate_chunks(size_type keep) noexcept
+    {
+        while (_chunk_count > keep)
+        {
+            --_chunk_count;
+            _data_allocator::deallocate(_chunks[_chunk_count],
+                                        chunk_capacity(_chunk_count));
+            _chunks[_chunk_count] = nullptr;
+        }
+        _sync_tail();
+    }
+
+    // 析构下标不小于 n 的元素，逐块调用 destroy
+    void _destroy_from(size_type n) noexcept
+    {
+        while (_size > n)
+        {
+            const size_type last = _size - 1;
+            const size_type j = last + base_chunk_size;
+            const size_type msb = _floor_log2(j);
+            // 本块中第一个元素的下标
+            const size_type chunk_first =
+                (size_type(1) << msb) - base_chunk_size;
+            const size_type first = chunk_first > n ? chunk_first : n;
+            pointer chunk = _chunks[msb - _base_shift];
+            _data_allocator::destroy(chunk + (first - chunk_first),
+                                     chunk + (_size - chunk_first));
+            _size = first;
+        }
+        _sync_tail();
+    }
+
+    // 根据 _size 重新计算 _finish 和 _chunk_limit
+    void _sync_tail() noexcept
+    {
+        const size_type j = _size + base_chunk_size;
+        const size_type msb = _floor_log2(j);
+        pointer chunk = _chunks[msb - _base_shift];
+        if (chunk == nullptr)
+        {
+            _finish = _chunk_limit = nullptr;
+            return;
+        }
+        _finish = chunk + (j - (size_type(1) << msb));
+        _chunk_limit = chunk + (size_type(1) << msb);
+    }
+
+    // 当前块已满，移到下一块，需要时先分配
+    void _next_tail()
+    {
+        if (_size == capacity())
+        {
+            if (_size == max_size())
+            {
+                THROW_LENGTH_ERROR("segmented_vector<T>'s size too big");
+            }
+            _add_chunk();
+        }
+        _sync_tail();
+    }
+
+    template <typename InputIterator>
+    void _append(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+        {
+            emplace_back(*first);
+        }
+    }
+};
+
+template <typename T>
+constexpr size_t segmented_vector<T>::base_chunk_size;
+template <typename T>
+constexpr size_t segmented_vector<T>::_base_shift;
+template <typename T>
+constexpr size_t segmented_vector<T>::_max_chunks;
+
+// ************************************************************************************
+// 重载比较操作符
+// ************************************************************************************
+
+template <typename T>
+bool operator==(const segmented_vector<T>& lhs, const segmented_vector<T>& rhs)
+{
+    if (lhs.size() != rhs.size()) return false;
+    auto j = rhs.begin();
+    for (auto i = lhs.begin(); i != lhs.end(); ++i, ++j)
+    {
+        if (!(*i == *j)) return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool operator!=(const segmented_vector<T>& lhs, const segmented_vector<T>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename T>
+void swap(segmented_vector<T>& lhs, segmented_vector<T>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_SEGMENTED_VECTOR_H_
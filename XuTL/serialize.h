@@ -0,0 +1,474 @@
+#ifndef XUTL_SERIALIZE_H_
+#define XUTL_SERIALIZE_H_
+
+/**
+ * 该文件包含容器的二进制序列化
+ * 每个容器写成一个 32 字节的头部（魔数、版本、种类、元素大小、类型标签、元素个数），
+ * 随后是元素的原始字节：
+ *   vector、mmap_vector 的元素本身是连续的，直接作为一整块交给 writev，不经过复制；
+ *   list 的元素逐个复制到写缓冲区，写成同样紧凑的连续形式；
+ *   concurrent_hash_map 写成连续的键值对。
+ * vector 和 list 的格式相同，可以互相读取。反序列化 vector 时直接读入元素的存储，
+ * 不逐个构造元素；也可以用 deserialize_into() 读入调用者预先分配的缓冲区。
+ *
+ * 只支持 trivially copyable 的元素类型，数据按本机字节序写出
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "concurrent_hash_map.h"
+#include "exceptdef.h"
+#include "list.h"
+#include "memory.h"
+#include "mmap_vector.h"
+#include "type_traits.h"
+#include "vector.h"
+
+namespace xutl
+{
+
+// 每个容器的头部
+struct serial_header
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t kind;
+    uint32_t key_size;    // 只用于关联容器
+    uint32_t value_size;
+    uint64_t type_tag;
+    uint64_t count;
+};
+
+static_assert(sizeof(serial_header) == 32, "头部必须是 32 字节");
+
+constexpr uint32_t serial_magic = 0x53545558;  // "XUTS"
+constexpr uint16_t serial_version = 1;
+
+// 容器的种类
+enum class serial_kind : uint16_t
+{
+    sequence = 1,  // vector、mmap_vector、list
+    map = 2        // concurrent_hash_map
+};
+
+// ************************************************************************************
+// binary_writer
+// 把小块数据复制到内部缓冲区，大块数据只记录地址，flush() 时用一次 writev
+// 把它们按顺序写到文件描述符中
+// ************************************************************************************
+
+class binary_writer
+{
+public:
+    static constexpr size_t buffer_size = 64 * 1024;
+    // 小于该大小的块复制到缓冲区，不单独占一个 iovec
+    static constexpr size_t copy_threshold = 512;
+    static constexpr int max_iov = 64;
+
+    explicit binary_writer(int fd) :
+            _fd(fd),
+            _buffer(allocator<char>::allocate(buffer_size)),
+            _used(0),
+            _iov_count(0),
+            _bytes(0)
+    {
+    }
+
+    binary_writer(const binary_writer&) = delete;
+    binary_writer& operator=(const binary_writer&) = delete;
+
+    // 析构时不会刷新：write_block() 引用的数据此时可能已经失效
+    ~binary_writer()
+    {
+        allocator<char>::deallocate(_buffer, buffer_size);
+    }
+
+    // 复制 [p, p + n) 到缓冲区
+    void write(const void* p, size_t n)
+    {
+        const char* src = static_cast<const char*>(p);
+        while (n > 0)
+        {
+            if (_used == buffer_size || _iov_count == max_iov) flush();
+            const size_t k = n < buffer_size - _used ? n : buffer_size - _used;
+            std::memcpy(_buffer + _used, src, k);
+            _append_iov(_buffer + _used, k);
+            _used += k;
+            src += k;
+            n -= k;
+        }
+    }
+
+    // 引用 [p, p + n)，不复制；这段数据在 flush() 之前必须保持有效且不被修改
+    void write_block(const void* p, size_t n)
+    {
+        if (n < copy_threshold)
+        {
+            write(p, n);
+            return;
+        }
+        if (_iov_count == max_iov) flush();
+        _iov[_iov_count].iov_base = const_cast<void*>(p);
+        _iov[_iov_count].iov_len = n;
+        ++_iov_count;
+        _bytes += n;
+    }
+
+    // 写出所有待写的数据
+    void flush();
+
+    // 已经交给 write()/write_block() 的总字节数
+    uint64_t bytes() const noexcept
+    {
+        return _bytes;
+    }
+
+private:
+    int _fd;
+    char* _buffer;
+    size_t _used;
+    int _iov_count;
+    uint64_t _bytes;
+    struct iovec _iov[max_iov];
+
+    // 与上一个 iovec 在缓冲区中相邻时直接合并
+    void _append_iov(char* p, size_t n)
+    {
+        _bytes += n;
+        if (_iov_count > 0)
+        {
+            struct iovec& last = _iov[_iov_count - 1];
+            if (static_cast<char*>(last.iov_base) + last.iov_len == p)
+            {
+                last.iov_len += n;
+                return;
+            }
+        }
+        _iov[_iov_count].iov_base = p;
+        _iov[_iov_count].iov_len = n;
+        ++_iov_count;
+    }
+};
+
+inline void binary_writer::flush()
+{
+    struct iovec* iov = _iov;
+    int count = _iov_count;
+    while (count > 0)
+    {
+        ssize_t written = ::writev(_fd, iov, count);
+        if (written < 0)
+        {
+            if (errno == EINTR) continue;
+            THROW_SYSTEM_ERROR("binary_writer: writev");
+        }
+        // 还有数据却一个字节也没写出，重试只会空转
+        if (written == 0)
+        {
+            THROW_RUNTIME_ERROR("binary_writer: writev wrote nothing");
+        }
+        // 部分写入：跳过已经写完的 iovec，调整第一个未写完的
+        size_t left = static_cast<size_t>(written);
+        while (count > 0 && left >= iov->iov_len)
+        {
+            left -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+            iov->iov_len -= left;
+        }
+    }
+    _iov_count = 0;
+    _used = 0;
+}
+
+// ************************************************************************************
+// binary_reader
+// 小块读取经过内部缓冲区，大块读取直接读入目标内存
+// ************************************************************************************
+
+class binary_reader
+{
+public:
+    static constexpr size_t buffer_size = 64 * 1024;
+
+    explicit binary_reader(int fd) :
+            _fd(fd),
+            _buffer(allocator<char>::allocate(buffer_size)),
+            _begin(0),
+            _end(0)
+    {
+    }
+
+    binary_reader(const binary_reader&) = delete;
+    binary_reader& operator=(const binary_reader&) = delete;
+
+    ~binary_reader()
+    {
+        allocator<char>::deallocate(_buffer, buffer_size);
+    }
+
+    // 读取恰好 n 个字节到 p，数据不足时抛出异常
+    void read(void* p, size_t n)
+    {
+        char* dst = static_cast<char*>(p);
+        const size_t buffered = _end - _begin;
+        if (n <= buffered)
+        {
+            std::memcpy(dst, _buffer + _begin, n);
+            _begin += n;
+            return;
+        }
+        std::memcpy(dst, _buffer + _begin, buffered);
+        dst += buffered;
+        n -= buffered;
+        _begin = _end = 0;
+        if (n >= buffer_size)
+        {
+            _read_fully(dst, n);
+            return;
+        }
+        while (_end < n)
+        {
+            _end += _read_some(_buffer + _end, buffer_size - _end);
+        }
+        std::memcpy(dst, _buffer, n);
+        _begin = n;
+    }
+
+private:
+    int _fd;
+    char* _buffer;
+    size_t _begin;
+    size_t _end;
+
+    size_t _read_some(char* p, size_t n)
+    {
+        for (;;)
+        {
+            ssize_t got = ::read(_fd, p, n);
+            if (got > 0) return static_cast<size_t>(got);
+            if (got == 0)
+            {
+                THROW_RUNTIME_ERROR("binary_reader: unexpected end of file");
+            }
+            if (errno != EINTR)
+            {
+                THROW_SYSTEM_ERROR("binary_reader: read");
+            }
+        }
+    }
+
+    void _read_fully(char* p, size_t n)
+    {
+        while (n > 0)
+        {
+            const size_t got = _read_some(p, n);
+            p += got;
+            n -= got;
+        }
+    }
+};
+
+// ************************************************************************************
+// 头部
+// ************************************************************************************
+
+template <typename T>
+serial_header _serial_sequence_header(size_t count)
+{
+    static_assert(xutl::is_trivially_copyable<T>::value,
+                  "只能序列化 trivially copyable 的元素");
+    serial_header h;
+    h.magic = serial_magic;
+    h.version = serial_version;
+    h.kind = static_cast<uint16_t>(serial_kind::sequence);
+    h.key_size = 0;
+    h.value_size = static_cast<uint32_t>(sizeof(T));
+    h.type_tag = mmap_type_tag<T>();
+    h.count = count;
+    return h;
+}
+
+template <typename Key, typename T>
+serial_header _serial_map_header(size_t count)
+{
+    static_assert(xutl::is_trivially_copyable<Key>::value &&
+                      xutl::is_trivially_copyable<T>::value,
+                  "只能序列化 trivially copyable 的键和值");
+    serial_header h;
+    h.magic = serial_magic;
+    h.version = serial_version;
+    h.kind = static_cast<uint16_t>(serial_kind::map);
+    h.key_size = static_cast<uint32_t>(sizeof(Key));
+    h.value_size = static_cast<uint32_t>(sizeof(T));
+    h.type_tag = mmap_type_tag<void(Key, T)>();
+    h.count = count;
+    return h;
+}
+
+// 读出头部并检查与 expected 一致，返回元素个数
+inline size_t _read_serial_header(binary_reader& in,
+                                  const serial_header& expected)
+{
+    serial_header h;
+    in.read(&h, sizeof(h));
+    if (h.magic != serial_magic || h.version != serial_version)
+    {
+        THROW_RUNTIME_ERROR("deserialize: bad header");
+    }
+    if (h.kind != expected.kind || h.key_size != expected.key_size ||
+        h.value_size != expected.value_size ||
+        h.type_tag != expected.type_tag)
+    {
+        THROW_RUNTIME_ERROR("deserialize: container type mismatch");
+    }
+    return static_cast<size_t>(h.count);
+}
+
+// ************************************************************************************
+// 序列化
+// vector 和 mmap_vector 的元素以引用方式交给 out，在 out.flush() 之前不能修改容器
+// ************************************************************************************
+
+template <typename T, size_t Align>
+void serialize(binary_writer& out, const vector<T, Align>& v)
+{
+    const serial_header h = _serial_sequence_header<T>(v.size());
+    out.write(&h, sizeof(h));
+    out.write_block(v.data(), v.size() * sizeof(T));
+}
+
+template <typename T>
+void serialize(binary_writer& out, const mmap_vector<T>& v)
+{
+    const serial_header h = _serial_sequence_header<T>(v.size());
+    out.write(&h, sizeof(h));
+    out.write_block(v.data(), v.size() * sizeof(T));
+}
+
+template <typename T>
+void serialize(binary_writer& out, const list<T>& li)
+{
+    size_t count = 0;
+    for (auto it = li.cbegin(); it != li.cend(); ++it)
+    {
+        ++count;
+    }
+    const serial_header h = _serial_sequence_header<T>(count);
+    out.write(&h, sizeof(h));
+    for (auto it = li.cbegin(); it != li.cend(); ++it)
+    {
+        out.write(xutl::address_of(*it), sizeof(T));
+    }
+}
+
+// 写出时不能有其它线程修改 m，否则元素个数可能与头部不一致
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void serialize(binary_writer& out,
+               const concurrent_hash_map<Key, T, Hash, KeyEqual>& m)
+{
+    const size_t count = m.size();
+    const serial_header h = _serial_map_header<Key, T>(count);
+    out.write(&h, sizeof(h));
+    size_t written = 0;
+    m.for_each([&out, &written](const Key& key, const T& value) {
+        out.write(xutl::address_of(key), sizeof(Key));
+        out.write(xutl::address_of(value), sizeof(T));
+        ++written;
+    });
+    if (written != count)
+    {
+        THROW_RUNTIME_ERROR("serialize: concurrent_hash_map was modified");
+    }
+}
+
+// ************************************************************************************
+// 反序列化
+// 读入的元素替换容器原有的元素
+// ************************************************************************************
+
+template <typename T, size_t Align>
+void deserialize(binary_reader& in, vector<T, Align>& v)
+{
+    const size_t count =
+        _read_serial_header(in, _serial_sequence_header<T>(0));
+    v.clear();
+    v.resize_and_overwrite(count, [&in](T* p, size_t n) {
+        in.read(p, n * sizeof(T));
+        return n;
+    });
+}
+
+template <typename T>
+void deserialize(binary_reader& in, mmap_vector<T>& v)
+{
+    const size_t count =
+        _read_serial_header(in, _serial_sequence_header<T>(0));
+    v.clear();
+    v.resize_and_overwrite(count, [&in](T* p, size_t n) {
+        in.read(p, n * sizeof(T));
+        return n;
+    });
+}
+
+template <typename T>
+void deserialize(binary_reader& in, list<T>& li)
+{
+    const size_t count =
+        _read_serial_header(in, _serial_sequence_header<T>(0));
+    li.clear();
+    typename aligned_storage<sizeof(T), alignof(T)>::type buf;
+    T* tmp = reinterpret_cast<T*>(&buf);
+    for (size_t i = 0; i < count; ++i)
+    {
+        in.read(tmp, sizeof(T));
+        li.push_back(*tmp);
+    }
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void deserialize(binary_reader& in,
+                 concurrent_hash_map<Key, T, Hash, KeyEqual>& m)
+{
+    const size_t count = _read_serial_header(in, _serial_map_header<Key, T>(0));
+    m.clear();
+    m.reserve(count);
+    typename aligned_storage<sizeof(Key), alignof(Key)>::type key_buf;
+    typename aligned_storage<sizeof(T), alignof(T)>::type value_buf;
+    Key* key = reinterpret_cast<Key*>(&key_buf);
+    T* value = reinterpret_cast<T*>(&value_buf);
+    for (size_t i = 0; i < count; ++i)
+    {
+        in.read(key, sizeof(Key));
+        in.read(value, sizeof(T));
+        m.insert_or_assign(*key, *value);
+    }
+}
+
+// 把一个序列读入调用者预先分配的 buffer，不构造元素，返回元素个数
+// 元素个数超过 capacity 时抛出异常，此时 buffer 的内容不变，in 停在元素数据之前
+template <typename T>
+size_t deserialize_into(binary_reader& in, T* buffer, size_t capacity)
+{
+    const size_t count =
+        _read_serial_header(in, _serial_sequence_header<T>(0));
+    if (count > capacity)
+    {
+        THROW_LENGTH_ERROR("deserialize_into: buffer is too small");
+    }
+    in.read(buffer, count * sizeof(T));
+    return count;
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_SERIALIZE_H_
@@ -0,0 +1,80 @@
+#ifndef XUTL_SIMD_H_
+#define XUTL_SIMD_H_
+
+/**
+ * 该文件包含 SIMD 相关的辅助：运行时检测 CPU 支持的指令集，
+ * 以及只给单个函数开启指令集的宏
+ *
+ * 容器和算法中的 SIMD 路径写在带 XUTL_TARGET("avx2") 之类属性的函数里，
+ * 调用前用 simd_has_avx2() 等函数在运行时选择，因此不需要用 -mavx2 编译
+ * 整个程序，同一个二进制文件在不支持的 CPU 上自动使用标量实现。
+ * 不是 x86，或者编译器不是 GCC/Clang 时只有标量实现
+ */
+
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define XUTL_SIMD_X86 1
+#include <immintrin.h>
+// 只对这一个函数开启指令集 isa，例如 XUTL_TARGET("avx2")
+#define XUTL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define XUTL_SIMD_X86 0
+#define XUTL_TARGET(isa)
+#endif
+
+namespace xutl
+{
+
+// CPU 支持的指令集，第一次查询时检测
+struct cpu_features
+{
+    bool popcnt = false;
+    bool avx2 = false;
+};
+
+inline const cpu_features& detect_cpu_features() noexcept
+{
+    static const cpu_features features = []() {
+        cpu_features f;
+#if XUTL_SIMD_X86
+        __builtin_cpu_init();
+        f.popcnt = __builtin_cpu_supports("popcnt");
+        f.avx2 = __builtin_cpu_supports("avx2");
+#endif
+        return f;
+    }();
+    return features;
+}
+
+// 是否允许使用 SIMD 路径，默认允许
+// 关闭后所有函数都走标量实现，用于测试标量路径和对比性能
+inline std::atomic<bool>& _simd_enabled_flag() noexcept
+{
+    static std::atomic<bool> enabled(true);
+    return enabled;
+}
+
+inline void set_simd_enabled(bool enabled) noexcept
+{
+    _simd_enabled_flag().store(enabled, std::memory_order_relaxed);
+}
+
+inline bool simd_enabled() noexcept
+{
+    return _simd_enabled_flag().load(std::memory_order_relaxed);
+}
+
+// 当前可以使用的指令集
+inline bool simd_has_avx2() noexcept
+{
+    return simd_enabled() && detect_cpu_features().avx2;
+}
+inline bool simd_has_popcnt() noexcept
+{
+    return simd_enabled() && detect_cpu_features().popcnt;
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_SIMD_H_
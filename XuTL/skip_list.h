@@ -0,0 +1,1107 @@
+#ifndef XUTL_SKIP_LIST_H_
+#define XUTL_SKIP_LIST_H_
+
+/**
+ * 该文件包含两个模板类 skip_list 和 concurrent_skip_list
+ * 它们是按键有序的映射：每个节点有一座高度随机的指针塔，第 i 层的指针跳过
+ * 大约 4^i 个元素，查找、插入和删除的期望复杂度都是 O(log n)，第 0 层就是
+ * 按键有序的单向链表
+ *
+ * 节点的大小取决于塔的高度，从容器自己的内存池中分配：内存池从大块内存中
+ * 按实际高度切出节点，不为用不到的层预留指针；skip_list 删除的节点按高度
+ * 放入空闲链表复用。concurrent_skip_list 的插入和查找都不加锁，
+ * 用 CAS 把新节点逐层链接进去
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <tuple>
+#include <utility>
+
+#include "construct.h"
+#include "exceptdef.h"
+#include "functional.h"
+#include "iterator.h"
+#include "memory.h"
+#include "type_traits.h"
+#include "utils.h"
+
+namespace xutl
+{
+
+// 指针塔的最大高度，每升高一层的概率为 1/4，足以容纳 4^16 个元素
+constexpr unsigned skip_list_max_level = 16;
+
+// ************************************************************************************
+// 节点的内存
+// ************************************************************************************
+
+// 一块大内存，节点从 data() 开始依次切出
+struct _skip_slab
+{
+    _skip_slab* next;
+    size_t bytes;  // 包括头部在内的总字节数
+
+    // 头部之后按 align 对齐的位置
+    static size_t data_offset(size_t align) noexcept
+    {
+        return (sizeof(_skip_slab) + align - 1) / align * align;
+    }
+    char* data(size_t align) noexcept
+    {
+        return reinterpret_cast<char*>(this) + data_offset(align);
+    }
+
+    static _skip_slab* create(size_t bytes, size_t align, _skip_slab* next)
+    {
+        void* p = allocator<unsigned char>::allocate_aligned(bytes, align);
+        _skip_slab* slab = static_cast<_skip_slab*>(p);
+        slab->next = next;
+        slab->bytes = bytes;
+        return slab;
+    }
+    static void destroy(_skip_slab* slab, size_t align) noexcept
+    {
+        allocator<unsigned char>::deallocate_aligned(
+            reinterpret_cast<unsigned char*>(slab), slab->bytes, align);
+    }
+    // 释放 head 开始的所有块
+    static void destroy_all(_skip_slab* head, size_t align) noexcept
+    {
+        while (head != nullptr)
+        {
+            _skip_slab* next = head->next;
+            destroy(head, align);
+            head = next;
+        }
+    }
+};
+
+// 单线程的节点内存池：从块中顺序切出节点，释放的节点按塔高放入空闲链表
+// Align 为节点的对齐要求，所有节点的大小都是它的倍数
+template <size_t Align>
+class _skip_pool
+{
+public:
+    static constexpr size_t first_slab_bytes = 4096;
+    static constexpr size_t max_slab_bytes = 64 * 1024;
+
+    _skip_pool() noexcept
+    {
+        for (unsigned i = 0; i < skip_list_max_level; ++i)
+        {
+            _free[i] = nullptr;
+        }
+    }
+    _skip_pool(const _skip_pool&) = delete;
+    _skip_pool& operator=(const _skip_pool&) = delete;
+    ~_skip_pool()
+    {
+        _skip_slab::destroy_all(_slabs, Align);
+    }
+
+    // 分配一个塔高为 level、大小为 bytes 的节点
+    void* allocate(unsigned level, size_t bytes)
+    {
+        void* p = _free[level - 1];
+        if (p != nullptr)
+        {
+            _free[level - 1] = *static_cast<void**>(p);
+            return p;
+        }
+        if (static_cast<size_t>(_end - _cur) < bytes) _grow(bytes);
+        p = _cur;
+        _cur += bytes;
+        return p;
+    }
+    // 归还塔高为 level 的节点，之后分配同样高度的节点时复用
+    void deallocate(void* p, unsigned level) noexcept
+    {
+        *static_cast<void**>(p) = _free[level - 1];
+        _free[level - 1] = p;
+    }
+
+    // 归还所有节点，保留已经分配的块中的第一块
+    void reset() noexcept
+    {
+        for (unsigned i = 0; i < skip_list_max_level; ++i)
+        {
+            _free[i] = nullptr;
+        }
+        if (_slabs == nullptr) return;
+        _skip_slab::destroy_all(_slabs->next, Align);
+        _slabs->next = nullptr;
+        _cur = _slabs->data(Align);
+        _end = reinterpret_cast<char*>(_slabs) + _slabs->bytes;
+    }
+
+    void swap(_skip_pool& x) noexcept
+    {
+        for (unsigned i = 0; i < skip_list_max_level; ++i)
+        {
+            xutl::swap(_free[i], x._free[i]);
+        }
+        xutl::swap(_slabs, x._slabs);
+        xutl::swap(_cur, x._cur);
+        xutl::swap(_end, x._end);
+        xutl::swap(_next_bytes, x._next_bytes);
+    }
+
+private:
+    // 当前块剩余的空间放不下 bytes 时换一个新块，块的大小逐次翻倍
+    void _grow(size_t bytes)
+    {
+        size_t size = _next_bytes;
+        const size_t need = _skip_slab::data_offset(Align) + bytes;
+        if (size < need) size = need;
+        _slabs = _skip_slab::create(size, Align, _slabs);
+        _cur = _slabs->data(Align);
+        _end = reinterpret_cast<char*>(_slabs) + size;
+        if (_next_bytes < max_slab_bytes) _next_bytes *= 2;
+    }
+
+    void* _free[skip_list_max_level];  // 按塔高分类的空闲链表
+    _skip_slab* _slabs = nullptr;
+    char* _cur = nullptr;  // 当前块中尚未使用的部分
+    char* _end = nullptr;
+    size_t _next_bytes = first_slab_bytes;
+};
+
+// 由 64 位随机数得到塔高：每升高一层的概率为 1/4
+inline unsigned _skip_random_level(uint64_t r) noexcept
+{
+    // 最低的两个连续 0 位决定升高一层，再加一位保证结果不超过最大高度
+    r |= uint64_t(1) << (2 * (skip_list_max_level - 1));
+#if defined(__GNUC__) || defined(__clang__)
+    return 1 + static_cast<unsigned>(__builtin_ctzll(r)) / 2;
+#else
+    // 每次检查最低的两位，r 中已经置了一位，循环一定会结束
+    unsigned level = 1;
+    while ((r & 3) == 0)
+    {
+        r >>= 2;
+        ++level;
+    }
+    return level;
+#endif
+}
+
+// xorshift64* 随机数
+inline uint64_t _skip_next_random(uint64_t& state) noexcept
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545f4914f6cdd1dULL;
+}
+
+// ************************************************************************************
+// skip_list
+// ************************************************************************************
+
+// skip_list 的节点，塔的实际高度为 level，分配时只为这些层留出空间
+template <typename Value>
+struct _skip_node
+{
+    Value value;
+    unsigned level;
+    _skip_node* tower[1];
+
+    _skip_node** links() noexcept
+    {
+        return tower;
+    }
+
+    // 塔高为 level 的节点的大小，向上取整到节点的对齐，
+    // 内存池顺序切出的下一个节点才仍然是对齐的
+    static size_t bytes(unsigned level) noexcept
+    {
+        const size_t n =
+            sizeof(_skip_node) + (level - 1) * sizeof(_skip_node*);
+        return (n + alignof(_skip_node) - 1) & ~(alignof(_skip_node) - 1);
+    }
+};
+
+// skip_list 的迭代器，沿第 0 层前进
+template <typename Value, bool Const>
+class skip_list_iterator
+    : public xutl::iterator<forward_iterator_tag, Value, std::ptrdiff_t,
+                            typename conditional<Const, const Value*,
+                                                 Value*>::type,
+                            typename conditional<Const, const Value&,
+                                                 Value&>::type>
+{
+public:
+    using value_type = Value;
+    using pointer = typename conditional<Const, const Value*, Value*>::type;
+    using reference = typename conditional<Const, const Value&, Value&>::type;
+    using self = skip_list_iterator<Value, Const>;
+
+private:
+    using _node = _skip_node<Value>;
+
+    _node* _cur = nullptr;
+
+    template <typename V, bool>
+    friend class skip_list_iterator;
+    template <typename K, typename T, typename Compare>
+    friend class skip_list;
+
+public:
+    skip_list_iterator() = default;
+    explicit skip_list_iterator(_node* node) : _cur(node)
+    {
+    }
+    // iterator 可以转换为 const_iterator
+    template <bool C, typename = typename enable_if<Const && !C>::type>
+    skip_list_iterator(const skip_list_iterator<Value, C>& other) :
+            _cur(other._cur)
+    {
+    }
+
+    reference operator*() const
+    {
+        return _cur->value;
+    }
+    pointer operator->() const
+    {
+        return &_cur->value;
+    }
+
+    self& operator++()
+    {
+        _cur = _cur->links()[0];
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        _cur = _cur->links()[0];
+        return tmp;
+    }
+
+    template <bool C>
+    bool operator==(const skip_list_iterator<Value, C>& rhs) const
+    {
+        return _cur == rhs._cur;
+    }
+    template <bool C>
+    bool operator!=(const skip_list_iterator<Value, C>& rhs) const
+    {
+        return _cur != rhs._cur;
+    }
+};
+
+// skip_list 类
+// 键唯一；迭代器按键的递增顺序遍历，插入不会使迭代器失效，
+// 删除只使指向被删除元素的迭代器失效
+template <typename Key, typename T, typename Compare = xutl::less<Key>>
+class skip_list
+{
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using key_compare = Compare;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = skip_list_iterator<value_type, false>;
+    using const_iterator = skip_list_iterator<value_type, true>;
+
+    static constexpr unsigned max_level = skip_list_max_level;
+
+private:
+    using _node = _skip_node<value_type>;
+    using _pool_type = _skip_pool<alignof(_node)>;
+
+    // 数据成员
+
+    _node* _head[max_level];  // 每一层的第一个节点
+    unsigned _level = 1;      // 当前最高的塔高
+    size_type _size = 0;
+    uint64_t _rng = 0x9e3779b97f4a7c15ULL;
+    key_compare _comp;
+    _pool_type _pool;
+
+public:
+    // ********************************************************************************
+    // 构造函数/析构函数
+    // ********************************************************************************
+
+    skip_list() : skip_list(key_compare())
+    {
+    }
+    explicit skip_list(const key_compare& comp) : _comp(comp)
+    {
+        _reset_head();
+    }
+    skip_list(std::initializer_list<value_type> ilist) : skip_list()
+    {
+        for (const value_type& v : ilist)
+        {
+            insert(v);
+        }
+    }
+    skip_list(const skip_list& x) : skip_list(x._comp)
+    {
+        for (const value_type& v : x)
+        {
+            insert(v);
+        }
+    }
+    skip_list(skip_list&& x) noexcept : skip_list(x._comp)
+    {
+        swap(x);
+    }
+
+    skip_list& operator=(const skip_list& x)
+    {
+        if (this != &x)
+        {
+            skip_list tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+    skip_list& operator=(skip_list&& x) noexcept
+    {
+        skip_list tmp(xutl::move(x));
+        swap(tmp);
+        return *this;
+    }
+
+    // 节点的内存随内存池一起释放，这里只析构元素
+    ~skip_list()
+    {
+        _destroy_values();
+    }
+
+    // ********************************************************************************
+    // 迭代器和容量相关
+    // ********************************************************************************
+
+    iterator begin() noexcept
+    {
+        return iterator(_head[0]);
+    }
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(_head[0]);
+    }
+    iterator end() noexcept
+    {
+        return iterator();
+    }
+    const_iterator end() const noexcept
+    {
+        return const_iterator();
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+    size_type size() const noexcept
+    {
+        return _size;
+    }
+    key_compare key_comp() const
+    {
+        return _comp;
+    }
+
+    // ********************************************************************************
+    // 查找
+    // ********************************************************************************
+
+    // 第一个键不小于 key 的元素
+    iterator lower_bound(const key_type& key)
+    {
+        return iterator(_lower_bound(key));
+    }
+    const_iterator lower_bound(const key_type& key) const
+    {
+        return const_iterator(_lower_bound(key));
+    }
+    // 第一个键大于 key 的元素
+    iterator upper_bound(const key_type& key)
+    {
+        _node* n = _lower_bound(key);
+        if (n != nullptr && !_comp(key, n->value.first)) n = n->links()[0];
+        return iterator(n);
+    }
+    const_iterator upper_bound(const key_type& key) const
+    {
+        return const_cast<skip_list*>(this)->upper_bound(key);
+    }
+
+    iterator find(const key_type& key)
+    {
+        return iterator(_find(key));
+    }
+    const_iterator find(const key_type& key) const
+    {
+        return const_iterator(_find(key));
+    }
+    bool contains(const key_type& key) const
+    {
+        return _find(key) != nullptr;
+    }
+    size_type count(const key_type& key) const
+    {
+        return contains(key) ? 1 : 0;
+    }
+
+    mapped_type& at(const key_type& key)
+    {
+        _node* n = _find(key);
+        if (n == nullptr)
+        {
+            THROW_OUT_OF_RANGE("skip_list<Key, T>: key not found");
+        }
+        return n->value.second;
+    }
+    const mapped_type& at(const key_type& key) const
+    {
+        return const_cast<skip_list*>(this)->at(key);
+    }
+    mapped_type& operator[](const key_type& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    // ********************************************************************************
+    // 修改容器相关
+    // ********************************************************************************
+
+    // key 不存在时用 args 构造值并插入；返回指向 key 所在元素的迭代器，
+    // 以及是否插入了新元素
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+    {
+        _node** update[max_level];
+        _node* n = _find_update(key, update);
+        if (n != nullptr) return std::make_pair(iterator(n), false);
+        n = _create_node(std::piecewise_construct,
+                         std::forward_as_tuple(key),
+                         std::forward_as_tuple(xutl::forward<Args>(args)...));
+        _link(n, update);
+        return std::make_pair(iterator(n), true);
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        return try_emplace(value.first, value.second);
+    }
+
+    // 键已经存在时先构造的元素会被销毁
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        _node* n = _create_node(xutl::forward<Args>(args)...);
+        _node** update[max_level];
+        _node* found = _find_update(n->value.first, update);
+        if (found != nullptr)
+        {
+            _destroy_node(n);
+            return std::make_pair(iterator(found), false);
+        }
+        _link(n, update);
+        return std::make_pair(iterator(n), true);
+    }
+
+    // 删除键为 key 的元素，返回删除的个数
+    size_type erase(const key_type& key)
+    {
+        _node** update[max_level];
+        _node* n = _find_update(key, update);
+        if (n == nullptr) return 0;
+        _unlink(n, update);
+        return 1;
+    }
+    // 删除 pos 指向的元素，返回下一个元素的迭代器
+    // 单向链表无法直接找到前驱，需要按键重新查找一次
+    iterator erase(const_iterator pos)
+    {
+        _node* next = pos._cur->links()[0];
+        erase(pos._cur->value.first);
+        return iterator(next);
+    }
+
+    void clear() noexcept
+    {
+        _destroy_values();
+        _pool.reset();
+        _reset_head();
+        _size = 0;
+    }
+
+    void swap(skip_list& x) noexcept
+    {
+        for (unsigned i = 0; i < max_level; ++i)
+        {
+            xutl::swap(_head[i], x._head[i]);
+        }
+        xutl::swap(_level, x._level);
+        xutl::swap(_size, x._size);
+        xutl::swap(_rng, x._rng);
+        xutl::swap(_comp, x._comp);
+        _pool.swap(x._pool);
+    }
+
+private:
+    void _reset_head() noexcept
+    {
+        for (unsigned i = 0; i < max_level; ++i)
+        {
+            _head[i] = nullptr;
+        }
+        _level = 1;
+    }
+
+    void _destroy_values() noexcept
+    {
+        for (_node* n = _head[0]; n != nullptr; n = n->links()[0])
+        {
+            xutl::destroy(xutl::address_of(n->value));
+        }
+    }
+
+    template <typename... Args>
+    _node* _create_node(Args&&... args)
+    {
+        const unsigned level =
+            _skip_random_level(_skip_next_random(_rng));
+        _node* n = static_cast<_node*>(
+            _pool.allocate(level, _node::bytes(level)));
+        try
+        {
+            xutl::construct(xutl::address_of(n->value),
+                            xutl::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            _pool.deallocate(n, level);
+            throw;
+        }
+        n->level = level;
+        return n;
+    }
+    void _destroy_node(_node* n) noexcept
+    {
+        xutl::destroy(xutl::address_of(n->value));
+        _pool.deallocate(n, n->level);
+    }
+
+    // 第一个键不小于 key 的节点
+    _node* _lower_bound(const key_type& key) const
+    {
+        _node* const* links = _head;
+        for (unsigned i = _level; i-- > 0;)
+        {
+            _node* n;
+            while ((n = links[i]) != nullptr && _comp(n->value.first, key))
+            {
+                links = n->links();
+            }
+        }
+        return links[0];
+    }
+    _node* _find(const key_type& key) const
+    {
+        _node* n = _lower_bound(key);
+        return n != nullptr && !_comp(key, n->value.first) ? n : nullptr;
+    }
+
+    // 查找 key，同时记下每一层中最后一个键小于 key 的位置：
+    // update[i] 是前驱节点（或 _head）的指针数组，新节点插入在 update[i][i] 之前
+    // 返回键等于 key 的节点，不存在时返回 nullptr
+    _node* _find_update(const key_type& key, _node** update[])
+    {
+        _node** links = _head;
+        for (unsigned i = max_level; i-- > _level;)
+        {
+            update[i] = _head;
+        }
+        for (unsigned i = _level; i-- > 0;)
+        {
+            _node* n;
+            while ((n = links[i]) != nullptr && _comp(n->value.first, key))
+            {
+                links = n->links();
+            }
+            update[i] = links;
+        }
+        _node* n = links[0];
+        return n != nullptr && !_comp(key, n->value.first) ? n : nullptr;
+    }
+
+    void _link(_node* n, _node** update[]) noexcept
+    {
+        if (n->level > _level) _level = n->level;
+        _node** tower = n->links();
+        for (unsigned i = 0; i < n->level; ++i)
+        {
+            tower[i] = update[i][i];
+            update[i][i] = n;
+        }
+        ++_size;
+    }
+
+    void _unlink(_node* n, _node** update[]) noexcept
+    {
+        _node** tower = n->links();
+        for (unsigned i = 0; i < n->level; ++i)
+        {
+            update[i][i] = tower[i];
+        }
+        while (_level > 1 && _head[_level - 1] == nullptr)
+        {
+            --_level;
+        }
+        --_size;
+        _destroy_node(n);
+    }
+};
+
+template <typename Key, typename T, typename Compare>
+constexpr unsigned skip_list<Key, T, Compare>::max_level;
+
+template <typename Key, typename T, typename Compare>
+bool operator==(const skip_list<Key, T, Compare>& lhs,
+                const skip_list<Key, T, Compare>& rhs)
+{
+    if (lhs.size() != rhs.size()) return false;
+    auto j = rhs.begin();
+    for (auto i = lhs.begin(); i != lhs.end(); ++i, ++j)
+    {
+        if (!(*i == *j)) return false;
+    }
+    return true;
+}
+
+template <typename Key, typename T, typename Compare>
+bool operator!=(const skip_list<Key, T, Compare>& lhs,
+                const skip_list<Key, T, Compare>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename T, typename Compare>
+void swap(skip_list<Key, T, Compare>& lhs,
+          skip_list<Key, T, Compare>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+// ************************************************************************************
+// concurrent_skip_list
+// ************************************************************************************
+
+// 多线程共享的节点内存池：从当前块中用 fetch_add 切出节点，
+// 块用完时新建一块并用 CAS 换上，没有锁。节点不单独释放，随容器一起归还
+template <size_t Align>
+class _concurrent_skip_pool
+{
+public:
+    static constexpr size_t slab_bytes = 64 * 1024;
+
+    _concurrent_skip_pool() : _slabs(nullptr)
+    {
+    }
+    _concurrent_skip_pool(const _concurrent_skip_pool&) = delete;
+    _concurrent_skip_pool& operator=(const _concurrent_skip_pool&) = delete;
+    ~_concurrent_skip_pool()
+    {
+        _slab* s = _slabs.load(std::memory_order_relaxed);
+        while (s != nullptr)
+        {
+            _slab* next = s->next;
+            _destroy(s);
+            s = next;
+        }
+    }
+
+    void* allocate(size_t bytes)
+    {
+        _slab* s = _slabs.load(std::memory_order_acquire);
+        for (;;)
+        {
+            if (s != nullptr)
+            {
+                const size_t offset =
+                    s->used.fetch_add(bytes, std::memory_order_relaxed);
+                if (offset + bytes <= s->capacity) return s->data() + offset;
+            }
+            // 当前块已满（或者还没有块）：换一个新块，失败说明别的线程已经换过
+            _slab* fresh = _create(bytes, s);
+            if (_slabs.compare_exchange_strong(s, fresh,
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_acquire))
+            {
+                s = fresh;
+            }
+            else
+            {
+                _destroy(fresh);
+            }
+        }
+    }
+
+private:
+    struct _slab
+    {
+        _slab* next;
+        size_t capacity;           // 可以切分的字节数
+        std::atomic<size_t> used;  // 已经切出的字节数，可能超过 capacity
+
+        static size_t header() noexcept
+        {
+            return (sizeof(_slab) + Align - 1) / Align * Align;
+        }
+        char* data() noexcept
+        {
+            return reinterpret_cast<char*>(this) + header();
+        }
+    };
+
+    static _slab* _create(size_t bytes, _slab* next)
+    {
+        const size_t capacity = bytes > slab_bytes ? bytes : slab_bytes;
+        void* p = allocator<unsigned char>::allocate_aligned(
+            _slab::header() + capacity, Align);
+        _slab* s = static_cast<_slab*>(p);
+        s->next = next;
+        s->capacity = capacity;
+        xutl::construct(xutl::address_of(s->used), size_t(0));
+        return s;
+    }
+    static void _destroy(_slab* s) noexcept
+    {
+        allocator<unsigned char>::deallocate_aligned(
+            reinterpret_cast<unsigned char*>(s), _slab::header() + s->capacity,
+            Align);
+    }
+
+    std::atomic<_slab*> _slabs;
+};
+
+// concurrent_skip_list 的节点
+template <typename Value>
+struct _concurrent_skip_node
+{
+    Value value;
+    unsigned level;
+    std::atomic<_concurrent_skip_node*> tower[1];
+
+    std::atomic<_concurrent_skip_node*>* links() noexcept
+    {
+        return tower;
+    }
+
+    // 与 _skip_node::bytes 一样向上取整到节点的对齐
+    static size_t bytes(unsigned level) noexcept
+    {
+        constexpr size_t align = alignof(_concurrent_skip_node);
+        const size_t n =
+            sizeof(_concurrent_skip_node) +
+            (level - 1) * sizeof(std::atomic<_concurrent_skip_node*>);
+        return (n + align - 1) & ~(align - 1);
+    }
+};
+
+// concurrent_skip_list 的迭代器，只读，沿第 0 层前进
+template <typename Value>
+class concurrent_skip_list_iterator
+    : public xutl::iterator<forward_iterator_tag, Value, std::ptrdiff_t,
+                            const Value*, const Value&>
+{
+public:
+    using value_type = Value;
+    using pointer = const Value*;
+    using reference = const Value&;
+    using self = concurrent_skip_list_iterator<Value>;
+
+private:
+    using _node = _concurrent_skip_node<Value>;
+
+    _node* _cur = nullptr;
+
+public:
+    concurrent_skip_list_iterator() = default;
+    explicit concurrent_skip_list_iterator(_node* node) : _cur(node)
+    {
+    }
+
+    reference operator*() const
+    {
+        return _cur->value;
+    }
+    pointer operator->() const
+    {
+        return &_cur->value;
+    }
+
+    self& operator++()
+    {
+        _cur = _cur->links()[0].load(std::memory_order_acquire);
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    bool operator==(const self& rhs) const
+    {
+        return _cur == rhs._cur;
+    }
+    bool operator!=(const self& rhs) const
+    {
+        return _cur != rhs._cur;
+    }
+};
+
+// concurrent_skip_list 类
+// 多个线程可以同时插入和查找，都不加锁：
+//   插入先找到每一层的前驱，再自底向上用 CAS 把新节点接到前驱之后，
+//   某一层的 CAS 失败说明别的线程刚在这里插入了节点，重新查找这一层的前驱；
+//   第 0 层链接成功的那一刻元素对所有线程可见，键相同的插入只有一个成功。
+//   查找和遍历只是沿着指针前进，遍历看到的是弱一致的视图。
+// 不支持删除，因此元素的地址在容器析构之前一直有效，find 可以直接返回指针；
+// 修改查到的值需要调用者自己同步。析构时不允许有其它线程仍在访问
+template <typename Key, typename T, typename Compare = xutl::less<Key>>
+class concurrent_skip_list
+{
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using key_compare = Compare;
+    using size_type = size_t;
+
+    using iterator = concurrent_skip_list_iterator<value_type>;
+    using const_iterator = iterator;
+
+    static constexpr unsigned max_level = skip_list_max_level;
+
+private:
+    using _node = _concurrent_skip_node<value_type>;
+    using _link_type = std::atomic<_node*>;
+
+    // 数据成员
+
+    _link_type _head[max_level];
+    std::atomic<size_type> _size;
+    key_compare _comp;
+    _concurrent_skip_pool<alignof(_node)> _pool;
+
+public:
+    // ********************************************************************************
+    // 构造函数/析构函数
+    // ********************************************************************************
+
+    explicit concurrent_skip_list(const key_compare& comp = key_compare()) :
+            _size(0),
+            _comp(comp)
+    {
+        for (unsigned i = 0; i < max_level; ++i)
+        {
+            xutl::construct(xutl::address_of(_head[i]),
+                            static_cast<_node*>(nullptr));
+        }
+    }
+
+    concurrent_skip_list(const concurrent_skip_list&) = delete;
+    concurrent_skip_list& operator=(const concurrent_skip_list&) = delete;
+
+    ~concurrent_skip_list()
+    {
+        _node* n = _head[0].load(std::memory_order_relaxed);
+        while (n != nullptr)
+        {
+            _node* next = n->links()[0].load(std::memory_order_relaxed);
+            xutl::destroy(xutl::address_of(n->value));
+            n = next;
+        }
+    }
+
+    // ********************************************************************************
+    // 迭代器和容量相关
+    // 并发插入时 size() 只是一个近似值
+    // ********************************************************************************
+
+    iterator begin() const noexcept
+    {
+        return iterator(_head[0].load(std::memory_order_acquire));
+    }
+    iterator end() const noexcept
+    {
+        return iterator();
+    }
+
+    size_type size() const noexcept
+    {
+        return _size.load(std::memory_order_relaxed);
+    }
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    // ********************************************************************************
+    // 查找
+    // ********************************************************************************
+
+    // 找到 key 时返回值的地址，否则返回 nullptr
+    mapped_type* find(const key_type& key) const noexcept
+    {
+        _node* n = _lower_bound(key);
+        if (n == nullptr || _comp(key, n->value.first)) return nullptr;
+        return &n->value.second;
+    }
+    bool contains(const key_type& key) const noexcept
+    {
+        return find(key) != nullptr;
+    }
+    // 第一个键不小于 key 的元素
+    iterator lower_bound(const key_type& key) const noexcept
+    {
+        return iterator(_lower_bound(key));
+    }
+
+    // ********************************************************************************
+    // 修改
+    // ********************************************************************************
+
+    // key 不存在时用 args 构造值并插入，插入了新元素时返回 true
+    // 与另一个线程同时插入相同的键而失败时，已经构造的值被销毁，
+    // 节点的内存留在内存池中直到容器析构
+    template <typename... Args>
+    bool try_emplace(const key_type& key, Args&&... args);
+
+    bool insert(const key_type& key, const mapped_type& value)
+    {
+        return try_emplace(key, value);
+    }
+
+private:
+    _node* _lower_bound(const key_type& key) const noexcept
+    {
+        const _link_type* links = _head;
+        for (unsigned i = max_level; i-- > 0;)
+        {
+            _node* n;
+            while ((n = links[i].load(std::memory_order_acquire)) != nullptr &&
+                   _comp(n->value.first, key))
+            {
+                links = n->links();
+            }
+        }
+        return links[0].load(std::memory_order_acquire);
+    }
+
+    // 与 skip_list::_find_update 相同，另外记下每一层前驱之后的节点 succ，
+    // 作为 CAS 的期望值
+    _node* _find_update(const key_type& key, _link_type* update[],
+                        _node* succ[]) noexcept
+    {
+        _link_type* links = _head;
+        for (unsigned i = max_level; i-- > 0;)
+        {
+            _node* n;
+            while ((n = links[i].load(std::memory_order_acquire)) != nullptr &&
+                   _comp(n->value.first, key))
+            {
+                links = n->links();
+            }
+            update[i] = links;
+            succ[i] = n;
+        }
+        _node* n = succ[0];
+        return n != nullptr && !_comp(key, n->value.first) ? n : nullptr;
+    }
+
+    // 每个线程一个随机数生成器
+    static unsigned _random_level() noexcept
+    {
+        static thread_local uint64_t state = 0;
+        if (state == 0)
+        {
+            state = reinterpret_cast<uintptr_t>(&state) | 1;
+        }
+        return _skip_random_level(_skip_next_random(state));
+    }
+};
+
+template <typename Key, typename T, typename Compare>
+constexpr unsigned concurrent_skip_list<Key, T, Compare>::max_level;
+
+template <typename Key, typename T, typename Compare>
+template <typename... Args>
+bool concurrent_skip_list<Key, T, Compare>::try_emplace(const key_type& key,
+                                                        Args&&... args)
+{
+    _link_type* update[max_level];
+    _node* succ[max_level];
+    if (_find_update(key, update, succ) != nullptr) return false;
+
+    const unsigned level = _random_level();
+    _node* n = static_cast<_node*>(_pool.allocate(_node::bytes(level)));
+    xutl::construct(xutl::address_of(n->value), std::piecewise_construct,
+                    std::forward_as_tuple(key),
+                    std::forward_as_tuple(xutl::forward<Args>(args)...));
+    n->level = level;
+    _link_type* tower = n->links();
+    for (unsigned i = 0; i < level; ++i)
+    {
+        xutl::construct(xutl::address_of(tower[i]), succ[i]);
+    }
+
+    // 第 0 层：链接成功后元素才可见；失败时如果别的线程插入了相同的键就放弃
+    while (!update[0][0].compare_exchange_strong(succ[0], n,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed))
+    {
+        if (_find_update(key, update, succ) != nullptr)
+        {
+            xutl::destroy(xutl::address_of(n->value));
+            return false;
+        }
+        tower[0].store(succ[0], std::memory_order_relaxed);
+    }
+    _size.fetch_add(1, std::memory_order_relaxed);
+
+    // 上面各层：重新查找时 n 已经在第 0 层，_find_update 会返回 n 本身，
+    // 但各层的前驱仍然正确，因为 n 在这些层上还没有链接
+    for (unsigned i = 1; i < level; ++i)
+    {
+        while (!update[i][i].compare_exchange_strong(succ[i], n,
+                                                     std::memory_order_release,
+                                                     std::memory_order_relaxed))
+        {
+            _find_update(key, update, succ);
+            tower[i].store(succ[i], std::memory_order_relaxed);
+        }
+    }
+    return true;
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_SKIP_LIST_H_
@@ -0,0 +1,339 @@
+#ifndef XUTL_SLOT_MAP_H_
+#define XUTL_SLOT_MAP_H_
+
+/**
+ * 该文件包含一个模板类 slot_map
+ * 元素紧密地保存在一个 vector 中，遍历与遍历 vector 一样快；插入时返回一个句柄，
+ * 句柄由槽位下标和代数（generation）组成，通过槽位表 O(1) 找到元素在 vector 中的位置
+ *
+ * 删除时把最后一个元素移到被删除的位置，再更新它的槽位，因此删除也是 O(1)，
+ * 但会改变元素的顺序和地址，需要长期引用元素时应当保存句柄而不是指针。
+ * 被删除的槽位代数加一后放入空闲链表供之后的插入复用，旧句柄因代数不符而失效
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "exceptdef.h"
+#include "utils.h"
+#include "vector.h"
+
+namespace xutl
+{
+
+// slot_map 的句柄，默认构造的句柄不指向任何元素
+struct slot_map_handle
+{
+    static constexpr uint32_t npos = 0xffffffffu;
+
+    uint32_t index = npos;    // 槽位下标
+    uint32_t generation = 0;  // 槽位的代数
+
+    slot_map_handle() = default;
+    slot_map_handle(uint32_t index, uint32_t generation) :
+            index(index),
+            generation(generation)
+    {
+    }
+};
+
+inline bool operator==(const slot_map_handle& lhs, const slot_map_handle& rhs)
+{
+    return lhs.index == rhs.index && lhs.generation == rhs.generation;
+}
+
+inline bool operator!=(const slot_map_handle& lhs, const slot_map_handle& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename T>
+class slot_map
+{
+public:
+    using value_type = T;
+    using handle = slot_map_handle;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    // 按紧密存储的顺序遍历，删除会改变顺序
+    using iterator = typename vector<T>::iterator;
+    using const_iterator = typename vector<T>::const_iterator;
+
+private:
+    // 槽位：占用时 dense 为元素在 _data 中的下标，空闲时为空闲链表的下一个槽位
+    struct _slot
+    {
+        uint32_t dense;
+        uint32_t generation;
+    };
+
+    static constexpr uint32_t _npos = slot_map_handle::npos;
+
+    // 数据成员
+
+    vector<T> _data;              // 紧密存储的元素
+    vector<uint32_t> _owners;     // _owners[i] 为 _data[i] 所在的槽位
+    vector<_slot> _slots;         // 槽位表
+    uint32_t _free_head = _npos;  // 空闲链表的头
+
+public:
+    // ********************************************************************************
+    // 构造函数
+    // ********************************************************************************
+
+    slot_map() = default;
+    slot_map(const slot_map&) = default;
+    slot_map(slot_map&& x) noexcept :
+            _data(xutl::move(x._data)),
+            _owners(xutl::move(x._owners)),
+            _slots(xutl::move(x._slots)),
+            _free_head(x._free_head)
+    {
+        x._free_head = _npos;
+    }
+
+    slot_map& operator=(const slot_map&) = default;
+    slot_map& operator=(slot_map&& x) noexcept
+    {
+        slot_map tmp(xutl::move(x));
+        swap(tmp);
+        return *this;
+    }
+
+    // ********************************************************************************
+    // 迭代器相关
+    // ********************************************************************************
+
+    iterator begin() noexcept
+    {
+        return _data.begin();
+    }
+    const_iterator begin() const noexcept
+    {
+        return _data.begin();
+    }
+    iterator end() noexcept
+    {
+        return _data.end();
+    }
+    const_iterator end() const noexcept
+    {
+        return _data.end();
+    }
+
+    // 紧密存储的元素
+    pointer data() noexcept
+    {
+        return _data.data();
+    }
+    const_pointer data() const noexcept
+    {
+        return _data.data();
+    }
+
+    // ********************************************************************************
+    // 容量相关
+    // ********************************************************************************
+
+    bool empty() const noexcept
+    {
+        return _data.empty();
+    }
+    size_type size() const noexcept
+    {
+        return _data.size();
+    }
+    // 已经创建的槽位数，包括空闲的槽位
+    size_type slot_count() const noexcept
+    {
+        return _slots.size();
+    }
+
+    void reserve(size_type n)
+    {
+        _data.reserve(n);
+        _owners.reserve(n);
+        _slots.reserve(n);
+    }
+
+    // ********************************************************************************
+    // 查找
+    // ********************************************************************************
+
+    bool contains(handle h) const noexcept
+    {
+        return h.index < _slots.size() &&
+               _slots[h.index].generation == h.generation &&
+               _slots[h.index].dense < _data.size() &&
+               _owners[_slots[h.index].dense] == h.index;
+    }
+
+    // 句柄失效时返回 nullptr
+    pointer find(handle h) noexcept
+    {
+        return contains(h) ? _data.data() + _slots[h.index].dense : nullptr;
+    }
+    const_pointer find(handle h) const noexcept
+    {
+        return contains(h) ? _data.data() + _slots[h.index].dense : nullptr;
+    }
+
+    // 不检查句柄是否有效
+    reference operator[](handle h)
+    {
+        return _data[_slots[h.index].dense];
+    }
+    const_reference operator[](handle h) const
+    {
+        return _data[_slots[h.index].dense];
+    }
+
+    reference at(handle h)
+    {
+        pointer p = find(h);
+        if (p == nullptr)
+        {
+            THROW_OUT_OF_RANGE("slot_map: invalid handle");
+        }
+        return *p;
+    }
+    const_reference at(handle h) const
+    {
+        const_pointer p = find(h);
+        if (p == nullptr)
+        {
+            THROW_OUT_OF_RANGE("slot_map: invalid handle");
+        }
+        return *p;
+    }
+
+    // 紧密存储中第 i 个元素的句柄
+    handle handle_at(size_type i) const noexcept
+    {
+        const uint32_t index = _owners[i];
+        return handle(index, _slots[index].generation);
+    }
+    handle handle_of(const_iterator it) const noexcept
+    {
+        return handle_at(static_cast<size_type>(it - _data.begin()));
+    }
+
+    // ********************************************************************************
+    // 修改容器相关
+    // ********************************************************************************
+
+    // 每一步失败时容器都保持原样：先准备好空闲槽位，再依次追加到 _owners 和 _data
+    template <typename... Args>
+    handle emplace(Args&&... args)
+    {
+        if (_free_head == _npos)
+        {
+            if (_slots.size() >= _npos)
+            {
+                THROW_LENGTH_ERROR("slot_map<T>'s size too big");
+            }
+            _slots.push_back(_slot{_npos, 0});
+            _free_head = static_cast<uint32_t>(_slots.size() - 1);
+        }
+        const uint32_t index = _free_head;
+        const uint32_t dense = static_cast<uint32_t>(_data.size());
+        _owners.push_back(index);
+        try
+        {
+            _data.emplace_back(xutl::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            _owners.pop_back();
+            throw;
+        }
+        _free_head = _slots[index].dense;
+        _slots[index].dense = dense;
+        return handle(index, _slots[index].generation);
+    }
+
+    handle insert(const value_type& value)
+    {
+        return emplace(value);
+    }
+    handle insert(value_type&& value)
+    {
+        return emplace(xutl::move(value));
+    }
+
+    // 句柄失效时什么也不做，返回 false
+    bool erase(handle h)
+    {
+        if (!contains(h)) return false;
+        _erase_dense(_slots[h.index].dense);
+        return true;
+    }
+    // 删除 pos 指向的元素，返回指向原来最后一个元素（现在位于 pos）的迭代器
+    iterator erase(const_iterator pos)
+    {
+        const size_type i = static_cast<size_type>(pos - _data.begin());
+        _erase_dense(static_cast<uint32_t>(i));
+        return _data.begin() + i;
+    }
+
+    // 删除所有元素，所有槽位进入空闲链表，已有的句柄全部失效
+    void clear() noexcept
+    {
+        for (size_type i = 0; i < _owners.size(); ++i)
+        {
+            _release_slot(_owners[i]);
+        }
+        _data.clear();
+        _owners.clear();
+    }
+
+    void swap(slot_map& x) noexcept
+    {
+        _data.swap(x._data);
+        _owners.swap(x._owners);
+        _slots.swap(x._slots);
+        xutl::swap(_free_head, x._free_head);
+    }
+
+private:
+    // 把最后一个元素移到位置 i，再删除最后一个元素
+    void _erase_dense(uint32_t i)
+    {
+        const uint32_t index = _owners[i];
+        const uint32_t last = static_cast<uint32_t>(_data.size() - 1);
+        if (i != last)
+        {
+            _data[i] = xutl::move(_data[last]);
+            _owners[i] = _owners[last];
+            _slots[_owners[i]].dense = i;
+        }
+        _data.pop_back();
+        _owners.pop_back();
+        _release_slot(index);
+    }
+
+    void _release_slot(uint32_t index) noexcept
+    {
+        ++_slots[index].generation;
+        _slots[index].dense = _free_head;
+        _free_head = index;
+    }
+};
+
+template <typename T>
+constexpr uint32_t slot_map<T>::_npos;
+
+template <typename T>
+void swap(slot_map<T>& lhs, slot_map<T>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_SLOT_MAP_H_
@@ -0,0 +1,761 @@
+#ifndef XUTL_SOA_VECTOR_H_
+#define XUTL_SOA_VECTOR_H_
+
+/**
+ * 该文件包含一个模板类 soa_vector
+ * 它按「数组的结构体」（structure of arrays）存储元素：每个字段各自保存在一个连续的
+ * 数组中，只访问少数几个字段的循环不会把其它字段读进缓存，也便于编译器向量化
+ *
+ * 所有字段的数组放在同一块按缓存行对齐的内存中，按同一个增长策略一起扩容；
+ * field<I>() 返回第 I 个字段的 span，迭代器按行访问，解引用得到由各字段引用组成的
+ * std::tuple<Fields&...>（代理引用）
+ */
+
+#include <cstddef>
+#include <initializer_list>
+#include <tuple>
+
+#include "algorithm.h"
+#include "construct.h"
+#include "exceptdef.h"
+#include "iterator.h"
+#include "memory.h"
+#include "span.h"
+#include "type_traits.h"
+#include "uninitialized.h"
+#include "utils.h"
+
+namespace xutl
+{
+
+// 参数包中最大的 alignof
+template <typename... T>
+struct _max_alignof;
+
+template <>
+struct _max_alignof<> : integral_constant<size_t, 1>
+{
+};
+
+template <typename T, typename... Rest>
+struct _max_alignof<T, Rest...>
+    : integral_constant<size_t, (alignof(T) > _max_alignof<Rest...>::value
+                                     ? alignof(T)
+                                     : _max_alignof<Rest...>::value)>
+{
+};
+
+// 展开参数包中的表达式，按顺序求值
+using _swallow = int[];
+
+// ************************************************************************************
+// soa_iterator
+// 保存各字段数组的起始指针和行号，解引用时现场组装各字段的引用
+// ************************************************************************************
+
+template <bool Const, typename... Fields>
+class soa_iterator
+{
+public:
+    using iterator_category = random_access_iterator_tag;
+    using value_type = std::tuple<Fields...>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = typename conditional<Const, std::tuple<const Fields&...>,
+                                           std::tuple<Fields&...>>::type;
+
+    using self = soa_iterator<Const, Fields...>;
+
+private:
+    std::tuple<Fields*...> _fields;
+    difference_type _index = 0;
+
+    template <bool, typename...>
+    friend class soa_iterator;
+
+public:
+    soa_iterator() = default;
+    soa_iterator(const std::tuple<Fields*...>& fields, difference_type index) :
+            _fields(fields),
+            _index(index)
+    {
+    }
+    // iterator 可以转换为 const_iterator
+    template <bool C, typename = typename enable_if<Const && !C>::type>
+    soa_iterator(const soa_iterator<C, Fields...>& other) :
+            _fields(other._fields),
+            _index(other._index)
+    {
+    }
+
+    // 行号
+    difference_type index() const noexcept
+    {
+        return _index;
+    }
+
+    reference operator*() const
+    {
+        return _deref(_index, index_sequence_for<Fields...>());
+    }
+    reference operator[](difference_type n) const
+    {
+        return _deref(_index + n, index_sequence_for<Fields...>());
+    }
+
+    self& operator++()
+    {
+        ++_index;
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++_index;
+        return tmp;
+    }
+    self& operator--()
+    {
+        --_index;
+        return *this;
+    }
+    self operator--(int)
+    {
+        self tmp = *this;
+        --_index;
+        return tmp;
+    }
+    self& operator+=(difference_type n)
+    {
+        _index += n;
+        return *this;
+    }
+    self& operator-=(difference_type n)
+    {
+        _index -= n;
+        return *this;
+    }
+    self operator+(difference_type n) const
+    {
+        return self(_fields, _index + n);
+    }
+    friend self operator+(difference_type n, const self& it)
+    {
+        return it + n;
+    }
+    self operator-(difference_type n) const
+    {
+        return self(_fields, _index - n);
+    }
+    difference_type operator-(const self& rhs) const
+    {
+        return _index - rhs._index;
+    }
+
+    bool operator==(const self& rhs) const
+    {
+        return _index == rhs._index;
+    }
+    bool operator!=(const self& rhs) const
+    {
+        return _index != rhs._index;
+    }
+    bool operator<(const self& rhs) const
+    {
+        return _index < rhs._index;
+    }
+    bool operator>(const self& rhs) const
+    {
+        return _index > rhs._index;
+    }
+    bool operator<=(const self& rhs) const
+    {
+        return _index <= rhs._index;
+    }
+    bool operator>=(const self& rhs) const
+    {
+        return _index >= rhs._index;
+    }
+
+private:
+    template <size_t... I>
+    reference _deref(difference_type i, index_sequence<I...>) const
+    {
+        return reference(std::get<I>(_fields)[i]...);
+    }
+};
+
+// ************************************************************************************
+// soa_vector
+// ************************************************************************************
+
+template <typename... Fields>
+class soa_vector
+{
+public:
+    static_assert(sizeof...(Fields) > 0, "soa_vector 至少需要一个字段");
+
+    static constexpr size_t field_count = sizeof...(Fields);
+
+    template <size_t I>
+    using field_type =
+        typename std::tuple_element<I, std::tuple<Fields...>>::type;
+
+    using value_type = std::tuple<Fields...>;
+    using reference = std::tuple<Fields&...>;
+    using const_reference = std::tuple<const Fields&...>;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = soa_iterator<false, Fields...>;
+    using const_iterator = soa_iterator<true, Fields...>;
+    using reverse_iterator = xutl::reverse_iterator<iterator>;
+    using const_reverse_iterator = xutl::reverse_iterator<const_iterator>;
+
+private:
+    using _pointers = std::tuple<Fields*...>;
+    using _indices = index_sequence_for<Fields...>;
+    using _block_allocator = allocator<unsigned char>;
+
+    // 每个字段的数组都从缓存行边界开始
+    static constexpr size_t _alignment =
+        _max_alignof<Fields...>::value > cache_line_size
+            ? _max_alignof<Fields...>::value
+            : cache_line_size;
+
+    template <size_t I>
+    using _index = integral_constant<size_t, I>;
+    using _end_index = _index<sizeof...(Fields)>;
+
+    // 数据成员
+
+    _pointers _fields;
+    unsigned char* _block = nullptr;
+    size_type _block_bytes = 0;
+    size_type _size = 0;
+    size_type _capacity = 0;
+
+public:
+    // ********************************************************************************
+    // 构造函数/析构函数
+    // ********************************************************************************
+
+    soa_vector() noexcept : _fields()
+    {
+    }
+    // 以下构造函数都委托给默认构造函数，构造元素时抛出异常会执行析构函数，
+    // 释放已经构造的行和分配的内存
+    // 构造 n 个各字段都是值初始化的行
+    explicit soa_vector(size_type n) : soa_vector()
+    {
+        resize(n);
+    }
+    soa_vector(std::initializer_list<value_type> list) : soa_vector()
+    {
+        reserve(list.size());
+        for (const value_type& row : list)
+        {
+            push_back(row);
+        }
+    }
+
+    soa_vector(const soa_vector& x) : soa_vector()
+    {
+        reserve(x.size());
+        for (size_type i = 0; i < x.size(); ++i)
+        {
+            _emplace_back_tuple(x[i]);
+        }
+    }
+    soa_vector(soa_vector&& x) noexcept : _fields()
+    {
+        swap(x);
+    }
+
+    soa_vector& operator=(const soa_vector& x)
+    {
+        if (this != &x)
+        {
+            soa_vector tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+    soa_vector& operator=(soa_vector&& x) noexcept
+    {
+        soa_vector tmp(xutl::move(x));
+        swap(tmp);
+        return *this;
+    }
+
+    ~soa_vector()
+    {
+        _destroy_rows(_fields, 0, _size, _indices());
+        _deallocate_block(_block, _block_bytes);
+    }
+
+    // ********************************************************************************
+    // 迭代器相关
+    // ********************************************************************************
+
+    iterator begin() noexcept
+    {
+        return iterator(_fields, 0);
+    }
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(_fields, 0);
+    }
+    iterator end() noexcept
+    {
+        return iterator(_fields, static_cast<difference_type>(_size));
+    }
+    const_iterator end() const noexcept
+    {
+        return const_iterator(_fields, static_cast<difference_type>(_size));
+    }
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    // ********************************************************************************
+    // 容量相关
+    // ********************************************************************************
+
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+    size_type size() const noexcept
+    {
+        return _size;
+    }
+    size_type capacity() const noexcept
+    {
+        return _capacity;
+    }
+    size_type max_size() const noexcept
+    {
+        return static_cast<size_type>(-1) / _row_bytes() / 2;
+    }
+
+    void reserve(size_type n)
+    {
+        if (n > _capacity)
+        {
+            _reallocate(n);
+        }
+    }
+
+    void shrink_to_fit()
+    {
+        if (_size < _capacity)
+        {
+            _reallocate(_size);
+        }
+    }
+
+    // ********************************************************************************
+    // 元素访问
+    // ********************************************************************************
+
+    reference operator[](size_type n)
+    {
+        return _row(_fields, n, _indices());
+    }
+    const_reference operator[](size_type n) const
+    {
+        return _row(_const_fields(_indices()), n, _indices());
+    }
+
+    reference at(size_type n)
+    {
+        if (n >= _size)
+        {
+            THROW_OUT_OF_RANGE("soa_vector");
+        }
+        return (*this)[n];
+    }
+    const_reference at(size_type n) const
+    {
+        if (n >= _size)
+        {
+            THROW_OUT_OF_RANGE("soa_vector");
+        }
+        return (*this)[n];
+    }
+
+    reference front()
+    {
+        return (*this)[0];
+    }
+    const_reference front() const
+    {
+        return (*this)[0];
+    }
+    reference back()
+    {
+        return (*this)[_size - 1];
+    }
+    const_reference back() const
+    {
+        return (*this)[_size - 1];
+    }
+
+    // 第 I 个字段的数组
+    template <size_t I>
+    span<field_type<I>> field() noexcept
+    {
+        return span<field_type<I>>(std::get<I>(_fields), _size);
+    }
+    template <size_t I>
+    span<const field_type<I>> field() const noexcept
+    {
+        return span<const field_type<I>>(std::get<I>(_fields), _size);
+    }
+    template <size_t I>
+    field_type<I>* data() noexcept
+    {
+        return std::get<I>(_fields);
+    }
+    template <size_t I>
+    const field_type<I>* data() const noexcept
+    {
+        return std::get<I>(_fields);
+    }
+
+    // ********************************************************************************
+    // 修改容器相关
+    // ********************************************************************************
+
+    // 每个字段一个实参
+    template <typename... Args>
+    void emplace_back(Args&&... args)
+    {
+        static_assert(sizeof...(Args) == sizeof...(Fields),
+                      "emplace_back 需要为每个字段提供一个实参");
+        _emplace_back_tuple(
+            std::forward_as_tuple(xutl::forward<Args>(args)...));
+    }
+
+    void push_back(const value_type& row)
+    {
+        _emplace_back_tuple(row);
+    }
+    void push_back(value_type&& row)
+    {
+        _emplace_back_tuple(xutl::move(row));
+    }
+
+    void pop_back()
+    {
+        _destroy_rows(_fields, _size - 1, _size, _indices());
+        --_size;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
+    // 把 [last, end) 的每个字段向前移动，再析构末尾多出的行
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        const size_type from = static_cast<size_type>(first.index());
+        const size_type to = static_cast<size_type>(last.index());
+        if (from != to)
+        {
+            _move_rows_down(from, to, _indices());
+            _destroy_rows(_fields, _size - (to - from), _size, _indices());
+            _size -= to - from;
+        }
+        return begin() + static_cast<difference_type>(from);
+    }
+
+    void clear() noexcept
+    {
+        _destroy_rows(_fields, 0, _size, _indices());
+        _size = 0;
+    }
+
+    // 新增的行各字段都是值初始化的
+    void resize(size_type n)
+    {
+        if (n < _size)
+        {
+            _destroy_rows(_fields, n, _size, _indices());
+            _size = n;
+            return;
+        }
+        reserve(n);
+        while (_size < n)
+        {
+            _emplace_back_tuple(value_type());
+        }
+    }
+
+    void swap(soa_vector& x) noexcept
+    {
+        xutl::swap(_fields, x._fields);
+        xutl::swap(_block, x._block);
+        xutl::swap(_block_bytes, x._block_bytes);
+        xutl::swap(_size, x._size);
+        xutl::swap(_capacity, x._capacity);
+    }
+
+private:
+    // ********************************************************************************
+    // 辅助函数
+    // ********************************************************************************
+
+    static size_type _row_bytes() noexcept
+    {
+        size_type n = 0;
+        (void)_swallow{0, (n += sizeof(Fields), 0)...};
+        return n;
+    }
+
+    static size_type _align_up(size_type n) noexcept
+    {
+        return (n + _alignment - 1) / _alignment * _alignment;
+    }
+
+    // 容量为 capacity 时的内存布局：offsets[i] 为第 i 个字段数组的起点，返回总字节数
+    static size_type _layout(size_type capacity, size_type* offsets)
+    {
+        const size_type sizes[] = {sizeof(Fields)...};
+        size_type bytes = 0;
+        for (size_type i = 0; i < sizeof...(Fields); ++i)
+        {
+            offsets[i] = bytes;
+            bytes = _align_up(bytes + sizes[i] * capacity);
+        }
+        return bytes;
+    }
+
+    template <size_t... I>
+    static _pointers _field_pointers(unsigned char* block,
+                                     const size_type* offsets,
+                                     index_sequence<I...>)
+    {
+        return _pointers(reinterpret_cast<Fields*>(block + offsets[I])...);
+    }
+
+    template <size_t... I>
+    std::tuple<const Fields*...> _const_fields(index_sequence<I...>) const
+    {
+        return std::tuple<const Fields*...>(std::get<I>(_fields)...);
+    }
+
+    static void _deallocate_block(unsigned char* block, size_type bytes)
+    {
+        _block_allocator::deallocate_aligned(block, bytes, _alignment);
+    }
+
+    template <typename Pointers, size_t... I>
+    static auto _row(const Pointers& fields, size_type n, index_sequence<I...>)
+        -> std::tuple<decltype(*std::get<I>(fields))...>
+    {
+        return std::tuple<decltype(*std::get<I>(fields))...>(
+            std::get<I>(fields)[n]...);
+    }
+
+    template <size_t... I>
+    static void _destroy_rows(const _pointers& fields, size_type first,
+                              size_type last, index_sequence<I...>)
+    {
+        (void)_swallow{0, (xutl::destroy(std::get<I>(fields) + first,
+                                         std::get<I>(fields) + last),
+                           0)...};
+    }
+
+    template <size_t... I>
+    void _move_rows_down(size_type from, size_type to, index_sequence<I...>)
+    {
+        (void)_swallow{0, (xutl::move(std::get<I>(_fields) + to,
+                                      std::get<I>(_fields) + _size,
+                                      std::get<I>(_fields) + from),
+                           0)...};
+    }
+
+    // 在 fields 的第 n 行依次构造各字段，第 I 个字段由 std::get<I>(args) 构造；
+    // 某个字段构造失败时析构同一行已经构造的字段
+    template <typename Tuple, size_t I>
+    static void _construct_row(const _pointers& fields, size_type n,
+                               Tuple&& args, _index<I>)
+    {
+        field_type<I>* p = std::get<I>(fields) + n;
+        xutl::construct(p, std::get<I>(xutl::forward<Tuple>(args)));
+        try
+        {
+            _construct_row(fields, n, xutl::forward<Tuple>(args),
+                           _index<I + 1>());
+        }
+        catch (...)
+        {
+            xutl::destroy(p);
+            throw;
+        }
+    }
+    template <typename Tuple>
+    static void _construct_row(const _pointers&, size_type, Tuple&&,
+                               _end_index)
+    {
+    }
+
+    // 把 src 的前 n 行逐个字段迁移到 dst：移动构造不抛出异常时移动，否则拷贝，
+    // 因此失败时 src 保持不变；某个字段失败时析构 dst 中已经迁移的字段
+    template <size_t I>
+    static void _relocate_fields(const _pointers& dst, const _pointers& src,
+                                 size_type n, _index<I>)
+    {
+        using F = field_type<I>;
+        F* from = std::get<I>(src);
+        F* to = std::get<I>(dst);
+        _relocate_field(
+            from, n, to,
+            integral_constant<bool,
+                              xutl::is_nothrow_move_constructible<F>::value ||
+                                  !xutl::is_copy_constructible<F>::value>());
+        try
+        {
+            _relocate_fields(dst, src, n, _index<I + 1>());
+        }
+        catch (...)
+        {
+            xutl::destroy(to, to + n);
+            throw;
+        }
+    }
+    static void _relocate_fields(const _pointers&, const _pointers&,
+                                 size_type, _end_index)
+    {
+    }
+
+    template <typename F>
+    static void _relocate_field(F* from, size_type n, F* to, true_type)
+    {
+        xutl::uninitialized_move(from, from + n, to);
+    }
+    template <typename F>
+    static void _relocate_field(F* from, size_type n, F* to, false_type)
+    {
+        xutl::uninitialized_copy(from, from + n, to);
+    }
+
+    size_type _recommend_capacity(size_type new_capacity) const
+    {
+        const size_type ms = max_size();
+        if (new_capacity > ms)
+        {
+            THROW_LENGTH_ERROR("soa_vector is too large");
+        }
+        if (_capacity >= ms / 2) return ms;
+        return xutl::max<size_type>(2 * _capacity, new_capacity);
+    }
+
+    // 分配容量为 new_cap 的新内存，先用 construct_new 在其中构造新的行
+    // （返回构造的行数，这些行位于原有的行之后），再把原有的行迁移过去，最后释放旧内存
+    template <typename Construct>
+    void _reallocate_with(size_type new_cap, Construct construct_new)
+    {
+        size_type offsets[sizeof...(Fields)];
+        const size_type bytes = _layout(new_cap, offsets);
+        unsigned char* block = nullptr;
+        if (new_cap != 0)
+        {
+            block = _block_allocator::allocate_aligned(bytes, _alignment);
+        }
+        const _pointers fields = _field_pointers(block, offsets, _indices());
+        size_type built = 0;
+        try
+        {
+            built = construct_new(fields);
+        }
+        catch (...)
+        {
+            _deallocate_block(block, bytes);
+            throw;
+        }
+        try
+        {
+            _relocate_fields(fields, _fields, _size, _index<0>());
+        }
+        catch (...)
+        {
+            _destroy_rows(fields, _size, _size + built, _indices());
+            _deallocate_block(block, bytes);
+            throw;
+        }
+        _destroy_rows(_fields, 0, _size, _indices());
+        _deallocate_block(_block, _block_bytes);
+        _fields = fields;
+        _block = block;
+        _block_bytes = bytes;
+        _capacity = new_cap;
+    }
+
+    void _reallocate(size_type new_cap)
+    {
+        _reallocate_with(new_cap,
+                         [](const _pointers&) { return size_type(0); });
+    }
+
+    template <typename Tuple>
+    void _emplace_back_tuple(Tuple&& args)
+    {
+        if (_size == _capacity)
+        {
+            // 新的行先在新内存中构造，args 可能引用本容器中的元素
+            const size_type n = _size;
+            _reallocate_with(_recommend_capacity(_size + 1),
+                             [n, &args](const _pointers& fields) -> size_type {
+                                 _construct_row(fields, n,
+                                                xutl::forward<Tuple>(args),
+                                                _index<0>());
+                                 return size_type(1);
+                             });
+        }
+        else
+        {
+            _construct_row(_fields, _size, xutl::forward<Tuple>(args),
+                           _index<0>());
+        }
+        ++_size;
+    }
+};
+
+template <typename... Fields>
+constexpr size_t soa_vector<Fields...>::field_count;
+template <typename... Fields>
+constexpr size_t soa_vector<Fields...>::_alignment;
+
+template <typename... Fields>
+void swap(soa_vector<Fields...>& x, soa_vector<Fields...>& y) noexcept
+{
+    x.swap(y);
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_SOA_VECTOR_H_
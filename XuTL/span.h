@@ -0,0 +1,145 @@
+#ifndef XUTL_SPAN_H_
+#define XUTL_SPAN_H_
+
+/**
+ * 该文件包含一个模板类 span
+ * 它是对一段连续元素的非拥有视图（C++20 std::span 的动态长度版本），
+ * 只保存起始指针和元素个数
+ */
+
+#include <cstddef>
+
+#include "exceptdef.h"
+#include "iterator.h"
+
+namespace xutl
+{
+
+template <typename T>
+class span
+{
+public:
+    using element_type = T;
+    using value_type = typename xutl::remove_cv<T>::type;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = T*;
+    using reverse_iterator = xutl::reverse_iterator<iterator>;
+
+private:
+    pointer _data = nullptr;
+    size_type _size = 0;
+
+public:
+    constexpr span() noexcept = default;
+    constexpr span(pointer data, size_type size) noexcept :
+            _data(data),
+            _size(size)
+    {
+    }
+    constexpr span(pointer first, pointer last) noexcept :
+            _data(first),
+            _size(static_cast<size_type>(last - first))
+    {
+    }
+    template <size_t N>
+    constexpr span(T (&arr)[N]) noexcept : _data(arr), _size(N)
+    {
+    }
+    // span<T> 可以转换为 span<const T>
+    template <typename U,
+              typename = typename enable_if<
+                  xutl::is_convertible<U (*)[], T (*)[]>::value>::type>
+    constexpr span(const span<U>& other) noexcept :
+            _data(other.data()),
+            _size(other.size())
+    {
+    }
+
+    // 迭代器
+
+    constexpr iterator begin() const noexcept
+    {
+        return _data;
+    }
+    constexpr iterator end() const noexcept
+    {
+        return _data + _size;
+    }
+    reverse_iterator rbegin() const noexcept
+    {
+        return reverse_iterator(end());
+    }
+    reverse_iterator rend() const noexcept
+    {
+        return reverse_iterator(begin());
+    }
+
+    // 元素访问
+
+    constexpr reference operator[](size_type n) const
+    {
+        return _data[n];
+    }
+    reference at(size_type n) const
+    {
+        if (n >= _size)
+        {
+            THROW_OUT_OF_RANGE("span");
+        }
+        return _data[n];
+    }
+    constexpr reference front() const
+    {
+        return _data[0];
+    }
+    constexpr reference back() const
+    {
+        return _data[_size - 1];
+    }
+    constexpr pointer data() const noexcept
+    {
+        return _data;
+    }
+
+    // 容量
+
+    constexpr size_type size() const noexcept
+    {
+        return _size;
+    }
+    constexpr size_type size_bytes() const noexcept
+    {
+        return _size * sizeof(T);
+    }
+    constexpr bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    // 子视图
+
+    constexpr span first(size_type n) const
+    {
+        return span(_data, n);
+    }
+    constexpr span last(size_type n) const
+    {
+        return span(_data + _size - n, n);
+    }
+    constexpr span subspan(size_type offset,
+                           size_type n = static_cast<size_type>(-1)) const
+    {
+        return span(_data + offset, n == static_cast<size_type>(-1)
+                                        ? _size - offset
+                                        : n);
+    }
+};
+
+}  // namespace xutl
+
+#endif  // XUTL_SPAN_H_
@@ -0,0 +1,196 @@
+#ifndef XUTL_SPLIT_H_
+#define XUTL_SPLIT_H_
+
+/**
+ * 该文件包含函数 split 和它返回的 split_range
+ * split(s, delim) 按单个字符 delim 切分 s，依次得到各段的 string_view，
+ * 不分配内存，也不复制字符。n 个分隔符得到 n + 1 段，相邻的分隔符之间是空段，
+ * 空字符串得到一个空段，与 Python 的 str.split(sep) 相同
+ *
+ * 迭代器每次对 64 个字节生成一个位掩码，第 i 位表示第 i 个字节是分隔符，
+ * 之后每前进一段只需要取出最低位的 1；CPU 支持 AVX2 时掩码由两次 32 字节的比较得到
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "iterator.h"
+#include "simd.h"
+#include "string_view.h"
+
+namespace xutl
+{
+
+// ************************************************************************************
+// 分隔符掩码
+// ************************************************************************************
+
+// [p, p + n) 中等于 c 的字节的位掩码，n <= 64
+inline uint64_t _delimiter_mask_scalar(const char* p, size_t n,
+                                       char c) noexcept
+{
+    uint64_t mask = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        mask |= static_cast<uint64_t>(p[i] == c) << i;
+    }
+    return mask;
+}
+
+#if XUTL_SIMD_X86
+// [p, p + 64) 中等于 c 的字节的位掩码
+XUTL_TARGET("avx2")
+inline uint64_t _delimiter_mask_avx2(const char* p, char c) noexcept
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+    const __m256i* q = reinterpret_cast<const __m256i*>(p);
+    const uint32_t lo = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_loadu_si256(q), needle)));
+    const uint32_t hi = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_loadu_si256(q + 1), needle)));
+    return lo | (static_cast<uint64_t>(hi) << 32);
+}
+#endif
+
+// ************************************************************************************
+// split_iterator
+// ************************************************************************************
+
+class split_iterator
+    : public xutl::iterator<forward_iterator_tag, string_view, std::ptrdiff_t,
+                            const string_view*, string_view>
+{
+public:
+    using value_type = string_view;
+    using reference = string_view;
+    using self = split_iterator;
+
+private:
+    static constexpr size_t _block_bytes = 64;
+
+    const char* _data = nullptr;
+    size_t _size = 0;
+    size_t _start = 0;  // 当前段的起点
+    size_t _end = 0;    // 当前段的终点，即下一个分隔符的位置或 _size
+    size_t _block = 0;  // _mask 对应的 64 字节块的起点
+    uint64_t _mask = 0;  // 块中还没有用过的分隔符
+    char _delim = '\0';
+    bool _simd = false;
+    bool _done = true;
+
+public:
+    // 默认构造的迭代器即尾后迭代器
+    split_iterator() = default;
+    split_iterator(string_view s, char delim) noexcept :
+            _data(s.data()),
+            _size(s.size()),
+            _delim(delim),
+            _simd(simd_has_avx2()),
+            _done(false)
+    {
+        _mask = _scan(0);
+        _end = _next_delimiter();
+    }
+
+    string_view operator*() const noexcept
+    {
+        return string_view(_data + _start, _end - _start);
+    }
+
+    self& operator++() noexcept
+    {
+        if (_end == _size)
+        {
+            _done = true;
+        }
+        else
+        {
+            _start = _end + 1;
+            _end = _next_delimiter();
+        }
+        return *this;
+    }
+    self operator++(int) noexcept
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    // 同一次 split 得到的迭代器之间比较
+    bool operator==(const self& rhs) const noexcept
+    {
+        return _done == rhs._done && (_done || _start == rhs._start);
+    }
+    bool operator!=(const self& rhs) const noexcept
+    {
+        return !(*this == rhs);
+    }
+
+private:
+    // 从 block 开始的 64 个字节（末尾可能不足）的分隔符掩码
+    uint64_t _scan(size_t block) const noexcept
+    {
+#if XUTL_SIMD_X86
+        if (_simd && block + _block_bytes <= _size)
+        {
+            return _delimiter_mask_avx2(_data + block, _delim);
+        }
+#endif
+        const size_t n =
+            _size - block < _block_bytes ? _size - block : _block_bytes;
+        return _delimiter_mask_scalar(_data + block, n, _delim);
+    }
+
+    // 取出下一个分隔符的位置，没有时返回 _size
+    size_t _next_delimiter() noexcept
+    {
+        while (_mask == 0)
+        {
+            _block += _block_bytes;
+            if (_block >= _size) return _size;
+            _mask = _scan(_block);
+        }
+        const size_t pos = _block + static_cast<size_t>(__builtin_ctzll(_mask));
+        _mask &= _mask - 1;
+        return pos;
+    }
+};
+
+// ************************************************************************************
+// split_range
+// ************************************************************************************
+
+class split_range
+{
+private:
+    string_view _s;
+    char _delim;
+
+public:
+    using iterator = split_iterator;
+    using const_iterator = split_iterator;
+
+    split_range(string_view s, char delim) noexcept : _s(s), _delim(delim)
+    {
+    }
+
+    iterator begin() const noexcept
+    {
+        return iterator(_s, _delim);
+    }
+    iterator end() const noexcept
+    {
+        return iterator();
+    }
+};
+
+// 按字符 delim 切分 s，结果中的 string_view 都指向 s 的字符
+inline split_range split(string_view s, char delim) noexcept
+{
+    return split_range(s, delim);
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_SPLIT_H_
@@ -0,0 +1,510 @@
+#ifndef XUTL_STRING_VIEW_H_
+#define XUTL_STRING_VIEW_H_
+
+/**
+ * 该文件包含类 string_view
+ * 它是对一段连续字符的非拥有视图（C++17 std::string_view 的 char 版本），
+ * 只保存起始指针和长度
+ *
+ * 查找单个字符、子串和 find_first_of 在 CPU 支持 AVX2 时每次比较 32 个字节，
+ * 否则使用标量实现
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include "exceptdef.h"
+#include "iterator.h"
+#include "simd.h"
+
+namespace xutl
+{
+
+// ************************************************************************************
+// 字节查找
+// 都返回找到的下标，没有时返回 n
+// ************************************************************************************
+
+#if XUTL_SIMD_X86
+XUTL_TARGET("avx2")
+inline size_t _find_byte_avx2(const char* p, size_t n, char c) noexcept
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+    // 先不对齐地检查前 32 个字节，之后从 32 字节对齐的位置开始，
+    // 避免每次读取都跨越缓存行
+    const uint32_t head = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), needle)));
+    if (head != 0) return static_cast<size_t>(__builtin_ctz(head));
+    size_t i = 32 - (reinterpret_cast<uintptr_t>(p) & 31);
+    // 每次检查 128 个字节，合并四次比较的结果后只判断一次
+    for (; i + 128 <= n; i += 128)
+    {
+        const __m256i* q = reinterpret_cast<const __m256i*>(p + i);
+        const __m256i e0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(q), needle);
+        const __m256i e1 =
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(q + 1), needle);
+        const __m256i e2 =
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(q + 2), needle);
+        const __m256i e3 =
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(q + 3), needle);
+        const __m256i any = _mm256_or_si256(_mm256_or_si256(e0, e1),
+                                            _mm256_or_si256(e2, e3));
+        if (_mm256_testz_si256(any, any)) continue;
+        const uint64_t lo =
+            static_cast<uint32_t>(_mm256_movemask_epi8(e0)) |
+            static_cast<uint64_t>(
+                static_cast<uint32_t>(_mm256_movemask_epi8(e1)))
+                << 32;
+        if (lo != 0) return i + static_cast<size_t>(__builtin_ctzll(lo));
+        const uint64_t hi =
+            static_cast<uint32_t>(_mm256_movemask_epi8(e2)) |
+            static_cast<uint64_t>(
+                static_cast<uint32_t>(_mm256_movemask_epi8(e3)))
+                << 32;
+        return i + 64 + static_cast<size_t>(__builtin_ctzll(hi));
+    }
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        const uint32_t mask = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+        if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    if (i == n) return n;
+    // 调用者保证 n >= 32：最后不足 32 个字节时，与前面的字节重叠着再读一次，
+    // 去掉已经比较过的部分
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + n - 32));
+    const uint32_t mask =
+        static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle))) >>
+        (32 - (n - i));
+    return mask != 0 ? i + static_cast<size_t>(__builtin_ctz(mask)) : n;
+}
+
+// 集合中最多 _find_set_simd_max 个字符时，每 32 个字节与每个字符各比较一次
+constexpr size_t _find_set_simd_max = 8;
+
+XUTL_TARGET("avx2")
+inline size_t _find_first_of_avx2(const char* p, size_t n, const char* set,
+                                  size_t m) noexcept
+{
+    __m256i needles[_find_set_simd_max];
+    for (size_t j = 0; j < m; ++j)
+    {
+        needles[j] = _mm256_set1_epi8(set[j]);
+    }
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i hit = _mm256_cmpeq_epi8(v, needles[0]);
+        for (size_t j = 1; j < m; ++j)
+        {
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, needles[j]));
+        }
+        const uint32_t mask =
+            static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    for (; i < n; ++i)
+    {
+        if (memchr(set, p[i], m) != nullptr) return i;
+    }
+    return n;
+}
+#endif
+
+inline size_t _find_byte(const char* p, size_t n, char c) noexcept
+{
+#if XUTL_SIMD_X86
+    if (n >= 32 && simd_has_avx2()) return _find_byte_avx2(p, n, c);
+#endif
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (p[i] == c) return i;
+    }
+    return n;
+}
+
+// 标量实现先把集合做成 256 项的表
+inline size_t _find_first_of(const char* p, size_t n, const char* set,
+                             size_t m) noexcept
+{
+    if (m == 0) return n;
+    if (m == 1) return _find_byte(p, n, set[0]);
+#if XUTL_SIMD_X86
+    if (m <= _find_set_simd_max && n >= 32 && simd_has_avx2())
+    {
+        return _find_first_of_avx2(p, n, set, m);
+    }
+#endif
+    bool table[256] = {};
+    for (size_t j = 0; j < m; ++j)
+    {
+        table[static_cast<unsigned char>(set[j])] = true;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (table[static_cast<unsigned char>(p[i])]) return i;
+    }
+    return n;
+}
+
+// 子串查找：返回 needle 在 [p, p + n) 中第一次出现的下标，没有时返回 n
+// 标量实现用 _find_byte 找首字符，再比较其余部分
+inline size_t _find_substring_scalar(const char* p, size_t n,
+                                     const char* needle, size_t m) noexcept
+{
+    size_t pos = 0;
+    while (pos + m <= n)
+    {
+        const size_t last = n - m + 1;
+        const size_t i = _find_byte(p + pos, last - pos, needle[0]);
+        if (i == last - pos) return n;
+        pos += i;
+        if (memcmp(p + pos + 1, needle + 1, m - 1) == 0) return pos;
+        ++pos;
+    }
+    return n;
+}
+
+#if XUTL_SIMD_X86
+// 首尾字节过滤：每次取 32 个候选位置，同时比较候选位置上的字节与 needle 的
+// 首字节、候选位置加 m - 1 上的字节与 needle 的末字节，两者都相等的位置
+// 才用 memcmp 比较中间部分。真实文本中很少有位置能通过过滤，
+// 但对于 "aaaa...ab" 之类的输入最坏仍是 O(nm)
+XUTL_TARGET("avx2")
+inline size_t _find_substring_avx2(const char* p, size_t n, const char* needle,
+                                   size_t m) noexcept
+{
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32)
+    {
+        const __m256i a =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        const __m256i b = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(p + i + m - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first),
+                             _mm256_cmpeq_epi8(b, last))));
+        while (mask != 0)
+        {
+            const size_t j = i + static_cast<size_t>(__builtin_ctz(mask));
+            if (memcmp(p + j + 1, needle + 1, m - 2) == 0) return j;
+            mask &= mask - 1;
+        }
+    }
+    const size_t rest = _find_substring_scalar(p + i, n - i, needle, m);
+    return rest == n - i ? n : i + rest;
+}
+#endif
+
+inline size_t _find_substring(const char* p, size_t n, const char* needle,
+                              size_t m) noexcept
+{
+    if (m == 0) return 0;
+    if (m > n) return n;
+    if (m == 1) return _find_byte(p, n, needle[0]);
+#if XUTL_SIMD_X86
+    if (n >= m + 31 && simd_has_avx2())
+    {
+        return _find_substring_avx2(p, n, needle, m);
+    }
+#endif
+    return _find_substring_scalar(p, n, needle, m);
+}
+
+// FNV-1a，供 std::hash 的特化使用
+inline size_t _hash_bytes(const char* p, size_t n) noexcept
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < n; ++i)
+    {
+        h ^= static_cast<unsigned char>(p[i]);
+        h *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(h);
+}
+
+// ************************************************************************************
+// string_view
+// ************************************************************************************
+
+class string_view
+{
+public:
+    using value_type = char;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const char*;
+    using const_pointer = const char*;
+    using reference = const char&;
+    using const_reference = const char&;
+    using iterator = const char*;
+    using const_iterator = const char*;
+    using reverse_iterator = xutl::reverse_iterator<const_iterator>;
+    using const_reverse_iterator = reverse_iterator;
+
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+private:
+    const char* _data = nullptr;
+    size_type _size = 0;
+
+public:
+    constexpr string_view() noexcept = default;
+    constexpr string_view(const char* s, size_type n) noexcept :
+            _data(s),
+            _size(n)
+    {
+    }
+    string_view(const char* s) noexcept : _data(s), _size(strlen(s))
+    {
+    }
+    // 与 std::string 互通
+    string_view(const std::string& s) noexcept :
+            _data(s.data()),
+            _size(s.size())
+    {
+    }
+
+    explicit operator std::string() const
+    {
+        return std::string(_data, _size);
+    }
+
+    // 迭代器
+
+    constexpr const_iterator begin() const noexcept
+    {
+        return _data;
+    }
+    constexpr const_iterator end() const noexcept
+    {
+        return _data + _size;
+    }
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    // 元素访问
+
+    constexpr const_reference operator[](size_type n) const
+    {
+        return _data[n];
+    }
+    const_reference at(size_type n) const
+    {
+        if (n >= _size)
+        {
+            THROW_OUT_OF_RANGE("string_view");
+        }
+        return _data[n];
+    }
+    constexpr const_reference front() const
+    {
+        return _data[0];
+    }
+    constexpr const_reference back() const
+    {
+        return _data[_size - 1];
+    }
+    constexpr const_pointer data() const noexcept
+    {
+        return _data;
+    }
+
+    // 容量
+
+    constexpr size_type size() const noexcept
+    {
+        return _size;
+    }
+    constexpr size_type length() const noexcept
+    {
+        return _size;
+    }
+    constexpr bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    // 修改视图
+
+    void remove_prefix(size_type n) noexcept
+    {
+        _data += n;
+        _size -= n;
+    }
+    void remove_suffix(size_type n) noexcept
+    {
+        _size -= n;
+    }
+    void swap(string_view& v) noexcept
+    {
+        const string_view tmp = *this;
+        *this = v;
+        v = tmp;
+    }
+
+    // ********************************************************************************
+    // 子串和比较
+    // ********************************************************************************
+
+    string_view substr(size_type pos = 0, size_type n = npos) const
+    {
+        if (pos > _size)
+        {
+            THROW_OUT_OF_RANGE("string_view::substr");
+        }
+        return string_view(_data + pos, n < _size - pos ? n : _size - pos);
+    }
+
+    int compare(string_view v) const noexcept
+    {
+        const size_type n = _size < v._size ? _size : v._size;
+        const int r = n == 0 ? 0 : memcmp(_data, v._data, n);
+        if (r != 0) return r;
+        return _size < v._size ? -1 : (_size > v._size ? 1 : 0);
+    }
+
+    bool starts_with(string_view v) const noexcept
+    {
+        return _size >= v._size &&
+               (v._size == 0 || memcmp(_data, v._data, v._size) == 0);
+    }
+    bool starts_with(char c) const noexcept
+    {
+        return _size != 0 && _data[0] == c;
+    }
+    bool ends_with(string_view v) const noexcept
+    {
+        return _size >= v._size &&
+               (v._size == 0 ||
+                memcmp(_data + _size - v._size, v._data, v._size) == 0);
+    }
+    bool ends_with(char c) const noexcept
+    {
+        return _size != 0 && _data[_size - 1] == c;
+    }
+
+    // ********************************************************************************
+    // 查找，找不到时返回 npos
+    // ********************************************************************************
+
+    size_type find(char c, size_type pos = 0) const noexcept
+    {
+        if (pos >= _size) return npos;
+        const size_type i = _find_byte(_data + pos, _size - pos, c);
+        return i == _size - pos ? npos : pos + i;
+    }
+
+    // CPU 支持 AVX2 时用首尾字节过滤，见 _find_substring_avx2
+    size_type find(string_view v, size_type pos = 0) const noexcept
+    {
+        if (pos > _size) return npos;
+        if (v._size == 0) return pos;
+        const size_type i =
+            _find_substring(_data + pos, _size - pos, v._data, v._size);
+        return i == _size - pos ? npos : pos + i;
+    }
+
+    size_type rfind(char c, size_type pos = npos) const noexcept
+    {
+        if (_size == 0) return npos;
+        for (size_type i = pos < _size ? pos + 1 : _size; i > 0; --i)
+        {
+            if (_data[i - 1] == c) return i - 1;
+        }
+        return npos;
+    }
+
+    size_type find_first_of(string_view set, size_type pos = 0) const noexcept
+    {
+        if (pos >= _size) return npos;
+        const size_type i =
+            _find_first_of(_data + pos, _size - pos, set._data, set._size);
+        return i == _size - pos ? npos : pos + i;
+    }
+    size_type find_first_of(char c, size_type pos = 0) const noexcept
+    {
+        return find(c, pos);
+    }
+
+    bool contains(string_view v) const noexcept
+    {
+        return find(v) != npos;
+    }
+    bool contains(char c) const noexcept
+    {
+        return find(c) != npos;
+    }
+};
+
+constexpr string_view::size_type string_view::npos;
+
+// ************************************************************************************
+// 比较运算
+// ************************************************************************************
+
+inline bool operator==(string_view lhs, string_view rhs) noexcept
+{
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+inline bool operator!=(string_view lhs, string_view rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+inline bool operator<(string_view lhs, string_view rhs) noexcept
+{
+    return lhs.compare(rhs) < 0;
+}
+inline bool operator>(string_view lhs, string_view rhs) noexcept
+{
+    return rhs < lhs;
+}
+inline bool operator<=(string_view lhs, string_view rhs) noexcept
+{
+    return !(rhs < lhs);
+}
+inline bool operator>=(string_view lhs, string_view rhs) noexcept
+{
+    return !(lhs < rhs);
+}
+
+inline void swap(string_view& lhs, string_view& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+}  // namespace xutl
+
+namespace std
+{
+
+template <>
+struct hash<xutl::string_view>
+{
+    size_t operator()(xutl::string_view v) const noexcept
+    {
+        return xutl::_hash_bytes(v.data(), v.size());
+    }
+};
+
+}  // namespace std
+
+#endif  // XUTL_STRING_VIEW_H_
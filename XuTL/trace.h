@@ -0,0 +1,381 @@
+#ifndef XUTL_TRACE_H_
+#define XUTL_TRACE_H_
+
+/**
+ * 该文件包含容器热路径上的事件追踪
+ * 编译时定义宏 XUTL_TRACE 才会编译进来，vector 的扩容和 concurrent_hash_map 的
+ * 扩容（rehash）会各自记录一个事件：开始和结束时的时间戳（x86 上为 TSC）、
+ * 容器地址、旧容量、新容量和搬移的字节数。
+ *
+ * 每个线程有一个固定大小的环形缓冲区，只有所属线程写入，写满后覆盖最旧的事件，
+ * 写入时不加锁也没有原子的读改写；导出时从各个缓冲区复制事件，
+ * 再写成 Chrome trace-event 格式的 JSON（可以用 chrome://tracing 或 Perfetto 打开）。
+ *
+ * 编译进来之后，运行时默认不记录，调用 trace_start() 开始、trace_stop() 停止；
+ * 停止时每个追踪点只多一次 relaxed 读取和一次分支。
+ * 未定义 XUTL_TRACE 时追踪宏展开为空，也不引入 <cstdio> 和 <vector>：
+ * trace_start/trace_stop/trace_clear 仍然可以调用但什么都不做，
+ * 返回事件的 trace_snapshot 和 write_chrome_trace 只在定义了宏时提供。
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef XUTL_TRACE
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+#endif
+
+namespace xutl
+{
+
+// 一个追踪事件
+struct trace_event
+{
+    const char* name;      // 事件名，必须是字符串字面量等静态字符串
+    const void* address;   // 容器地址
+    uint64_t begin;        // 开始时间戳
+    uint64_t end;          // 结束时间戳
+    uint64_t old_capacity;
+    uint64_t new_capacity;
+    uint64_t bytes;        // 搬移的字节数
+    uint32_t thread;       // 线程编号，从 1 开始
+};
+
+#ifdef XUTL_TRACE
+
+constexpr bool trace_enabled = true;
+
+// 每个线程的环形缓冲区能保存的事件数，必须是 2 的幂
+#ifndef XUTL_TRACE_RING_SIZE
+#define XUTL_TRACE_RING_SIZE 4096
+#endif
+
+static_assert((XUTL_TRACE_RING_SIZE & (XUTL_TRACE_RING_SIZE - 1)) == 0,
+              "XUTL_TRACE_RING_SIZE 必须是 2 的幂");
+
+// 时间戳：x86 上读取 TSC，其它平台使用 steady_clock 的纳秒数
+inline uint64_t _trace_clock() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+}
+
+// ************************************************************************************
+// 环形缓冲区
+// ************************************************************************************
+
+// 环形缓冲区中的一个槽位
+// 写入前后各更新一次 seq（奇数表示正在写入），读者复制前后比较 seq，
+// 不一致说明复制期间被覆盖，丢弃该事件
+struct _trace_slot
+{
+    std::atomic<uint64_t> seq;
+    std::atomic<const char*> name;
+    std::atomic<const void*> address;
+    std::atomic<uint64_t> begin;
+    std::atomic<uint64_t> end;
+    std::atomic<uint64_t> old_capacity;
+    std::atomic<uint64_t> new_capacity;
+    std::atomic<uint64_t> bytes;
+};
+
+class _trace_ring
+{
+public:
+    explicit _trace_ring(uint32_t thread) noexcept : _head(0), _thread(thread)
+    {
+        for (_trace_slot& slot : _slots)
+        {
+            slot.seq.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // 只由所属线程调用
+    void push(const trace_event& e) noexcept
+    {
+        const uint64_t index = _head.load(std::memory_order_relaxed);
+        _trace_slot& slot = _slots[index & (XUTL_TRACE_RING_SIZE - 1)];
+        const uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(e.name, std::memory_order_relaxed);
+        slot.address.store(e.address, std::memory_order_relaxed);
+        slot.begin.store(e.begin, std::memory_order_relaxed);
+        slot.end.store(e.end, std::memory_order_relaxed);
+        slot.old_capacity.store(e.old_capacity, std::memory_order_relaxed);
+        slot.new_capacity.store(e.new_capacity, std::memory_order_relaxed);
+        slot.bytes.store(e.bytes, std::memory_order_relaxed);
+        slot.seq.store(seq + 2, std::memory_order_release);
+        _head.store(index + 1, std::memory_order_release);
+    }
+
+    // 可以由任意线程调用，把仍然完整的事件按时间顺序追加到 out
+    void collect(std::vector<trace_event>& out) const
+    {
+        const uint64_t head = _head.load(std::memory_order_acquire);
+        const uint64_t first =
+            head > XUTL_TRACE_RING_SIZE ? head - XUTL_TRACE_RING_SIZE : 0;
+        for (uint64_t i = first; i < head; ++i)
+        {
+            const _trace_slot& slot = _slots[i & (XUTL_TRACE_RING_SIZE - 1)];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq & 1) continue;
+            trace_event e;
+            e.name = slot.name.load(std::memory_order_relaxed);
+            e.address = slot.address.load(std::memory_order_relaxed);
+            e.begin = slot.begin.load(std::memory_order_relaxed);
+            e.end = slot.end.load(std::memory_order_relaxed);
+            e.old_capacity = slot.old_capacity.load(std::memory_order_relaxed);
+            e.new_capacity = slot.new_capacity.load(std::memory_order_relaxed);
+            e.bytes = slot.bytes.load(std::memory_order_relaxed);
+            e.thread = _thread;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+            out.push_back(e);
+        }
+    }
+
+    // 清空缓冲区，只在所属线程不会同时写入时调用（例如追踪已经停止）
+    void clear() noexcept
+    {
+        _head.store(0, std::memory_order_relaxed);
+    }
+
+    uint32_t thread() const noexcept
+    {
+        return _thread;
+    }
+
+private:
+    std::atomic<uint64_t> _head;
+    uint32_t _thread;
+    _trace_slot _slots[XUTL_TRACE_RING_SIZE];
+};
+
+// 所有线程的环形缓冲区，创建后永不释放；
+// 线程退出后缓冲区保留，其中的事件仍然可以导出
+class _trace_registry
+{
+public:
+    std::atomic<bool> active;
+    std::mutex lock;
+    std::vector<_trace_ring*> rings;
+    uint32_t next_thread;
+    // 用于把时间戳换算为微秒的基准点
+    uint64_t base_clock;
+    std::chrono::steady_clock::time_point base_time;
+
+    static _trace_registry& instance()
+    {
+        static _trace_registry* registry = new _trace_registry();
+        return *registry;
+    }
+
+    _trace_ring* create_ring()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        _trace_ring* ring = new _trace_ring(next_thread++);
+        rings.push_back(ring);
+        return ring;
+    }
+
+private:
+    _trace_registry() :
+            active(false),
+            next_thread(1),
+            base_clock(_trace_clock()),
+            base_time(std::chrono::steady_clock::now())
+    {
+    }
+};
+
+inline _trace_ring* _trace_current_ring()
+{
+    static thread_local _trace_ring* ring =
+        _trace_registry::instance().create_ring();
+    return ring;
+}
+
+// ************************************************************************************
+// 追踪点
+// ************************************************************************************
+
+// 在作用域开始时记下时间戳，结束时把整个事件写入当前线程的缓冲区
+class _trace_scope
+{
+public:
+    _trace_scope(const char* name, const void* address, uint64_t old_capacity,
+                 uint64_t new_capacity, uint64_t bytes) noexcept
+    {
+        _active = _trace_registry::instance().active.load(
+            std::memory_order_relaxed);
+        if (!_active) return;
+        _event.name = name;
+        _event.address = address;
+        _event.old_capacity = old_capacity;
+        _event.new_capacity = new_capacity;
+        _event.bytes = bytes;
+        _event.begin = _trace_clock();
+    }
+
+    ~_trace_scope()
+    {
+        if (!_active) return;
+        _event.end = _trace_clock();
+        _trace_current_ring()->push(_event);
+    }
+
+    _trace_scope(const _trace_scope&) = delete;
+    _trace_scope& operator=(const _trace_scope&) = delete;
+
+private:
+    bool _active;
+    trace_event _event;
+};
+
+#define XUTL_TRACE_CONCAT_(a, b) a##b
+#define XUTL_TRACE_CONCAT(a, b) XUTL_TRACE_CONCAT_(a, b)
+
+// 记录从这里到所在作用域结束的一个事件
+#define XUTL_TRACE_SCOPE(name, address, old_capacity, new_capacity, bytes) \
+    ::xutl::_trace_scope XUTL_TRACE_CONCAT(_xutl_trace_scope_, __LINE__)(  \
+        name, address, old_capacity, new_capacity, bytes)
+
+// ************************************************************************************
+// 控制和导出
+// ************************************************************************************
+
+inline void trace_start() noexcept
+{
+    _trace_registry::instance().active.store(true, std::memory_order_relaxed);
+}
+
+inline void trace_stop() noexcept
+{
+    _trace_registry::instance().active.store(false, std::memory_order_relaxed);
+}
+
+// 丢弃所有已记录的事件，应当在 trace_stop() 之后调用
+inline void trace_clear()
+{
+    _trace_registry& registry = _trace_registry::instance();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    for (_trace_ring* ring : registry.rings)
+    {
+        ring->clear();
+    }
+}
+
+// 复制出所有线程缓冲区中的事件，同一线程的事件按时间顺序排列
+inline std::vector<trace_event> trace_snapshot()
+{
+    _trace_registry& registry = _trace_registry::instance();
+    std::vector<trace_event> events;
+    std::lock_guard<std::mutex> guard(registry.lock);
+    for (const _trace_ring* ring : registry.rings)
+    {
+        ring->collect(events);
+    }
+    return events;
+}
+
+// 每微秒的时间戳数：用注册表创建以来的时间校准，间隔太短时先等待一会儿
+inline double _trace_ticks_per_us()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _trace_registry& registry = _trace_registry::instance();
+    auto elapsed = std::chrono::steady_clock::now() - registry.base_time;
+    if (elapsed < std::chrono::milliseconds(10))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10) - elapsed);
+    }
+    const uint64_t clock = _trace_clock();
+    elapsed = std::chrono::steady_clock::now() - registry.base_time;
+    const double us =
+        std::chrono::duration<double, std::micro>(elapsed).count();
+    return static_cast<double>(clock - registry.base_clock) / us;
+#else
+    return 1000.0;
+#endif
+}
+
+// 把所有事件写成 Chrome trace-event 格式的 JSON，成功时返回 true
+inline bool write_chrome_trace(FILE* out)
+{
+    const std::vector<trace_event> events = trace_snapshot();
+    const double ticks_per_us = _trace_ticks_per_us();
+    const uint64_t base = _trace_registry::instance().base_clock;
+#if defined(__linux__)
+    const long pid = static_cast<long>(getpid());
+#else
+    const long pid = 1;
+#endif
+    fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const trace_event& e = events[i];
+        const double ts = static_cast<double>(e.begin - base) / ticks_per_us;
+        const double dur = static_cast<double>(e.end - e.begin) / ticks_per_us;
+        fprintf(out,
+                "%s\n{\"name\": \"%s\", \"cat\": \"xutl\", \"ph\": \"X\", "
+                "\"ts\": %.3f, \"dur\": %.3f, \"pid\": %ld, \"tid\": %u, "
+                "\"args\": {\"address\": \"%p\", \"old_capacity\": %llu, "
+                "\"new_capacity\": %llu, \"bytes_moved\": %llu}}",
+                i == 0 ? "" : ",", e.name, ts, dur, pid, e.thread, e.address,
+                static_cast<unsigned long long>(e.old_capacity),
+                static_cast<unsigned long long>(e.new_capacity),
+                static_cast<unsigned long long>(e.bytes));
+    }
+    fprintf(out, "\n]}\n");
+    return ferror(out) == 0;
+}
+
+inline bool write_chrome_trace(const char* path)
+{
+    FILE* out = fopen(path, "w");
+    if (out == nullptr) return false;
+    const bool ok = write_chrome_trace(out);
+    return fclose(out) == 0 && ok;
+}
+
+#else  // XUTL_TRACE
+
+constexpr bool trace_enabled = false;
+
+#define XUTL_TRACE_SCOPE(name, address, old_capacity, new_capacity, bytes) \
+    ((void)0)
+
+inline void trace_start() noexcept
+{
+}
+
+inline void trace_stop() noexcept
+{
+}
+
+inline void trace_clear()
+{
+}
+
+#endif  // XUTL_TRACE
+
+}  // namespace xutl
+
+#endif  // XUTL_TRACE_H_
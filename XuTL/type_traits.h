@@ -62,6 +62,22 @@ using std::is_trivially_copy_assignable;
 using std::is_trivially_move_assignable;
 
 using std::is_constructible;
+using std::is_copy_constructible;
+
+// is_trivially_copyable
+using std::is_trivially_copyable;
+
+// conditional
+using std::conditional;
+
+// is_nothrow_constructible 系列
+using std::is_nothrow_constructible;
+using std::is_nothrow_copy_constructible;
+using std::is_nothrow_move_assignable;
+using std::is_nothrow_move_constructible;
+
+// aligned_storage
+using std::aligned_storage;
 
 // declval
 // 在没有实际创建对象的情况下，实现了创建该类型对象的效果。
@@ -88,6 +104,33 @@ using std::remove_cv;
 // remove_reference
 using std::remove_reference;
 
+// add_lvalue_reference
+using std::add_lvalue_reference;
+
+// is_array, remove_extent
+using std::is_array;
+using std::remove_extent;
+
+// is_empty
+using std::is_empty;
+
+// is_void, is_function, is_pointer, is_member_pointer
+using std::is_function;
+using std::is_member_pointer;
+using std::is_pointer;
+using std::is_void;
+
+// decay
+using std::decay;
+
+// is_trivially_relocatable
+// 把对象按字节拷贝到新地址、并且不再析构原对象，效果等同于移动构造后析构原对象。
+// trivially copyable 的类型都满足；其它类型（如 unique_ptr）可以特化为 true，
+// 容器扩容时对这些类型用 memcpy 代替逐个移动和析构
+template <class T>
+struct is_trivially_relocatable
+    : public integral_constant<bool, std::is_trivially_copyable<T>::value> {};
+
 // is_integral
 
 template <class T>
@@ -24,7 +24,7 @@ ForwardIterator _uninitialized_copy(InputIterator first, InputIterator last,
 
 template <typename InputIterator, typename ForwardIterator>
 ForwardIterator _uninitialized_copy(InputIterator first, InputIterator last,
-                                    ForwardIterator result) {
+                                    ForwardIterator result, xutl::false_type) {
     ForwardIterator current = result;
     try {
         while (first != last) {
@@ -36,6 +36,7 @@ ForwardIterator _uninitialized_copy(InputIterator first, InputIterator last,
     } catch (...) {
         // 出现异常的话，需要析构所有已经构造的对象
         xutl::destroy(result, current);
+        throw;
     }
     return current;
 }
@@ -44,7 +45,7 @@ template <typename InputIterator, typename ForwardIterator>
 ForwardIterator uninitialized_copy(InputIterator first, InputIterator last,
                                    ForwardIterator result) {
     return _uninitialized_copy(
-        first, last,
+        first, last, result,
         xutl::is_trivially_copy_assignable<
             typename iterator_traits<InputIterator>::value_type>{});
 }
@@ -74,6 +75,7 @@ ForwardIterator _uninitialized_copy_n(InputIterator first, Size n,
         }
     } catch (...) {
         xutl::destroy(result, current);
+        throw;
     }
     return current;
 }
@@ -109,6 +111,7 @@ void _uninitialized_fill(ForwardIterator first, ForwardIterator last,
         }
     } catch (...) {
         xutl::destroy(first, current);
+        throw;
     }
 }
 
@@ -143,6 +146,7 @@ ForwardIterator _uninitialized_fill_n(ForwardIterator first, Size n,
         }
     } catch (...) {
         xutl::destroy(first, current);
+        throw;
     }
     return current;
 }
@@ -179,6 +183,7 @@ ForwardIterator _uninitialized_move(InputIterator first, InputIterator last,
         }
     } catch (...) {
         xutl::destroy(result, current);
+        throw;
     }
     return current;
 }
@@ -0,0 +1,711 @@
+#ifndef XUTL_UNROLLED_LIST_H_
+#define XUTL_UNROLLED_LIST_H_
+
+/**
+ * 该文件包含一个模板类 unrolled_list
+ * 它是一个展开的双向链表：每个节点保存一个小数组，节点大约占 2 个缓存行，
+ * 顺序遍历时每个节点只有一次缓存缺失，而 list 每个元素一次
+ *
+ * 节点内的元素连续存放在 [0, count) 中。在节点内插入和删除需要移动节点内的元素，
+ * 代价以 node_capacity 为上限，因此仍是 O(1)；节点满时分裂成两个，删除后元素过少时
+ * 与相邻节点合并。插入和删除会使指向受影响节点的迭代器失效
+ */
+
+#include <cstddef>
+#include <initializer_list>
+
+#include "algorithm.h"
+#include "exceptdef.h"
+#include "iterator.h"
+#include "memory.h"
+#include "type_traits.h"
+#include "uninitialized.h"
+#include "utils.h"
+
+namespace xutl
+{
+
+// 节点之间的链接，链表尾端的空白节点只有这一部分
+struct _unrolled_link
+{
+    _unrolled_link* prev;
+    _unrolled_link* next;
+    size_t count;  // 节点中的元素个数，空白节点为 0
+};
+
+// 节点的元素个数：节点大约占 2 个缓存行，至少 4 个元素
+constexpr size_t _unrolled_capacity_for(size_t element_size)
+{
+    return (2 * cache_line_size - sizeof(_unrolled_link)) / element_size > 4
+               ? (2 * cache_line_size - sizeof(_unrolled_link)) / element_size
+               : 4;
+}
+
+template <typename T>
+struct _unrolled_capacity
+    : integral_constant<size_t, _unrolled_capacity_for(sizeof(T))>
+{
+};
+
+template <typename T>
+struct _unrolled_node : _unrolled_link
+{
+    typename aligned_storage<sizeof(T), alignof(T)>::type
+        storage[_unrolled_capacity<T>::value];
+
+    T* data() noexcept
+    {
+        return reinterpret_cast<T*>(storage);
+    }
+};
+
+// unrolled_list 的迭代器，保存节点和节点内的下标
+template <typename T, bool Const>
+class unrolled_list_iterator
+    : public xutl::iterator<bidirectional_iterator_tag, T, std::ptrdiff_t,
+                            typename conditional<Const, const T*, T*>::type,
+                            typename conditional<Const, const T&, T&>::type>
+{
+public:
+    using value_type = T;
+    using pointer = typename conditional<Const, const T*, T*>::type;
+    using reference = typename conditional<Const, const T&, T&>::type;
+    using self = unrolled_list_iterator<T, Const>;
+
+private:
+    using _node = _unrolled_node<T>;
+
+    _unrolled_link* _link = nullptr;
+    size_t _index = 0;
+
+    template <typename, bool>
+    friend class unrolled_list_iterator;
+    template <typename>
+    friend class unrolled_list;
+
+public:
+    unrolled_list_iterator() = default;
+    unrolled_list_iterator(_unrolled_link* link, size_t index) :
+            _link(link),
+            _index(index)
+    {
+    }
+    // iterator 可以转换为 const_iterator
+    template <bool C, typename = typename enable_if<Const && !C>::type>
+    unrolled_list_iterator(const unrolled_list_iterator<T, C>& other) :
+            _link(other._link),
+            _index(other._index)
+    {
+    }
+
+    reference operator*() const
+    {
+        return static_cast<_node*>(_link)->data()[_index];
+    }
+    pointer operator->() const
+    {
+        return static_cast<_node*>(_link)->data() + _index;
+    }
+
+    self& operator++()
+    {
+        if (++_index == _link->count)
+        {
+            _link = _link->next;
+            _index = 0;
+        }
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+    self& operator--()
+    {
+        if (_index == 0)
+        {
+            _link = _link->prev;
+            _index = _link->count;
+        }
+        --_index;
+        return *this;
+    }
+    self operator--(int)
+    {
+        self tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    template <bool C>
+    bool operator==(const unrolled_list_iterator<T, C>& rhs) const
+    {
+        return _link == rhs._link && _index == rhs._index;
+    }
+    template <bool C>
+    bool operator!=(const unrolled_list_iterator<T, C>& rhs) const
+    {
+        return !(*this == rhs);
+    }
+};
+
+template <typename T>
+class unrolled_list
+{
+public:
+    // 每个节点最多保存的元素个数
+    static constexpr size_t node_capacity = _unrolled_capacity<T>::value;
+
+    using allocator_type = allocator<T>;
+
+    using value_type = T;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = unrolled_list_iterator<T, false>;
+    using const_iterator = unrolled_list_iterator<T, true>;
+    using reverse_iterator = xutl::reverse_iterator<iterator>;
+    using const_reverse_iterator = xutl::reverse_iterator<const_iterator>;
+
+private:
+    using _node = _unrolled_node<T>;
+    using _node_allocator = allocator<_node>;
+    using _data_allocator = allocator<T>;
+
+    // 删除后元素不超过该值的节点尝试与相邻节点合并，合并后不超过 _merge_limit
+    static constexpr size_type _merge_threshold = node_capacity / 4;
+    static constexpr size_type _merge_limit =
+        node_capacity - node_capacity / 4;
+
+    // 数据成员
+
+    _unrolled_link _root;  // 尾端的空白节点，整个链表是一个环
+    size_type _size = 0;
+
+public:
+    // ********************************************************************************
+    // 构造函数/析构函数
+    // ********************************************************************************
+
+    unrolled_list() noexcept
+    {
+        _reset();
+    }
+    // 以下构造函数都委托给默认构造函数，构造元素时抛出异常会执行析构函数，
+    // 释放已经构造的元素和节点
+    explicit unrolled_list(size_type n) : unrolled_list()
+    {
+        while (n--)
+        {
+            emplace_back();
+        }
+    }
+    unrolled_list(size_type n, const value_type& value) : unrolled_list()
+    {
+        while (n--)
+        {
+            push_back(value);
+        }
+    }
+    template <typename InputIterator,
+              typename = typename enable_if<
+                  !is_integral<InputIterator>::value>::type>
+    unrolled_list(InputIterator first, InputIterator last) : unrolled_list()
+    {
+        _append(first, last);
+    }
+    unrolled_list(std::initializer_list<value_type> list) : unrolled_list()
+    {
+        _append(list.begin(), list.end());
+    }
+    unrolled_list(const unrolled_list& x) : unrolled_list()
+    {
+        _append(x.begin(), x.end());
+    }
+    unrolled_list(unrolled_list&& x) noexcept
+    {
+        _reset();
+        swap(x);
+    }
+
+    unrolled_list& operator=(const unrolled_list& x)
+    {
+        if (this != &x)
+        {
+            unrolled_list tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+    unrolled_list& operator=(unrolled_list&& x) noexcept
+    {
+        unrolled_list tmp(xutl::move(x));
+        swap(tmp);
+        return *this;
+    }
+
+    ~unrolled_list()
+    {
+        clear();
+    }
+
+    // ********************************************************************************
+    // 迭代器相关
+    // ********************************************************************************
+
+    iterator begin() noexcept
+    {
+        return iterator(_root.next, 0);
+    }
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(_root.next, 0);
+    }
+    iterator end() noexcept
+    {
+        return iterator(&_root, 0);
+    }
+    const_iterator end() const noexcept
+    {
+        return const_iterator(const_cast<_unrolled_link*>(&_root), 0);
+    }
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    // ********************************************************************************
+    // 容量和元素访问
+    // ********************************************************************************
+
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+    size_type size() const noexcept
+    {
+        return _size;
+    }
+    size_type max_size() const noexcept
+    {
+        return static_cast<size_type>(-1) / sizeof(T);
+    }
+
+    reference front()
+    {
+        return *begin();
+    }
+    const_reference front() const
+    {
+        return *begin();
+    }
+    reference back()
+    {
+        return *(--end());
+    }
+    const_reference back() const
+    {
+        return *(--end());
+    }
+
+    // ********************************************************************************
+    // 修改容器相关
+    // ********************************************************************************
+
+    // 在 position 之前构造一个元素，返回指向它的迭代器
+    template <typename... Args>
+    iterator emplace(const_iterator position, Args&&... args)
+    {
+        _unrolled_link* link = position._link;
+        size_type i = position._index;
+        if (link == &_root)
+        {
+            // 在末尾插入：追加到最后一个节点
+            link = _root.prev;
+            i = link->count;
+        }
+        _node* n = link == &_root ? nullptr : static_cast<_node*>(link);
+        if (n == nullptr || n->count == node_capacity)
+        {
+            // 拆分节点会移动并析构原来的元素，args 可能引用它们，
+            // 所以先构造好新元素
+            value_type tmp(xutl::forward<Args>(args)...);
+            _split_for_insert(n, i);
+            try
+            {
+                _insert_in_node(n, i, xutl::move(tmp));
+            }
+            catch (...)
+            {
+                // 新建的空节点不能留在链表中
+                if (n->count == 0) _free_node(n);
+                throw;
+            }
+        }
+        else
+        {
+            _insert_in_node(n, i, xutl::forward<Args>(args)...);
+        }
+        ++_size;
+        return iterator(n, i);
+    }
+
+    iterator insert(const_iterator position, const value_type& value)
+    {
+        return emplace(position, value);
+    }
+    iterator insert(const_iterator position, value_type&& value)
+    {
+        return emplace(position, xutl::move(value));
+    }
+    iterator insert(const_iterator position, size_type n,
+                    const value_type& value)
+    {
+        iterator result(position._link, position._index);
+        for (size_type k = 0; k < n; ++k)
+        {
+            result = emplace(result, value);
+        }
+        return result;
+    }
+
+    template <typename... Args>
+    void emplace_back(Args&&... args)
+    {
+        emplace(end(), xutl::forward<Args>(args)...);
+    }
+    template <typename... Args>
+    void emplace_front(Args&&... args)
+    {
+        emplace(begin(), xutl::forward<Args>(args)...);
+    }
+    void push_back(const value_type& value)
+    {
+        emplace(end(), value);
+    }
+    void push_back(value_type&& value)
+    {
+        emplace(end(), xutl::move(value));
+    }
+    void push_front(const value_type& value)
+    {
+        emplace(begin(), value);
+    }
+    void push_front(value_type&& value)
+    {
+        emplace(begin(), xutl::move(value));
+    }
+
+    // 删除 position 指向的元素，返回指向下一个元素的迭代器
+    iterator erase(const_iterator position)
+    {
+        _node* n = static_cast<_node*>(position._link);
+        const size_type i = position._index;
+        T* d = n->data();
+        xutl::move(d + i + 1, d + n->count, d + i);
+        _data_allocator::destroy(d + n->count - 1);
+        --n->count;
+        --_size;
+        if (n->count == 0)
+        {
+            _unrolled_link* next = n->next;
+            _free_node(n);
+            return iterator(next, 0);
+        }
+        if (n->count <= _merge_threshold)
+        {
+            return _merge_after_erase(n, i);
+        }
+        return _normalize(n, i);
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        // 合并节点会使 last 失效，因此先数出要删除的个数
+        size_type n = static_cast<size_type>(xutl::distance(first, last));
+        iterator it(first._link, first._index);
+        while (n--)
+        {
+            it = erase(it);
+        }
+        return it;
+    }
+
+    void pop_back()
+    {
+        erase(--end());
+    }
+    void pop_front()
+    {
+        erase(begin());
+    }
+
+    void clear() noexcept
+    {
+        _unrolled_link* cur = _root.next;
+        while (cur != &_root)
+        {
+            _unrolled_link* next = cur->next;
+            _node* n = static_cast<_node*>(cur);
+            _data_allocator::destroy(n->data(), n->data() + n->count);
+            _free_node(n);
+            cur = next;
+        }
+        _reset();
+    }
+
+    void swap(unrolled_list& x) noexcept
+    {
+        _unrolled_link* a = _root.next == &_root ? nullptr : _root.next;
+        _unrolled_link* b = x._root.next == &x._root ? nullptr : x._root.next;
+        _unrolled_link* a_last = _root.prev;
+        _unrolled_link* b_last = x._root.prev;
+        const size_type a_size = _size;
+        const size_type b_size = x._size;
+        _reset();
+        x._reset();
+        if (b != nullptr) _adopt(b, b_last);
+        if (a != nullptr) x._adopt(a, a_last);
+        _size = b_size;
+        x._size = a_size;
+    }
+
+    // 节点个数，用于观察填充率
+    size_type node_count() const noexcept
+    {
+        size_type n = 0;
+        for (const _unrolled_link* p = _root.next; p != &_root; p = p->next)
+        {
+            ++n;
+        }
+        return n;
+    }
+
+private:
+    // ********************************************************************************
+    // 辅助函数
+    // ********************************************************************************
+
+    void _reset() noexcept
+    {
+        _root.prev = _root.next = &_root;
+        _root.count = 0;
+        _size = 0;
+    }
+
+    // 把 [first, last) 这串节点接到空链表上
+    void _adopt(_unrolled_link* first, _unrolled_link* last) noexcept
+    {
+        _root.next = first;
+        _root.prev = last;
+        first->prev = &_root;
+        last->next = &_root;
+    }
+
+    // 在 pos 之后新建一个空节点
+    _node* _new_node_after(_unrolled_link* pos)
+    {
+        _node* n = _node_allocator::allocate();
+        n->count = 0;
+        n->prev = pos;
+        n->next = pos->next;
+        pos->next->prev = n;
+        pos->next = n;
+        return n;
+    }
+
+    void _free_node(_node* n) noexcept
+    {
+        n->prev->next = n->next;
+        n->next->prev = n->prev;
+        _node_allocator::deallocate(n);
+    }
+
+    // 节点 n 已满（或链表为空，n 为空），为在 n 的下标 i 处插入腾出位置，
+    // 完成后 n 和 i 指向插入的位置
+    void _split_for_insert(_node*& n, size_type& i)
+    {
+        if (n == nullptr)
+        {
+            n = _new_node_after(&_root);
+            i = 0;
+            return;
+        }
+        if (i == n->count)
+        {
+            // 追加到满节点的末尾：放到下一个节点的开头，下一个节点也满时新建节点，
+            // 这样顺序 push_back 得到的节点都是满的
+            _unrolled_link* next = n->next;
+            if (next != &_root && next->count < node_capacity)
+            {
+                n = static_cast<_node*>(next);
+            }
+            else
+            {
+                n = _new_node_after(n);
+            }
+            i = 0;
+            return;
+        }
+        if (i == 0 && n->prev != &_root && n->prev->count < node_capacity)
+        {
+            // 插入到满节点的开头：追加到前一个节点的末尾
+            n = static_cast<_node*>(n->prev);
+            i = n->count;
+            return;
+        }
+        // 把后一半元素移到新节点
+        _node* m = _new_node_after(n);
+        const size_type half = n->count / 2;
+        const size_type moved = n->count - half;
+        try
+        {
+            xutl::uninitialized_move(n->data() + half, n->data() + n->count,
+                                     m->data());
+        }
+        catch (...)
+        {
+            _free_node(m);
+            throw;
+        }
+        _data_allocator::destroy(n->data() + half, n->data() + n->count);
+        n->count = half;
+        m->count = moved;
+        if (i > half)
+        {
+            n = m;
+            i -= half;
+        }
+    }
+
+    // 在未满的节点 n 的下标 i 处构造元素，后面的元素后移一位
+    template <typename... Args>
+    void _insert_in_node(_node* n, size_type i, Args&&... args)
+    {
+        T* d = n->data();
+        if (i == n->count)
+        {
+            _data_allocator::construct(d + i, xutl::forward<Args>(args)...);
+        }
+        else
+        {
+            // 先构造好新元素，args 可能引用节点中将被移动的元素
+            value_type tmp(xutl::forward<Args>(args)...);
+            _data_allocator::construct(d + n->count,
+                                       xutl::move(d[n->count - 1]));
+            xutl::move_backward(d + i, d + n->count - 1, d + n->count);
+            d[i] = xutl::move(tmp);
+        }
+        ++n->count;
+    }
+
+    // 节点 n 删除后元素过少，尝试与后一个或前一个节点合并；
+    // 返回指向原来下标 i 处（即被删除元素的下一个元素）的迭代器
+    iterator _merge_after_erase(_node* n, size_type i)
+    {
+        _unrolled_link* next = n->next;
+        if (next != &_root && n->count + next->count <= _merge_limit)
+        {
+            _node* m = static_cast<_node*>(next);
+            _move_all(m, n);
+            _free_node(m);
+            return _normalize(n, i);
+        }
+        _unrolled_link* prev = n->prev;
+        if (prev != &_root && prev->count + n->count <= _merge_limit)
+        {
+            _node* p = static_cast<_node*>(prev);
+            const size_type offset = p->count;
+            _move_all(n, p);
+            _free_node(n);
+            return _normalize(p, offset + i);
+        }
+        return _normalize(n, i);
+    }
+
+    // 把 from 的所有元素移到 to 的末尾
+    void _move_all(_node* from, _node* to)
+    {
+        xutl::uninitialized_move(from->data(), from->data() + from->count,
+                                 to->data() + to->count);
+        _data_allocator::destroy(from->data(), from->data() + from->count);
+        to->count += from->count;
+        from->count = 0;
+    }
+
+    // 下标等于节点的元素个数时，指向下一个节点的开头
+    iterator _normalize(_unrolled_link* link, size_type i) noexcept
+    {
+        if (i == link->count) return iterator(link->next, 0);
+        return iterator(link, i);
+    }
+
+    template <typename InputIterator>
+    void _append(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+        {
+            emplace_back(*first);
+        }
+    }
+};
+
+template <typename T>
+constexpr size_t unrolled_list<T>::node_capacity;
+template <typename T>
+constexpr size_t unrolled_list<T>::_merge_threshold;
+template <typename T>
+constexpr size_t unrolled_list<T>::_merge_limit;
+
+template <typename T>
+bool operator==(const unrolled_list<T>& lhs, const unrolled_list<T>& rhs)
+{
+    if (lhs.size() != rhs.size()) return false;
+    auto j = rhs.begin();
+    for (auto i = lhs.begin(); i != lhs.end(); ++i, ++j)
+    {
+        if (!(*i == *j)) return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool operator!=(const unrolled_list<T>& lhs, const unrolled_list<T>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename T>
+void swap(unrolled_list<T>& lhs, unrolled_list<T>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+}  // namespace xutl
+
+#endif  // XUTL_UNROLLED_LIST_H_
@@ -5,6 +5,8 @@
  * 该文件包含常用的工具类和工具函数，包括 move、forward、swap 等函数，pair 等类
  */
 
+#include <cstddef>
+
 #include "type_traits.h"
 
 namespace xutl {
@@ -38,7 +40,21 @@ inline typename xutl::remove_reference<T>::type&& move(T&& t) noexcept {
 }
 
 // ************************************************************************************
-// move
+// move_if_noexcept
+// 移动构造不会抛出异常（或者不可拷贝）时移动，否则拷贝，用于保证强异常安全
+// ************************************************************************************
+
+template <typename T>
+inline typename xutl::conditional<
+    !xutl::is_nothrow_move_constructible<T>::value &&
+        xutl::is_copy_constructible<T>::value,
+    const T&, T&&>::type
+move_if_noexcept(T& t) noexcept {
+    return xutl::move(t);
+}
+
+// ************************************************************************************
+// swap
 // ************************************************************************************
 template <typename T>
 void swap(T& lhs, T& rhs) {
@@ -56,6 +72,32 @@ template <typename T>
 inline T* address_of(T& value) noexcept {
     return &value;
 }
+
+// ************************************************************************************
+// index_sequence
+// C++14 中 std::index_sequence 的替代，用于展开参数包的下标
+// ************************************************************************************
+
+template <size_t... I>
+struct index_sequence {
+    static constexpr size_t size() noexcept {
+        return sizeof...(I);
+    }
+};
+
+template <size_t N, size_t... I>
+struct _make_index_sequence : _make_index_sequence<N - 1, N - 1, I...> {};
+
+template <size_t... I>
+struct _make_index_sequence<0, I...> {
+    using type = index_sequence<I...>;
+};
+
+template <size_t N>
+using make_index_sequence = typename _make_index_sequence<N>::type;
+
+template <typename... T>
+using index_sequence_for = make_index_sequence<sizeof...(T)>;
 }  // namespace xutl
 
 #endif  // XUTL_UTILS_H_
\ No newline at end of file
@@ -6,12 +6,14 @@
  */
 
 #include <cstddef>
+#include <cstring>
 #include <initializer_list>
 
 #include "algorithm.h"
 #include "exceptdef.h"
 #include "iterator.h"
 #include "memory.h"
+#include "trace.h"
 #include "type_traits.h"
 #include "uninitialized.h"
 #include "utils.h"
@@ -22,7 +24,8 @@ namespace xutl
 // vector_base 类
 // 按照 RAII，vector_base 管理 vector 的资源，包括管理所有数据成员，
 // 负责内存空间的分配和回收，并利用该类的析构函数统一析构所有元素
-template <typename T>
+// 存储空间的起始地址按 Align 对齐
+template <typename T, size_t Align>
 class vector_base
 {
 protected:
@@ -74,12 +77,13 @@ protected:
     void _destroy_at_end(pointer new_end) noexcept
     {
         _data_allocator::destroy(new_end, _finish);
+        _finish = new_end;
     }
 
     // 为 n 个对象分配空间
     void _allocate(size_type n)
     {
-        _finish = _start = _data_allocator::allocate(n);
+        _finish = _start = _data_allocator::allocate_aligned(n, Align);
         _end_of_storage = _start + n;
     }
 
@@ -89,15 +93,16 @@ protected:
         if (_start != nullptr)
         {
             _clear();
-            _data_allocator::deallocate(_start, _capacity());
+            _data_allocator::deallocate_aligned(_start, _capacity(), Align);
             _start = _finish = _end_of_storage = nullptr;
         }
     }
 };
 
 // vector 类
-template <typename T>
-class vector : private vector_base<T>
+// Align 为存储空间起始地址的对齐，默认为 alignof(T)，见 aligned_vector
+template <typename T, size_t Align = alignof(T)>
+class vector : private vector_base<T, Align>
 {
 public:
     static_assert(!std::is_same<typename std::remove_cv<T>, T>::value,
@@ -105,8 +110,11 @@ public:
 
     static_assert(!std::is_same<bool, T>::value, "xutl::vector<bool> 被禁止");
 
+    static_assert((Align & (Align - 1)) == 0 && Align >= alignof(T),
+                  "Align 必须是 2 的幂，且不小于 alignof(T)");
+
 private:
-    using base = vector_base<T>;
+    using base = vector_base<T, Align>;
 
 public:
     using allocator_type = allocator<T>;
@@ -343,11 +351,11 @@ public:
     }
     reference back()
     {
-        return *end();
+        return *(end() - 1);
     }
     const_reference back() const
     {
-        return *end();
+        return *(end() - 1);
     }
 
     pointer data() noexcept
@@ -443,6 +451,25 @@ public:
         return insert(position, list.begin(), list.end());
     }
 
+    // erase
+    iterator erase(const_iterator position);
+    iterator erase(const_iterator first, const_iterator last);
+
+    // resize_and_overwrite
+    // 把容量扩大到至少 n，调用 op(data(), n) 直接写入 [data(), data() + n)，
+    // 原有的元素保持不变；op 返回保留的元素个数 m（m <= n），之后 size() == m
+    // 新位置上的元素不会先被构造，因此只允许 trivially copyable 的 T
+    template <typename Operation>
+    void resize_and_overwrite(size_type n, Operation op)
+    {
+        static_assert(xutl::is_trivially_copyable<T>::value,
+                      "resize_and_overwrite 要求 trivially copyable 的 T");
+        reserve(n);
+        const size_type m = static_cast<size_type>(op(_start, n));
+        XUTL_ASSERT(m <= n);
+        _finish = _start + m;
+    }
+
     // swap
     void swap(vector&) noexcept;
 
@@ -484,19 +511,6 @@ private:
         _finish = xutl::uninitialized_copy(first, last, end());
     }
 
-    // 把 [first, last) 的 n 个元素移动到末尾
-    template <typename InputIterator>
-    typename enable_if<is_input_iterator<InputIterator>::value, void>::type
-    _move_at_end(InputIterator first, InputIterator last)
-    {
-        size_type n = static_cast<size_type>(xutl::distance(first, last));
-        if (size() + n > capacity())
-        {
-            _reallocate(size() + n);
-        }
-        _finish = xutl::uninitialized_move(first, last, end());
-    }
-
     // _destroy_at_end()
     using base::_destroy_at_end;
 
@@ -513,6 +527,16 @@ private:
         return xutl::max<size_type>(2 * capacity(), new_capacity);
     }
 
+    // 在现有元素之外再插入 n 个元素时的建议容量，size() + n 溢出时抛出异常
+    size_type _recommend_capacity_for_insert(size_type n) const
+    {
+        if (n > max_size() - size())
+        {
+            THROW_LENGTH_ERROR("vector<T> is too large");
+        }
+        return _recommend_capacity(size() + n);
+    }
+
     // 重新分配空间（保留原来的元素）
     void _reallocate(size_type new_capacity, bool recommending = true)
     {
@@ -521,107 +545,125 @@ private:
         {
             new_cap = _recommend_capacity(new_capacity);
         }
-        auto old_begin = begin();
-        auto old_end = end();
-        auto old_size = size();
-        _allocate(new_cap);
-        try
-        {
-            _move_at_end(old_begin, old_end);
-        }
-        catch (...)
-        {
-            _deallocate();
-            _start = old_begin;
-            _finish = old_end;
-            throw;
-        }
-        _data_allocator::destroy(old_begin, old_end);
-        _data_allocator::deallocate(old_begin, old_size);
+        XUTL_TRACE_SCOPE("vector::reallocate", this, capacity(), new_cap,
+                         size() * sizeof(T));
+        _reallocate_with_gap(new_cap, _finish, 0, [](pointer) {});
     }
 
     // 重新分配空间（保留原来的元素），并在 pos 处插入元素
     void _reallocate_and_insert(iterator pos, const_reference value)
     {
-        const size_type new_cap = _recommend_capacity(capacity() + 1);
-        iterator old_begin = begin();
-        iterator old_end = end();
-        size_type old_size = size();
-        _allocate(new_cap);
-        try
-        {
-            _move_at_end(old_begin, pos);
-            _construct_at_end(1, value);
-            _move_at_end(pos, old_end);
-        }
-        catch (...)
-        {
-            _deallocate();
-            _start = old_begin;
-            _finish = old_end;
-            throw;
-        }
-        _data_allocator::destroy(old_begin, old_end);
-        _data_allocator::deallocate(old_begin, old_size);
+        const size_type new_cap = _recommend_capacity_for_insert(1);
+        XUTL_TRACE_SCOPE("vector::reallocate_and_insert", this, capacity(),
+                         new_cap, size() * sizeof(T));
+        _reallocate_with_gap(new_cap, pos, 1, [&value](pointer gap) {
+            _data_allocator::construct(gap, value);
+        });
     }
 
     // 重新分配空间（保留原来的元素），并在 pos 处就地构造元素
     template <typename... Args>
     void _reallocate_and_emplace(iterator pos, Args&&... args)
     {
-        const size_type new_cap = _recommend_capacity(capacity() + 1);
-        auto old_begin = begin();
-        auto old_end = end();
-        auto old_size = size();
-        _allocate(new_cap);
-        try
-        {
-            _move_at_end(old_begin, pos);
-            _data_allocator::construct(xutl::address_of(*_finish),
-                                       xutl::forward<Args>(args)...);
-            ++_finish;
-            _move_at_end(pos, old_end);
-        }
-        catch (...)
-        {
-            _deallocate();
-            _start = old_begin;
-            _finish = old_end;
-            throw;
-        }
-        _data_allocator::destroy(old_begin, old_end);
-        _data_allocator::deallocate(old_begin, old_size);
+        const size_type new_cap = _recommend_capacity_for_insert(1);
+        XUTL_TRACE_SCOPE("vector::reallocate_and_emplace", this, capacity(),
+                         new_cap, size() * sizeof(T));
+        _reallocate_with_gap(new_cap, pos, 1, [&](pointer gap) {
+            _data_allocator::construct(gap, xutl::forward<Args>(args)...);
+        });
     }
 
     // 重新分配空间（保留原来的元素），并从 pos 处开始插入 n 个元素
     void _reallocate_and_fill_n(iterator pos, size_type n,
                                 const_reference value)
     {
-        const size_type new_cap = _recommend_capacity(capacity() + n);
-        auto old_begin = begin();
-        auto old_end = end();
-        auto old_size = size();
+        const size_type new_cap = _recommend_capacity_for_insert(n);
+        XUTL_TRACE_SCOPE("vector::reallocate_and_fill_n", this, capacity(),
+                         new_cap, size() * sizeof(T));
+        _reallocate_with_gap(new_cap, pos, n, [n, &value](pointer gap) {
+            xutl::uninitialized_fill_n(gap, n, value);
+        });
+    }
+
+    // 以上几种重新分配的公共部分：
+    // 分配 new_cap 大小的新空间，先由 construct_gap 在新空间中 pos 对应的位置构造
+    // n 个新元素（此时旧元素都还完好，新元素可以引用它们），再把 [begin, pos) 和
+    // [pos, end) 迁移到新元素的两侧，最后释放旧空间
+    template <typename Construct>
+    void _reallocate_with_gap(size_type new_cap, pointer pos, size_type n,
+                              Construct construct_gap)
+    {
+        pointer old_begin = _start;
+        pointer old_end = _finish;
+        pointer old_end_of_storage = _end_of_storage;
+        const size_type offset = static_cast<size_type>(pos - old_begin);
+        // 新空间至少要放下 pos 之前的元素和新元素。调用者已经保证了这一点，
+        // 写出来是让编译器也知道 new_cap 不为 0，分配结果不是空指针
+        if (new_cap < offset + n)
+        {
+            THROW_LENGTH_ERROR("vector<T> is too large");
+        }
         _allocate(new_cap);
+        pointer gap = _start + offset;
+        bool gap_built = false;
         try
         {
-            _move_at_end(old_begin, pos);
-            xutl::fill_n(_finish, n, value);
-            _move_at_end(pos, old_end);
+            construct_gap(gap);
+            gap_built = true;
+            _relocate_at_end(old_begin, pos);
+            _finish += n;
+            _relocate_at_end(pos, old_end);
         }
         catch (...)
         {
+            // construct_gap 失败时已自行析构构造了一半的元素；
+            // 异常发生在前半段迁移完成之前时，新元素还不在 [_start, _finish) 内
+            if (gap_built && _finish <= gap)
+            {
+                _data_allocator::destroy(gap, gap + n);
+            }
+            // 按字节迁移的元素仍由旧空间持有，不能在新空间中析构
+            if (xutl::is_trivially_relocatable<T>::value) _finish = _start;
             _deallocate();
             _start = old_begin;
             _finish = old_end;
+            _end_of_storage = old_end_of_storage;
             throw;
         }
-        _data_allocator::destroy(old_begin, old_end);
-        _data_allocator::deallocate(old_begin, old_size);
+        if (!xutl::is_trivially_relocatable<T>::value)
+        {
+            _data_allocator::destroy(old_begin, old_end);
+        }
+        _data_allocator::deallocate_aligned(
+            old_begin, static_cast<size_type>(old_end_of_storage - old_begin),
+            Align);
+    }
+
+    // 把 [first, last) 的元素迁移到末尾
+    // trivially relocatable 的类型（如 unique_ptr）直接按字节拷贝，
+    // 原位置上的对象视为已经不存在，不再析构；其它类型逐个移动构造
+    void _relocate_at_end(pointer first, pointer last)
+    {
+        _relocate_at_end(first, last, xutl::is_trivially_relocatable<T>());
+    }
+    void _relocate_at_end(pointer first, pointer last, xutl::true_type)
+    {
+        const size_type n = static_cast<size_type>(last - first);
+        if (n > 0)
+        {
+            memcpy(static_cast<void*>(_finish), static_cast<const void*>(first),
+                   n * sizeof(T));
+            _finish += n;
+        }
+    }
+    void _relocate_at_end(pointer first, pointer last, xutl::false_type)
+    {
+        _finish = xutl::uninitialized_move(first, last, _finish);
     }
 };
 
-template <typename T>
-vector<T>& vector<T>::operator=(const vector<T>& x)
+template <typename T, size_t Align>
+vector<T, Align>& vector<T, Align>::operator=(const vector<T, Align>& x)
 {
     if (this != &x)
     {
@@ -630,22 +672,23 @@ vector<T>& vector<T>::operator=(const vector<T>& x)
     return *this;
 }
 
-template <typename T>
-vector<T>& vector<T>::operator=(vector<T>&& x) noexcept
+template <typename T, size_t Align>
+vector<T, Align>& vector<T, Align>::operator=(vector<T, Align>&& x) noexcept
 {
     _deallocate();
     _start = x._start;
     _finish = x._finish;
     _end_of_storage = x._end_of_storage;
     x._start = x._finish = x._end_of_storage = nullptr;
+    return *this;
 }
 
-template <typename T>
+template <typename T, size_t Align>
 template <typename InputIterator>
 typename enable_if<xutl::is_input_iterator<InputIterator>::value &&
                        !xutl::is_forward_iterator<InputIterator>::value,
                    void>::type
-vector<T>::assign(InputIterator first, InputIterator last)
+vector<T, Align>::assign(InputIterator first, InputIterator last)
 {
     clear();
     while (first != last)
@@ -655,11 +698,11 @@ vector<T>::assign(InputIterator first, InputIterator last)
     }
 }
 
-template <typename T>
+template <typename T, size_t Align>
 template <typename ForwardIterator>
 typename enable_if<xutl::is_forward_iterator<ForwardIterator>::value,
                    void>::type
-vector<T>::assign(ForwardIterator first, ForwardIterator last)
+vector<T, Align>::assign(ForwardIterator first, ForwardIterator last)
 {
     const size_type new_size =
         static_cast<size_type>(xutl::distance(first, last));
@@ -692,8 +735,8 @@ vector<T>::assign(ForwardIterator first, ForwardIterator last)
     }
 }
 
-template <typename T>
-void vector<T>::assign(size_type n, const_reference value)
+template <typename T, size_t Align>
+void vector<T, Align>::assign(size_type n, const_reference value)
 {
     if (n <= capacity())
     {
@@ -716,14 +759,14 @@ void vector<T>::assign(size_type n, const_reference value)
     }
 }
 
-template <typename T>
-void vector<T>::assign(std::initializer_list<value_type> list)
+template <typename T, size_t Align>
+void vector<T, Align>::assign(std::initializer_list<value_type> list)
 {
     assign(list.begin(), list.end());
 }
 
-template <typename T>
-void vector<T>::push_back(const_reference value)
+template <typename T, size_t Align>
+void vector<T, Align>::push_back(const_reference value)
 {
     if (_finish != _end_of_storage)
     {
@@ -736,15 +779,15 @@ void vector<T>::push_back(const_reference value)
     }
 }
 
-template <typename T>
-void vector<T>::push_back(value_type&& value)
+template <typename T, size_t Align>
+void vector<T, Align>::push_back(value_type&& value)
 {
     emplace_back(xutl::move(value));
 }
 
-template <typename T>
+template <typename T, size_t Align>
 template <typename... Args>
-void vector<T>::emplace_back(Args&&... args)
+void vector<T, Align>::emplace_back(Args&&... args)
 {
     if (_finish != _end_of_storage)
     {
@@ -758,20 +801,19 @@ void vector<T>::emplace_back(Args&&... args)
     }
 }
 
-template <typename T>
-void vector<T>::pop_back()
+template <typename T, size_t Align>
+void vector<T, Align>::pop_back()
 {
     if (!empty())
     {
         _destroy_at_end(_finish - 1);
-        --_finish;
     }
 }
 
-template <typename T>
+template <typename T, size_t Align>
 template <typename... Args>
-typename vector<T>::iterator vector<T>::emplace(const_iterator position,
-                                                Args&&... args)
+typename vector<T, Align>::iterator vector<T, Align>::emplace(
+    const_iterator position, Args&&... args)
 {
     iterator pos = const_cast<iterator>(position);
     const size_type n = pos - _start;
@@ -787,7 +829,7 @@ typename vector<T>::iterator vector<T>::emplace(const_iterator position,
         {
             auto old_finish = _finish;
             _data_allocator::construct(xutl::address_of(*_finish),
-                                       *(_finish - 1));
+                                       xutl::move(*(_finish - 1)));
             ++_finish;
             xutl::move_backward(pos, old_finish - 1, old_finish);
             *pos = value_type(xutl::forward<Args>(args)...);
@@ -800,9 +842,9 @@ typename vector<T>::iterator vector<T>::emplace(const_iterator position,
     return _start + n;
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::insert(const_iterator position,
-                                               const_reference value)
+template <typename T, size_t Align>
+typename vector<T, Align>::iterator vector<T, Align>::insert(
+    const_iterator position, const_reference value)
 {
     // 去除 const
     // iterator pos = const_cast<iterator>(position);
@@ -819,7 +861,7 @@ typename vector<T>::iterator vector<T>::insert(const_iterator position,
         {
             auto old_finish = _finish;
             _data_allocator::construct(xutl::address_of(*_finish),
-                                       *(_finish - 1));
+                                       xutl::move(*(_finish - 1)));
             ++_finish;
             // value 是引用，如果它是内部元素之一，那么它可能被改变，因此先拷贝
             auto value_copy = value;
@@ -834,43 +876,137 @@ typename vector<T>::iterator vector<T>::insert(const_iterator position,
     return _start + n;
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::insert(const_iterator position,
-                                               size_type n,
-                                               const_reference value)
+template <typename T, size_t Align>
+typename vector<T, Align>::iterator vector<T, Align>::insert(
+    const_iterator position, size_type n, const_reference value)
 {
     iterator pos = _start + (position - begin());
-    if (n <= 0) return pos;
-    // 如果插入 n 后，容量不会超过上限
-    if (n <= static_cast<size_type>(_end_of_storage - end()))
-    {
-        auto old_n = n;
-        auto old_end = _finish;
-        // 如果插入的 n 个元素比原来的末尾还要长，先插入末尾多出来的元素
-        if (n > static_cast<size_type>(end() - pos))
+    const size_type offset = static_cast<size_type>(pos - _start);
+    if (n == 0) return pos;
+    // 如果插入 n 个元素后，容量不会超过上限
+    if (n <= static_cast<size_type>(_end_of_storage - _finish))
+    {
+        // value 可能是内部元素之一，移动元素之前先拷贝
+        value_type value_copy = value;
+        const size_type elems_after = static_cast<size_type>(_finish - pos);
+        pointer old_finish = _finish;
+        if (elems_after > n)
         {
-            size_type n_at_end = n - (end() - pos);
-            _construct_at_end(n_at_end, value);
-            n -= n_at_end;
+            // 末尾的 n 个元素移动到未初始化空间，其余的元素向后移动 n 个位置
+            _finish = xutl::uninitialized_move(old_finish - n, old_finish,
+                                               old_finish);
+            xutl::move_backward(pos, old_finish - n, old_finish);
+            xutl::fill_n(pos, n, value_copy);
         }
-        // 接着把 pos 到末尾的元素插入
-        // 由于 pos 可能就是末尾，所以再判断一次 n > 0
-        if (n > 0)
+        else
         {
-            auto value_copy = value;
-            _move_at_end(pos, old_end);
-            xutl::fill_n(pos, n, value_copy);
+            // 插入的元素比 pos 之后的元素还多，多出来的部分直接在末尾构造
+            _finish = xutl::uninitialized_fill_n(old_finish, n - elems_after,
+                                                 value_copy);
+            _finish = xutl::uninitialized_move(pos, old_finish, _finish);
+            xutl::fill_n(pos, elems_after, value_copy);
         }
     }
     else
     {
         _reallocate_and_fill_n(pos, n, value);
     }
-    return _start + n;
+    return _start + offset;
+}
+
+template <typename T, size_t Align>
+template <typename InputIterator>
+typename enable_if<
+    xutl::is_input_iterator<InputIterator>::value &&
+        !xutl::is_forward_iterator<InputIterator>::value &&
+        xutl::is_constructible<
+            T, typename iterator_traits<InputIterator>::reference>::value,
+    typename vector<T, Align>::iterator>::type
+vector<T, Align>::insert(const_iterator position, InputIterator first,
+                  InputIterator last)
+{
+    // 输入迭代器只能遍历一次，无法预先知道元素个数，只能逐个插入
+    size_type offset = static_cast<size_type>(position - begin());
+    const size_type result = offset;
+    while (first != last)
+    {
+        emplace(begin() + offset, *first);
+        ++offset;
+        ++first;
+    }
+    return _start + result;
+}
+
+template <typename T, size_t Align>
+template <typename ForwardIterator>
+typename enable_if<
+    xutl::is_forward_iterator<ForwardIterator>::value &&
+        xutl::is_constructible<
+            T, typename iterator_traits<ForwardIterator>::reference>::value,
+    typename vector<T, Align>::iterator>::type
+vector<T, Align>::insert(const_iterator position, ForwardIterator first,
+                  ForwardIterator last)
+{
+    iterator pos = _start + (position - begin());
+    const size_type offset = static_cast<size_type>(pos - _start);
+    const size_type n = static_cast<size_type>(xutl::distance(first, last));
+    if (n == 0) return pos;
+    if (n <= static_cast<size_type>(_end_of_storage - _finish))
+    {
+        const size_type elems_after = static_cast<size_type>(_finish - pos);
+        pointer old_finish = _finish;
+        if (elems_after > n)
+        {
+            _finish = xutl::uninitialized_move(old_finish - n, old_finish,
+                                               old_finish);
+            xutl::move_backward(pos, old_finish - n, old_finish);
+            xutl::copy(first, last, pos);
+        }
+        else
+        {
+            ForwardIterator mid = first;
+            xutl::advance(mid, elems_after);
+            _finish = xutl::uninitialized_copy(mid, last, old_finish);
+            _finish = xutl::uninitialized_move(pos, old_finish, _finish);
+            xutl::copy(first, mid, pos);
+        }
+    }
+    else
+    {
+        const size_type new_cap = _recommend_capacity_for_insert(n);
+        XUTL_TRACE_SCOPE("vector::reallocate_and_copy", this, capacity(),
+                         new_cap, size() * sizeof(T));
+        _reallocate_with_gap(new_cap, pos, n, [first, last](pointer gap) {
+            xutl::uninitialized_copy(first, last, gap);
+        });
+    }
+    return _start + offset;
+}
+
+template <typename T, size_t Align>
+typename vector<T, Align>::iterator vector<T, Align>::erase(
+    const_iterator position)
+{
+    return erase(position, position + 1);
 }
 
-template <typename T>
-void vector<T>::swap(vector<T>& rhs) noexcept
+template <typename T, size_t Align>
+typename vector<T, Align>::iterator vector<T, Align>::erase(
+    const_iterator first, const_iterator last)
+{
+    iterator pos = _start + (first - begin());
+    if (first != last)
+    {
+        // 把 [last, end) 向前移动到 pos，再析构末尾多出来的元素
+        pointer new_finish =
+            xutl::move(_start + (last - begin()), _finish, pos);
+        _destroy_at_end(new_finish);
+    }
+    return pos;
+}
+
+template <typename T, size_t Align>
+void vector<T, Align>::swap(vector<T, Align>& rhs) noexcept
 {
     if (this != &rhs)
     {
@@ -880,6 +1016,13 @@ void vector<T>::swap(vector<T>& rhs) noexcept
     }
 }
 
+// aligned_vector
+// 存储空间的起始地址按 Align 对齐的 vector：例如 aligned_vector<float, 64>
+// 可以让 SIMD 内核使用对齐的加载指令；元素类型本身是 alignas(64) 的时，
+// 每个元素各占独立的缓存行，不同线程的元素之间没有伪共享
+template <typename T, size_t Align>
+using aligned_vector = vector<T, Align>;
+
 }  // namespace xutl
 
 #endif  // XUTL_VECTOR_H_
\ No newline at end of file
@@ -0,0 +1,721 @@
+#ifndef XUTL_XSTRING_H_
+#define XUTL_XSTRING_H_
+
+/**
+ * 该文件包含类 string
+ * 文件不命名为 string.h，以免在 XuTL 目录加入头文件搜索路径时遮住 C 的 <string.h>
+ *
+ * string 对象大小为 3 个指针（64 位平台上 24 字节），带小字符串优化（SSO）：
+ * 不超过 sizeof(string) - 1 个（64 位平台上 23 个）字符时直接保存在对象内部，
+ * 最后一个字节保存「还能再放几个字符」，长度恰好为 23 时它为 0，同时充当结尾的 '\0'；
+ * 更长时对象中保存指针、长度和容量，容量最高字节的最高位作为标记。
+ * 对象中不保存指向自身的指针，因此可以按字节搬移（trivially relocatable）。
+ *
+ * append 扩容时与 vector 一样至少翻倍，字符用 memcpy 复制；
+ * append_and_overwrite() 让调用者直接写入新增部分，不需要先填充
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <string>
+
+#include "algorithm.h"
+#include "exceptdef.h"
+#include "iterator.h"
+#include "memory.h"
+#include "string_view.h"
+#include "type_traits.h"
+#include "utils.h"
+
+namespace xutl
+{
+
+class string
+{
+public:
+    using value_type = char;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = char*;
+    using const_pointer = const char*;
+    using reference = char&;
+    using const_reference = const char&;
+    using iterator = char*;
+    using const_iterator = const char*;
+    using reverse_iterator = xutl::reverse_iterator<iterator>;
+    using const_reverse_iterator = xutl::reverse_iterator<const_iterator>;
+    using allocator_type = allocator<char>;
+
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+private:
+    struct _long_rep
+    {
+        char* ptr;
+        size_type size;
+        size_type cap_word;  // 容量，最高字节的最高位为长字符串标记
+    };
+
+    static constexpr size_type _bytes = sizeof(_long_rep);
+    static constexpr size_type _flag_shift = 8 * (sizeof(size_type) - 1);
+
+public:
+    // 能直接保存在对象内部的最多字符数
+    static constexpr size_type small_capacity = _bytes - 1;
+
+private:
+    union
+    {
+        _long_rep _long;
+        char _small[_bytes];
+    };
+
+public:
+    // ********************************************************************************
+    // 构造函数/析构函数
+    // ********************************************************************************
+
+    string() noexcept
+    {
+        _set_small_size(0);
+    }
+    string(const char* s)
+    {
+        _init(s, strlen(s));
+    }
+    string(const char* s, size_type n)
+    {
+        _init(s, n);
+    }
+    string(size_type n, char c)
+    {
+        _init_uninitialized(n);
+        memset(data(), c, n);
+    }
+    explicit string(string_view v)
+    {
+        _init(v.data(), v.size());
+    }
+    string(std::initializer_list<char> ilist)
+    {
+        _init(ilist.begin(), ilist.size());
+    }
+    string(const string& s)
+    {
+        _init(s.data(), s.size());
+    }
+    // 直接复制对象的字节，s 变为空字符串
+    string(string&& s) noexcept
+    {
+        memcpy(static_cast<void*>(this), &s, _bytes);
+        s._set_small_size(0);
+    }
+    ~string()
+    {
+        _release();
+    }
+
+    string& operator=(const string& s)
+    {
+        if (this != &s) assign(s.data(), s.size());
+        return *this;
+    }
+    string& operator=(string&& s) noexcept
+    {
+        if (this != &s)
+        {
+            _release();
+            memcpy(static_cast<void*>(this), &s, _bytes);
+            s._set_small_size(0);
+        }
+        return *this;
+    }
+    string& operator=(const char* s)
+    {
+        return assign(s, strlen(s));
+    }
+    string& operator=(string_view v)
+    {
+        return assign(v.data(), v.size());
+    }
+
+    operator string_view() const noexcept
+    {
+        return string_view(data(), size());
+    }
+    explicit operator std::string() const
+    {
+        return std::string(data(), size());
+    }
+
+    // ********************************************************************************
+    // 迭代器
+    // ********************************************************************************
+
+    iterator begin() noexcept
+    {
+        return data();
+    }
+    const_iterator begin() const noexcept
+    {
+        return data();
+    }
+    iterator end() noexcept
+    {
+        return data() + size();
+    }
+    const_iterator end() const noexcept
+    {
+        return data() + size();
+    }
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    // ********************************************************************************
+    // 容量
+    // ********************************************************************************
+
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+    size_type size() const noexcept
+    {
+        return _is_long() ? _long.size : _small_size();
+    }
+    size_type length() const noexcept
+    {
+        return size();
+    }
+    size_type capacity() const noexcept
+    {
+        return _is_long() ? _long_capacity() : small_capacity;
+    }
+    // 容量的最高字节用作标记
+    static constexpr size_type max_size() noexcept
+    {
+        return (size_type(1) << _flag_shift) - 2;
+    }
+    bool is_small() const noexcept
+    {
+        return !_is_long();
+    }
+
+    // 容量扩大到至少 n，n 不大于当前容量时什么都不做
+    void reserve(size_type n)
+    {
+        if (n > capacity()) _reallocate(n);
+    }
+    // 释放多余的容量，足够短时搬回对象内部
+    void shrink_to_fit()
+    {
+        if (!_is_long() || _long.size == _long_capacity()) return;
+        const size_type n = _long.size;
+        if (n <= small_capacity)
+        {
+            char* old = _long.ptr;
+            const size_type old_cap = _long_capacity();
+            memcpy(_small, old, n);
+            _set_small_size(n);
+            allocator_type::deallocate(old, old_cap + 1);
+            return;
+        }
+        _reallocate(n);
+    }
+
+    // ********************************************************************************
+    // 元素访问
+    // ********************************************************************************
+
+    reference operator[](size_type n)
+    {
+        XUTL_ASSERT(n <= size());
+        return data()[n];
+    }
+    const_reference operator[](size_type n) const
+    {
+        XUTL_ASSERT(n <= size());
+        return data()[n];
+    }
+    reference at(size_type n)
+    {
+        if (n >= size())
+        {
+            THROW_OUT_OF_RANGE("string::at() subscript out of range");
+        }
+        return data()[n];
+    }
+    const_reference at(size_type n) const
+    {
+        if (n >= size())
+        {
+            THROW_OUT_OF_RANGE("string::at() subscript out of range");
+        }
+        return data()[n];
+    }
+    reference front()
+    {
+        return data()[0];
+    }
+    const_reference front() const
+    {
+        return data()[0];
+    }
+    reference back()
+    {
+        return data()[size() - 1];
+    }
+    const_reference back() const
+    {
+        return data()[size() - 1];
+    }
+    char* data() noexcept
+    {
+        return _is_long() ? _long.ptr : _small;
+    }
+    const char* data() const noexcept
+    {
+        return _is_long() ? _long.ptr : _small;
+    }
+    const char* c_str() const noexcept
+    {
+        return data();
+    }
+
+    // ********************************************************************************
+    // 修改
+    // ********************************************************************************
+
+    string& assign(const char* s, size_type n)
+    {
+        if (n <= capacity())
+        {
+            // s 可能指向自身
+            memmove(data(), s, n);
+            _set_size(n);
+            return *this;
+        }
+        string tmp(s, n);
+        swap(tmp);
+        return *this;
+    }
+    string& assign(string_view v)
+    {
+        return assign(v.data(), v.size());
+    }
+
+    // 追加 n 个字符，空间不够时按 vector 的策略扩容
+    string& append(const char* s, size_type n)
+    {
+        const size_type sz = size();
+        if (n <= capacity() - sz)
+        {
+            // 追加的位置在现有字符之后，即使 s 指向自身也不会重叠
+            char* p = data();
+            memcpy(p + sz, s, n);
+            _set_size(sz + n);
+            return *this;
+        }
+        _grow_and_append(s, n);
+        return *this;
+    }
+    string& append(string_view v)
+    {
+        return append(v.data(), v.size());
+    }
+    string& append(const char* s)
+    {
+        return append(s, strlen(s));
+    }
+    string& append(size_type n, char c)
+    {
+        const size_type sz = size();
+        _reserve_for(sz + n);
+        memset(data() + sz, c, n);
+        _set_size(sz + n);
+        return *this;
+    }
+    string& operator+=(string_view v)
+    {
+        return append(v.data(), v.size());
+    }
+    string& operator+=(const char* s)
+    {
+        return append(s, strlen(s));
+    }
+    string& operator+=(char c)
+    {
+        push_back(c);
+        return *this;
+    }
+
+    void push_back(char c)
+    {
+        append(&c, 1);
+    }
+    void pop_back() noexcept
+    {
+        XUTL_ASSERT(!empty());
+        _set_size(size() - 1);
+    }
+
+    // append_and_overwrite
+    // 在末尾预留 n 个字符的空间（按 vector 的策略扩容），调用 op(p, n)
+    // 直接写入 [p, p + n)，p 为原来的 end()；op 返回实际写入的个数 m（m <= n），
+    // 之后 size() 增加 m。新增的部分不会先被填充
+    template <typename Operation>
+    string& append_and_overwrite(size_type n, Operation op)
+    {
+        const size_type sz = size();
+        _reserve_for(sz + n);
+        const size_type m = static_cast<size_type>(op(data() + sz, n));
+        XUTL_ASSERT(m <= n);
+        _set_size(sz + m);
+        return *this;
+    }
+
+    // resize_and_overwrite
+    // 与 vector::resize_and_overwrite 相同：容量扩大到至少 n，
+    // 调用 op(data(), n) 直接写入，op 返回保留的字符数 m（m <= n）
+    template <typename Operation>
+    void resize_and_overwrite(size_type n, Operation op)
+    {
+        reserve(n);
+        const size_type m = static_cast<size_type>(op(data(), n));
+        XUTL_ASSERT(m <= n);
+        _set_size(m);
+    }
+
+    void resize(size_type n, char c = '\0')
+    {
+        const size_type sz = size();
+        if (n > sz)
+        {
+            append(n - sz, c);
+        }
+        else
+        {
+            _set_size(n);
+        }
+    }
+
+    void clear() noexcept
+    {
+        _set_size(0);
+    }
+
+    // 在 pos 处插入 [s, s + n)，s 可能指向自身
+    string& insert(size_type pos, const char* s, size_type n)
+    {
+        const size_type sz = size();
+        if (pos > sz)
+        {
+            THROW_OUT_OF_RANGE("string::insert");
+        }
+        if (n > capacity() - sz)
+        {
+            _grow_and_insert(pos, s, n);
+            return *this;
+        }
+        char* p = data();
+        memmove(p + pos + n, p + pos, sz - pos);
+        // s 指向自身时，pos 之前的部分没有移动，pos 及之后的部分后移了 n
+        size_type head = n;
+        if (s >= p && s <= p + sz)
+        {
+            head = s < p + pos ? static_cast<size_type>(p + pos - s) : 0;
+            head = head < n ? head : n;
+        }
+        memmove(p + pos, s, head);
+        memcpy(p + pos + head, s + head + (head < n ? n : 0), n - head);
+        _set_size(sz + n);
+        return *this;
+    }
+    string& insert(size_type pos, string_view v)
+    {
+        return insert(pos, v.data(), v.size());
+    }
+
+    // 删除 [pos, pos + n)，n 超过剩余长度时删除到末尾
+    string& erase(size_type pos = 0, size_type n = npos)
+    {
+        const size_type sz = size();
+        if (pos > sz)
+        {
+            THROW_OUT_OF_RANGE("string::erase");
+        }
+        if (n > sz - pos) n = sz - pos;
+        char* p = data();
+        memmove(p + pos, p + pos + n, sz - pos - n);
+        _set_size(sz - n);
+        return *this;
+    }
+
+    void swap(string& s) noexcept
+    {
+        char tmp[_bytes];
+        memcpy(tmp, static_cast<void*>(this), _bytes);
+        memcpy(static_cast<void*>(this), &s, _bytes);
+        memcpy(static_cast<void*>(&s), tmp, _bytes);
+    }
+
+    // ********************************************************************************
+    // 子串、比较和查找，都转发给 string_view
+    // ********************************************************************************
+
+    string substr(size_type pos = 0, size_type n = npos) const
+    {
+        return string(string_view(*this).substr(pos, n));
+    }
+    int compare(string_view v) const noexcept
+    {
+        return string_view(*this).compare(v);
+    }
+    bool starts_with(string_view v) const noexcept
+    {
+        return string_view(*this).starts_with(v);
+    }
+    bool ends_with(string_view v) const noexcept
+    {
+        return string_view(*this).ends_with(v);
+    }
+    size_type find(char c, size_type pos = 0) const noexcept
+    {
+        return string_view(*this).find(c, pos);
+    }
+    size_type find(string_view v, size_type pos = 0) const noexcept
+    {
+        return string_view(*this).find(v, pos);
+    }
+    size_type rfind(char c, size_type pos = npos) const noexcept
+    {
+        return string_view(*this).rfind(c, pos);
+    }
+    size_type find_first_of(string_view set, size_type pos = 0) const noexcept
+    {
+        return string_view(*this).find_first_of(set, pos);
+    }
+    bool contains(string_view v) const noexcept
+    {
+        return string_view(*this).contains(v);
+    }
+
+private:
+    // helper functions
+
+    bool _is_long() const noexcept
+    {
+        return (static_cast<unsigned char>(_small[_bytes - 1]) & 0x80) != 0;
+    }
+
+    size_type _small_size() const noexcept
+    {
+        return small_capacity - static_cast<unsigned char>(_small[_bytes - 1]);
+    }
+
+    // 容量与标记合成一个字，使标记落在对象的最后一个字节
+    static size_type _encode_capacity(size_type cap) noexcept
+    {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        return (cap << 8) | 0x80;
+#else
+        return cap | (size_type(0x80) << _flag_shift);
+#endif
+    }
+    size_type _long_capacity() const noexcept
+    {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        return _long.cap_word >> 8;
+#else
+        return _long.cap_word & ~(size_type(0xff) << _flag_shift);
+#endif
+    }
+
+    // 长度为 n 的短字符串：第 n 个字节为 '\0'，最后一个字节为剩余容量
+    // n 为 small_capacity 时两者是同一个字节
+    void _set_small_size(size_type n) noexcept
+    {
+        _small[n] = '\0';
+        _small[_bytes - 1] = static_cast<char>(small_capacity - n);
+    }
+    void _set_size(size_type n) noexcept
+    {
+        if (_is_long())
+        {
+            _long.size = n;
+            _long.ptr[n] = '\0';
+        }
+        else
+        {
+            _set_small_size(n);
+        }
+    }
+
+    // 构造一个长度为 n、内容未初始化的字符串
+    void _init_uninitialized(size_type n)
+    {
+        if (n <= small_capacity)
+        {
+            _set_small_size(n);
+            return;
+        }
+        if (n > max_size())
+        {
+            THROW_LENGTH_ERROR("string is too large");
+        }
+        _long.ptr = allocator_type::allocate(n + 1);
+        _long.cap_word = _encode_capacity(n);
+        _long.size = n;
+        _long.ptr[n] = '\0';
+    }
+    void _init(const char* s, size_type n)
+    {
+        _init_uninitialized(n);
+        if (n != 0) memcpy(data(), s, n);
+    }
+
+    void _release() noexcept
+    {
+        if (_is_long())
+        {
+            allocator_type::deallocate(_long.ptr, _long_capacity() + 1);
+        }
+    }
+
+    // 与 vector 相同：至少翻倍
+    size_type _recommend_capacity(size_type n) const
+    {
+        const size_type ms = max_size();
+        if (n > ms)
+        {
+            THROW_LENGTH_ERROR("string is too large");
+        }
+        const size_type cap = capacity();
+        if (cap >= ms / 2) return ms;
+        return xutl::max<size_type>(2 * cap, n);
+    }
+
+    void _reserve_for(size_type n)
+    {
+        if (n > capacity()) _reallocate(_recommend_capacity(n));
+    }
+
+    // 把容量改为 cap（cap 不小于 size()），保留原有字符
+    void _reallocate(size_type cap)
+    {
+        if (cap > max_size())
+        {
+            THROW_LENGTH_ERROR("string is too large");
+        }
+        const size_type sz = size();
+        char* p = allocator_type::allocate(cap + 1);
+        memcpy(p, data(), sz + 1);
+        _release();
+        _long.ptr = p;
+        _long.size = sz;
+        _long.cap_word = _encode_capacity(cap);
+    }
+
+    // 扩容并追加，s 可能指向自身，因此先复制再释放原来的空间
+    void _grow_and_append(const char* s, size_type n)
+    {
+        const size_type sz = size();
+        if (n > max_size() - sz)
+        {
+            THROW_LENGTH_ERROR("string is too large");
+        }
+        const size_type cap = _recommend_capacity(sz + n);
+        char* p = allocator_type::allocate(cap + 1);
+        memcpy(p, data(), sz);
+        memcpy(p + sz, s, n);
+        p[sz + n] = '\0';
+        _release();
+        _long.ptr = p;
+        _long.size = sz + n;
+        _long.cap_word = _encode_capacity(cap);
+    }
+
+    // 扩容并在 pos 处插入，s 可能指向自身，同样先复制再释放原来的空间
+    void _grow_and_insert(size_type pos, const char* s, size_type n)
+    {
+        const size_type sz = size();
+        if (n > max_size() - sz)
+        {
+            THROW_LENGTH_ERROR("string is too large");
+        }
+        const size_type cap = _recommend_capacity(sz + n);
+        char* p = allocator_type::allocate(cap + 1);
+        const char* old = data();
+        memcpy(p, old, pos);
+        memcpy(p + pos, s, n);
+        memcpy(p + pos + n, old + pos, sz - pos + 1);
+        _release();
+        _long.ptr = p;
+        _long.size = sz + n;
+        _long.cap_word = _encode_capacity(cap);
+    }
+};
+
+constexpr string::size_type string::npos;
+constexpr string::size_type string::small_capacity;
+
+static_assert(sizeof(string) == 3 * sizeof(void*),
+              "string 的大小必须是 3 个指针");
+
+// 对象中不保存指向自身的指针，可以按字节搬移
+template <>
+struct is_trivially_relocatable<string> : public true_type {};
+
+inline string operator+(const string& lhs, string_view rhs)
+{
+    string result;
+    result.reserve(lhs.size() + rhs.size());
+    result.append(lhs.data(), lhs.size());
+    result.append(rhs);
+    return result;
+}
+inline string operator+(string&& lhs, string_view rhs)
+{
+    lhs.append(rhs);
+    return xutl::move(lhs);
+}
+
+inline void swap(string& lhs, string& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+}  // namespace xutl
+
+namespace std
+{
+
+template <>
+struct hash<xutl::string>
+{
+    size_t operator()(const xutl::string& s) const noexcept
+    {
+        return xutl::_hash_bytes(s.data(), s.size());
+    }
+};
+
+}  // namespace std
+
+#endif  // XUTL_XSTRING_H_
@@ -0,0 +1,321 @@
+#ifndef XUTL_BENCH_BENCH_H_
+#define XUTL_BENCH_BENCH_H_
+
+/**
+ * 该文件包含一个不依赖第三方库的简单性能测试框架
+ * 每个测试先预热若干次，再重复运行多次，报告每次运行耗时的中位数和 p99，
+ * 以及每个元素的纳秒数和周期数（x86 上用 rdtsc 计数），结果可以输出为 JSON，
+ * 便于在升级前后对比，发现性能退化
+ *
+ * 命令行参数：
+ *   --runs N      重复运行的次数，默认 21
+ *   --warmup N    预热的次数，默认 3
+ *   --size N      测试规模（元素个数），由各个测试自行解释，默认 1048576
+ *   --filter STR  只运行名称中包含 STR 的测试
+ *   --json FILE   把结果以 JSON 格式写入 FILE，FILE 为 - 时写到标准输出
+ *
+ * 测量框架本身只使用 std::，不依赖被测的 xutl 代码
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace bench
+{
+
+// 读取周期计数器；没有可用的计数器时返回 0
+inline uint64_t cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+inline bool has_cycle_counter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+// 阻止编译器把 value 的计算当作无用代码删除
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// 阻止编译器跨过这一点重排或省略内存读写
+inline void clobber_memory()
+{
+    asm volatile("" : : : "memory");
+}
+
+// 一个测试的统计结果
+struct result
+{
+    std::string name;
+    uint64_t elements;
+    double median_ns;
+    double p99_ns;
+    double min_ns;
+    double median_cycles;
+};
+
+struct options
+{
+    int runs = 21;
+    int warmup = 3;
+    uint64_t size = 1 << 20;
+    std::string filter;
+    std::string json_path;
+};
+
+class runner
+{
+public:
+    // defaults 为该测试程序自己的默认参数，命令行参数会覆盖它们
+    runner(int argc, char* argv[], const options& defaults = options()) :
+            _options(defaults)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char* arg = argv[i];
+            const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+            if (value == nullptr)
+            {
+                _usage(argv[0]);
+            }
+            else if (strcmp(arg, "--runs") == 0)
+            {
+                _options.runs = std::max(1, atoi(value));
+            }
+            else if (strcmp(arg, "--warmup") == 0)
+            {
+                _options.warmup = std::max(0, atoi(value));
+            }
+            else if (strcmp(arg, "--size") == 0)
+            {
+                _options.size =
+                    std::max<uint64_t>(1, strtoull(value, nullptr, 10));
+            }
+            else if (strcmp(arg, "--filter") == 0)
+            {
+                _options.filter = value;
+            }
+            else if (strcmp(arg, "--json") == 0)
+            {
+                _options.json_path = value;
+            }
+            else
+            {
+                _usage(argv[0]);
+            }
+            ++i;
+        }
+    }
+
+    const options& opts() const
+    {
+        return _options;
+    }
+
+    uint64_t size() const
+    {
+        return _options.size;
+    }
+
+    // 运行一个测试：每次运行前调用 setup() 准备状态（不计时），
+    // 然后对其调用 body(state) 并计时，state 在计时结束后才析构
+    // elements 为一次运行处理的元素个数，用于计算每个元素的开销
+    template <typename Setup, typename Body>
+    void run(const std::string& name, uint64_t elements, Setup setup,
+             Body body)
+    {
+        if (!_options.filter.empty() &&
+            name.find(_options.filter) == std::string::npos)
+        {
+            return;
+        }
+        for (int i = 0; i < _options.warmup; ++i)
+        {
+            auto state = setup();
+            body(state);
+            clobber_memory();
+        }
+        std::vector<double> ns;
+        std::vector<double> cyc;
+        ns.reserve(static_cast<size_t>(_options.runs));
+        cyc.reserve(static_cast<size_t>(_options.runs));
+        for (int i = 0; i < _options.runs; ++i)
+        {
+            auto state = setup();
+            clobber_memory();
+            const uint64_t c0 = cycles();
+            const auto t0 = std::chrono::steady_clock::now();
+            body(state);
+            clobber_memory();
+            const auto t1 = std::chrono::steady_clock::now();
+            const uint64_t c1 = cycles();
+            ns.push_back(
+                std::chrono::duration<double, std::nano>(t1 - t0).count());
+            cyc.push_back(static_cast<double>(c1 - c0));
+        }
+        result r;
+        r.name = name;
+        r.elements = elements;
+        r.median_ns = _percentile(ns, 0.5);
+        r.p99_ns = _percentile(ns, 0.99);
+        r.min_ns = *std::min_element(ns.begin(), ns.end());
+        r.median_cycles = _percentile(cyc, 0.5);
+        _print(r);
+        _results.push_back(r);
+    }
+
+    // 按需写出 JSON，返回值作为进程的退出码
+    int report() const
+    {
+        if (_options.json_path.empty()) return 0;
+        if (_options.json_path == "-") return _write_json(stdout);
+        FILE* f = fopen(_options.json_path.c_str(), "w");
+        if (f == nullptr)
+        {
+            fprintf(stderr, "cannot open %s\n", _options.json_path.c_str());
+            return 1;
+        }
+        int rc = _write_json(f);
+        fclose(f);
+        return rc;
+    }
+
+    const std::vector<result>& results() const
+    {
+        return _results;
+    }
+
+private:
+    options _options;
+    std::vector<result> _results;
+    bool _header_printed = false;
+
+    static void _usage(const char* prog)
+    {
+        fprintf(stderr,
+                "usage: %s [--runs N] [--warmup N] [--size N] "
+                "[--filter STR] [--json FILE]\n",
+                prog);
+        exit(2);
+    }
+
+    // 最近秩法求百分位数
+    static double _percentile(std::vector<double> v, double p)
+    {
+        std::sort(v.begin(), v.end());
+        size_t rank = static_cast<size_t>(std::ceil(p * v.size()));
+        if (rank == 0) rank = 1;
+        return v[rank - 1];
+    }
+
+    // 名称以 /xutl 结尾、并且已经有同名 /std 结果时，给出与 std 的耗时比
+    double _ratio_to_std(const result& r) const
+    {
+        const std::string suffix = "/xutl";
+        if (r.name.size() < suffix.size() ||
+            r.name.compare(r.name.size() - suffix.size(), suffix.size(),
+                           suffix) != 0)
+        {
+            return 0;
+        }
+        const std::string peer =
+            r.name.substr(0, r.name.size() - suffix.size()) + "/std";
+        for (const result& other : _results)
+        {
+            if (other.name == peer && other.median_ns > 0)
+            {
+                return r.median_ns / other.median_ns;
+            }
+        }
+        return 0;
+    }
+
+    void _print(const result& r)
+    {
+        // JSON 写到标准输出时，表格改写到标准错误，避免混在一起
+        FILE* out = _options.json_path == "-" ? stderr : stdout;
+        if (!_header_printed)
+        {
+            fprintf(out, "%-36s %10s %12s %12s %9s %9s %8s\n", "name",
+                    "elements", "median(ns)", "p99(ns)", "ns/elem",
+                    "cyc/elem", "vs std");
+            _header_printed = true;
+        }
+        const double per = r.elements ? static_cast<double>(r.elements) : 1;
+        fprintf(out, "%-36s %10llu %12.0f %12.0f %9.3f %9.3f",
+                r.name.c_str(), static_cast<unsigned long long>(r.elements),
+                r.median_ns, r.p99_ns, r.median_ns / per,
+                r.median_cycles / per);
+        // 先运行的 std 版本在这里还看不到对应的 xutl 版本，因此只在 xutl 一行给出比值
+        const double ratio = _ratio_to_std(r);
+        if (ratio > 0)
+        {
+            fprintf(out, " %7.2fx", ratio);
+        }
+        fprintf(out, "\n");
+        fflush(out);
+    }
+
+    static void _write_string(FILE* f, const std::string& s)
+    {
+        fputc('"', f);
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\') fputc('\\', f);
+            fputc(c, f);
+        }
+        fputc('"', f);
+    }
+
+    int _write_json(FILE* f) const
+    {
+        fprintf(f, "{\n  \"runs\": %d,\n  \"warmup\": %d,\n  \"size\": %llu,\n",
+                _options.runs, _options.warmup,
+                static_cast<unsigned long long>(_options.size));
+        fprintf(f, "  \"cycle_counter\": %s,\n  \"results\": [",
+                has_cycle_counter() ? "\"rdtsc\"" : "null");
+        for (size_t i = 0; i < _results.size(); ++i)
+        {
+            const result& r = _results[i];
+            const double per = r.elements ? static_cast<double>(r.elements) : 1;
+            fprintf(f, "%s\n    {\"name\": ", i == 0 ? "" : ",");
+            _write_string(f, r.name);
+            fprintf(f,
+                    ", \"elements\": %llu, \"median_ns\": %.1f, "
+                    "\"p99_ns\": %.1f, \"min_ns\": %.1f, "
+                    "\"ns_per_element\": %.4f, \"cycles_per_element\": %.4f}",
+                    static_cast<unsigned long long>(r.elements), r.median_ns,
+                    r.p99_ns, r.min_ns, r.median_ns / per,
+                    r.median_cycles / per);
+        }
+        fprintf(f, "\n  ]\n}\n");
+        return ferror(f) ? 1 : 0;
+    }
+};
+
+}  // namespace bench
+
+#endif  // XUTL_BENCH_BENCH_H_
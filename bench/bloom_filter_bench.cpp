@@ -0,0 +1,135 @@
+// bloom_filter 的查询吞吐量和实测误判率
+// 用法：bloom_filter_bench [--runs N] [--warmup N] [--size N] [--filter STR]
+//                          [--json FILE]
+// 插入 --size 个（默认 2^22）键，误判率为 1%，再查询同样多个不存在的键：
+//   bloom/contains          逐个查询，std 为在 std::unordered_set 中查找，
+//                           即布隆过滤器要替代的那次哈希表访问
+//   bloom/contains_scalar   关闭 SIMD 后逐个查询
+//   bloom/contains_batch    用 contains(span) 批量查询，提前预取块
+// 最后打印不同误判率下的块参数和实测误判率
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <unordered_set>
+
+#include "bench.h"
+#include "bloom_filter.h"
+#include "vector.h"
+
+namespace
+{
+
+using key_vector = xutl::vector<uint64_t>;
+using filter = xutl::bloom_filter<uint64_t>;
+
+// 键是打散后的整数，插入的键和查询的键不相交
+uint64_t key_at(uint64_t i)
+{
+    return (i + 1) * 0x9e3779b97f4a7c15ULL;
+}
+
+key_vector make_keys(uint64_t first, uint64_t n)
+{
+    key_vector keys;
+    keys.reserve(n);
+    for (uint64_t i = first; i < first + n; ++i)
+    {
+        keys.push_back(key_at(i));
+    }
+    return keys;
+}
+
+uint64_t count_hits(const filter& f, const key_vector& probes)
+{
+    uint64_t hits = 0;
+    for (uint64_t k : probes)
+    {
+        hits += f.contains(k);
+    }
+    return hits;
+}
+
+void bench_contains(bench::runner& r, const key_vector& keys,
+                    const key_vector& probes)
+{
+    const uint64_t n = probes.size();
+
+    std::unordered_set<uint64_t> set(keys.begin(), keys.end());
+    const std::unordered_set<uint64_t>* ps = &set;
+    r.run(
+        "bloom/contains/std", n, [ps]() { return ps; },
+        [&probes](const std::unordered_set<uint64_t>* s) {
+            uint64_t hits = 0;
+            for (uint64_t k : probes)
+            {
+                hits += s->count(k);
+            }
+            bench::do_not_optimize(hits);
+        });
+
+    filter f(keys.size(), 0.01);
+    for (uint64_t k : keys)
+    {
+        f.insert(k);
+    }
+    const filter* pf = &f;
+    r.run(
+        "bloom/contains/xutl", n, [pf]() { return pf; },
+        [&probes](const filter* p) {
+            bench::do_not_optimize(count_hits(*p, probes));
+        });
+
+    xutl::set_simd_enabled(false);
+    r.run(
+        "bloom/contains_scalar/xutl", n, [pf]() { return pf; },
+        [&probes](const filter* p) {
+            bench::do_not_optimize(count_hits(*p, probes));
+        });
+    xutl::set_simd_enabled(true);
+
+    std::unique_ptr<bool[]> result(new bool[n]);
+    bool* out = result.get();
+    r.run(
+        "bloom/contains_batch/xutl", n, [pf]() { return pf; },
+        [&probes, out](const filter* p) {
+            xutl::span<const uint64_t> s(probes.data(), probes.size());
+            bench::do_not_optimize(p->contains(s, out));
+        });
+}
+
+void print_fpr(const key_vector& keys, const key_vector& probes)
+{
+    printf("\n%-10s %4s %12s %14s %14s\n", "target", "k", "bits/key",
+           "expected fpr", "measured fpr");
+    const double targets[] = {0.1, 0.01, 0.001, 0.0001};
+    for (double target : targets)
+    {
+        filter f(keys.size(), target);
+        for (uint64_t k : keys)
+        {
+            f.insert(k);
+        }
+        const double measured = static_cast<double>(count_hits(f, probes)) /
+                                static_cast<double>(probes.size());
+        printf("%-10g %4zu %12.2f %14.6f %14.6f\n", target, f.hash_count(),
+               static_cast<double>(f.bit_count()) / keys.size(),
+               f.expected_fpr(), measured);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    bench::options defaults;
+    defaults.size = uint64_t(1) << 22;
+    bench::runner r(argc, argv, defaults);
+    const key_vector keys = make_keys(0, r.size());
+    const key_vector probes = make_keys(r.size(), r.size());
+
+    bench_contains(r, keys, probes);
+    print_fpr(keys, probes);
+
+    return r.report();
+}
@@ -0,0 +1,155 @@
+// concurrent_hash_map 的扩展性测试
+// 用法：concurrent_hash_map_bench [最大线程数] [键的个数] [每线程操作数]
+// 对比 xutl::concurrent_hash_map 与「std::unordered_map + 全局锁」，
+// 线程数从 1 增加到最大线程数，分别测试读多写少（95% 读）和写多（50% 读）两种负载
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "concurrent_hash_map.h"
+#include "vector.h"
+
+namespace
+{
+
+// 每个线程独立的随机数生成器
+struct xorshift
+{
+    uint64_t state;
+
+    explicit xorshift(uint64_t seed) : state(seed * 0x9e3779b97f4a7c15ULL + 1)
+    {
+    }
+    uint64_t operator()()
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+// 全局锁保护的 std::unordered_map，即被替换的方案
+class locked_map
+{
+public:
+    explicit locked_map(size_t n)
+    {
+        _map.reserve(n);
+    }
+    void insert_or_assign(uint64_t key, uint64_t value)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _map[key] = value;
+    }
+    bool find(uint64_t key, uint64_t& value)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        auto it = _map.find(key);
+        if (it == _map.end()) return false;
+        value = it->second;
+        return true;
+    }
+
+private:
+    std::mutex _lock;
+    std::unordered_map<uint64_t, uint64_t> _map;
+};
+
+// threads 个线程各执行 ops 次操作，其中 read_percent% 为查找，返回总吞吐量（Mops/s）
+template <typename Map>
+double run(Map& map, int threads, uint64_t keys, uint64_t ops,
+           unsigned read_percent)
+{
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<uint64_t> sink(0);
+    xutl::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]() {
+            xorshift rng(t + 1);
+            uint64_t hits = 0;
+            ++ready;
+            while (!go.load())
+            {
+                std::this_thread::yield();
+            }
+            for (uint64_t i = 0; i < ops; ++i)
+            {
+                uint64_t r = rng();
+                uint64_t key = r % keys;
+                if ((r >> 40) % 100 < read_percent)
+                {
+                    uint64_t value;
+                    hits += map.find(key, value);
+                }
+                else
+                {
+                    map.insert_or_assign(key, r);
+                }
+            }
+            sink += hits;
+        });
+    }
+    while (ready.load() != threads)
+    {
+        std::this_thread::yield();
+    }
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    return threads * ops / seconds / 1e6;
+}
+
+template <typename Map>
+void prefill(Map& map, uint64_t keys)
+{
+    for (uint64_t k = 0; k < keys; k += 2)
+    {
+        map.insert_or_assign(k, k);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    unsigned hw = std::thread::hardware_concurrency();
+    int max_threads = argc > 1 ? atoi(argv[1]) : (hw > 0 ? hw : 4);
+    uint64_t keys = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1 << 20;
+    uint64_t ops = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1000000;
+
+    const unsigned mixes[] = {95, 50};
+    printf("%-8s %-8s %14s %14s\n", "read%", "threads", "xutl Mops/s",
+           "locked Mops/s");
+    for (unsigned mix : mixes)
+    {
+        for (int threads = 1; threads <= max_threads; threads *= 2)
+        {
+            xutl::concurrent_hash_map<uint64_t, uint64_t> cmap(keys, 256);
+            locked_map lmap(keys);
+            prefill(cmap, keys);
+            prefill(lmap, keys);
+            double x = run(cmap, threads, keys, ops, mix);
+            double l = run(lmap, threads, keys, ops, mix);
+            printf("%-8u %-8d %14.2f %14.2f\n", mix, threads, x, l);
+            if (threads < max_threads && threads * 2 > max_threads)
+            {
+                threads = max_threads / 2;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+// 大块分配模式的性能测试：对一个很大的 vector<uint64_t> 做顺序和随机访问
+// 用法：large_alloc_bench [--runs N] [--warmup N] [--size N] [--filter STR]
+//                         [--json FILE]
+// --size 为元素个数，向下取整为 2 的幂，默认 2^27（1GB）；4GB 对应 --size 536870912
+// 每种模式各分配一次数组：
+//   4k               不开启大块分配，由 ::operator new 分配普通页
+//   mmap_4k          开启大块分配但不请求大页
+//   huge             MADV_HUGEPAGE
+//   huge_local       MADV_HUGEPAGE，并绑定到当前线程所在的 NUMA 节点
+//   huge_interleave  MADV_HUGEPAGE，并在所有 NUMA 节点间交错
+// 顺序访问对整个数组求和；随机访问沿着依赖链读取，每次的下标取决于上一次读到的值，
+// 因此测到的是访存延迟（主要是 TLB 缺失和缓存缺失）
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "bench.h"
+#include "large_alloc.h"
+#include "vector.h"
+
+namespace
+{
+
+struct mode
+{
+    const char* name;
+    bool enabled;
+    bool huge_pages;
+    xutl::numa_policy numa;
+};
+
+// 当前进程中透明大页的总大小（kB），读不到时返回 -1
+long anon_huge_kb()
+{
+    FILE* f = fopen("/proc/self/smaps_rollup", "r");
+    if (f == nullptr) return -1;
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), f) != nullptr)
+    {
+        if (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) break;
+    }
+    fclose(f);
+    return kb;
+}
+
+using array = xutl::vector<uint64_t>;
+
+void bench_mode(bench::runner& r, const mode& m, uint64_t n)
+{
+    const std::string suffix = std::string("/") + m.name;
+    if (!r.opts().filter.empty() &&
+        ("large/seq" + suffix).find(r.opts().filter) == std::string::npos &&
+        ("large/random" + suffix).find(r.opts().filter) == std::string::npos)
+    {
+        return;
+    }
+
+    xutl::large_alloc_policy policy;
+    policy.enabled = m.enabled;
+    policy.huge_pages = m.huge_pages;
+    policy.numa = m.numa;
+    xutl::set_large_alloc_policy(policy);
+
+    const long huge_before = anon_huge_kb();
+    array v(n);
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        v[i] = i;
+    }
+    fprintf(stderr, "%s: AnonHugePages +%ld kB\n", m.name,
+            anon_huge_kb() - huge_before);
+
+    array* p = &v;
+    auto setup = [p]() { return p; };
+
+    r.run("large/seq" + suffix, n, setup, [n](array* a) {
+        const uint64_t* d = a->data();
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            sum += d[i];
+        }
+        bench::do_not_optimize(sum);
+    });
+
+    // v[i] == i，下一个下标由读到的值经过满周期的线性同余变换得到
+    const uint64_t steps = n / 64;
+    const uint64_t mask = n - 1;
+    r.run("large/random" + suffix, steps, setup, [steps, mask](array* a) {
+        const uint64_t* d = a->data();
+        uint64_t idx = 0;
+        for (uint64_t i = 0; i < steps; ++i)
+        {
+            idx = (d[idx] * 6364136223846793005ull + 1442695040888963407ull) &
+                  mask;
+        }
+        bench::do_not_optimize(idx);
+    });
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    bench::options defaults;
+    defaults.size = uint64_t(1) << 27;
+    defaults.runs = 5;
+    defaults.warmup = 1;
+    bench::runner r(argc, argv, defaults);
+
+    uint64_t n = 1;
+    while (n * 2 <= r.size())
+    {
+        n *= 2;
+    }
+
+    const mode modes[] = {
+        {"4k", false, false, xutl::numa_policy::none},
+        {"mmap_4k", true, false, xutl::numa_policy::none},
+        {"huge", true, true, xutl::numa_policy::none},
+        {"huge_local", true, true, xutl::numa_policy::local},
+        {"huge_interleave", true, true, xutl::numa_policy::interleave},
+    };
+    for (const mode& m : modes)
+    {
+        bench_mode(r, m, n);
+    }
+    xutl::set_large_alloc_policy(xutl::large_alloc_policy());
+
+    return r.report();
+}
@@ -0,0 +1,124 @@
+// lru_cache 与 list 加 std::unordered_map 手写的 LRU 对比
+// 用法：lru_cache_bench [--runs N] [--warmup N] [--size N] [--filter STR]
+//                       [--json FILE]
+// 缓存容量为 2^16 个条目，依次访问 --size 个（默认 2^20）偏斜分布的键，
+// 命中时读取值，未命中时插入：
+//   cache/get_put        std 为手写的 LRU，xutl 为 LRU 策略的 lru_cache
+//   cache/get_put_clock  CLOCK 策略的 lru_cache
+
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <utility>
+
+#include "bench.h"
+#include "list.h"
+#include "lru_cache.h"
+#include "vector.h"
+
+namespace
+{
+
+const size_t cache_capacity = size_t(1) << 16;
+
+using key_vector = xutl::vector<uint64_t>;
+
+// 两个均匀随机数的乘积落在较小的值上的概率更高，约 90% 的访问命中
+key_vector make_keys(uint64_t n)
+{
+    key_vector keys;
+    keys.reserve(n);
+    std::mt19937_64 rng(5);
+    const uint64_t range = 1024;
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        keys.push_back((rng() % range) * (rng() % range));
+    }
+    return keys;
+}
+
+// 被替换的方案：list 保存访问顺序，unordered_map 保存键到节点的映射，
+// 每个条目各分配一次
+class hand_rolled_lru
+{
+public:
+    uint64_t* get(uint64_t key)
+    {
+        auto it = _index.find(key);
+        if (it == _index.end()) return nullptr;
+        _order.splice(_order.begin(), _order, it->second);
+        return &it->second->second;
+    }
+    void put(uint64_t key, uint64_t value)
+    {
+        if (_order.size() == cache_capacity)
+        {
+            _index.erase(_order.back().first);
+            _order.pop_back();
+        }
+        _order.push_front(std::make_pair(key, value));
+        _index[key] = _order.begin();
+    }
+
+private:
+    using entry_list = xutl::list<std::pair<uint64_t, uint64_t>>;
+    entry_list _order;
+    std::unordered_map<uint64_t, entry_list::iterator> _index;
+};
+
+template <typename Cache>
+uint64_t run_keys(Cache& c, const key_vector& keys)
+{
+    uint64_t sum = 0;
+    for (uint64_t k : keys)
+    {
+        if (uint64_t* v = c.get(k))
+        {
+            sum += *v;
+        }
+        else
+        {
+            c.put(k, k);
+        }
+    }
+    return sum;
+}
+
+using xutl_cache = xutl::lru_cache<uint64_t, uint64_t>;
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    bench::options defaults;
+    defaults.size = uint64_t(1) << 20;
+    bench::runner r(argc, argv, defaults);
+    const key_vector keys = make_keys(r.size());
+    const uint64_t n = keys.size();
+
+    r.run(
+        "cache/get_put/std", n,
+        []() { return xutl::unique_ptr<hand_rolled_lru>(new hand_rolled_lru); },
+        [&keys](xutl::unique_ptr<hand_rolled_lru>& c) {
+            bench::do_not_optimize(run_keys(*c, keys));
+        });
+    r.run(
+        "cache/get_put/xutl", n,
+        []() {
+            return xutl::unique_ptr<xutl_cache>(new xutl_cache(cache_capacity));
+        },
+        [&keys](xutl::unique_ptr<xutl_cache>& c) {
+            bench::do_not_optimize(run_keys(*c, keys));
+        });
+    r.run(
+        "cache/get_put_clock/xutl", n,
+        []() {
+            return xutl::unique_ptr<xutl_cache>(
+                new xutl_cache(cache_capacity, xutl::cache_policy::clock));
+        },
+        [&keys](xutl::unique_ptr<xutl_cache>& c) {
+            bench::do_not_optimize(run_keys(*c, keys));
+        });
+
+    return r.report();
+}
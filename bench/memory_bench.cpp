@@ -0,0 +1,178 @@
+// 智能指针的性能测试
+// 用法：memory_bench [迭代次数]
+// 1. 分配次数：make_shared 与 shared_ptr(new T) 各自需要几次 operator new
+// 2. 引用计数：拷贝并析构 shared_ptr 的开销，以及非原子计数的 local_shared_ptr、
+//    intrusive_ptr 与原子计数的 shared_ptr 的对比（单线程）
+// 3. vector<unique_ptr<T>> 扩容：xutl 按字节搬移，std 逐个移动并析构
+// 每一项都与 std:: 的对应实现对比
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "memory.h"
+#include "vector.h"
+
+namespace
+{
+
+// 统计全局 operator new 的调用次数
+uint64_t g_allocations = 0;
+
+struct payload
+{
+    uint64_t a = 0;
+    uint64_t b = 0;
+};
+
+struct intrusive_payload : xutl::intrusive_ref_counter<intrusive_payload>
+{
+    uint64_t a = 0;
+    uint64_t b = 0;
+};
+
+struct atomic_intrusive_payload
+    : xutl::intrusive_ref_counter<atomic_intrusive_payload,
+                                  xutl::thread_safe_counter>
+{
+    uint64_t a = 0;
+    uint64_t b = 0;
+};
+
+template <typename F>
+double seconds_of(F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+// 每个对象创建时调用 operator new 的平均次数
+template <typename F>
+double allocations_per_object(F make, int n)
+{
+    uint64_t before = g_allocations;
+    for (int i = 0; i < n; ++i)
+    {
+        make();
+    }
+    return static_cast<double>(g_allocations - before) / n;
+}
+
+// 反复拷贝并析构，返回每次拷贝+析构的纳秒数
+template <typename Ptr>
+double copy_destroy_ns(const Ptr& p, uint64_t iterations)
+{
+    uint64_t sink = 0;
+    double s = seconds_of([&]() {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            Ptr copy(p);
+            sink += reinterpret_cast<uintptr_t>(copy.get()) & 1;
+            asm volatile("" : : "r"(sink) : "memory");
+        }
+    });
+    return s * 1e9 / iterations;
+}
+
+// 一个一个 push_back 直到 n 个元素，返回耗时（毫秒）
+template <typename Vector, typename Make>
+double push_back_ms(uint64_t n, Make make)
+{
+    return seconds_of([&]() {
+               Vector v;
+               for (uint64_t i = 0; i < n; ++i)
+               {
+                   v.push_back(make());
+               }
+           }) *
+           1e3;
+}
+
+}  // namespace
+
+void* operator new(size_t n)
+{
+    ++g_allocations;
+    void* p = malloc(n == 0 ? 1 : n);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+int main(int argc, char* argv[])
+{
+    uint64_t iterations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+
+    printf("allocations per object\n");
+    printf("  xutl::make_shared        %.2f\n",
+           allocations_per_object([]() { xutl::make_shared<payload>(); }, 1000));
+    printf("  std::make_shared         %.2f\n",
+           allocations_per_object([]() { std::make_shared<payload>(); }, 1000));
+    printf("  xutl::shared_ptr(new T)  %.2f\n",
+           allocations_per_object(
+               []() { xutl::shared_ptr<payload>(new payload); }, 1000));
+    printf("  std::shared_ptr(new T)   %.2f\n",
+           allocations_per_object(
+               []() { std::shared_ptr<payload>(new payload); }, 1000));
+    printf("  xutl::make_local_shared  %.2f\n",
+           allocations_per_object(
+               []() { xutl::make_local_shared<payload>(); }, 1000));
+    printf("  xutl::make_intrusive     %.2f\n",
+           allocations_per_object(
+               []() { xutl::make_intrusive<intrusive_payload>(); }, 1000));
+
+    printf("object size (bytes)\n");
+    printf("  xutl::unique_ptr<T>      %zu\n", sizeof(xutl::unique_ptr<payload>));
+    printf("  std::unique_ptr<T>       %zu\n", sizeof(std::unique_ptr<payload>));
+    printf("  xutl::shared_ptr<T>      %zu\n", sizeof(xutl::shared_ptr<payload>));
+    printf("  std::shared_ptr<T>       %zu\n", sizeof(std::shared_ptr<payload>));
+    printf("  xutl::local_shared_ptr<T> %zu\n",
+           sizeof(xutl::local_shared_ptr<payload>));
+    printf("  xutl::intrusive_ptr<T>   %zu\n",
+           sizeof(xutl::intrusive_ptr<intrusive_payload>));
+
+    // libstdc++ 在单线程程序中使用非原子的引用计数，先创建一个线程，
+    // 使两者都在多线程程序的条件下比较
+    std::thread([]() {}).join();
+    printf("copy + destroy (ns)\n");
+    xutl::shared_ptr<payload> xp = xutl::make_shared<payload>();
+    std::shared_ptr<payload> sp = std::make_shared<payload>();
+    printf("  xutl::shared_ptr         %.2f\n", copy_destroy_ns(xp, iterations));
+    printf("  std::shared_ptr          %.2f\n", copy_destroy_ns(sp, iterations));
+    xutl::local_shared_ptr<payload> lp = xutl::make_local_shared<payload>();
+    xutl::intrusive_ptr<intrusive_payload> ip =
+        xutl::make_intrusive<intrusive_payload>();
+    xutl::intrusive_ptr<atomic_intrusive_payload> aip =
+        xutl::make_intrusive<atomic_intrusive_payload>();
+    printf("  xutl::local_shared_ptr   %.2f\n", copy_destroy_ns(lp, iterations));
+    printf("  xutl::intrusive_ptr      %.2f\n", copy_destroy_ns(ip, iterations));
+    printf("  xutl::intrusive_ptr (atomic counter) %.2f\n",
+           copy_destroy_ns(aip, iterations));
+
+    const uint64_t n = iterations / 10;
+    printf("push_back %llu unique_ptr (ms)\n",
+           static_cast<unsigned long long>(n));
+    printf("  xutl::vector<xutl::unique_ptr>  %.2f\n",
+           push_back_ms<xutl::vector<xutl::unique_ptr<payload>>>(
+               n, []() { return xutl::unique_ptr<payload>(); }));
+    printf("  std::vector<std::unique_ptr>    %.2f\n",
+           push_back_ms<std::vector<std::unique_ptr<payload>>>(
+               n, []() { return std::unique_ptr<payload>(); }));
+    return 0;
+}
@@ -0,0 +1,156 @@
+// skip_list 与 std::map 的对比
+// 用法：skip_list_bench [--runs N] [--warmup N] [--size N] [--filter STR]
+//                       [--json FILE]
+// 键是 --size 个（默认 2^18）打乱顺序的 64 位整数：
+//   ordered/insert          单线程依次插入所有键
+//   ordered/find            单线程依次查找所有键
+//   ordered/insert_threads  4 个线程各插入四分之一的键，std 为全局锁保护的
+//                           std::map，xutl 为 concurrent_skip_list
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+
+#include "bench.h"
+#include "skip_list.h"
+#include "vector.h"
+
+namespace
+{
+
+const int thread_count = 4;
+
+using key_vector = xutl::vector<uint64_t>;
+
+// std::shuffle 会通过 ADL 找到 xutl::swap 而产生歧义，这里自己打乱
+key_vector make_keys(uint64_t n)
+{
+    key_vector keys;
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        keys.push_back(i * 2654435761u);
+    }
+    std::mt19937_64 rng(42);
+    for (size_t i = keys.size(); i > 1; --i)
+    {
+        std::swap(keys[i - 1], keys[rng() % i]);
+    }
+    return keys;
+}
+
+template <typename Map>
+struct filled
+{
+    key_vector keys;
+    Map map;
+};
+
+template <typename Map>
+void bench_single(bench::runner& r, const key_vector& keys,
+                  const std::string& impl)
+{
+    const uint64_t n = keys.size();
+    r.run(
+        "ordered/insert/" + impl, n, []() { return Map(); },
+        [&keys](Map& m) {
+            for (uint64_t k : keys)
+            {
+                m.insert(std::make_pair(k, k));
+            }
+            bench::do_not_optimize(m.size());
+        });
+    r.run(
+        "ordered/find/" + impl, n,
+        [&keys]() {
+            filled<Map> f;
+            f.keys = keys;
+            for (uint64_t k : keys)
+            {
+                f.map.insert(std::make_pair(k, k));
+            }
+            return f;
+        },
+        [](filled<Map>& f) {
+            uint64_t sum = 0;
+            for (uint64_t k : f.keys)
+            {
+                sum += f.map.find(k)->second;
+            }
+            bench::do_not_optimize(sum);
+        });
+}
+
+// 全局锁保护的 std::map，即被替换的方案
+class locked_map
+{
+public:
+    void insert(uint64_t key, uint64_t value)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _map.insert(std::make_pair(key, value));
+    }
+    size_t size() const
+    {
+        return _map.size();
+    }
+
+private:
+    std::mutex _lock;
+    std::map<uint64_t, uint64_t> _map;
+};
+
+// thread_count 个线程各插入 keys 中的一段
+template <typename Map>
+void insert_parallel(Map& m, const key_vector& keys)
+{
+    xutl::vector<std::thread> workers;
+    const size_t per_thread = keys.size() / thread_count;
+    for (int t = 0; t < thread_count; ++t)
+    {
+        workers.emplace_back([&m, &keys, t, per_thread]() {
+            const size_t first = t * per_thread;
+            for (size_t i = first; i < first + per_thread; ++i)
+            {
+                m.insert(keys[i], keys[i]);
+            }
+        });
+    }
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+}
+
+template <typename Map>
+void bench_threads(bench::runner& r, const key_vector& keys,
+                   const std::string& impl)
+{
+    r.run(
+        "ordered/insert_threads/" + impl, keys.size(),
+        []() { return xutl::unique_ptr<Map>(new Map()); },
+        [&keys](xutl::unique_ptr<Map>& m) {
+            insert_parallel(*m, keys);
+            bench::do_not_optimize(m->size());
+        });
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    bench::options defaults;
+    defaults.size = uint64_t(1) << 18;
+    bench::runner r(argc, argv, defaults);
+    const key_vector keys = make_keys(r.size());
+
+    bench_single<std::map<uint64_t, uint64_t>>(r, keys, "std");
+    bench_single<xutl::skip_list<uint64_t, uint64_t>>(r, keys, "xutl");
+    bench_threads<locked_map>(r, keys, "std");
+    bench_threads<xutl::concurrent_skip_list<uint64_t, uint64_t>>(r, keys,
+                                                                   "xutl");
+
+    return r.report();
+}
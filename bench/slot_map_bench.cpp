@@ -0,0 +1,150 @@
+// slot_map 与 list 保存实体时的性能对比
+// 用法：slot_map_bench [--runs N] [--warmup N] [--size N] [--filter STR]
+//                      [--json FILE]
+// 实体是 32 字节的结构体。两种容器都先插入 --size 个实体，再随机删除一半、
+// 重新插入一半，模拟运行一段时间后的状态：
+//   entity/iterate      遍历所有实体并累加一个字段
+//   entity/erase_random 按随机顺序通过句柄（list 为迭代器）删除所有实体
+
+#include <cstdint>
+#include <random>
+#include <utility>
+
+#include "bench.h"
+#include "list.h"
+#include "slot_map.h"
+#include "vector.h"
+
+namespace
+{
+
+struct entity
+{
+    float x, y, z;
+    float vx, vy, vz;
+    int hp;
+    int id;
+};
+
+entity make_entity(uint64_t i)
+{
+    entity e = {};
+    e.hp = static_cast<int>(i % 100);
+    e.id = static_cast<int>(i);
+    return e;
+}
+
+using entity_list = xutl::list<entity>;
+using entity_map = xutl::slot_map<entity>;
+
+struct list_state
+{
+    entity_list entities;
+    xutl::vector<entity_list::iterator> handles;
+};
+
+struct map_state
+{
+    entity_map entities;
+    xutl::vector<xutl::slot_map_handle> handles;
+};
+
+// std::shuffle 会通过 ADL 找到 xutl::swap 而产生歧义，这里自己打乱
+template <typename Vector>
+void shuffle(Vector& v, std::mt19937_64& rng)
+{
+    for (size_t i = v.size(); i > 1; --i)
+    {
+        std::swap(v[i - 1], v[rng() % i]);
+    }
+}
+
+// 插入 n 个实体，随机删除一半再插入一半，最后把句柄打乱
+template <typename State, typename Insert, typename Erase>
+State build(uint64_t n, Insert insert, Erase erase)
+{
+    State s;
+    std::mt19937_64 rng(42);
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        s.handles.push_back(insert(s, i));
+    }
+    shuffle(s.handles, rng);
+    for (uint64_t i = 0; i < n / 2; ++i)
+    {
+        erase(s, s.handles[i]);
+        s.handles[i] = insert(s, n + i);
+    }
+    shuffle(s.handles, rng);
+    return s;
+}
+
+list_state build_list(uint64_t n)
+{
+    return build<list_state>(
+        n,
+        [](list_state& s, uint64_t i) {
+            return s.entities.insert(s.entities.end(), make_entity(i));
+        },
+        [](list_state& s, entity_list::iterator it) { s.entities.erase(it); });
+}
+
+map_state build_map(uint64_t n)
+{
+    return build<map_state>(
+        n,
+        [](map_state& s, uint64_t i) {
+            return s.entities.insert(make_entity(i));
+        },
+        [](map_state& s, xutl::slot_map_handle h) { s.entities.erase(h); });
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    bench::runner r(argc, argv);
+    const uint64_t n = r.size();
+
+    r.run(
+        "entity/iterate/list", n, [n]() { return build_list(n); },
+        [](list_state& s) {
+            long long sum = 0;
+            for (const entity& e : s.entities)
+            {
+                sum += e.hp;
+            }
+            bench::do_not_optimize(sum);
+        });
+    r.run(
+        "entity/iterate/slot_map", n, [n]() { return build_map(n); },
+        [](map_state& s) {
+            long long sum = 0;
+            for (const entity& e : s.entities)
+            {
+                sum += e.hp;
+            }
+            bench::do_not_optimize(sum);
+        });
+
+    r.run(
+        "entity/erase_random/list", n, [n]() { return build_list(n); },
+        [](list_state& s) {
+            for (entity_list::iterator it : s.handles)
+            {
+                s.entities.erase(it);
+            }
+            bench::do_not_optimize(s.entities.begin());
+        });
+    r.run(
+        "entity/erase_random/slot_map", n, [n]() { return build_map(n); },
+        [](map_state& s) {
+            for (xutl::slot_map_handle h : s.handles)
+            {
+                s.entities.erase(h);
+            }
+            bench::do_not_optimize(s.entities.size());
+        });
+
+    return r.report();
+}
@@ -0,0 +1,114 @@
+// string_view 的子串查找和 split 与 std:: 的对比
+// 用法：string_search_bench [--runs N] [--warmup N] [--size N] [--filter STR]
+//                           [--json FILE]
+// 文本为 --size 个（默认 2^20）字节的随机单词，单词之间用空格或逗号分隔：
+//   search/needleN  查找长度为 N 的子串，它只出现在文本末尾，
+//                   std 为 std::string::find，strstr 为 C 库的 strstr
+//   split/csv       按逗号切分文本，累加各段的长度，
+//                   std 为用 std::string::find 逐个找逗号
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "bench.h"
+#include "split.h"
+#include "string_view.h"
+
+namespace
+{
+
+// 平均长度约 6 的小写单词，约四分之一的分隔符是逗号
+std::string make_text(uint64_t n)
+{
+    std::string text;
+    text.reserve(n);
+    std::mt19937_64 rng(11);
+    while (text.size() < n)
+    {
+        const int len = 1 + static_cast<int>(rng() % 11);
+        for (int i = 0; i < len; ++i)
+        {
+            text.push_back(static_cast<char>('a' + rng() % 26));
+        }
+        text.push_back(rng() % 4 == 0 ? ',' : ' ');
+    }
+    text.resize(n);
+    return text;
+}
+
+// 以普通单词开头、以大写字母结尾的子串，只在末尾出现
+std::string make_needle(size_t m)
+{
+    std::string needle;
+    std::mt19937_64 rng(m);
+    for (size_t i = 0; i + 1 < m; ++i)
+    {
+        const char c = static_cast<char>('a' + rng() % 26);
+        needle.push_back(i % 7 == 6 ? ' ' : c);
+    }
+    needle.push_back('Z');
+    return needle;
+}
+
+int no_state()
+{
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    bench::options defaults;
+    defaults.size = uint64_t(1) << 20;
+    bench::runner r(argc, argv, defaults);
+    const std::string text = make_text(r.size());
+    const uint64_t n = text.size();
+
+    const size_t lengths[] = {4, 16, 64};
+    for (size_t m : lengths)
+    {
+        const std::string needle = make_needle(m);
+        const std::string haystack = text + needle;
+        const xutl::string_view view = haystack;
+        const std::string name = "search/needle" + std::to_string(m);
+        r.run(name + "/std", n, no_state, [&](int&) {
+            bench::do_not_optimize(haystack.find(needle));
+        });
+        r.run(name + "/strstr", n, no_state, [&](int&) {
+            bench::do_not_optimize(strstr(haystack.c_str(), needle.c_str()));
+        });
+        r.run(name + "/xutl", n, no_state, [&](int&) {
+            bench::do_not_optimize(view.find(needle));
+        });
+    }
+
+    r.run("split/csv/std", n, no_state, [&](int&) {
+        size_t total = 0;
+        size_t start = 0;
+        for (;;)
+        {
+            const size_t pos = text.find(',', start);
+            if (pos == std::string::npos)
+            {
+                total += text.size() - start;
+                break;
+            }
+            total += pos - start;
+            start = pos + 1;
+        }
+        bench::do_not_optimize(total);
+    });
+    r.run("split/csv/xutl", n, no_state, [&](int&) {
+        size_t total = 0;
+        for (xutl::string_view field : xutl::split(text, ','))
+        {
+            total += field.size();
+        }
+        bench::do_not_optimize(total);
+    });
+
+    return r.report();
+}
@@ -0,0 +1,143 @@
+// unrolled_list 与 list、vector 的遍历和中间插入对比
+// 用法：unrolled_list_bench [--runs N] [--warmup N] [--size N] [--filter STR]
+//                           [--json FILE]
+// 每个容器保存 --size 个 int（默认 2^20）：
+//   sequence/traverse      从头到尾遍历求和；list_shuffled 的节点按随机顺序链接，
+//                          模拟反复插入删除之后节点在内存中不再连续的情况
+//   sequence/insert_middle 在中间位置连续插入 --size / 1024 个元素
+
+#include <cstdint>
+#include <random>
+#include <utility>
+
+#include "bench.h"
+#include "list.h"
+#include "unrolled_list.h"
+#include "vector.h"
+
+namespace
+{
+
+using int_list = xutl::list<int>;
+using int_unrolled = xutl::unrolled_list<int>;
+using int_vector = xutl::vector<int>;
+
+template <typename Seq>
+Seq make_sequence(uint64_t n)
+{
+    Seq s;
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        s.push_back(static_cast<int>(i));
+    }
+    return s;
+}
+
+// 把节点按随机顺序重新链接
+int_list make_shuffled_list(uint64_t n)
+{
+    int_list s = make_sequence<int_list>(n);
+    xutl::vector<int_list::iterator> nodes;
+    for (int_list::iterator it = s.begin(); it != s.end(); ++it)
+    {
+        nodes.push_back(it);
+    }
+    std::mt19937_64 rng(42);
+    for (size_t i = nodes.size(); i > 1; --i)
+    {
+        std::swap(nodes[i - 1], nodes[rng() % i]);
+    }
+    for (int_list::iterator it : nodes)
+    {
+        s.splice(s.end(), s, it);
+    }
+    return s;
+}
+
+template <typename Seq>
+void traverse(Seq& s)
+{
+    long long sum = 0;
+    for (int x : s)
+    {
+        sum += x;
+    }
+    bench::do_not_optimize(sum);
+}
+
+// 中间位置的迭代器，不计入耗时
+template <typename Seq>
+typename Seq::iterator middle(Seq& s)
+{
+    typename Seq::iterator it = s.begin();
+    const size_t half = s.size() / 2;
+    for (size_t i = 0; i < half; ++i)
+    {
+        ++it;
+    }
+    return it;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    bench::runner r(argc, argv);
+    const uint64_t n = r.size();
+    const uint64_t m = n / 1024 > 0 ? n / 1024 : 1;
+
+    r.run(
+        "sequence/traverse/vector", n,
+        [n]() { return make_sequence<int_vector>(n); }, traverse<int_vector>);
+    r.run(
+        "sequence/traverse/list", n,
+        [n]() { return make_sequence<int_list>(n); }, traverse<int_list>);
+    r.run(
+        "sequence/traverse/list_shuffled", n,
+        [n]() { return make_shuffled_list(n); }, traverse<int_list>);
+    r.run(
+        "sequence/traverse/unrolled_list", n,
+        [n]() { return make_sequence<int_unrolled>(n); },
+        traverse<int_unrolled>);
+
+    r.run(
+        "sequence/insert_middle/vector", m,
+        [n]() { return make_sequence<int_vector>(n); },
+        [m](int_vector& v) {
+            for (uint64_t i = 0; i < m; ++i)
+            {
+                v.insert(v.begin() + v.size() / 2, static_cast<int>(i));
+            }
+            bench::do_not_optimize(v.data());
+        });
+    r.run(
+        "sequence/insert_middle/list", m,
+        [n]() {
+            int_list s = make_sequence<int_list>(n);
+            int_list::iterator it = middle(s);
+            return std::make_pair(std::move(s), it);
+        },
+        [m](std::pair<int_list, int_list::iterator>& p) {
+            for (uint64_t i = 0; i < m; ++i)
+            {
+                p.second = p.first.insert(p.second, static_cast<int>(i));
+            }
+            bench::do_not_optimize(&*p.second);
+        });
+    r.run(
+        "sequence/insert_middle/unrolled_list", m,
+        [n]() {
+            int_unrolled s = make_sequence<int_unrolled>(n);
+            int_unrolled::iterator it = middle(s);
+            return std::make_pair(std::move(s), it);
+        },
+        [m](std::pair<int_unrolled, int_unrolled::iterator>& p) {
+            for (uint64_t i = 0; i < m; ++i)
+            {
+                p.second = p.first.insert(p.second, static_cast<int>(i));
+            }
+            bench::do_not_optimize(&*p.second);
+        });
+
+    return r.report();
+}
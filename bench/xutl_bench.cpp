@@ -0,0 +1,525 @@
+// 容器和算法的回归性能测试
+// 用法：xutl_bench [--runs N] [--warmup N] [--size N] [--filter STR]
+//                   [--json FILE]
+// 覆盖 vector 的 push_back/insert/erase/reserve，list 的 insert/splice/merge，
+// copy/fill/move 算法，segmented_vector 与 std::deque 的 push_back 和遍历，
+// soa_vector 与 std::vector<struct> 的单字段扫描，
+// bitset 与 std::bitset 的按位与、count 和逐个查找 1，
+// 以及 string 与 std::string 的小字符串追加、查找字符和 find_first_of，
+// 每一项都与 std:: 的对应实现对比，
+// 名称形如「vector/push_back/xutl」，xutl 一行的「vs std」为与 std 的耗时比
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "algorithm.h"
+#include "bench.h"
+#include "bitset.h"
+#include "list.h"
+#include "segmented_vector.h"
+#include "soa_vector.h"
+#include "vector.h"
+#include "xstring.h"
+
+namespace
+{
+
+// 平方复杂度的测试（在头部或中间逐个插入、删除）使用较小的规模
+uint64_t quadratic_size(uint64_t n)
+{
+    return std::max<uint64_t>(n / 64, 1);
+}
+
+template <typename Vector>
+void bench_vector(bench::runner& r, const std::string& impl)
+{
+    const uint64_t n = r.size();
+    const uint64_t m = quadratic_size(n);
+
+    r.run(
+        "vector/push_back/" + impl, n, []() { return Vector(); },
+        [n](Vector& v) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                v.push_back(static_cast<int>(i));
+            }
+            bench::do_not_optimize(v.data());
+        });
+
+    r.run(
+        "vector/reserve_push_back/" + impl, n, []() { return Vector(); },
+        [n](Vector& v) {
+            v.reserve(n);
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                v.push_back(static_cast<int>(i));
+            }
+            bench::do_not_optimize(v.data());
+        });
+
+    r.run(
+        "vector/insert_middle/" + impl, m, []() { return Vector(); },
+        [m](Vector& v) {
+            for (uint64_t i = 0; i < m; ++i)
+            {
+                v.insert(v.begin() + v.size() / 2, static_cast<int>(i));
+            }
+            bench::do_not_optimize(v.data());
+        });
+
+    r.run(
+        "vector/insert_n/" + impl, n, [n]() { return Vector(n / 2, 1); },
+        [n](Vector& v) {
+            v.insert(v.begin() + v.size() / 2, n - n / 2, 2);
+            bench::do_not_optimize(v.data());
+        });
+
+    r.run(
+        "vector/insert_range/" + impl, n,
+        [n]() {
+            Vector v(n / 2, 1);
+            v.reserve(n);
+            return v;
+        },
+        [n](Vector& v) {
+            const Vector src(n - n / 2, 2);
+            v.insert(v.begin() + v.size() / 2, src.begin(), src.end());
+            bench::do_not_optimize(v.data());
+        });
+
+    r.run(
+        "vector/erase_front/" + impl, m, [m]() { return Vector(m, 1); },
+        [](Vector& v) {
+            while (!v.empty())
+            {
+                v.erase(v.begin());
+            }
+            bench::do_not_optimize(v.data());
+        });
+
+    r.run(
+        "vector/erase_range/" + impl, n, [n]() { return Vector(n, 1); },
+        [n](Vector& v) {
+            v.erase(v.begin() + n / 4, v.begin() + n / 4 * 3);
+            bench::do_not_optimize(v.data());
+        });
+}
+
+template <typename List>
+struct list_pair
+{
+    List a;
+    List b;
+};
+
+template <typename List>
+void bench_list(bench::runner& r, const std::string& impl)
+{
+    const uint64_t n = r.size();
+
+    r.run(
+        "list/push_back/" + impl, n, []() { return List(); },
+        [n](List& li) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                li.push_back(static_cast<int>(i));
+            }
+            bench::do_not_optimize(li.front());
+        });
+
+    // 由 vector 中的元素一次构造整个链表，计时包括链表的析构
+    r.run(
+        "list/construct_range/" + impl, n,
+        [n]() {
+            std::vector<int> src(n);
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                src[i] = static_cast<int>(i);
+            }
+            return src;
+        },
+        [](std::vector<int>& src) {
+            List li(src.data(), src.data() + src.size());
+            bench::do_not_optimize(li.back());
+        });
+
+    r.run(
+        "list/insert_middle/" + impl, n, []() { return List(2, 0); },
+        [n](List& li) {
+            auto pos = li.begin();
+            ++pos;
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                li.insert(pos, static_cast<int>(i));
+            }
+            bench::do_not_optimize(li.front());
+        });
+
+    r.run(
+        "list/splice/" + impl, n,
+        [n]() {
+            list_pair<List> p;
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                p.a.push_back(static_cast<int>(i));
+            }
+            return p;
+        },
+        [n](list_pair<List>& p) {
+            // 逐个把 a 的头部接合到 b 的尾部，再整体接合回 a
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                p.b.splice(p.b.end(), p.a, p.a.begin());
+            }
+            p.a.splice(p.a.end(), p.b);
+            bench::do_not_optimize(p.a.front());
+        });
+
+    r.run(
+        "list/merge/" + impl, n,
+        [n]() {
+            list_pair<List> p;
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                (i % 2 ? p.a : p.b).push_back(static_cast<int>(i));
+            }
+            return p;
+        },
+        [](list_pair<List>& p) {
+            p.a.merge(p.b);
+            bench::do_not_optimize(p.a.front());
+        });
+}
+
+template <typename T>
+struct buffers
+{
+    std::vector<T> src;
+    std::vector<T> dst;
+};
+
+template <typename T>
+buffers<T> make_buffers(uint64_t n)
+{
+    buffers<T> b;
+    b.src.assign(n, T(1));
+    b.dst.assign(n, T(0));
+    return b;
+}
+
+void bench_algorithm(bench::runner& r)
+{
+    const uint64_t n = r.size();
+    auto setup = [n]() { return make_buffers<int>(n); };
+    auto setup_char = [n]() { return make_buffers<char>(n); };
+
+    r.run("algorithm/copy/std", n, setup, [](buffers<int>& b) {
+        bench::do_not_optimize(std::copy(b.src.data(),
+                                         b.src.data() + b.src.size(),
+                                         b.dst.data()));
+    });
+    r.run("algorithm/copy/xutl", n, setup, [](buffers<int>& b) {
+        bench::do_not_optimize(xutl::copy(b.src.data(),
+                                          b.src.data() + b.src.size(),
+                                          b.dst.data()));
+    });
+
+    r.run("algorithm/move/std", n, setup, [](buffers<int>& b) {
+        bench::do_not_optimize(std::move(b.src.data(),
+                                         b.src.data() + b.src.size(),
+                                         b.dst.data()));
+    });
+    r.run("algorithm/move/xutl", n, setup, [](buffers<int>& b) {
+        bench::do_not_optimize(xutl::move(b.src.data(),
+                                          b.src.data() + b.src.size(),
+                                          b.dst.data()));
+    });
+
+    r.run("algorithm/fill/std", n, setup, [](buffers<int>& b) {
+        std::fill(b.dst.data(), b.dst.data() + b.dst.size(), 7);
+        bench::do_not_optimize(b.dst.data());
+    });
+    r.run("algorithm/fill/xutl", n, setup, [](buffers<int>& b) {
+        xutl::fill(b.dst.data(), b.dst.data() + b.dst.size(), 7);
+        bench::do_not_optimize(b.dst.data());
+    });
+
+    r.run("algorithm/fill_char/std", n, setup_char, [](buffers<char>& b) {
+        std::fill(b.dst.data(), b.dst.data() + b.dst.size(), 'x');
+        bench::do_not_optimize(b.dst.data());
+    });
+    r.run("algorithm/fill_char/xutl", n, setup_char, [](buffers<char>& b) {
+        xutl::fill(b.dst.data(), b.dst.data() + b.dst.size(), 'x');
+        bench::do_not_optimize(b.dst.data());
+    });
+}
+
+// segmented_vector 与同样不移动已有元素的 std::deque 对比
+template <typename Seq>
+void bench_segmented(bench::runner& r, const std::string& impl)
+{
+    const uint64_t n = r.size();
+
+    r.run(
+        "segmented/push_back/" + impl, n, []() { return Seq(); },
+        [n](Seq& s) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                s.push_back(static_cast<int>(i));
+            }
+            bench::do_not_optimize(&s.back());
+        });
+
+    r.run(
+        "segmented/iterate/" + impl, n,
+        [n]() {
+            Seq s;
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                s.push_back(static_cast<int>(i));
+            }
+            return s;
+        },
+        [](Seq& s) {
+            long long sum = 0;
+            for (int x : s)
+            {
+                sum += x;
+            }
+            bench::do_not_optimize(sum);
+        });
+
+    r.run(
+        "segmented/index/" + impl, n,
+        [n]() {
+            Seq s;
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                s.push_back(static_cast<int>(i));
+            }
+            return s;
+        },
+        [n](Seq& s) {
+            long long sum = 0;
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                sum += s[(i * 7919) % n];
+            }
+            bench::do_not_optimize(sum);
+        });
+}
+
+// 一个 64 字节的结构体，扫描时只读 mass 一个字段
+struct particle
+{
+    double x, y, z;
+    double vx, vy, vz;
+    float mass;
+    int id;
+};
+
+using particle_soa = xutl::soa_vector<double, double, double, double, double,
+                                      double, float, int>;
+
+void bench_soa(bench::runner& r)
+{
+    const uint64_t n = r.size();
+    std::vector<particle> aos(n);
+    particle_soa soa;
+    soa.reserve(n);
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        const float mass = static_cast<float>(i % 100);
+        aos[i].mass = mass;
+        soa.emplace_back(0.0, 0.0, 0.0, 0.0, 0.0, 0.0, mass,
+                         static_cast<int>(i));
+    }
+
+    const std::vector<particle>* pa = &aos;
+    const particle_soa* ps = &soa;
+    r.run(
+        "soa/sum_field/std", n, [pa]() { return pa; },
+        [](const std::vector<particle>* a) {
+            float sum = 0;
+            for (const particle& p : *a)
+            {
+                sum += p.mass;
+            }
+            bench::do_not_optimize(sum);
+        });
+    r.run(
+        "soa/sum_field/xutl", n, [ps]() { return ps; },
+        [](const particle_soa* s) {
+            float sum = 0;
+            for (float m : s->field<6>())
+            {
+                sum += m;
+            }
+            bench::do_not_optimize(sum);
+        });
+}
+
+// 位数固定为 2^20，不随 --size 变化
+const size_t bench_bits = size_t(1) << 20;
+
+// std::bitset 没有 find_next，使用 libstdc++ 的扩展 _Find_first/_Find_next
+size_t find_first(const std::bitset<bench_bits>& b)
+{
+    return b._Find_first();
+}
+size_t find_next(const std::bitset<bench_bits>& b, size_t pos)
+{
+    return b._Find_next(pos);
+}
+size_t find_first(const xutl::bitset<bench_bits>& b)
+{
+    return b.find_first();
+}
+size_t find_next(const xutl::bitset<bench_bits>& b, size_t pos)
+{
+    return b.find_next(pos);
+}
+
+template <typename Bits>
+struct bit_pair
+{
+    Bits a, b;
+};
+
+template <typename Bits>
+void bench_bitset(bench::runner& r, const std::string& impl)
+{
+    using pair_ptr = xutl::unique_ptr<bit_pair<Bits>>;
+    // a 中约一半的位为 1，b 中约 1% 的位为 1
+    auto setup = []() {
+        pair_ptr p(new bit_pair<Bits>());
+        uint64_t x = 88172645463325252ull;
+        for (size_t i = 0; i < bench_bits; ++i)
+        {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            p->a.set(i, x % 2 == 0);
+            p->b.set(i, x % 100 == 1);
+        }
+        return p;
+    };
+
+    r.run("bitset/and/" + impl, bench_bits, setup, [](pair_ptr& p) {
+        p->a &= p->b;
+        bench::do_not_optimize(&p->a);
+    });
+    r.run("bitset/count/" + impl, bench_bits, setup, [](pair_ptr& p) {
+        bench::do_not_optimize(p->a.count());
+    });
+    r.run("bitset/find_next/" + impl, bench_bits, setup, [](pair_ptr& p) {
+        size_t sum = 0;
+        for (size_t i = find_first(p->b); i < bench_bits;
+             i = find_next(p->b, i))
+        {
+            sum += i;
+        }
+        bench::do_not_optimize(sum);
+    });
+}
+
+// 模拟日志格式化：每行由几个短片段拼成，行本身通常放得进 SSO
+template <typename String>
+void bench_string(bench::runner& r, const std::string& impl)
+{
+    const uint64_t n = r.size();
+    r.run(
+        "string/append_small/" + impl, n, []() { return 0; },
+        [n](int&) {
+            size_t total = 0;
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                String line;
+                line += "lvl=";
+                line += (i & 1) ? "info" : "warn";
+                line += ' ';
+                line += "id=";
+                line += static_cast<char>('0' + i % 10);
+                // 让每一行都真正写入内存，否则短字符串的拼接会被整个优化掉
+                bench::do_not_optimize(line.data());
+                total += line.size();
+            }
+            bench::do_not_optimize(total);
+        });
+    r.run(
+        "string/append_long/" + impl, n, []() { return String(); },
+        [n](String& s) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                s += "key=value ";
+            }
+            bench::do_not_optimize(s.data());
+        });
+    // 在一个长字符串中逐个查找分隔符
+    r.run(
+        "string/find_char/" + impl, n,
+        [n]() {
+            String s;
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                s += (i % 100 == 99) ? '\n' : 'x';
+            }
+            return s;
+        },
+        [](String& s) {
+            size_t count = 0;
+            for (size_t pos = s.find('\n'); pos != String::npos;
+                 pos = s.find('\n', pos + 1))
+            {
+                ++count;
+            }
+            bench::do_not_optimize(count);
+        });
+    // 查找几种分隔符中的任意一个
+    r.run(
+        "string/find_first_of/" + impl, n,
+        [n]() {
+            String s;
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                s += (i % 100 == 99) ? (i % 300 == 299 ? ';' : ',') : 'x';
+            }
+            return s;
+        },
+        [](String& s) {
+            size_t count = 0;
+            for (size_t pos = s.find_first_of(",;\n"); pos != String::npos;
+                 pos = s.find_first_of(",;\n", pos + 1))
+            {
+                ++count;
+            }
+            bench::do_not_optimize(count);
+        });
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    bench::runner r(argc, argv);
+
+    bench_vector<std::vector<int>>(r, "std");
+    bench_vector<xutl::vector<int>>(r, "xutl");
+    bench_list<std::list<int>>(r, "std");
+    bench_list<xutl::list<int>>(r, "xutl");
+    bench_algorithm(r);
+    bench_segmented<std::deque<int>>(r, "std");
+    bench_segmented<xutl::segmented_vector<int>>(r, "xutl");
+    bench_soa(r);
+    bench_bitset<std::bitset<bench_bits>>(r, "std");
+    bench_bitset<xutl::bitset<bench_bits>>(r, "xutl");
+    bench_string<std::string>(r, "std");
+    bench_string<xutl::string>(r, "xutl");
+
+    return r.report();
+}
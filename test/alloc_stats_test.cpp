@@ -0,0 +1,56 @@
+// 开启分配统计，并让占用字节数每次都并入全局计数，使峰值精确
+#define XUTL_ALLOC_STATS
+#define XUTL_ALLOC_STATS_FLUSH_BYTES 0
+
+#include <cstdio>
+#include <thread>
+
+#include "alloc_stats.h"
+#include "list.h"
+#include "vector.h"
+
+int main()
+{
+    xutl::reset_alloc_stats();
+    {
+        xutl::vector<int> v;  // 默认构造分配 16 个元素
+        for (int i = 0; i < 100; ++i)
+        {
+            v.push_back(i);
+        }
+        // 16 -> 32 -> 64 -> 128，共 4 次分配，扩容时释放了前 3 次
+        xutl::alloc_stats s = xutl::snapshot_alloc_stats<int>();
+        printf("int: allocations = %llu, deallocations = %llu, live = %lld, "
+               "peak = %lld\n",
+               static_cast<unsigned long long>(s.allocations),
+               static_cast<unsigned long long>(s.deallocations),
+               static_cast<long long>(s.bytes_live),
+               static_cast<long long>(s.peak_bytes));
+        if (s.allocations != 4 || s.deallocations != 3) return 1;
+        if (s.bytes_live != 128 * 4 || s.peak_bytes != (64 + 128) * 4) return 1;
+        if (s.histogram[xutl::alloc_histogram_bucket(512)] != 1) return 1;
+    }
+
+    // 其它线程的计数在查询时合并，线程退出后仍然保留
+    std::thread t([]() {
+        xutl::list<long> li;
+        for (int i = 0; i < 10; ++i)
+        {
+            li.push_back(i);
+        }
+    });
+    t.join();
+
+    xutl::alloc_stats_snapshot snap = xutl::snapshot_alloc_stats();
+    xutl::print_alloc_stats(snap);
+    xutl::alloc_stats nodes = xutl::snapshot_alloc_stats<xutl::list_node<long>>();
+    if (nodes.allocations != 11 || nodes.bytes_live != 0) return 1;
+    if (snap.total.allocations != 15 || snap.total.bytes_live != 0) return 1;
+
+    xutl::reset_alloc_stats();
+    snap = xutl::snapshot_alloc_stats();
+    printf("after reset: allocations = %llu, types = %zu\n",
+           static_cast<unsigned long long>(snap.total.allocations),
+           snap.types.size());
+    return snap.total.allocations == 0 && snap.types.empty() ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+#include <bitset>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bitset.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+
+namespace
+{
+
+const size_t bits = 1000;
+
+using fixed = xutl::bitset<bits>;
+using reference = std::bitset<bits>;
+
+template <typename Bits>
+void fill_random(Bits& b, std::mt19937& rng, unsigned percent)
+{
+    for (size_t i = 0; i < b.size(); ++i)
+    {
+        b.set(i, rng() % 100 < percent);
+    }
+}
+
+reference to_std(const fixed& b)
+{
+    reference r;
+    for (size_t i = 0; i < bits; ++i)
+    {
+        r[i] = b[i];
+    }
+    return r;
+}
+
+// 用 find_first/find_next 列出所有 1 的位置，与逐位检查的结果比较
+template <typename Bits>
+bool finds_all(const Bits& b)
+{
+    size_t expect = 0;
+    while (expect < b.size() && !b[expect]) ++expect;
+    size_t pos = b.find_first();
+    while (pos != Bits::npos)
+    {
+        if (pos != expect) return false;
+        ++expect;
+        while (expect < b.size() && !b[expect]) ++expect;
+        pos = b.find_next(pos);
+    }
+    return expect == b.size();
+}
+
+int run_fixed(std::mt19937& rng)
+{
+    int failed = 0;
+    fixed a, b;
+    fill_random(a, rng, 50);
+    fill_random(b, rng, 30);
+    const reference ra = to_std(a), rb = to_std(b);
+
+    failed += check(a.count() == ra.count(), "count");
+    failed += check(to_std(a & b) == (ra & rb), "and");
+    failed += check(to_std(a | b) == (ra | rb), "or");
+    failed += check(to_std(a ^ b) == (ra ^ rb), "xor");
+    failed += check(to_std(~a) == ~ra && (~a).count() == bits - ra.count(),
+                    "flip keeps the tail clear");
+    fixed c = a;
+    c.and_not(b);
+    failed += check(to_std(c) == (ra & ~rb), "and_not");
+    failed += check(finds_all(a) && finds_all(c), "find_first/find_next");
+
+    // 稀疏的位集：find_next 需要跳过大段全 0 的字
+    fixed sparse;
+    sparse.set(3).set(700).set(bits - 1);
+    failed += check(sparse.find_first() == 3 && sparse.find_next(3) == 700 &&
+                        sparse.find_next(700) == bits - 1 &&
+                        sparse.find_next(bits - 1) == fixed::npos,
+                    "find_next skips zero words");
+    sparse.reset();
+    failed += check(sparse.none() && sparse.find_first() == fixed::npos,
+                    "reset");
+    sparse.set();
+    failed += check(sparse.all() && sparse.count() == bits, "set all");
+    failed += check(xutl::bitset<70>(~0ull).count() == 64 &&
+                        xutl::bitset<10>(~0ull).count() == 10,
+                    "construct from unsigned long long");
+    return failed;
+}
+
+int run_dynamic(std::mt19937& rng)
+{
+    int failed = 0;
+    // 覆盖不足一个字、刚好整字、以及较长的位集
+    const size_t sizes[] = {0, 1, 63, 64, 65, 511, 512, 5000};
+    for (size_t n : sizes)
+    {
+        xutl::dynamic_bitset a(n), b(n, true);
+        std::vector<bool> ra(n), rb(n, true);
+        for (size_t i = 0; i < n; ++i)
+        {
+            const bool x = rng() % 3 == 0;
+            a.set(i, x);
+            ra[i] = x;
+            if (rng() % 4 == 0)
+            {
+                b.reset(i);
+                rb[i] = false;
+            }
+        }
+        size_t expect = 0;
+        bool ok = true;
+        xutl::dynamic_bitset x = a, o = a, n_ = a;
+        x ^= b;
+        o |= b;
+        n_.and_not(b);
+        a &= b;
+        for (size_t i = 0; i < n; ++i)
+        {
+            expect += ra[i] && rb[i];
+            ok = ok && a[i] == (ra[i] && rb[i]) && o[i] == (ra[i] || rb[i]) &&
+                 x[i] == (ra[i] != rb[i]) && n_[i] == (ra[i] && !rb[i]);
+        }
+        failed += check(ok && a.count() == expect, "dynamic_bitset ops");
+        failed += check(finds_all(a) && finds_all(b), "dynamic find_next");
+    }
+
+    xutl::dynamic_bitset d(10, true);
+    d.resize(100, true);
+    failed += check(d.count() == 100 && d.all(), "resize fills new bits");
+    d.resize(70);
+    d.resize(130);
+    failed += check(d.count() == 70 && d.size() == 130,
+                    "shrink clears dropped bits");
+    for (int i = 0; i < 200; ++i)
+    {
+        d.push_back(i % 2 == 0);
+    }
+    failed += check(d.size() == 330 && d.count() == 170 && d[130] && !d[131],
+                    "push_back");
+    xutl::dynamic_bitset e = d;
+    failed += check(e == d && !(e != d), "equality");
+    e.flip(0);
+    failed += check(e != d, "inequality");
+    bool thrown = false;
+    try
+    {
+        d.test(d.size());
+    }
+    catch (const std::out_of_range&)
+    {
+        thrown = true;
+    }
+    failed += check(thrown, "test throws out_of_range");
+    d.clear();
+    failed += check(d.empty() && d.none(), "clear");
+    return failed;
+}
+
+}  // namespace
+
+int main()
+{
+    int failed = 0;
+    std::mt19937 rng(11);
+
+    // SIMD 路径和标量路径都要与 std 一致
+    for (int simd = 1; simd >= 0; --simd)
+    {
+        xutl::set_simd_enabled(simd != 0);
+        failed += run_fixed(rng);
+        failed += run_dynamic(rng);
+    }
+    xutl::set_simd_enabled(true);
+
+    return xutl_test::report(failed);
+}
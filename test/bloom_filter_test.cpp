@@ -0,0 +1,114 @@
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "bloom_filter.h"
+#include "vector.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+
+namespace
+{
+
+// 插入 [0, n) 后查询 [n, 2n)，返回误判的比例
+double measured_fpr(const xutl::bloom_filter<uint64_t>& f, uint64_t n)
+{
+    uint64_t hits = 0;
+    for (uint64_t i = n; i < 2 * n; ++i)
+    {
+        hits += f.contains(i);
+    }
+    return static_cast<double>(hits) / static_cast<double>(n);
+}
+
+int run(uint64_t n, double fpr)
+{
+    int failed = 0;
+    xutl::bloom_filter<uint64_t> f(n, fpr);
+    failed += check(f.expected_fpr() <= fpr && f.hash_count() == 8,
+                    "shape meets the requested fpr");
+    failed += check(f.contains(42) == false, "empty filter");
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        f.insert(i);
+    }
+    bool all = true;
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        all = all && f.contains(i);
+    }
+    failed += check(all, "no false negatives");
+    // 实测误判率与理论值相差不大
+    const double measured = measured_fpr(f, n);
+    failed += check(measured <= fpr * 1.5, "measured fpr");
+
+    // 批量查询与逐个查询一致
+    xutl::vector<uint64_t> keys;
+    for (uint64_t i = 0; i < 2 * n; i += 3)
+    {
+        keys.push_back(i);
+    }
+    std::unique_ptr<bool[]> out(new bool[keys.size()]);
+    const size_t found =
+        f.contains(xutl::span<const uint64_t>(keys.data(), keys.size()),
+                   out.get());
+    size_t expect = 0;
+    bool same = true;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        expect += f.contains(keys[i]);
+        same = same && out[i] == f.contains(keys[i]);
+    }
+    failed += check(same && found == expect, "batched contains");
+
+    f.clear();
+    failed += check(!f.contains(0) && !f.contains(n - 1), "clear");
+    return failed;
+}
+
+}  // namespace
+
+int main()
+{
+    int failed = 0;
+
+    // SIMD 路径和标量路径都要正确
+    for (int simd = 1; simd >= 0; --simd)
+    {
+        xutl::set_simd_enabled(simd != 0);
+        failed += run(100000, 0.01);
+        failed += run(20000, 0.001);
+        failed += run(5, 0.1);
+    }
+
+    // 两条路径设置的位相同：标量插入的键用 SIMD 查询也能找到
+    xutl::set_simd_enabled(false);
+    xutl::bloom_filter<std::string> s(1000, 0.01);
+    for (int i = 0; i < 1000; ++i)
+    {
+        s.insert(std::to_string(i));
+    }
+    xutl::set_simd_enabled(true);
+    bool all = true;
+    for (int i = 0; i < 1000; ++i)
+    {
+        all = all && s.contains(std::to_string(i));
+    }
+    failed += check(all, "scalar and SIMD paths agree");
+
+    bool thrown = false;
+    try
+    {
+        xutl::bloom_filter<int> bad(10, 1.5);
+    }
+    catch (const std::out_of_range&)
+    {
+        thrown = true;
+    }
+    failed += check(thrown, "invalid fpr throws");
+
+    return xutl_test::report(failed);
+}
@@ -0,0 +1,131 @@
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "concurrent_hash_map.h"
+#include "vector.h"
+
+int main()
+{
+    // 单线程：插入、覆盖、查找、删除
+    xutl::concurrent_hash_map<int, int> m(0, 4);
+    for (int i = 0; i < 1000; ++i)
+    {
+        m.insert_or_assign(i, i * 2);
+    }
+    bool inserted = m.insert_or_assign(7, 70);
+    printf("size = %zu, inserted = %d\n", m.size(), inserted);
+    int value = 0;
+    m.find(7, value);
+    printf("m[7] = %d\n", value);
+    for (int i = 0; i < 1000; i += 2)
+    {
+        m.erase(i);
+    }
+    int bad = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        bool found = m.find(i, [&](const int& v) {
+            if (i != 7 && v != i * 2) ++bad;
+        });
+        if (found != (i % 2 == 1)) ++bad;
+    }
+    printf("size = %zu, bad = %d\n", m.size(), bad);
+    if (m.size() != 500 || bad != 0 || value != 70 || inserted) return 1;
+
+    // 不可无锁读的类型走加锁路径
+    xutl::concurrent_hash_map<std::string, std::string> sm;
+    sm.insert_or_assign(std::string("key"), std::string("value"));
+    std::string s;
+    sm.find("key", s);
+    printf("sm[key] = %s\n", s.c_str());
+    if (s != "value") return 1;
+
+    // 扩容是渐进的：单个分片在 769 个元素时扩到 2048 个槽位，之后每次写操作
+    // 迁移 16 个旧槽位，插入 800 个元素时旧表还没有迁完
+    xutl::concurrent_hash_map<int, int> gm(0, 1);
+    xutl::concurrent_hash_map<int, std::string> gsm(0, 1);
+    for (int i = 0; i < 800; ++i)
+    {
+        gm.insert_or_assign(i, i);
+        gsm.insert_or_assign(i, std::to_string(i));
+    }
+    for (int i = 0; i < 800; ++i)
+    {
+        if (!gm.contains(i) || !gsm.contains(i)) ++bad;
+    }
+    // 覆盖和删除还在旧表中的元素
+    for (int i = 0; i < 100; ++i)
+    {
+        gm.insert_or_assign(i, -i);
+        gsm.insert_or_assign(i, std::to_string(-i));
+        gm.erase(i + 100);
+        gsm.erase(i + 100);
+    }
+    for (int i = 0; i < 800; ++i)
+    {
+        int v = 0;
+        std::string sv;
+        const bool expect = i < 100 || i >= 200;
+        const int ev = i < 100 ? -i : i;
+        if (gm.find(i, v) != expect || gsm.find(i, sv) != expect) ++bad;
+        if (expect && (v != ev || sv != std::to_string(ev))) ++bad;
+    }
+    size_t visited = 0;
+    gsm.for_each([&visited](const int&, const std::string&) { ++visited; });
+    printf("growing: size = %zu, visited = %zu, bad = %d\n", gm.size(),
+           visited, bad);
+    if (gm.size() != 700 || gsm.size() != 700 || visited != 700 || bad != 0)
+    {
+        return 1;
+    }
+    gsm.clear();
+    if (!gsm.empty() || gsm.contains(5)) return 1;
+
+    // 多线程：写者不断插入并扩容，读者验证读到的值一致
+    xutl::concurrent_hash_map<long, long> cm(0, 8);
+    const int writers = 2;
+    const int readers = 2;
+    const long per_writer = 50000;
+    std::atomic<long> torn(0);
+    std::atomic<bool> done(false);
+    xutl::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w)
+    {
+        threads.emplace_back([&cm, w, per_writer]() {
+            for (long i = 0; i < per_writer; ++i)
+            {
+                long k = w * per_writer + i;
+                cm.insert_or_assign(k, k * 3);
+                if (i % 3 == 0) cm.erase(k);
+            }
+        });
+    }
+    for (int r = 0; r < readers; ++r)
+    {
+        threads.emplace_back([&cm, &torn, &done, per_writer]() {
+            long k = 0;
+            while (!done.load())
+            {
+                cm.find(k, [&torn, k](const long& v) {
+                    if (v != k * 3) ++torn;
+                });
+                k = (k + 7) % (writers * per_writer);
+            }
+        });
+    }
+    for (int w = 0; w < writers; ++w)
+    {
+        threads[w].join();
+    }
+    done = true;
+    for (int r = 0; r < readers; ++r)
+    {
+        threads[writers + r].join();
+    }
+    long expected = writers * (per_writer - (per_writer + 2) / 3);
+    printf("size = %zu, expected = %ld, torn = %ld\n", cm.size(), expected,
+           torn.load());
+    return cm.size() == static_cast<size_t>(expected) && torn == 0 ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "functional.h"
+#include "memory.h"
+
+// 统计全局 operator new 的调用次数，检查小的可调用对象不分配内存
+static int g_allocations = 0;
+
+void* operator new(size_t n)
+{
+    ++g_allocations;
+    void* p = malloc(n == 0 ? 1 : n);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+static int twice(int x)
+{
+    return 2 * x;
+}
+
+static int apply(xutl::function_ref<int(int)> f, int x)
+{
+    return f(x);
+}
+
+int main()
+{
+    // function：捕获 3 个指针的 lambda 就地存放
+    int a = 1, b = 2, c = 3;
+    int before = g_allocations;
+    xutl::function<int(int)> f = [&a, &b, &c](int x) { return a + b + c + x; };
+    xutl::function<int(int)> g = f;
+    xutl::function<int(int)> h = xutl::move(g);
+    xutl::function<int(int)> p = twice;
+    printf("f(4) = %d, h(4) = %d, p(4) = %d, allocations = %d\n", f(4), h(4),
+           p(4), g_allocations - before);
+    if (f(4) != 10 || h(4) != 10 || p(4) != 8 || g) return 1;
+    if (g_allocations != before) return 1;
+
+    // 超过内联存储的可调用对象分配在堆上
+    long big[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    xutl::function<long()> large = [big]() { return big[7]; };
+    xutl::function<long()> large_copy = large;
+    printf("large() = %ld, allocations = %d\n", large_copy(),
+           g_allocations - before);
+    if (large_copy() != 8 || g_allocations - before != 2) return 1;
+
+    bool caught = false;
+    try
+    {
+        xutl::function<void()> empty;
+        empty();
+    }
+    catch (const xutl::bad_function_call&)
+    {
+        caught = true;
+    }
+    int (*null_fn)(int) = nullptr;
+    xutl::function<int(int)> from_null = null_fn;
+    if (!caught || from_null != nullptr) return 1;
+
+    // unique_function 保存只能移动的可调用对象
+    xutl::unique_ptr<int> owned(new int(42));
+    int* raw = owned.get();
+    xutl::unique_function<int()> u = [raw]() { return *raw; };
+    xutl::unique_function<int()> u2 = xutl::move(u);
+    struct holder
+    {
+        xutl::unique_ptr<int> p;
+        int operator()()
+        {
+            return *p;
+        }
+    };
+    xutl::unique_function<int()> mo = holder{xutl::move(owned)};
+    printf("u2() = %d, mo() = %d\n", u2(), mo());
+    if (u2() != 42 || mo() != 42 || u) return 1;
+
+    // function_ref：两个指针大小，只引用原对象
+    int offset = 5;
+    auto add = [&offset](int x) { return x + offset; };
+    printf("sizeof(function_ref) = %zu, add = %d, twice = %d\n",
+           sizeof(xutl::function_ref<int(int)>), apply(add, 1), apply(twice, 1));
+    if (sizeof(xutl::function_ref<int(int)>) != 2 * sizeof(void*)) return 1;
+    return apply(add, 1) == 6 && apply(twice, 1) == 2 && apply(f, 0) == 6 ? 0
+                                                                           : 1;
+}
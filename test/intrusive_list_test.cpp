@@ -0,0 +1,135 @@
+#include <cstdio>
+#include <initializer_list>
+#include <utility>
+
+#include "intrusive_list.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+
+namespace
+{
+
+// 一个连接同时挂在全部连接的链表和空闲/活跃链表上
+struct session
+{
+    int id;
+    xutl::list_hook all_hook;
+    xutl::list_hook state_hook;
+
+    explicit session(int i) : id(i)
+    {
+    }
+};
+
+using all_list = xutl::intrusive_list<session, &session::all_hook>;
+using state_list = xutl::intrusive_list<session, &session::state_hook>;
+
+// 不是标准布局的类型：有虚函数，hook 在派生类中
+struct task_base
+{
+    virtual ~task_base() = default;
+    long priority = 0;
+};
+
+struct task : task_base
+{
+    int id = 0;
+    xutl::list_hook hook;
+};
+
+template <typename List>
+bool equals(const List& li, std::initializer_list<int> expect)
+{
+    if (li.size() != expect.size()) return false;
+    auto it = expect.begin();
+    for (const session& s : li)
+    {
+        if (s.id != *it++) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main()
+{
+    int failed = 0;
+
+    session s[5] = {session(0), session(1), session(2), session(3),
+                    session(4)};
+    all_list all;
+    state_list idle;
+    state_list active;
+    for (session& x : s)
+    {
+        all.push_back(x);
+        idle.push_back(x);
+    }
+    failed += check(equals(all, {0, 1, 2, 3, 4}) &&
+                        equals(idle, {0, 1, 2, 3, 4}) && active.empty(),
+                    "push_back on two hooks");
+
+    // 在空闲和活跃链表之间移动，不影响另一个 hook
+    active.splice(active.end(), idle, idle.iterator_to(s[2]));
+    active.splice(active.begin(), idle, idle.iterator_to(s[4]));
+    failed += check(equals(idle, {0, 1, 3}) && equals(active, {4, 2}) &&
+                        equals(all, {0, 1, 2, 3, 4}),
+                    "splice single element");
+
+    // 元素通过自己的 hook 摘下
+    s[1].state_hook.unlink();
+    failed += check(equals(idle, {0, 3}) && !s[1].state_hook.is_linked() &&
+                        s[1].all_hook.is_linked(),
+                    "unlink from the element");
+    idle.push_front(s[1]);
+    idle.remove(s[3]);
+    failed += check(equals(idle, {1, 0}), "push_front and remove");
+
+    active.splice(active.end(), idle);
+    failed += check(idle.empty() && equals(active, {4, 2, 1, 0}),
+                    "splice whole list");
+    active.splice(active.begin(), active, ++active.begin(), active.end());
+    failed += check(equals(active, {2, 1, 0, 4}), "splice range");
+
+    active.reverse();
+    failed += check(equals(active, {4, 0, 1, 2}) && active.front().id == 4 &&
+                        active.back().id == 2,
+                    "reverse");
+
+    state_list::iterator it = active.erase(active.begin());
+    failed += check(it->id == 0 && equals(active, {0, 1, 2}) &&
+                        !s[4].state_hook.is_linked(),
+                    "erase");
+
+    idle.swap(active);
+    failed += check(active.empty() && equals(idle, {0, 1, 2}), "swap");
+    state_list moved(std::move(idle));
+    failed += check(idle.empty() && equals(moved, {0, 1, 2}), "move");
+
+    // 对象析构时自动摘下
+    {
+        session temp(9);
+        moved.push_back(temp);
+        all.push_back(temp);
+        failed += check(equals(moved, {0, 1, 2, 9}), "push temporary");
+    }
+    failed += check(equals(moved, {0, 1, 2}) && equals(all, {0, 1, 2, 3, 4}),
+                    "auto unlink on destruction");
+
+    moved.clear();
+    failed += check(moved.empty() && !s[0].state_hook.is_linked(), "clear");
+
+    task tasks[3];
+    xutl::intrusive_list<task, &task::hook> tl;
+    for (int i = 0; i < 3; ++i)
+    {
+        tasks[i].id = i;
+        tl.push_front(tasks[i]);
+    }
+    failed += check(&tl.front() == &tasks[2] && tl.back().id == 0,
+                    "non-standard-layout element");
+
+    return xutl_test::report(failed);
+}
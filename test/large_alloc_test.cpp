@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <cstdio>
+
+#include "large_alloc.h"
+#include "memory.h"
+#include "vector.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+
+namespace
+{
+
+bool huge_aligned(const void* p)
+{
+    return reinterpret_cast<uintptr_t>(p) % xutl::huge_page_size == 0;
+}
+
+}  // namespace
+
+int main()
+{
+    int failed = 0;
+    const size_t n = (8u << 20) / sizeof(uint64_t);  // 8MB
+
+    // 默认关闭
+    {
+        xutl::vector<uint64_t> v(n, 1);
+        failed += check(xutl::large_alloc_live_blocks() == 0, "disabled");
+    }
+
+    xutl::large_alloc_policy policy;
+    policy.enabled = true;
+    policy.threshold = 1;  // 会被提高到 huge_page_size
+    policy.numa = xutl::numa_policy::local;
+    xutl::set_large_alloc_policy(policy);
+    failed += check(xutl::get_large_alloc_policy().threshold ==
+                        xutl::huge_page_size,
+                    "threshold floor");
+    {
+        xutl::vector<uint64_t> small(1000, 2);
+        failed += check(xutl::large_alloc_live_blocks() == 0,
+                        "small allocation uses operator new");
+
+        xutl::vector<uint64_t> v(n, 3);
+        failed += check(xutl::large_alloc_live_blocks() == 1 &&
+                            huge_aligned(v.data()) && v[n - 1] == 3,
+                        "large allocation");
+
+        // 扩容时旧块按原来的大小释放
+        for (size_t i = 0; i < 10; ++i)
+        {
+            v.push_back(i);
+        }
+        failed += check(xutl::large_alloc_live_blocks() == 1 &&
+                            huge_aligned(v.data()) && v[n] == 0 &&
+                            v[n - 1] == 3,
+                        "reallocation");
+
+        policy.numa = xutl::numa_policy::interleave;
+        policy.huge_pages = false;
+        xutl::set_large_alloc_policy(policy);
+        uint64_t* p = xutl::allocator<uint64_t>::allocate(n);
+        p[0] = p[n - 1] = 5;
+        failed += check(xutl::large_alloc_live_blocks() == 2, "interleave");
+        xutl::allocator<uint64_t>::deallocate(p, n);
+
+        // 关闭后分配的块仍能正确释放
+        xutl::set_large_alloc_policy(xutl::large_alloc_policy());
+    }
+    failed += check(xutl::large_alloc_live_blocks() == 0, "all released");
+
+    return xutl_test::report(failed);
+}
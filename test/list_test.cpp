@@ -1,7 +1,22 @@
 #include <cstdio>
+#include <stdexcept>
 
 #include "list.h"
 
+#include "test_util.h"
+
+using xutl_test::fragile;
+
+template <class T>
+static bool equals(const xutl::list<T>& li, std::initializer_list<T> expect) {
+    if (li.size() != expect.size()) return false;
+    auto it = expect.begin();
+    for (auto node = li.cbegin(); node != li.cend(); ++node) {
+        if (*node != *it++) return false;
+    }
+    return true;
+}
+
 int main() {
     xutl::list<int> li;
     printf("size = %ld\n", li.size());
@@ -11,5 +26,86 @@ int main() {
     li.push_back(3);
     li.push_back(4);
     printf("size = %ld\n", li.size());
-    return 0;
-}
\ No newline at end of file
+    if (!equals(li, {0, 1, 2, 3, 4})) return 1;
+
+    li.pop_back();
+    li.pop_front();
+    if (!equals(li, {1, 2, 3}) || li.back() != 3) return 1;
+
+    // splice 和 merge
+    xutl::list<int> other(2, 7);
+    li.splice(li.begin(), other);
+    li.splice(li.end(), li, li.begin());
+    if (!equals(li, {7, 1, 2, 3, 7}) || !other.empty()) return 1;
+
+    xutl::list<int> a;
+    xutl::list<int> b;
+    for (int i = 0; i < 6; ++i) {
+        (i % 2 ? a : b).push_back(i);
+    }
+    a.merge(b);
+    if (!equals(a, {0, 1, 2, 3, 4, 5}) || !b.empty()) return 1;
+    a.merge(a);
+    if (a.size() != 6 || !equals(a, {0, 1, 2, 3, 4, 5})) return 1;
+    a.reverse();
+    if (!equals(a, {5, 4, 3, 2, 1, 0})) return 1;
+    a.reverse();
+
+    // 区间构造和区间插入，新节点整体接到 position 之前
+    int src[] = {10, 11, 12};
+    xutl::list<int> ranged(src, src + 3);
+    if (!equals(ranged, {10, 11, 12})) return 1;
+    auto first = ranged.insert(++ranged.begin(), src, src + 2);
+    if (*first != 10 || !equals(ranged, {10, 10, 11, 11, 12})) return 1;
+    first = ranged.insert(ranged.end(), 2, 9);
+    if (*first != 9 || !equals(ranged, {10, 10, 11, 11, 12, 9, 9})) return 1;
+    if (ranged.insert(ranged.begin(), src, src) != ranged.begin()) return 1;
+
+    // remove_if 和 unique 返回移除的个数，size() 随之更新
+    xutl::list<int> runs;
+    int values[] = {1, 1, 2, 3, 3, 3, 4, 5, 5, 6};
+    runs.insert(runs.end(), values, values + 10);
+    if (runs.unique() != 4 || !equals(runs, {1, 2, 3, 4, 5, 6})) return 1;
+    auto is_even = [](int x) { return x % 2 == 0; };
+    if (runs.remove_if(is_even) != 3 || !equals(runs, {1, 3, 5})) return 1;
+    // 与前面保留的元素相差不超过 2 的元素都被移除
+    runs.clear();
+    runs.insert(runs.end(), values, values + 10);
+    auto close = [](int x, int y) { return y - x <= 2 && x - y <= 2; };
+    if (runs.unique(close) != 8 || !equals(runs, {1, 4})) return 1;
+    // value 引用的元素本身也会被移除
+    runs.insert(runs.begin(), 3, 5);
+    if (runs.remove(runs.front()) != 3 || !equals(runs, {1, 4})) return 1;
+    // 链表之间的接合同时更新两边的元素个数
+    runs.splice(runs.end(), ranged, ranged.begin(), --ranged.end());
+    if (runs.size() != 8 || ranged.size() != 1) return 1;
+
+    // 构造元素时抛出异常，已经创建的节点被销毁，原链表不变
+    {
+        fragile values[] = {1, 2, 3, 4};
+        xutl::list<fragile> fl(values, values + 2);
+        fragile::throw_at = 3;
+        bool thrown = false;
+        try {
+            fl.insert(fl.begin(), values, values + 4);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        if (!thrown || fl.size() != 2 || fragile::live != 6) return 1;
+        fragile::throw_at = 2;
+        try {
+            xutl::list<fragile> failed(values, values + 4);
+            return 1;
+        } catch (const std::runtime_error&) {
+        }
+        if (fragile::live != 6) return 1;
+    }
+    if (fragile::live != 0) return 1;
+
+    // 拷贝、赋值和 clear
+    xutl::list<int> copy(a);
+    copy = li;
+    a.clear();
+    printf("copy size = %ld, a size = %ld\n", copy.size(), a.size());
+    return equals(copy, {7, 1, 2, 3, 7}) && a.empty() ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+// 开启分配统计，检查缓存装满之后插入和淘汰不再分配内存
+#define XUTL_ALLOC_STATS
+
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <string>
+
+#include "alloc_stats.h"
+#include "lru_cache.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+
+namespace
+{
+
+// 参照实现：std::list 保存访问顺序，头部是最近访问的
+class reference_lru
+{
+public:
+    explicit reference_lru(size_t capacity) : _capacity(capacity)
+    {
+    }
+
+    const int* get(int key)
+    {
+        auto it = _index.find(key);
+        if (it == _index.end()) return nullptr;
+        _order.splice(_order.begin(), _order, it->second);
+        return &it->second->second;
+    }
+    void put(int key, int value)
+    {
+        auto it = _index.find(key);
+        if (it != _index.end())
+        {
+            it->second->second = value;
+            _order.splice(_order.begin(), _order, it->second);
+            return;
+        }
+        if (_order.size() == _capacity)
+        {
+            _index.erase(_order.back().first);
+            _order.pop_back();
+        }
+        _order.emplace_front(key, value);
+        _index[key] = _order.begin();
+    }
+    bool erase(int key)
+    {
+        auto it = _index.find(key);
+        if (it == _index.end()) return false;
+        _order.erase(it->second);
+        _index.erase(it);
+        return true;
+    }
+    size_t size() const
+    {
+        return _order.size();
+    }
+
+private:
+    size_t _capacity;
+    std::list<std::pair<int, int>> _order;
+    std::map<int, std::list<std::pair<int, int>>::iterator> _index;
+};
+
+// 按字符串长度计算代价
+struct length_cost
+{
+    size_t operator()(int, const std::string& s) const
+    {
+        return s.size();
+    }
+};
+
+}  // namespace
+
+int main()
+{
+    int failed = 0;
+
+    // 与参照实现对比随机的 get、put、erase
+    xutl::lru_cache<int, int> cache(100);
+    reference_lru ref(100);
+    srand(3);
+    bool same = true;
+    for (int step = 0; step < 200000 && same; ++step)
+    {
+        const int key = rand() % 300;
+        const int op = rand() % 10;
+        if (op < 5)
+        {
+            const int* a = cache.get(key);
+            const int* b = ref.get(key);
+            same = (a == nullptr) == (b == nullptr) && (!a || *a == *b);
+        }
+        else if (op < 9)
+        {
+            cache.put(key, step);
+            ref.put(key, step);
+        }
+        else
+        {
+            same = cache.erase(key) == ref.erase(key);
+        }
+        same = same && cache.size() == ref.size();
+    }
+    failed += check(same, "matches reference LRU");
+    for (int i = 0; i < 200; ++i)
+    {
+        cache.put(i, i);
+    }
+    failed += check(cache.size() == 100 && cache.total_cost() == 100,
+                    "full cache size");
+
+    // 缓存装满后的插入和淘汰不分配内存
+    xutl::reset_alloc_stats();
+    for (int i = 0; i < 10000; ++i)
+    {
+        cache.put(1000 + i, i);
+        cache.get(1000 + i / 2);
+    }
+    failed += check(xutl::snapshot_alloc_stats().total.allocations == 0,
+                    "no allocation once warm");
+
+    // peek 不改变访问顺序
+    xutl::lru_cache<int, int> small(2);
+    small.put(1, 1);
+    small.put(2, 2);
+    small.peek(1);
+    small.put(3, 3);
+    failed += check(!small.contains(1) && small.contains(2) &&
+                        small.contains(3),
+                    "peek does not touch");
+    small.get(2);
+    small.put(4, 4);
+    failed += check(small.contains(2) && !small.contains(3), "get touches");
+
+    // 按代价限制容量
+    xutl::lru_cache<int, std::string, std::hash<int>, xutl::equal_to<int>,
+                    length_cost>
+        bytes(10);
+    bytes.put(1, std::string("aaaa"));
+    bytes.put(2, std::string("bbbb"));
+    bytes.put(3, std::string("cc"));
+    failed += check(bytes.size() == 3 && bytes.total_cost() == 10,
+                    "cost fills capacity");
+    bytes.put(4, std::string("ddd"));
+    failed += check(!bytes.contains(1) && bytes.total_cost() == 9,
+                    "cost evicts least recent");
+    failed += check(!bytes.put(5, std::string(11, 'e')) && !bytes.contains(5),
+                    "oversized entry is rejected");
+    bytes.put(2, std::string("bbbbbbbb"));
+    failed += check(bytes.contains(2) && !bytes.contains(3) &&
+                        bytes.total_cost() <= 10,
+                    "growing a value evicts others");
+
+    // 已有的键换成超过容量的值：只删除这个键，两种策略都不影响其它条目
+    for (int policy = 0; policy < 2; ++policy)
+    {
+        xutl::lru_cache<int, std::string, std::hash<int>,
+                        xutl::equal_to<int>, length_cost>
+            grow(10, policy ? xutl::cache_policy::clock
+                            : xutl::cache_policy::lru);
+        grow.put(1, std::string("aa"));
+        grow.put(2, std::string("bb"));
+        grow.put(3, std::string("cc"));
+        failed += check(!grow.put(2, std::string(20, 'x')) &&
+                            grow.size() == 2 && !grow.contains(2) &&
+                            grow.contains(1) && grow.contains(3) &&
+                            grow.total_cost() == 4,
+                        "oversized replacement drops only that key");
+    }
+
+    // CLOCK：命中过的条目得到第二次机会
+    xutl::lru_cache<int, int> clock(3, xutl::cache_policy::clock);
+    clock.put(1, 1);
+    clock.put(2, 2);
+    clock.put(3, 3);
+    clock.get(1);
+    clock.put(4, 4);
+    failed += check(clock.contains(1) && !clock.contains(2) &&
+                        clock.contains(3) && clock.contains(4),
+                    "clock gives a second chance");
+    // 所有条目都被访问过时，扫过一圈后仍能淘汰
+    clock.get(1);
+    clock.get(3);
+    clock.get(4);
+    clock.put(5, 5);
+    failed += check(clock.size() == 3 && clock.contains(5),
+                    "clock evicts after a full sweep");
+
+    // CLOCK 也与参照集合保持一致：存在的键都能查到，个数不超过容量
+    xutl::lru_cache<int, int> clock_big(64, xutl::cache_policy::clock);
+    std::map<int, int> present;
+    same = true;
+    for (int step = 0; step < 50000 && same; ++step)
+    {
+        const int key = rand() % 200;
+        if (rand() % 2)
+        {
+            clock_big.put(key, step);
+            present[key] = step;
+        }
+        else if (const int* v = clock_big.get(key))
+        {
+            same = present.count(key) && present[key] == *v;
+        }
+        same = same && clock_big.size() <= 64;
+    }
+    failed += check(same, "clock keeps values and capacity");
+
+    clock_big.clear();
+    failed += check(clock_big.empty() && !clock_big.contains(1) &&
+                        clock_big.total_cost() == 0,
+                    "clear");
+
+    return xutl_test::report(failed);
+}
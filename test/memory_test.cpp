@@ -0,0 +1,133 @@
+#include <cstdio>
+
+#include "memory.h"
+#include "vector.h"
+
+struct base
+{
+    virtual ~base()
+    {
+    }
+    int b = 1;
+};
+
+struct derived : base
+{
+    explicit derived(int x) : d(x)
+    {
+        ++live;
+    }
+    ~derived()
+    {
+        --live;
+    }
+    int d;
+    static int live;
+};
+
+int derived::live = 0;
+
+struct node : xutl::intrusive_ref_counter<node>
+{
+    explicit node(int x) : v(x)
+    {
+        ++live;
+    }
+    ~node()
+    {
+        --live;
+    }
+    int v;
+    static int live;
+};
+
+int node::live = 0;
+
+int main()
+{
+    // unique_ptr：默认删除器不占空间，可以转换到基类，放进 vector 后扩容按字节搬移
+    static_assert(sizeof(xutl::unique_ptr<int>) == sizeof(int*),
+                  "unique_ptr with default_delete must be pointer-sized");
+    static_assert(
+        xutl::is_trivially_relocatable<xutl::unique_ptr<derived>>::value,
+        "unique_ptr must be trivially relocatable");
+    {
+        xutl::unique_ptr<base> ub = xutl::make_unique<derived>(5);
+        xutl::unique_ptr<int[]> arr = xutl::make_unique<int[]>(4);
+        arr[3] = 2;
+        xutl::vector<xutl::unique_ptr<derived>> v;
+        for (int i = 0; i < 100; ++i)
+        {
+            v.push_back(xutl::unique_ptr<derived>(new derived(i)));
+        }
+        v.emplace(v.begin(), new derived(-1));
+        printf("live = %d, v[0] = %d, v[100] = %d\n", derived::live, v[0]->d,
+               v[100]->d);
+        if (derived::live != 102 || v[0]->d != -1 || v[100]->d != 99)
+            return 1;
+    }
+    printf("live = %d\n", derived::live);
+    if (derived::live != 0) return 1;
+
+    // shared_ptr / weak_ptr
+    xutl::shared_ptr<derived> s = xutl::make_shared<derived>(7);
+    xutl::shared_ptr<base> sb = s;
+    xutl::weak_ptr<base> w = sb;
+    long use = w.lock().use_count();
+    printf("use_count = %ld, b = %d\n", use, w.lock()->b);
+    s.reset();
+    sb.reset();
+    printf("expired = %d, live = %d\n", w.expired(), derived::live);
+    if (use != 3 || !w.expired() || derived::live != 0) return 1;
+
+    xutl::shared_ptr<derived> p(new derived(3));
+    xutl::shared_ptr<base> pb = xutl::static_pointer_cast<base>(p);
+    xutl::shared_ptr<derived> pd = xutl::dynamic_pointer_cast<derived>(pb);
+    printf("d = %d, use_count = %ld\n", pd->d, pd.use_count());
+    if (pd->d != 3 || pd.use_count() != 3) return 1;
+
+    xutl::shared_ptr<int> from_unique(xutl::unique_ptr<int>(new int(9)));
+    bool caught = false;
+    try
+    {
+        xutl::shared_ptr<base> bad(w);
+    }
+    catch (const xutl::bad_weak_ptr&)
+    {
+        caught = true;
+    }
+    printf("from_unique = %d, caught = %d\n", *from_unique, caught);
+    if (*from_unique != 9 || !caught) return 1;
+
+    // local_shared_ptr
+    int live_before = derived::live;
+    {
+        xutl::local_shared_ptr<derived> l = xutl::make_local_shared<derived>(5);
+        xutl::local_shared_ptr<base> lb = l;
+        xutl::local_shared_ptr<int> alias(l, &l->d);
+        printf("local use_count = %ld, alias = %d\n", l.use_count(), *alias);
+        if (l.use_count() != 3 || *alias != 5) return 1;
+        l.reset(new derived(6));
+        if (l.use_count() != 1 || derived::live != live_before + 2) return 1;
+        xutl::local_shared_ptr<base> owned(
+            xutl::unique_ptr<derived>(new derived(7)));
+        if (owned.use_count() != 1 || derived::live != live_before + 3)
+        {
+            return 1;
+        }
+    }
+    printf("local live = %d\n", derived::live - live_before);
+    if (derived::live != live_before) return 1;
+
+    // intrusive_ptr
+    {
+        xutl::intrusive_ptr<node> n = xutl::make_intrusive<node>(4);
+        xutl::intrusive_ptr<node> m = n;
+        node* raw = m.detach();
+        xutl::intrusive_ptr<node> adopted(raw, false);
+        printf("intrusive use_count = %ld, v = %d\n", n->use_count(), n->v);
+        if (n->use_count() != 2 || adopted->v != 4) return 1;
+    }
+    printf("intrusive live = %d\n", node::live);
+    return node::live == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+#include "mmap_vector.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+
+namespace
+{
+
+struct point
+{
+    int x;
+    int y;
+};
+
+}  // namespace
+
+int main()
+{
+    char path[] = "/tmp/xutl_mmap_vector_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return 1;
+    close(fd);
+
+    int failed = 0;
+    {
+        xutl::mmap_vector<point> v(path);
+        failed += check(v.is_open() && v.empty(), "open empty file");
+        // 超过一页，触发多次扩容
+        for (int i = 0; i < 10000; ++i)
+        {
+            v.push_back(point{i, -i});
+        }
+        v.insert(v.begin(), 3, point{7, 7});
+        v.erase(v.begin() + 1, v.begin() + 3);
+        v.emplace_back(point{1, 2});
+        v.sync();
+        failed += check(v.size() == 10002, "size after push_back");
+        failed += check(v[0].x == 7 && v[1].x == 0 && v[10000].x == 9999,
+                        "contents after insert and erase");
+    }
+    {
+        // 重新打开，内容保持不变
+        xutl::mmap_vector<point> v(path, xutl::mmap_mode::read_only);
+        v.advise(xutl::mmap_advice::sequential);
+        failed += check(v.is_read_only() && v.size() == 10002,
+                        "reopen read-only");
+        long long sum = 0;
+        for (const point& p : v)
+        {
+            sum += p.x;
+        }
+        failed += check(sum == 7 + 9999LL * 10000 / 2 + 1, "sum after reopen");
+        failed += check(v.back().x == 1 && v.back().y == 2, "back");
+        bool threw = false;
+        try
+        {
+            v.push_back(point{0, 0});
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        failed += check(threw, "push_back on read-only");
+        threw = false;
+        try
+        {
+            v.pop_back();
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        failed += check(threw && v.size() == 10002, "pop_back on read-only");
+    }
+    {
+        xutl::mmap_vector<point> v(path);
+        v.resize(5);
+        v.shrink_to_fit();
+        failed += check(v.size() == 5 && v.capacity() >= 5, "shrink_to_fit");
+        v.resize(8, point{3, 4});
+        failed += check(v[7].y == 4, "resize with value");
+    }
+    {
+        // 元素类型不同的文件不能打开
+        bool threw = false;
+        try
+        {
+            xutl::mmap_vector<long long> v(path);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        failed += check(threw, "type tag mismatch");
+    }
+    {
+        xutl::mmap_vector<point> v(path, xutl::mmap_mode::truncate);
+        failed += check(v.empty(), "truncate");
+        v.assign(100, point{1, 1});
+        xutl::mmap_vector<point> w(xutl::move(v));
+        failed += check(!v.is_open() && w.size() == 100, "move");
+        failed += check(v.type_tag() == 0 && w.type_tag() != 0,
+                        "type_tag of a closed vector");
+    }
+
+    unlink(path);
+    return xutl_test::report(failed);
+}
@@ -0,0 +1,109 @@
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "mpmc_queue.h"
+#include "vector.h"
+
+namespace
+{
+
+// 从 std::string 构造时可能抛出异常，构造内容为 "bad" 的对象时抛出
+struct checked
+{
+    std::string text;
+
+    checked() = default;
+    explicit checked(std::string&& s) : text(std::move(s))
+    {
+        if (text == "bad") throw std::runtime_error("bad");
+    }
+};
+
+}  // namespace
+
+int main()
+{
+    // 单线程：容量、满、空
+    xutl::mpmc_queue<int> q(5);
+    printf("capacity = %zu\n", q.capacity());
+    int pushed = 0;
+    while (q.try_push(pushed))
+    {
+        ++pushed;
+    }
+    printf("pushed = %d, size = %zu\n", pushed, q.size());
+    int value = -1;
+    int sum = 0;
+    while (q.try_pop(value))
+    {
+        sum += value;
+    }
+    printf("sum = %d, empty = %d\n", sum, q.empty());
+    if (pushed != 8 || sum != 28 || !q.empty()) return 1;
+
+    // 构造可能抛出异常时先占据槽位：队列已满时参数不会被移走，
+    // 构造失败的槽位被消费者跳过
+    xutl::mpmc_queue<checked> cq(2);
+    cq.emplace(std::string("a"));
+    std::string arg("b");
+    if (!cq.try_emplace(std::move(arg))) return 1;
+    arg = "c";
+    if (cq.try_emplace(std::move(arg)) || arg != "c") return 1;
+    checked out;
+    cq.pop(out);
+    bool thrown = false;
+    try
+    {
+        cq.try_emplace(std::string("bad"));
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    if (!thrown || !cq.try_pop(out) || out.text != "b") return 1;
+    if (cq.try_pop(out) || !cq.try_emplace(std::move(arg))) return 1;
+    cq.pop(out);
+    printf("checked = %s, empty = %d\n", out.text.c_str(), cq.empty());
+    if (out.text != "c" || !cq.empty()) return 1;
+
+    // 多生产者多消费者：阻塞 push/pop，小容量以触发 futex 等待
+    const int producers = 4;
+    const int consumers = 4;
+    const long per_producer = 100000;
+    xutl::mpmc_queue<long> mq(64);
+    std::atomic<long> total(0);
+    xutl::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&mq, p, per_producer]() {
+            for (long i = 1; i <= per_producer; ++i)
+            {
+                mq.push(i + p * per_producer);
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c)
+    {
+        threads.emplace_back([&mq, &total, producers, consumers,
+                              per_producer]() {
+            long local = 0;
+            for (long i = 0; i < producers * per_producer / consumers; ++i)
+            {
+                long v;
+                mq.pop(v);
+                local += v;
+            }
+            total += local;
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    const long n = producers * per_producer;
+    printf("total = %ld, expected = %ld\n", total.load(), n * (n + 1) / 2);
+    return total.load() == n * (n + 1) / 2 ? 0 : 1;
+}
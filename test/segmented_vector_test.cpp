@@ -0,0 +1,167 @@
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "segmented_vector.h"
+#include "vector.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+using xutl_test::fragile;
+
+int main()
+{
+    int failed = 0;
+
+    using seq = xutl::segmented_vector<int>;
+    static_assert(
+        std::is_same<std::iterator_traits<seq::iterator>::iterator_category,
+                     xutl::random_access_iterator_tag>::value,
+        "segmented_vector iterator should be random access");
+
+    seq v;
+    failed += check(v.empty() && v.capacity() == 0 && v.chunk_count() == 0,
+                    "default constructed");
+
+    // 扩容时已有元素的地址保持不变
+    const int n = 100000;
+    xutl::vector<const int*> addresses;
+    for (int i = 0; i < n; ++i)
+    {
+        addresses.push_back(&v.emplace_back(i));
+    }
+    bool stable = true;
+    for (int i = 0; i < n; ++i)
+    {
+        stable = stable && addresses[i] == &v[i] && *addresses[i] == i;
+    }
+    failed += check(stable, "addresses are stable across growth");
+    failed += check(v.size() == static_cast<size_t>(n) &&
+                        v.capacity() >= v.size() && v.front() == 0 &&
+                        v.back() == n - 1,
+                    "size, front and back");
+
+    // 块的大小按几何级数增长
+    size_t total = 0;
+    for (size_t k = 0; k < v.chunk_count(); ++k)
+    {
+        total += seq::chunk_capacity(k);
+    }
+    failed += check(total == v.capacity() &&
+                        seq::chunk_capacity(1) == 2 * seq::chunk_capacity(0),
+                    "geometric chunks");
+
+    // 迭代器跨块遍历
+    long long sum = 0;
+    for (int x : v)
+    {
+        sum += x;
+    }
+    failed += check(sum == static_cast<long long>(n) * (n - 1) / 2,
+                    "forward iteration");
+    long long rsum = 0;
+    int expected = n - 1;
+    bool ordered = true;
+    for (auto it = v.rbegin(); it != v.rend(); ++it)
+    {
+        ordered = ordered && *it == expected--;
+        rsum += *it;
+    }
+    failed += check(ordered && rsum == sum, "reverse iteration");
+
+    seq::iterator it = v.begin() + 5000;
+    seq::const_iterator cit = it;
+    failed += check(*it == 5000 && it[-4999] == 1 && *(it - 5000) == 0 &&
+                        cit - v.cbegin() == 5000 && v.end() - it == n - 5000,
+                    "random access");
+    it += 3;
+    it -= 1;
+    failed += check(*it == 5002 && cit < it && it > v.begin(),
+                    "iterator compare");
+
+    // 容量正好用满时的 end()
+    seq full;
+    full.resize(seq::base_chunk_size);
+    failed += check(full.size() == full.capacity() &&
+                        full.end() - full.begin() ==
+                            static_cast<std::ptrdiff_t>(full.size()) &&
+                        *(full.end() - 1) == 0,
+                    "end() when capacity is full");
+
+    v.resize(10);
+    failed += check(v.size() == 10 && v.back() == 9 &&
+                        addresses[3] == &v[3],
+                    "resize shrinks");
+    v.shrink_to_fit();
+    failed += check(v.chunk_count() == 1 && addresses[3] == &v[3],
+                    "shrink_to_fit keeps the first chunk");
+    v.pop_back();
+    failed += check(v.size() == 9 && v.back() == 8, "pop_back");
+
+    bool thrown = false;
+    try
+    {
+        v.at(9);
+    }
+    catch (const std::out_of_range&)
+    {
+        thrown = true;
+    }
+    failed += check(thrown, "at throws out_of_range");
+
+    // 非平凡的元素类型，拷贝和移动
+    xutl::segmented_vector<std::string> s(300, std::string("long enough "
+                                                            "to allocate"));
+    s.push_back("last");
+    xutl::segmented_vector<std::string> copy(s);
+    failed += check(copy == s && copy.back() == "last" && &copy[0] != &s[0],
+                    "copy constructor");
+    const std::string* first = &s[0];
+    auto kept = s.begin() + 200;
+    xutl::segmented_vector<std::string> moved(xutl::move(s));
+    failed += check(s.empty() && &moved[0] == first && moved == copy,
+                    "move keeps element addresses");
+    // 迭代器随元素一起归属另一个容器
+    xutl::segmented_vector<std::string> other(5);
+    other.swap(moved);
+    failed += check(&*kept == &other[200] && kept + 101 == other.end() &&
+                        (kept + 100)->compare("last") == 0,
+                    "iterators survive move and swap");
+    copy.clear();
+    failed += check(copy.empty() && copy.capacity() > 0, "clear keeps chunks");
+
+    xutl::segmented_vector<int> list = {1, 2, 3};
+    failed += check(list.size() == 3 && list[2] == 3, "initializer_list");
+
+    // 构造元素时抛出异常，已经构造的元素和分配的块都被释放
+    {
+        xutl::segmented_vector<fragile> src;
+        for (int i = 0; i < 20; ++i)
+        {
+            src.emplace_back(i);
+        }
+        fragile::throw_at = 6;
+        try
+        {
+            xutl::segmented_vector<fragile> bad(src);
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+        fragile::throw_at = 3;
+        try
+        {
+            xutl::segmented_vector<fragile> bad(10);
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+        failed += check(fragile::live == 20, "throwing constructors");
+    }
+    failed += check(fragile::live == 0, "no leaked elements");
+
+    return xutl_test::report(failed);
+}
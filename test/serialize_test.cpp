@@ -0,0 +1,167 @@
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "serialize.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+
+namespace
+{
+
+struct record
+{
+    int id;
+    double score;
+};
+
+// 大于 0 时，下面的 writev 每次最多写出这么多字节；为 0 时什么也不写，返回 0
+long writev_limit = -1;
+
+}  // namespace
+
+// 替换 libc 的 writev，模拟只写出一部分或一个字节也写不出的文件描述符
+extern "C" ssize_t writev(int fd, const struct iovec* iov, int count)
+{
+    if (writev_limit < 0) return syscall(SYS_writev, fd, iov, count);
+    if (writev_limit == 0 || count == 0) return 0;
+    const size_t n = iov[0].iov_len < static_cast<size_t>(writev_limit)
+                         ? iov[0].iov_len
+                         : static_cast<size_t>(writev_limit);
+    return write(fd, iov[0].iov_base, n);
+}
+
+int main()
+{
+    char path[] = "/tmp/xutl_serialize_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return 1;
+
+    int failed = 0;
+    xutl::vector<record> v;
+    for (int i = 0; i < 100000; ++i)
+    {
+        v.push_back(record{i, i * 0.5});
+    }
+    xutl::list<int> li;
+    for (int i = 0; i < 1000; ++i)
+    {
+        li.push_back(i * 3);
+    }
+    xutl::concurrent_hash_map<int, long> m;
+    for (int i = 0; i < 5000; ++i)
+    {
+        m.insert_or_assign(i, i * 10L);
+    }
+    const xutl::vector<int> small(10, 4);
+
+    {
+        xutl::binary_writer out(fd);
+        xutl::serialize(out, v);
+        xutl::serialize(out, li);
+        xutl::serialize(out, m);
+        xutl::serialize(out, small);
+        xutl::serialize(out, small);
+        out.flush();
+        const off_t expected = 5 * 32 + 100000 * sizeof(record) +
+                               1000 * sizeof(int) +
+                               5000 * (sizeof(int) + sizeof(long)) +
+                               20 * sizeof(int);
+        failed += check(lseek(fd, 0, SEEK_CUR) == expected &&
+                            out.bytes() == static_cast<uint64_t>(expected),
+                        "file size");
+    }
+
+    lseek(fd, 0, SEEK_SET);
+    {
+        xutl::binary_reader in(fd);
+        xutl::vector<record> v2;
+        xutl::deserialize(in, v2);
+        bool same = v2.size() == v.size();
+        for (size_t i = 0; same && i < v.size(); ++i)
+        {
+            same = v2[i].id == v[i].id && v2[i].score == v[i].score;
+        }
+        failed += check(same, "vector round trip");
+
+        // list 和 vector 的格式相同
+        xutl::vector<int> from_list;
+        xutl::deserialize(in, from_list);
+        failed += check(from_list.size() == 1000 && from_list[999] == 2997,
+                        "list read as vector");
+
+        xutl::concurrent_hash_map<int, long> m2;
+        xutl::deserialize(in, m2);
+        long value = 0;
+        failed += check(m2.size() == 5000 && m2.find(4321, value) &&
+                            value == 43210,
+                        "concurrent_hash_map round trip");
+
+        int buffer[10];
+        failed += check(xutl::deserialize_into(in, buffer, 10) == 10 &&
+                            buffer[9] == 4,
+                        "deserialize_into");
+
+        // 元素类型不匹配
+        bool threw = false;
+        try
+        {
+            xutl::list<long> wrong;
+            xutl::deserialize(in, wrong);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        failed += check(threw, "type mismatch");
+    }
+
+    close(fd);
+    unlink(path);
+
+    // 写到管道，每次 writev 只写出 7 个字节
+    int fds[2];
+    if (pipe(fds) != 0) return 1;
+    {
+        xutl::vector<int> block(1000);
+        for (int i = 0; i < 1000; ++i)
+        {
+            block[i] = i;
+        }
+        xutl::binary_writer out(fds[1]);
+        writev_limit = 7;
+        xutl::serialize(out, block);
+        out.flush();
+        writev_limit = -1;
+        xutl::binary_reader in(fds[0]);
+        xutl::vector<int> back;
+        xutl::deserialize(in, back);
+        failed += check(back.size() == 1000 && back[999] == 999,
+                        "short writes");
+
+        // writev 返回 0 时抛出异常，而不是一直重试
+        bool threw = false;
+        writev_limit = 0;
+        try
+        {
+            out.write(block.data(), sizeof(int));
+            out.flush();
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        writev_limit = -1;
+        failed += check(threw, "writev wrote nothing");
+    }
+    close(fds[0]);
+    close(fds[1]);
+    return xutl_test::report(failed);
+}
@@ -0,0 +1,224 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "skip_list.h"
+#include "vector.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+
+namespace
+{
+
+// 对齐要求超过指针的键，用来检查内存池切出的节点都是对齐的
+struct alignas(32) wide_key
+{
+    long v;
+
+    bool operator<(const wide_key& rhs) const
+    {
+        return v < rhs.v;
+    }
+};
+
+template <typename P>
+bool aligned_to(const P* p, size_t align)
+{
+    return reinterpret_cast<uintptr_t>(p) % align == 0;
+}
+
+template <typename K, typename V>
+bool same(const xutl::skip_list<K, V>& a, const std::map<K, V>& b)
+{
+    if (a.size() != b.size()) return false;
+    auto j = b.begin();
+    for (const auto& kv : a)
+    {
+        if (kv.first != j->first || kv.second != j->second) return false;
+        ++j;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main()
+{
+    int failed = 0;
+
+    // 与 std::map 对比随机插入、覆盖和删除
+    xutl::skip_list<int, std::string> s;
+    std::map<int, std::string> ref;
+    srand(11);
+    for (int step = 0; step < 20000; ++step)
+    {
+        const int key = rand() % 2000;
+        const int op = rand() % 3;
+        if (op == 0)
+        {
+            const std::string value = std::to_string(step);
+            const bool inserted = s.try_emplace(key, value).second;
+            if (inserted != ref.emplace(key, value).second)
+            {
+                failed += check(false, "try_emplace reports insertion");
+                break;
+            }
+        }
+        else if (op == 1)
+        {
+            s[key] = "x";
+            ref[key] = "x";
+        }
+        else if (s.erase(key) != ref.erase(key))
+        {
+            failed += check(false, "erase returns the count");
+            break;
+        }
+    }
+    failed += check(same(s, ref), "matches std::map after random edits");
+
+    // 有序查找
+    bool bounds = true;
+    for (int key = -1; key <= 2001; ++key)
+    {
+        auto lb = s.lower_bound(key);
+        auto rlb = ref.lower_bound(key);
+        auto ub = s.upper_bound(key);
+        auto rub = ref.upper_bound(key);
+        if ((lb == s.end()) != (rlb == ref.end()) ||
+            (lb != s.end() && lb->first != rlb->first) ||
+            (ub == s.end()) != (rub == ref.end()) ||
+            (ub != s.end() && ub->first != rub->first) ||
+            s.contains(key) != (ref.count(key) == 1))
+        {
+            bounds = false;
+        }
+    }
+    failed += check(bounds, "lower_bound, upper_bound and contains");
+
+    // 按迭代器删除
+    auto it = s.begin();
+    ++it;
+    const int second = it->first;
+    auto next = s.erase(it);
+    auto rit = ref.erase(ref.find(second));
+    failed += check(same(s, ref) && next->first == rit->first,
+                    "erase by iterator");
+
+    // emplace 遇到已有的键时不插入
+    const int first_key = s.begin()->first;
+    auto r = s.emplace(first_key, std::string("dup"));
+    failed += check(!r.second && r.first->second == ref[first_key],
+                    "emplace keeps the existing element");
+
+    bool threw = false;
+    try
+    {
+        s.at(-5);
+    }
+    catch (const std::out_of_range&)
+    {
+        threw = true;
+    }
+    failed += check(threw, "at throws for a missing key");
+
+    // 拷贝、移动、clear 之后继续使用
+    xutl::skip_list<int, std::string> copy(s);
+    xutl::skip_list<int, std::string> moved(xutl::move(s));
+    failed += check(s.empty() && copy == moved && same(moved, ref),
+                    "copy and move");
+    moved.clear();
+    failed += check(moved.empty() && moved.begin() == moved.end(), "clear");
+    moved[3] = "c";
+    moved[1] = "a";
+    failed += check(moved.size() == 2 && moved.begin()->second == "a",
+                    "reuse after clear");
+
+    xutl::skip_list<int, int> small = {{3, 30}, {1, 10}, {2, 20}};
+    failed += check(small.size() == 3 && small.begin()->first == 1 &&
+                        small.at(2) == 20,
+                    "initializer_list");
+
+    // 多线程：各线程插入交错的键，部分键相同，同时有读者查找
+    xutl::concurrent_skip_list<long, long> cs;
+    const int writers = 4;
+    const long per_writer = 20000;
+    std::atomic<long> inserted(0);
+    std::atomic<long> bad(0);
+    std::atomic<bool> done(false);
+    xutl::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w)
+    {
+        threads.emplace_back([&cs, &inserted, w, per_writer]() {
+            long n = 0;
+            for (long i = 0; i < per_writer; ++i)
+            {
+                // 一半的键与相邻的线程重复
+                const long key = i % 2 ? i * writers + w
+                                       : i * writers + (w & ~1);
+                n += cs.insert(key, key * 3);
+            }
+            inserted += n;
+        });
+    }
+    threads.emplace_back([&cs, &bad, &done]() {
+        while (!done.load())
+        {
+            long prev = -1;
+            for (const auto& kv : cs)
+            {
+                if (kv.first <= prev || kv.second != kv.first * 3) ++bad;
+                prev = kv.first;
+            }
+            const long* v = cs.find(8);
+            if (v != nullptr && *v != 24) ++bad;
+        }
+    });
+    for (int w = 0; w < writers; ++w)
+    {
+        threads[w].join();
+    }
+    done = true;
+    threads.back().join();
+
+    // 偶数下标的键每对线程只插入了一次
+    const long expected = writers * per_writer * 3 / 4;
+    long count = 0;
+    long prev = -1;
+    bool ordered = true;
+    for (const auto& kv : cs)
+    {
+        ordered = ordered && kv.first > prev;
+        prev = kv.first;
+        ++count;
+    }
+    printf("concurrent: size = %zu, bad = %ld\n", cs.size(), bad.load());
+    failed += check(inserted.load() == expected && count == expected &&
+                        static_cast<long>(cs.size()) == expected,
+                    "concurrent inserts of shared keys succeed once");
+    failed += check(ordered && bad.load() == 0, "concurrent readers");
+    failed += check(cs.contains(0) && !cs.contains(-1) &&
+                        cs.lower_bound(-1)->first == 0,
+                    "concurrent lookups");
+
+    // 各种塔高的节点交替分配，都要满足键的对齐
+    xutl::skip_list<wide_key, int> wide;
+    xutl::concurrent_skip_list<wide_key, int> cwide;
+    bool aligned = true;
+    for (long k = 0; k < 2000; ++k)
+    {
+        auto r = wide.try_emplace(wide_key{k * 7919 % 2000}, 1);
+        cwide.insert(wide_key{k}, 1);
+        aligned = aligned && aligned_to(&r.first->first, 32) &&
+                  aligned_to(cwide.find(wide_key{k}), 32);
+    }
+    failed += check(aligned, "nodes honor the key alignment");
+
+    return xutl_test::report(failed);
+}
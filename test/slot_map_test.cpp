@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#include "slot_map.h"
+#include "vector.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+
+int main()
+{
+    int failed = 0;
+
+    xutl::slot_map<std::string> m;
+    xutl::vector<xutl::slot_map_handle> handles;
+    for (int i = 0; i < 100; ++i)
+    {
+        handles.push_back(m.insert(std::to_string(i)));
+    }
+    failed += check(m.size() == 100 && m.slot_count() == 100, "insert");
+    failed += check(m[handles[42]] == "42" && *m.find(handles[7]) == "7",
+                    "lookup by handle");
+
+    // 删除后把最后一个元素移到空出的位置，其它句柄仍然有效
+    failed += check(m.erase(handles[10]), "erase valid handle");
+    failed += check(!m.erase(handles[10]), "erase stale handle");
+    failed += check(m.size() == 99 && m.data()[10] == "99" &&
+                        m[handles[99]] == "99" && m.find(handles[10]) == nullptr &&
+                        !m.contains(handles[10]),
+                    "swap with last on erase");
+    failed += check(!m.contains(xutl::slot_map_handle()),
+                    "default handle is invalid");
+
+    // 槽位复用，代数不同，旧句柄不会指向新元素
+    xutl::slot_map_handle reused = m.insert("new");
+    failed += check(reused.index == handles[10].index &&
+                        reused.generation != handles[10].generation &&
+                        m.find(handles[10]) == nullptr && m[reused] == "new",
+                    "free slot reused with a new generation");
+    failed += check(m.slot_count() == 100, "no new slot when reusing");
+
+    // 紧密存储与句柄一一对应
+    bool consistent = true;
+    for (size_t i = 0; i < m.size(); ++i)
+    {
+        consistent = consistent && &m[m.handle_at(i)] == m.data() + i;
+    }
+    failed += check(consistent, "handle_at matches dense storage");
+
+    // 遍历时删除
+    size_t visited = 0;
+    for (auto it = m.begin(); it != m.end();)
+    {
+        ++visited;
+        if (it->size() == 1)
+        {
+            it = m.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    failed += check(visited == 100 && m.size() == 90 &&
+                        !m.contains(handles[3]) && m[handles[50]] == "50",
+                    "erase while iterating");
+
+    bool thrown = false;
+    try
+    {
+        m.at(handles[3]);
+    }
+    catch (const std::out_of_range&)
+    {
+        thrown = true;
+    }
+    failed += check(thrown, "at throws out_of_range");
+
+    xutl::slot_map<std::string> copy(m);
+    m.clear();
+    failed += check(m.empty() && !m.contains(handles[50]) &&
+                        copy[handles[50]] == "50" && copy.size() == 90,
+                    "clear invalidates handles and copy is independent");
+    xutl::slot_map_handle after_clear = m.insert("x");
+    failed += check(m.size() == 1 && m.slot_count() == 100 &&
+                        m[after_clear] == "x",
+                    "insert after clear reuses slots");
+
+    return xutl_test::report(failed);
+}
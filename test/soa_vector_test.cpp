@@ -0,0 +1,163 @@
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "soa_vector.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+using xutl_test::fragile;
+
+namespace
+{
+
+using particles = xutl::soa_vector<double, int, std::string>;
+
+bool aligned(const void* p)
+{
+    return reinterpret_cast<uintptr_t>(p) % xutl::cache_line_size == 0;
+}
+
+}  // namespace
+
+int main()
+{
+    int failed = 0;
+
+    // 迭代器可以用于 iterator_traits
+    using traits = std::iterator_traits<particles::iterator>;
+    static_assert(
+        std::is_same<traits::iterator_category,
+                     xutl::random_access_iterator_tag>::value,
+        "soa_vector iterator should be random access");
+    static_assert(std::is_same<traits::reference,
+                               std::tuple<double&, int&, std::string&>>::value,
+                  "soa_vector iterator should yield a tuple of references");
+
+    particles v;
+    failed += check(v.empty() && v.capacity() == 0, "default constructed");
+    for (int i = 0; i < 1000; ++i)
+    {
+        v.emplace_back(i * 0.5, i, std::to_string(i));
+    }
+    failed += check(v.size() == 1000 && v.capacity() >= 1000,
+                    "size after emplace_back");
+    failed += check(aligned(v.data<0>()) && aligned(v.data<1>()) &&
+                        aligned(v.data<2>()),
+                    "field arrays are cache line aligned");
+
+    // 每个字段是一个连续数组
+    xutl::span<int> ids = v.field<1>();
+    long long sum = 0;
+    for (int id : ids)
+    {
+        sum += id;
+    }
+    failed += check(ids.size() == 1000 && sum == 999 * 1000 / 2,
+                    "field span");
+    failed += check(&v.field<0>()[10] == v.data<0>() + 10,
+                    "field span points into the array");
+
+    // 代理引用可以修改元素
+    std::get<1>(v[3]) = -3;
+    std::get<2>(*(v.begin() + 4)) = "four";
+    failed += check(v.field<1>()[3] == -3 && v.field<2>()[4] == "four",
+                    "write through proxy reference");
+
+    particles::iterator it = v.begin();
+    it += 10;
+    particles::const_iterator cit = it;
+    failed += check(cit - v.cbegin() == 10 && it[5] == v[15] &&
+                        std::get<0>(*(v.end() - 1)) == 999 * 0.5,
+                    "iterator arithmetic");
+    failed += check(v.cbegin() < cit && v.cend() > cit, "iterator compare");
+
+    // 删除时每个字段一起移动
+    v.erase(v.begin() + 1, v.begin() + 3);
+    v.erase(v.begin());
+    failed += check(v.size() == 997 && std::get<1>(v.front()) == -3 &&
+                        std::get<2>(v[1]) == "four" &&
+                        std::get<2>(v.back()) == "999",
+                    "erase");
+
+    v.push_back(std::make_tuple(1.5, 7, std::string("seven")));
+    v.pop_back();
+    failed += check(v.size() == 997, "push_back and pop_back");
+
+    // 拷贝和移动
+    particles copy(v);
+    failed += check(copy.size() == v.size() && copy[500] == v[500] &&
+                        copy.data<2>() != v.data<2>(),
+                    "copy constructor");
+    particles moved(xutl::move(copy));
+    failed += check(copy.empty() && moved.size() == v.size(),
+                    "move constructor");
+
+    v.resize(2000);
+    failed += check(v.size() == 2000 && std::get<2>(v[1999]).empty() &&
+                        std::get<1>(v[1999]) == 0,
+                    "resize grows with value initialized rows");
+    v.resize(10);
+    v.shrink_to_fit();
+    failed += check(v.size() == 10 && v.capacity() == 10 &&
+                        std::get<2>(v[1]) == "four",
+                    "resize shrinks and shrink_to_fit");
+
+    // 自引用的 emplace_back 在扩容时仍然读到原来的值
+    while (v.size() < v.capacity())
+    {
+        v.emplace_back(0.0, 0, std::string());
+    }
+    v.emplace_back(std::get<0>(v[1]), std::get<1>(v[1]), std::get<2>(v[1]));
+    failed += check(std::get<2>(v.back()) == "four",
+                    "emplace_back of own row during reallocation");
+
+    bool thrown = false;
+    try
+    {
+        v.at(v.size());
+    }
+    catch (const std::out_of_range&)
+    {
+        thrown = true;
+    }
+    failed += check(thrown, "at throws out_of_range");
+
+    xutl::soa_vector<float, char> small = {std::make_tuple(1.0f, 'a'),
+                                           std::make_tuple(2.0f, 'b')};
+    failed += check(small.size() == 2 && small.field<1>()[1] == 'b',
+                    "initializer_list");
+
+    // 构造元素时抛出异常，已经构造的行和分配的内存都被释放
+    {
+        xutl::soa_vector<int, fragile> src;
+        for (int i = 0; i < 20; ++i)
+        {
+            src.push_back(std::make_tuple(i, fragile(i)));
+        }
+        fragile::throw_at = 6;
+        try
+        {
+            xutl::soa_vector<int, fragile> bad(src);
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+        fragile::throw_at = 3;
+        try
+        {
+            xutl::soa_vector<int, fragile> bad(10);
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+        failed += check(fragile::live == 20, "throwing constructors");
+    }
+    failed += check(fragile::live == 0, "no leaked elements");
+
+    return xutl_test::report(failed);
+}
@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "split.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+
+namespace
+{
+
+// 参照实现：用 std::string::find 逐个找分隔符
+std::vector<std::string> reference_split(const std::string& s, char delim)
+{
+    std::vector<std::string> parts;
+    size_t start = 0;
+    for (;;)
+    {
+        const size_t pos = s.find(delim, start);
+        if (pos == std::string::npos)
+        {
+            parts.push_back(s.substr(start));
+            return parts;
+        }
+        parts.push_back(s.substr(start, pos - start));
+        start = pos + 1;
+    }
+}
+
+bool same_split(const std::string& s, char delim)
+{
+    const std::vector<std::string> ref = reference_split(s, delim);
+    size_t i = 0;
+    for (xutl::string_view part : xutl::split(s, delim))
+    {
+        if (i >= ref.size() || std::string(part) != ref[i]) return false;
+        ++i;
+    }
+    return i == ref.size();
+}
+
+int run()
+{
+    int failed = 0;
+    failed += check(same_split("", ',') && same_split(",", ',') &&
+                        same_split("a,,b,", ',') && same_split("abc", ','),
+                    "edge cases");
+
+    // 长度跨过多个 64 字节块，分隔符有疏有密
+    bool ok = true;
+    for (int round = 0; round < 3000 && ok; ++round)
+    {
+        std::string s;
+        const int n = rand() % 300;
+        const int density = 1 + rand() % 40;
+        for (int i = 0; i < n; ++i)
+        {
+            s.push_back(rand() % density == 0 ? ';' : 'a' + rand() % 26);
+        }
+        // 从字符串中间开始切分，使起点不对齐
+        const size_t skip = n == 0 ? 0 : rand() % (n / 4 + 1);
+        ok = same_split(s.substr(skip), ';');
+    }
+    failed += check(ok, "matches std::string::find");
+    return failed;
+}
+
+}  // namespace
+
+int main()
+{
+    int failed = 0;
+    srand(17);
+
+    // SIMD 路径和标量路径都要与参照实现一致
+    for (int simd = 1; simd >= 0; --simd)
+    {
+        xutl::set_simd_enabled(simd != 0);
+        failed += run();
+    }
+    xutl::set_simd_enabled(true);
+
+    // 结果指向原字符串，不复制字符
+    const std::string line = "2024-01-01,INFO,started";
+    auto it = xutl::split(line, ',').begin();
+    ++it;
+    failed += check((*it).data() == line.data() + 11 && *it == "INFO",
+                    "views point into the input");
+    auto copy = it++;
+    failed += check(*copy == "INFO" && *it == "started" &&
+                        ++it == xutl::split(line, ',').end(),
+                    "iterator increments to end");
+
+    return xutl_test::report(failed);
+}
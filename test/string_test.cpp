@@ -0,0 +1,217 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "vector.h"
+#include "xstring.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+
+namespace
+{
+
+bool same(const xutl::string& s, const std::string& ref)
+{
+    return s.size() == ref.size() && s.c_str()[s.size()] == '\0' &&
+           std::string(s.data(), s.size()) == ref;
+}
+
+// 与 std::string 对比随机字符串上的查找
+int run_find()
+{
+    int failed = 0;
+    bool ok = true;
+    for (int round = 0; round < 2000 && ok; ++round)
+    {
+        std::string ref;
+        const int n = rand() % 200;
+        for (int i = 0; i < n; ++i)
+        {
+            ref.push_back(static_cast<char>('a' + rand() % 6));
+        }
+        const xutl::string s(ref.data(), ref.size());
+        const xutl::string_view v = s;
+        const size_t pos = n == 0 ? 0 : rand() % (n + 1);
+        const char c = static_cast<char>('a' + rand() % 7);
+        // 随机的短子串，或者从字符串中截取的较长子串（一定能找到）
+        std::string needle;
+        if (n > 0 && rand() % 2)
+        {
+            const size_t from = rand() % n;
+            needle = ref.substr(from, 1 + rand() % 40);
+        }
+        else
+        {
+            const int m = rand() % 4;
+            for (int i = 0; i < m; ++i)
+            {
+                needle.push_back(static_cast<char>('a' + rand() % 6));
+            }
+        }
+        // 集合有时超过 SIMD 路径支持的大小
+        const std::string set = rand() % 4 ? "fg" : "xyzwvutsf";
+        ok = v.find(c, pos) == ref.find(c, pos) &&
+             v.find(needle, pos) == ref.find(needle, pos) &&
+             v.rfind(c, pos) == ref.rfind(c, pos) &&
+             v.find_first_of(set, pos) == ref.find_first_of(set, pos);
+    }
+    failed += check(ok, "find matches std::string");
+    return failed;
+}
+
+}  // namespace
+
+int main()
+{
+    int failed = 0;
+
+    failed += check(sizeof(xutl::string) == 24 &&
+                        xutl::string::small_capacity >= 22,
+                    "24-byte object with at least 22 inline characters");
+
+    // SSO 的边界
+    xutl::string s;
+    std::string ref;
+    failed += check(s.empty() && s.is_small() && *s.c_str() == '\0', "empty");
+    for (int i = 0; i < 23; ++i)
+    {
+        s.push_back(static_cast<char>('a' + i));
+        ref.push_back(static_cast<char>('a' + i));
+    }
+    failed += check(same(s, ref) && s.is_small() &&
+                        s.capacity() == xutl::string::small_capacity,
+                    "23 characters stay inline");
+    s.push_back('!');
+    ref.push_back('!');
+    failed += check(same(s, ref) && !s.is_small() && s.capacity() >= 46,
+                    "grows to the heap by doubling");
+
+    // 追加自身的一部分
+    s.append(s.data(), 10);
+    ref.append(ref.data(), 10);
+    failed += check(same(s, ref), "append aliasing");
+    for (int i = 0; i < 100; ++i)
+    {
+        s.append(s.data() + i, 7);
+        ref.append(ref.data() + i, 7);
+        s += "xy";
+        ref += "xy";
+    }
+    failed += check(same(s, ref), "repeated append");
+
+    // 拷贝、移动、交换
+    xutl::string copy = s;
+    xutl::string moved = xutl::move(copy);
+    failed += check(same(moved, ref) && copy.empty() && copy.is_small(),
+                    "move leaves an empty string");
+    xutl::string small("short");
+    small.swap(moved);
+    failed += check(same(small, ref) && same(moved, "short"),
+                    "swap small and long");
+    moved = small;
+    failed += check(same(moved, ref) && moved == small, "copy assign");
+    moved = "tiny";
+    moved.shrink_to_fit();
+    failed += check(same(moved, "tiny") && moved.is_small(),
+                    "shrink_to_fit moves back inline");
+
+    // 不先填充的写入
+    xutl::string line("n=");
+    line.append_and_overwrite(20, [](char* p, size_t n) {
+        return static_cast<size_t>(snprintf(p, n, "%d", 12345));
+    });
+    failed += check(same(line, "n=12345"), "append_and_overwrite");
+    xutl::string buf;
+    buf.resize_and_overwrite(100, [](char* p, size_t) {
+        memcpy(p, "hello", 5);
+        return 5;
+    });
+    failed += check(same(buf, "hello") && buf.capacity() >= 100,
+                    "resize_and_overwrite");
+
+    // insert、erase、resize、substr
+    xutl::string edit("hello world");
+    edit.insert(5, ",");
+    edit.erase(0, 1);
+    edit.resize(15, '.');
+    failed += check(same(edit, "ello, world...."), "insert, erase, resize");
+
+    // 插入自身的一部分：源在插入位置之前、之后或跨过插入位置，
+    // 分别覆盖原地插入和扩容插入
+    bool self_ok = true;
+    for (size_t len : {10u, 40u})
+    {
+        for (size_t pos = 0; pos <= len; pos += 3)
+        {
+            for (size_t from = 0; from + 4 <= len; from += 3)
+            {
+                std::string r;
+                for (size_t i = 0; i < len; ++i)
+                {
+                    r.push_back(static_cast<char>('a' + i % 26));
+                }
+                xutl::string x(r.data(), r.size());
+                x.reserve(len + 8);
+                xutl::string y(r.data(), r.size());
+                x.insert(pos, x.data() + from, 4);
+                y.insert(pos, y.data() + from, len - from);
+                std::string ry = r;
+                r.insert(pos, r.data() + from, 4);
+                ry.insert(pos, ry.data() + from, len - from);
+                self_ok = self_ok && same(x, r) && same(y, ry);
+            }
+        }
+    }
+    failed += check(self_ok, "insert aliasing");
+    failed += check(edit.substr(6, 5) == "world" && edit.starts_with("ello") &&
+                        edit.ends_with("..") && edit.contains("o, w"),
+                    "substr and comparisons");
+    failed += check(xutl::string("abc") < xutl::string("abd") &&
+                        xutl::string("ab") < xutl::string("abc") &&
+                        xutl::string("abc") != "abd",
+                    "ordering");
+    failed += check(xutl::string("left ") + "right" == "left right",
+                    "operator+");
+
+    bool thrown = false;
+    try
+    {
+        edit.at(100);
+    }
+    catch (const std::out_of_range&)
+    {
+        thrown = true;
+    }
+    failed += check(thrown, "at throws out_of_range");
+
+    // vector 按字节搬移 string，扩容后内容不变
+    xutl::vector<xutl::string> v;
+    for (int i = 0; i < 1000; ++i)
+    {
+        v.push_back(xutl::string(static_cast<size_t>(i % 40), 'x'));
+    }
+    bool ok = true;
+    for (int i = 0; i < 1000; ++i)
+    {
+        ok = ok && same(v[i], std::string(i % 40, 'x'));
+    }
+    failed += check(xutl::is_trivially_relocatable<xutl::string>::value && ok,
+                    "trivially relocatable");
+
+    failed += check(std::hash<xutl::string>()(xutl::string("key")) ==
+                        std::hash<xutl::string_view>()("key"),
+                    "hash agrees with string_view");
+
+    // SIMD 路径和标量路径都要与 std::string 一致
+    srand(9);
+    for (int simd = 1; simd >= 0; --simd)
+    {
+        xutl::set_simd_enabled(simd != 0);
+        failed += run_find();
+    }
+    xutl::set_simd_enabled(true);
+
+    return xutl_test::report(failed);
+}
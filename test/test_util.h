@@ -0,0 +1,78 @@
+#ifndef XUTL_TEST_UTIL_H_
+#define XUTL_TEST_UTIL_H_
+
+/**
+ * 该文件包含测试程序共用的辅助函数和类型
+ * 测试程序把 check() 的返回值累加到失败计数中，最后 return report(failed)，
+ * 全部通过时打印 ok，进程的返回值即失败的检查个数
+ */
+
+#include <cstdio>
+#include <stdexcept>
+
+namespace xutl_test
+{
+
+// 检查失败时打印 what，返回失败的个数（0 或 1）
+inline int check(bool ok, const char* what)
+{
+    if (!ok) printf("failed: %s\n", what);
+    return ok ? 0 : 1;
+}
+
+inline int report(int failed)
+{
+    if (failed == 0) printf("ok\n");
+    return failed;
+}
+
+// 用来测试异常安全的元素类型：每次构造都把 throw_at 减一，
+// 减到 0 时抛出 std::runtime_error，live 记录存活的对象数
+template <typename Tag>
+struct _fragile_counts
+{
+    static int live;
+    static int throw_at;
+};
+template <typename Tag>
+int _fragile_counts<Tag>::live = 0;
+template <typename Tag>
+int _fragile_counts<Tag>::throw_at = 0;
+
+struct fragile : _fragile_counts<void>
+{
+    int value;
+
+    fragile() : fragile(0)
+    {
+    }
+    fragile(int v) : value(v)
+    {
+        _constructed();
+    }
+    fragile(const fragile& rhs) : value(rhs.value)
+    {
+        _constructed();
+    }
+    // 非平凡的赋值，容器不会按字节搬移它
+    fragile& operator=(const fragile& rhs)
+    {
+        value = rhs.value;
+        return *this;
+    }
+    ~fragile()
+    {
+        --live;
+    }
+
+private:
+    void _constructed()
+    {
+        if (--throw_at == 0) throw std::runtime_error("fragile");
+        ++live;
+    }
+};
+
+}  // namespace xutl_test
+
+#endif  // XUTL_TEST_UTIL_H_
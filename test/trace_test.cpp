@@ -0,0 +1,104 @@
+// 开启事件追踪，检查扩容事件的内容和导出的 JSON
+#define XUTL_TRACE
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "concurrent_hash_map.h"
+#include "trace.h"
+#include "vector.h"
+
+namespace
+{
+
+size_t count_events(const std::vector<xutl::trace_event>& events,
+                    const char* name)
+{
+    size_t n = 0;
+    for (const xutl::trace_event& e : events)
+    {
+        if (strcmp(e.name, name) == 0) ++n;
+    }
+    return n;
+}
+
+}  // namespace
+
+int main()
+{
+    // 没有开始追踪时不记录
+    {
+        xutl::vector<int> v;
+        for (int i = 0; i < 100; ++i)
+        {
+            v.push_back(i);
+        }
+    }
+    if (!xutl::trace_snapshot().empty()) return 1;
+
+    xutl::trace_start();
+    xutl::vector<int> v;  // 默认构造分配 16 个元素
+    for (int i = 0; i < 128; ++i)
+    {
+        v.push_back(i);
+    }
+    v.emplace(v.begin(), 1);      // 已满，128 -> 256
+    v.insert(v.begin(), 300, 7);  // 256 -> 556
+    v.reserve(4096);
+
+    std::thread t([]() {
+        xutl::concurrent_hash_map<int, int> map;
+        for (int i = 0; i < 1000; ++i)
+        {
+            map.insert_or_assign(i, i);
+        }
+    });
+    t.join();
+    xutl::trace_stop();
+
+    std::vector<xutl::trace_event> events = xutl::trace_snapshot();
+    printf("events = %zu\n", events.size());
+
+    // push_back: 16 -> 32 -> 64 -> 128
+    if (count_events(events, "vector::reallocate_and_insert") != 3) return 1;
+    if (count_events(events, "vector::reallocate_and_fill_n") != 1) return 1;
+    if (count_events(events, "vector::reallocate_and_emplace") != 1) return 1;
+    if (count_events(events, "vector::reallocate") != 1) return 1;
+    if (count_events(events, "concurrent_hash_map::rehash") == 0) return 1;
+
+    const xutl::trace_event& first = events[0];
+    if (first.address != &v || first.old_capacity != 16 ||
+        first.new_capacity != 32 || first.bytes != 16 * sizeof(int) ||
+        first.end < first.begin)
+    {
+        return 1;
+    }
+    for (const xutl::trace_event& e : events)
+    {
+        const bool rehash = strcmp(e.name, "concurrent_hash_map::rehash") == 0;
+        if (rehash == (e.thread == first.thread)) return 1;
+    }
+
+    FILE* f = tmpfile();
+    if (f == nullptr || !xutl::write_chrome_trace(f)) return 1;
+    std::string json;
+    rewind(f);
+    for (int c; (c = fgetc(f)) != EOF;)
+    {
+        json += static_cast<char>(c);
+    }
+    fclose(f);
+    if (json.find("\"traceEvents\"") == std::string::npos ||
+        json.find("\"ph\": \"X\"") == std::string::npos ||
+        json.find("\"new_capacity\": 32") == std::string::npos)
+    {
+        return 1;
+    }
+
+    xutl::trace_clear();
+    if (!xutl::trace_snapshot().empty()) return 1;
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <string>
+
+#include "unrolled_list.h"
+
+#include "test_util.h"
+
+using xutl_test::check;
+using xutl_test::fragile;
+
+namespace
+{
+
+template <typename T>
+bool same(const xutl::unrolled_list<T>& a, const std::list<T>& b)
+{
+    if (a.size() != b.size()) return false;
+    auto j = b.begin();
+    for (const T& x : a)
+    {
+        if (x != *j++) return false;
+    }
+    // 反向遍历同样一致
+    auto rj = b.rbegin();
+    for (auto it = a.rbegin(); it != a.rend(); ++it)
+    {
+        if (*it != *rj++) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main()
+{
+    int failed = 0;
+
+    using seq = xutl::unrolled_list<int>;
+    seq v;
+    for (int i = 0; i < 1000; ++i)
+    {
+        v.push_back(i);
+    }
+    // 顺序 push_back 得到的节点都是满的
+    failed += check(v.size() == 1000 &&
+                        v.node_count() ==
+                            (1000 + seq::node_capacity - 1) /
+                                seq::node_capacity,
+                    "push_back fills nodes");
+    failed += check(v.front() == 0 && v.back() == 999, "front and back");
+
+    // 与 std::list 对比随机插入和删除，覆盖分裂与合并
+    xutl::unrolled_list<std::string> u;
+    std::list<std::string> ref;
+    srand(7);
+    for (int step = 0; step < 20000; ++step)
+    {
+        const size_t pos = ref.empty() ? 0 : rand() % (ref.size() + 1);
+        auto it = u.begin();
+        auto rit = ref.begin();
+        for (size_t k = 0; k < pos; ++k)
+        {
+            ++it;
+            ++rit;
+        }
+        // 前半段以插入为主，后半段以删除为主
+        const int percent = step < 10000 ? 70 : 45;
+        const bool insert = ref.empty() || rand() % 100 < percent;
+        if (insert)
+        {
+            const std::string value = std::to_string(step);
+            auto r = u.insert(it, value);
+            ref.insert(rit, value);
+            if (*r != value)
+            {
+                failed += check(false, "insert returns the new element");
+                break;
+            }
+        }
+        else if (rit != ref.end())
+        {
+            auto r = u.erase(it);
+            auto rr = ref.erase(rit);
+            if ((rr == ref.end()) != (r == u.end()) ||
+                (rr != ref.end() && *r != *rr))
+            {
+                failed += check(false, "erase returns the next element");
+                break;
+            }
+        }
+        if (step % 500 == 0 && !same(u, ref))
+        {
+            failed += check(false, "matches std::list during random edits");
+            break;
+        }
+    }
+    failed += check(same(u, ref), "matches std::list after random edits");
+
+    while (ref.size() < 1000)
+    {
+        u.push_front("x");
+        ref.push_front("x");
+    }
+
+    // 删除后节点会合并，不会留下大量几乎为空的节点
+    while (u.size() > 100)
+    {
+        u.erase(u.begin());
+        ref.erase(ref.begin());
+    }
+    // 每个节点最多 4 个 string，合并后平均每个节点至少 2 个元素
+    failed += check(same(u, ref) && u.node_count() <= 100 / 2 + 1,
+                    "merge keeps nodes filled");
+
+    // 范围删除、拷贝、移动
+    auto first = u.begin();
+    ++first;
+    auto last = first;
+    for (int k = 0; k < 50; ++k)
+    {
+        ++last;
+    }
+    auto after = u.erase(first, last);
+    auto rfirst = ref.begin();
+    ++rfirst;
+    auto rlast = rfirst;
+    for (int k = 0; k < 50; ++k)
+    {
+        ++rlast;
+    }
+    auto rafter = ref.erase(rfirst, rlast);
+    failed += check(same(u, ref) && *after == *rafter, "erase range");
+
+    xutl::unrolled_list<std::string> copy(u);
+    xutl::unrolled_list<std::string> moved(xutl::move(u));
+    failed += check(u.empty() && copy == moved && same(moved, ref),
+                    "copy and move");
+    moved.clear();
+    failed += check(moved.empty() && moved.begin() == moved.end(), "clear");
+
+    seq small = {1, 2, 3};
+    small.push_front(0);
+    small.pop_back();
+    failed += check(small.size() == 3 && small.front() == 0 &&
+                        small.back() == 2,
+                    "push_front and pop_back");
+
+    // 插入的值引用满节点中的元素，分裂节点不能影响它
+    xutl::unrolled_list<std::string> full;
+    for (int i = 0; i < 4; ++i)
+    {
+        full.push_back(std::string(40, static_cast<char>('a' + i)));
+    }
+    full.insert(++full.begin(), full.back());
+    failed += check(full.size() == 5 && *++full.begin() == std::string(40, 'd'),
+                    "insert an element of the same full node");
+
+    // 构造元素时抛出异常，不留下空节点，也不泄漏
+    xutl::unrolled_list<fragile> empty;
+    fragile::throw_at = 1;
+    try
+    {
+        empty.emplace_back(1);
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+    failed += check(empty.empty() && empty.begin() == empty.end() &&
+                        empty.node_count() == 0,
+                    "throwing emplace_back on an empty list");
+    {
+        fragile::throw_at = 0;
+        xutl::unrolled_list<fragile> src;
+        for (int i = 0; i < 20; ++i)
+        {
+            src.emplace_back(i);
+        }
+        fragile::throw_at = 6;
+        try
+        {
+            xutl::unrolled_list<fragile> copy(src);
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+        failed += check(fragile::live == 20, "throwing copy constructor");
+    }
+    failed += check(fragile::live == 0, "no leaked elements");
+
+    return xutl_test::report(failed);
+}
@@ -1,47 +1,126 @@
+#include <cstdint>
 #include <iostream>
-
+#include "list.h"
 #include "vector.h"
 
-int main(int argc, char* argv[])
+#include "test_util.h"
+
+using xutl_test::fragile;
+
+struct alignas(64) padded_counter
+{
+    long value;
+};
+
+template <typename P>
+static bool aligned_to(P p, size_t align)
+{
+    return reinterpret_cast<uintptr_t>(p) % align == 0;
+}
+
+template <typename T>
+static void print(const xutl::vector<T>& v)
 {
-    // test codes
-    xutl::vector<int> v;
-    int i = 2;
-    v.push_back(i);
-    v.push_back(3);
-    v.emplace_back(4);
     for (const auto& i : v)
     {
         std::cout << i << " ";
     }
     std::cout << std::endl;
-    v.pop_back();
+}
+
+template <typename T>
+static bool equals(const xutl::vector<T>& v, std::initializer_list<T> expect)
+{
+    if (v.size() != expect.size()) return false;
+    auto it = expect.begin();
     for (const auto& i : v)
     {
-        std::cout << i << " ";
+        if (i != *it++) return false;
     }
-    std::cout << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    // test codes
+    xutl::vector<int> v;
+    int i = 2;
+    v.push_back(i);
+    v.push_back(3);
+    v.emplace_back(4);
+    print(v);
+    if (!equals(v, {2, 3, 4}) || v.back() != 4) return 1;
+    v.pop_back();
+    print(v);
     v.assign(5, 1);
-    for (const auto& i : v)
-    {
-        std::cout << i << " ";
-    }
-    std::cout << std::endl;
+    print(v);
     v.insert(v.begin() + 1, 2);
-    for (const auto& i : v)
-    {
-        std::cout << i << " ";
-    }
-    std::cout << std::endl;
+    print(v);
     v.insert(v.begin() + 2, 2, 3);
-    for (const auto& i : v)
-    {
-        std::cout << i << " ";
-    }
-    std::cout << std::endl;
+    print(v);
+    if (!equals(v, {1, 2, 3, 3, 1, 1, 1, 1})) return 1;
     v.reserve(100);
     std::cout << v.capacity() << std::endl;
     v.shrink_to_fit();
     std::cout << v.capacity() << std::endl;
-    return 0;
-}
\ No newline at end of file
+
+    // insert 插入的元素比 pos 之后的元素多，以及 value 引用自身元素的情况
+    v.reserve(32);
+    v.insert(v.end() - 1, 3, v.back());
+    v.insert(v.begin(), 2, v[1]);
+    print(v);
+    if (!equals(v, {2, 2, 1, 2, 3, 3, 1, 1, 1, 1, 1, 1, 1})) return 1;
+
+    // 区间插入，包括需要扩容的情况
+    int arr[] = {7, 8, 9};
+    v.insert(v.begin() + 1, arr, arr + 3);
+    xutl::list<int> li(20, 5);
+    v.insert(v.end(), li.begin(), li.end());
+    if (v.size() != 36 || v[1] != 7 || v[3] != 9 || v.back() != 5) return 1;
+
+    // erase
+    v.erase(v.begin() + 4, v.end());
+    v.erase(v.begin());
+    print(v);
+    if (!equals(v, {7, 8, 9})) return 1;
+
+    xutl::vector<int> w;
+    w = xutl::move(v);
+    if (!equals(w, {7, 8, 9}) || !v.empty()) return 1;
+
+    // clear 和缩小的 assign 要更新 size
+    w.assign(2, 4);
+    if (!equals(w, {4, 4})) return 1;
+    w.clear();
+    if (!w.empty() || w.capacity() < 3) return 1;
+
+    // 超过 ::operator new 默认对齐的元素类型，以及 aligned_vector
+    xutl::vector<padded_counter> counters(3);
+    for (int k = 0; k < 100; ++k)
+    {
+        counters.push_back(padded_counter{k});
+        if (!aligned_to(counters.data(), 64)) return 1;
+    }
+    xutl::aligned_vector<float, 64> floats(17, 1.0f);
+    floats.insert(floats.begin(), 100, 2.0f);
+    if (!aligned_to(floats.data(), 64) || floats.size() != 117) return 1;
+    xutl::aligned_vector<char, 4096> page(1, 'x');
+
+    // 扩容时新元素的构造抛出异常，不能析构没有构造过的位置
+    {
+        xutl::vector<fragile> t;
+        while (t.size() < t.capacity()) t.emplace_back();
+        const fragile extra;
+        fragile::throw_at = 1;
+        try
+        {
+            t.push_back(extra);
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+        if (t.size() != 16) return 1;
+    }
+    if (fragile::live != 0) return 1;
+    return aligned_to(page.data(), 4096) ? 0 : 1;
+}